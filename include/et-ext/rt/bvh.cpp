@@ -0,0 +1,621 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et-ext/rt/bvh.h>
+#include <et-ext/rt/kdtree.h>
+#include <et/core/tools.h>
+#include <et/core/jobsystem.h>
+#include <array>
+
+namespace et
+{
+namespace rt
+{
+
+namespace
+{
+
+enum : uint32_t
+{
+	BinsCount = 16,
+	MaxTrianglesPerLeaf = 2 * PacketWidth,
+	MinTrianglesPerSubtree = 4096,
+	MinTrianglesForParallelBinning = 64 * 1024,
+	SubtreesPerWorker = 8,
+};
+
+/*
+ * costs of traversal step and triangle packet intersection, relative to each other
+ */
+const float TraversalCost = 1.0f;
+const float IntersectionCost = 1.0f;
+
+struct ET_ALIGNED(16) PrimitiveBounds
+{
+	float4 minVertex;
+	float4 maxVertex;
+};
+
+struct ET_ALIGNED(16) Bounds
+{
+	float4 minVertex = float4(+std::numeric_limits<float>::max());
+	float4 maxVertex = float4(-std::numeric_limits<float>::max());
+
+	void extend(const float4& mn, const float4& mx)
+	{
+		minVertex = minVertex.minWith(mn);
+		maxVertex = maxVertex.maxWith(mx);
+	}
+
+	void extend(const Bounds& b)
+	{
+		extend(b.minVertex, b.maxVertex);
+	}
+
+	float halfArea() const
+	{
+		vec3 d = (maxVertex - minVertex).xyz();
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+};
+
+struct ET_ALIGNED(16) Bin
+{
+	Bounds bounds;
+	Bounds centroidBounds;
+	uint32_t count = 0;
+};
+
+using AxisBins = std::array<Bin, BinsCount>;
+using Bins = std::array<AxisBins, 3>;
+
+struct ET_ALIGNED(16) BuildTask
+{
+	Bounds centroidBounds;
+	uint32_t nodeIndex = 0;
+	uint32_t begin = 0;
+	uint32_t end = 0;
+	uint32_t depth = 0;
+};
+
+struct ET_ALIGNED(16) Split
+{
+	Bounds leftBounds;
+	Bounds rightBounds;
+	Bounds leftCentroidBounds;
+	Bounds rightCentroidBounds;
+	float cost = std::numeric_limits<float>::max();
+	uint32_t axis = InvalidIndex;
+	uint32_t bin = 0;
+};
+
+void storeBounds(BVH::Node& node, const Bounds& b)
+{
+	vec3 mn = b.minVertex.xyz();
+	vec3 mx = b.maxVertex.xyz();
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		node.minVertex[i] = mn[i];
+		node.maxVertex[i] = mx[i];
+	}
+}
+
+class BVHBuilder
+{
+public:
+	BVHBuilder(const Vector<PrimitiveBounds>& bounds, const Vector<vec3>& centroids, Vector<uint32_t>& indices) :
+		_bounds(bounds), _centroids(centroids), _indices(indices) { }
+
+	/*
+	 * splits node described by task into two children, appended to the nodes,
+	 * returns false and turns node into leaf if split is not worth it
+	 */
+	bool splitNode(Vector<BVH::Node>& nodes, const BuildTask& task, BuildTask& left, BuildTask& right, bool parallel);
+	void buildSubtree(Vector<BVH::Node>& nodes, const BuildTask& task, uint32_t& maxDepth);
+
+private:
+	void binPrimitives(uint32_t begin, uint32_t end, const vec3& origin, const vec3& scale, Bins& bins);
+	void binPrimitivesParallel(uint32_t begin, uint32_t end, const vec3& origin, const vec3& scale, Bins& bins);
+
+	static uint32_t binIndex(float value, float origin, float scale)
+	{
+		float b = (value - origin) * scale;
+		return (b > 0.0f) ? std::min(static_cast<uint32_t>(b), uint32_t(BinsCount - 1)) : 0;
+	}
+
+private:
+	const Vector<PrimitiveBounds>& _bounds;
+	const Vector<vec3>& _centroids;
+	Vector<uint32_t>& _indices;
+};
+
+void BVHBuilder::binPrimitives(uint32_t begin, uint32_t end, const vec3& origin, const vec3& scale, Bins& bins)
+{
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		uint32_t primitiveIndex = _indices[i];
+		const PrimitiveBounds& b = _bounds[primitiveIndex];
+		const vec3& c = _centroids[primitiveIndex];
+		float4 centroid(c, 0.0f);
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			Bin& bin = bins[axis][binIndex(c[axis], origin[axis], scale[axis])];
+			bin.bounds.extend(b.minVertex, b.maxVertex);
+			bin.centroidBounds.extend(centroid, centroid);
+			++bin.count;
+		}
+	}
+}
+
+void BVHBuilder::binPrimitivesParallel(uint32_t begin, uint32_t end, const vec3& origin, const vec3& scale, Bins& bins)
+{
+	uint32_t chunksCount = 4 * (static_cast<uint32_t>(sharedJobSystem().workersCount()) + 1);
+	uint32_t chunkSize = (end - begin + chunksCount - 1) / chunksCount;
+
+	Vector<Bins> chunkBins(chunksCount);
+	sharedJobSystem().parallelFor(0, chunksCount, [&](uint32_t chunkBegin, uint32_t chunkEnd)
+	{
+		for (uint32_t chunk = chunkBegin; chunk < chunkEnd; ++chunk)
+		{
+			uint32_t rangeBegin = std::min(end, begin + chunk * chunkSize);
+			uint32_t rangeEnd = std::min(end, rangeBegin + chunkSize);
+			binPrimitives(rangeBegin, rangeEnd, origin, scale, chunkBins[chunk]);
+		}
+	}, 1);
+
+	for (const Bins& chunk : chunkBins)
+	{
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			for (uint32_t i = 0; i < BinsCount; ++i)
+			{
+				bins[axis][i].bounds.extend(chunk[axis][i].bounds);
+				bins[axis][i].centroidBounds.extend(chunk[axis][i].centroidBounds);
+				bins[axis][i].count += chunk[axis][i].count;
+			}
+		}
+	}
+}
+
+bool BVHBuilder::splitNode(Vector<BVH::Node>& nodes, const BuildTask& task, BuildTask& left, BuildTask& right, bool parallel)
+{
+	uint32_t count = task.end - task.begin;
+	nodes[task.nodeIndex].offset = task.begin;
+	nodes[task.nodeIndex].count = count;
+
+	if ((count <= 2) || (task.depth + 1 >= BVH::MaxDepth))
+		return false;
+
+	vec3 origin = task.centroidBounds.minVertex.xyz();
+	vec3 extent = (task.centroidBounds.maxVertex - task.centroidBounds.minVertex).xyz();
+	if ((extent.x <= 0.0f) && (extent.y <= 0.0f) && (extent.z <= 0.0f))
+		return false;
+
+	vec3 scale(0.0f);
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		if (extent[axis] > 0.0f)
+			scale[axis] = static_cast<float>(BinsCount) / extent[axis];
+	}
+
+	Bins bins;
+	if (parallel && (count >= MinTrianglesForParallelBinning))
+		binPrimitivesParallel(task.begin, task.end, origin, scale, bins);
+	else
+		binPrimitives(task.begin, task.end, origin, scale, bins);
+
+	Split best;
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		if (extent[axis] <= 0.0f)
+			continue;
+
+		const AxisBins& axisBins = bins[axis];
+
+		Bounds rightBounds[BinsCount];
+		uint32_t rightCount[BinsCount] = { };
+		Bounds accumulated;
+		uint32_t accumulatedCount = 0;
+		for (uint32_t i = BinsCount - 1; i > 0; --i)
+		{
+			accumulated.extend(axisBins[i].bounds);
+			accumulatedCount += axisBins[i].count;
+			rightBounds[i - 1] = accumulated;
+			rightCount[i - 1] = accumulatedCount;
+		}
+
+		accumulated = Bounds();
+		accumulatedCount = 0;
+		for (uint32_t i = 0; i + 1 < BinsCount; ++i)
+		{
+			accumulated.extend(axisBins[i].bounds);
+			accumulatedCount += axisBins[i].count;
+			if ((accumulatedCount == 0) || (rightCount[i] == 0))
+				continue;
+
+			float cost = accumulated.halfArea() * static_cast<float>(packetsCount(accumulatedCount)) +
+				rightBounds[i].halfArea() * static_cast<float>(packetsCount(rightCount[i]));
+
+			if (cost < best.cost)
+			{
+				best.cost = cost;
+				best.axis = axis;
+				best.bin = i;
+				best.leftBounds = accumulated;
+				best.rightBounds = rightBounds[i];
+			}
+		}
+	}
+
+	if (best.axis == InvalidIndex)
+		return false;
+
+	const BVH::Node& node = nodes[task.nodeIndex];
+	vec3 nodeExtent(node.maxVertex[0] - node.minVertex[0], node.maxVertex[1] - node.minVertex[1],
+		node.maxVertex[2] - node.minVertex[2]);
+	float nodeHalfArea = nodeExtent.x * nodeExtent.y + nodeExtent.y * nodeExtent.z + nodeExtent.z * nodeExtent.x;
+
+	float leafCost = IntersectionCost * static_cast<float>(packetsCount(count));
+	float splitCost = TraversalCost + IntersectionCost * best.cost / std::max(nodeHalfArea, std::numeric_limits<float>::min());
+	if ((splitCost >= leafCost) && (count <= MaxTrianglesPerLeaf))
+		return false;
+
+	for (uint32_t i = 0; i <= best.bin; ++i)
+		best.leftCentroidBounds.extend(bins[best.axis][i].centroidBounds);
+
+	for (uint32_t i = best.bin + 1; i < BinsCount; ++i)
+		best.rightCentroidBounds.extend(bins[best.axis][i].centroidBounds);
+
+	uint32_t axis = best.axis;
+	float axisOrigin = origin[axis];
+	float axisScale = scale[axis];
+	auto middle = std::partition(_indices.begin() + task.begin, _indices.begin() + task.end,
+		[this, axis, axisOrigin, axisScale, &best](uint32_t i)
+	{
+		return binIndex(_centroids[i][axis], axisOrigin, axisScale) <= best.bin;
+	});
+	uint32_t split = static_cast<uint32_t>(middle - _indices.begin());
+	ET_ASSERT((split > task.begin) && (split < task.end));
+
+	uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+	nodes[task.nodeIndex].offset = firstChild;
+	nodes[task.nodeIndex].count = 0;
+
+	nodes.emplace_back();
+	storeBounds(nodes.back(), best.leftBounds);
+	nodes.emplace_back();
+	storeBounds(nodes.back(), best.rightBounds);
+
+	left.nodeIndex = firstChild;
+	left.begin = task.begin;
+	left.end = split;
+	left.depth = task.depth + 1;
+	left.centroidBounds = best.leftCentroidBounds;
+
+	right.nodeIndex = firstChild + 1;
+	right.begin = split;
+	right.end = task.end;
+	right.depth = task.depth + 1;
+	right.centroidBounds = best.rightCentroidBounds;
+	return true;
+}
+
+void BVHBuilder::buildSubtree(Vector<BVH::Node>& nodes, const BuildTask& task, uint32_t& maxDepth)
+{
+	maxDepth = std::max(maxDepth, task.depth);
+
+	BuildTask left;
+	BuildTask right;
+	if (splitNode(nodes, task, left, right, false))
+	{
+		buildSubtree(nodes, left, maxDepth);
+		buildSubtree(nodes, right, maxDepth);
+	}
+}
+
+}
+
+BVH::~BVH()
+{
+	cleanUp();
+}
+
+void BVH::cleanUp()
+{
+	_nodes.clear();
+	_packets.clear();
+	_trianglesCount = 0;
+	_maxBuildDepth = 0;
+}
+
+void BVH::build(const TriangleStorage& triangles)
+{
+	cleanUp();
+
+	_trianglesCount = triangles.size();
+	if (triangles.empty())
+		return;
+
+	uint64_t t0 = queryContiniousTimeInMilliSeconds();
+
+	uint32_t trianglesCount = static_cast<uint32_t>(_trianglesCount);
+	Vector<PrimitiveBounds> bounds(trianglesCount);
+	Vector<vec3> centroids(trianglesCount);
+	Vector<uint32_t> indices(trianglesCount);
+
+	sharedJobSystem().parallelFor(0, trianglesCount, [&triangles, &bounds, &centroids, &indices](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			bounds[i].minVertex = triangles.minVertex(i);
+			bounds[i].maxVertex = triangles.maxVertex(i);
+			centroids[i] = ((bounds[i].minVertex + bounds[i].maxVertex) * 0.5f).xyz();
+			indices[i] = i;
+		}
+	});
+
+	BuildTask root;
+	Bounds rootBounds;
+	for (uint32_t i = 0; i < trianglesCount; ++i)
+	{
+		rootBounds.extend(bounds[i].minVertex, bounds[i].maxVertex);
+		float4 centroid(centroids[i], 0.0f);
+		root.centroidBounds.extend(centroid, centroid);
+	}
+	root.end = trianglesCount;
+
+	_nodes.reserve(2 * trianglesCount / MaxTrianglesPerLeaf + 1);
+	_nodes.emplace_back();
+	storeBounds(_nodes.back(), rootBounds);
+
+	/*
+	 * top levels are split here, until subtrees are small enough
+	 * to be distributed between workers
+	 */
+	uint32_t workersCount = static_cast<uint32_t>(sharedJobSystem().workersCount()) + 1;
+	uint32_t subtreeSize = std::max(uint32_t(MinTrianglesPerSubtree), trianglesCount / (SubtreesPerWorker * workersCount));
+
+	BVHBuilder builder(bounds, centroids, indices);
+	Vector<BuildTask> subtrees;
+	Vector<BuildTask> pending;
+	pending.emplace_back(root);
+	uint32_t maxDepth = 0;
+	while (!pending.empty())
+	{
+		BuildTask task = pending.back();
+		pending.pop_back();
+		maxDepth = std::max(maxDepth, task.depth);
+
+		if (task.end - task.begin <= subtreeSize)
+		{
+			subtrees.emplace_back(task);
+			continue;
+		}
+
+		BuildTask left;
+		BuildTask right;
+		if (builder.splitNode(_nodes, task, left, right, true))
+		{
+			pending.emplace_back(left);
+			pending.emplace_back(right);
+		}
+	}
+
+	/*
+	 * each subtree is built into it's own array, with root at index 0,
+	 * then arrays are appended to the nodes and child indices are relocated
+	 */
+	Vector<Vector<Node>> subtreeNodes(subtrees.size());
+	Vector<uint32_t> subtreeDepth(subtrees.size(), 0);
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(subtrees.size()), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			BuildTask task = subtrees[i];
+			Vector<Node>& nodes = subtreeNodes[i];
+			nodes.reserve(2 * (task.end - task.begin) / MaxTrianglesPerLeaf + 1);
+			nodes.emplace_back(_nodes[task.nodeIndex]);
+			task.nodeIndex = 0;
+			builder.buildSubtree(nodes, task, subtreeDepth[i]);
+		}
+	}, 1);
+
+	for (size_t i = 0, e = subtrees.size(); i < e; ++i)
+	{
+		const Vector<Node>& nodes = subtreeNodes[i];
+		uint32_t relocation = static_cast<uint32_t>(_nodes.size()) - 1;
+		auto relocated = [relocation](Node node)
+		{
+			if (!node.isLeaf())
+				node.offset += relocation;
+			return node;
+		};
+
+		_nodes[subtrees[i].nodeIndex] = relocated(nodes.front());
+		for (size_t n = 1, ne = nodes.size(); n < ne; ++n)
+			_nodes.emplace_back(relocated(nodes[n]));
+
+		maxDepth = std::max(maxDepth, subtreeDepth[i]);
+	}
+	_maxBuildDepth = maxDepth;
+
+	_packets.reserve(packetsCount(trianglesCount) + _nodes.size() / 2);
+	for (Node& node : _nodes)
+	{
+		if (node.isLeaf())
+			node.offset = packTriangles(_packets, triangles, indices.data() + node.offset, node.count);
+	}
+
+	uint64_t t1 = queryContiniousTimeInMilliSeconds();
+	log::info("BVH building time: %llu", t1 - t0);
+}
+
+struct BVHSearchNode
+{
+	uint32_t index;
+	float distance;
+
+	BVHSearchNode(uint32_t i, float d) :
+		index(i), distance(d) { }
+};
+
+inline bool rayToNode(const BVH::Node& node, const float origin[3], const float invDirection[3], float maxDistance, float& distance)
+{
+	float tNear = 0.0f;
+	float tFar = maxDistance;
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		float t0 = (node.minVertex[axis] - origin[axis]) * invDirection[axis];
+		float t1 = (node.maxVertex[axis] - origin[axis]) * invDirection[axis];
+		tNear = std::max(tNear, std::min(t0, t1));
+		tFar = std::min(tFar, std::max(t0, t1));
+	}
+	distance = tNear;
+	return tNear <= tFar;
+}
+
+BVH::TraverseResult BVH::traverse(const Ray& ray) const
+{
+	TraverseResult result;
+	if (_nodes.empty())
+		return result;
+
+	ET_ALIGNED(16) float origin[4];
+	ray.origin.loadToFloats(origin);
+
+	ET_ALIGNED(16) float invDirection[4];
+	ray.direction.loadToFloats(invDirection);
+	for (uint32_t axis = 0; axis < 3; ++axis)
+		invDirection[axis] = safeInverse(invDirection[axis]);
+
+	PacketHit hit;
+	float distance = 0.0f;
+	if (!rayToNode(_nodes.front(), origin, invDirection, hit.distance, distance))
+		return result;
+
+	const TrianglePacket* packetsPtr = _packets.data();
+	const Node* nodesPtr = _nodes.data();
+
+	FastStack<MaxDepth, BVHSearchNode> traverseStack;
+	const Node* localNode = nodesPtr;
+	for (;;)
+	{
+		if (localNode->isLeaf())
+		{
+			intersectTrianglePackets(ray, packetsPtr + localNode->offset, packetsCount(localNode->count),
+				std::numeric_limits<float>::max(), hit);
+		}
+		else
+		{
+			float leftDistance = 0.0f;
+			float rightDistance = 0.0f;
+			bool hitLeft = rayToNode(nodesPtr[localNode->offset], origin, invDirection, hit.distance, leftDistance);
+			bool hitRight = rayToNode(nodesPtr[localNode->offset + 1], origin, invDirection, hit.distance, rightDistance);
+			if (hitLeft && hitRight)
+			{
+				uint32_t nearChild = (leftDistance <= rightDistance) ? 0 : 1;
+				traverseStack.emplace(localNode->offset + 1 - nearChild, nearChild ? leftDistance : rightDistance);
+				localNode = nodesPtr + localNode->offset + nearChild;
+				continue;
+			}
+			else if (hitLeft || hitRight)
+			{
+				localNode = nodesPtr + localNode->offset + (hitLeft ? 0 : 1);
+				continue;
+			}
+		}
+
+		/*
+		 * nodes on stack could be farther than the closest intersection, found after they were pushed
+		 */
+		localNode = nullptr;
+		while (traverseStack.hasSomething() && (localNode == nullptr))
+		{
+			BVHSearchNode searchNode = traverseStack.top();
+			traverseStack.pop();
+			if (searchNode.distance <= hit.distance)
+				localNode = nodesPtr + searchNode.index;
+		}
+
+		if (localNode == nullptr)
+			break;
+	}
+
+	if (hit.triangleIndex != InvalidIndex)
+	{
+		result.triangleIndex = hit.triangleIndex;
+		result.intersectionPointBarycentric = float4(1.0f - hit.u - hit.v, hit.u, hit.v, 0.0f);
+		result.intersectionPoint = ray.origin + ray.direction * hit.distance;
+	}
+	return result;
+}
+
+void BVH::traverse(const RayPacket& rays, PacketHits& hits) const
+{
+	if (_nodes.empty())
+		return;
+
+	const uint32_t activeMask = PacketMask >> (PacketWidth - rays.count);
+	const TrianglePacket* packetsPtr = _packets.data();
+	const Node* nodesPtr = _nodes.data();
+
+	/*
+	 * children are visited in the order of the first ray, which is good enough for coherent rays
+	 */
+	float4 firstDirection(rays.direction[0][0], rays.direction[1][0], rays.direction[2][0], 0.0f);
+
+	FastStack<MaxDepth + 1, uint32_t> traverseStack;
+	traverseStack.push(0);
+	while (traverseStack.hasSomething())
+	{
+		const Node& node = nodesPtr[traverseStack.top()];
+		traverseStack.pop();
+
+		if (intersectBoundingBox(rays, node.minVertex, node.maxVertex, hits, activeMask) == 0)
+			continue;
+
+		if (node.isLeaf())
+		{
+			const TrianglePacket* packet = packetsPtr + node.offset;
+			for (uint32_t i = 0; i < node.count; ++i)
+				intersectTriangle(rays, packet[i / PacketWidth], i % PacketWidth, hits);
+		}
+		else
+		{
+			const Node& left = nodesPtr[node.offset];
+			const Node& right = nodesPtr[node.offset + 1];
+			float4 centersDelta(
+				(right.minVertex[0] + right.maxVertex[0]) - (left.minVertex[0] + left.maxVertex[0]),
+				(right.minVertex[1] + right.maxVertex[1]) - (left.minVertex[1] + left.maxVertex[1]),
+				(right.minVertex[2] + right.maxVertex[2]) - (left.minVertex[2] + left.maxVertex[2]), 0.0f);
+			uint32_t nearChild = (centersDelta.dot(firstDirection) >= 0.0f) ? 0 : 1;
+			traverseStack.push(node.offset + 1 - nearChild);
+			traverseStack.push(node.offset + nearChild);
+		}
+	}
+}
+
+BVH::Stats BVH::nodesStatistics() const
+{
+	BVH::Stats result;
+	result.totalNodes = _nodes.size();
+	result.maxDepth = _maxBuildDepth;
+	result.totalTriangles = _trianglesCount;
+	for (const auto& node : _nodes)
+	{
+		if (node.isLeaf())
+		{
+			++result.leafNodes;
+			result.maxTrianglesPerNode = std::max(result.maxTrianglesPerNode, node.count);
+			result.minTrianglesPerNode = std::min(result.minTrianglesPerNode, node.count);
+		}
+	}
+	return result;
+}
+
+}
+}
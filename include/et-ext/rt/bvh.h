@@ -0,0 +1,84 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et-ext/rt/packets.h>
+
+namespace et {
+namespace rt {
+
+/*
+ * Bounding volume hierarchy, built with binned SAH.
+ * Top levels are split on the calling thread (with parallel binning),
+ * independent subtrees are built in parallel on the shared job system.
+ * Children of the interior node are stored next to each other, so node
+ * keeps only index of the first child.
+ */
+class ET_ALIGNED(16) BVH {
+public:
+	struct ET_ALIGNED(32) Node {
+		float minVertex[3]{ };
+		uint32_t offset = 0;
+		float maxVertex[3]{ };
+		uint32_t count = 0;
+
+		/*
+		 * offset is index of the first child for interior nodes
+		 * and index of the first triangle packet for leaf nodes
+		 */
+		bool isLeaf() const {
+			return count > 0;
+		}
+	};
+
+	struct Stats
+	{
+		size_t totalTriangles = 0;
+		size_t totalNodes = 0;
+		size_t maxDepth = 0;
+		uint32_t leafNodes = 0;
+		uint32_t maxTrianglesPerNode = 0;
+		uint32_t minTrianglesPerNode = std::numeric_limits<uint32_t>::max();
+	};
+
+	enum : uint32_t
+	{
+		MaxDepth = 64
+	};
+
+	using TraverseResult = rt::TraverseResult;
+
+public:
+	~BVH();
+
+	/*
+	 * triangles are only accessed during build
+	 */
+	void build(const TriangleStorage&);
+	Stats nodesStatistics() const;
+	void cleanUp();
+
+	const Node& nodeAt(size_t i) const {
+		return _nodes[i];
+	}
+
+	TraverseResult traverse(const Ray& r) const;
+	void traverse(const RayPacket&, PacketHits&) const;
+
+private:
+	Vector<Node> _nodes;
+	TrianglePacketList _packets;
+
+	size_t _trianglesCount = 0;
+	size_t _maxBuildDepth = 0;
+};
+
+static_assert(sizeof(BVH::Node) == 32, "BVH node should be 32 bytes long");
+
+}
+}
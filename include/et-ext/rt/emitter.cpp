@@ -31,7 +31,7 @@ float4 UniformEmitter::evaluate(const Scene& scene, const float4& position, cons
 	float4& nrm, float4& pos, float& pdf) const
 {
 	float4 result(0.0f);
-	KDTree::TraverseResult hit = scene.kdTree.traverse(Ray(position, direction));
+	TraverseResult hit = scene.traverse(Ray(position, direction));
 	if (hit.triangleIndex == InvalidIndex)
 	{
 		pdf = 1.0f;
@@ -57,15 +57,17 @@ void MeshEmitter::prepare(const Scene& scene)
 {
 	for (uint32_t i = 0; i < _numTriangles; ++i)
 	{
-		_area += scene.kdTree.triangleAtIndex(_firstTriangle + i).area();
+		_area += scene.triangleAtIndex(_firstTriangle + i).area();
 	}
 }
 
 float4 MeshEmitter::samplePoint(const Scene& scene) const
 {
-	const Triangle& emitterTriangle = scene.kdTree.triangleAtIndex(_firstTriangle + rand() % _numTriangles);
+	size_t triangleIndex = _firstTriangle + rand() % _numTriangles;
 	float4 bc = randomBarycentric();
-	return emitterTriangle.interpolatedPosition(bc) + float4(0.0f, 0.0f, 0.0f, 1.0f);
+	return scene.triangles.vertex(triangleIndex, 0) * bc.shuffle<0, 0, 0, 3>() +
+		scene.triangles.vertex(triangleIndex, 1) * bc.shuffle<1, 1, 1, 3>() +
+		scene.triangles.vertex(triangleIndex, 2) * bc.shuffle<2, 2, 2, 3>() + float4(0.0f, 0.0f, 0.0f, 1.0f);
 }
 
 float4 MeshEmitter::evaluate(const Scene& scene, const float4& position, const float4& direction, 
@@ -73,10 +75,10 @@ float4 MeshEmitter::evaluate(const Scene& scene, const float4& position, const f
 {
 	float4 result(0.0f);
 
-	KDTree::TraverseResult hit = scene.kdTree.traverse(Ray(position, direction));
+	TraverseResult hit = scene.traverse(Ray(position, direction));
 	if (containsTriangle(hit.triangleIndex))
 	{
-		const Triangle& hitTriangle = scene.kdTree.triangleAtIndex(hit.triangleIndex);
+		Triangle hitTriangle = scene.triangleAtIndex(hit.triangleIndex);
 		nrm = hitTriangle.interpolatedNormal(hit.intersectionPointBarycentric);
 		pos = hit.intersectionPoint;
 
@@ -5,6 +5,7 @@
  *
  */
 
+#include <et/imaging/blockcompression.h>
 #include <et-ext/rt/image.h>
 
 namespace et
@@ -15,11 +16,23 @@ namespace rt
 class ImagePrivate
 {
 public:
+	TextureDescription::Pointer data;
 };
 
-Image::Image(const TextureDescription::Pointer) 
+Image::Image(const TextureDescription::Pointer desc) 
 {
 	ET_PIMPL_INIT(Image);
+
+	/*
+	 * block compressed images are decompressed once, so they could be sampled per pixel
+	 */
+	_private->data = desc;
+	if (desc.valid() && bc::decompressionSupported(desc->format))
+	{
+		_private->data = TextureDescription::Pointer::create();
+		if (!bc::decompressBlocks(desc.reference(), _private->data.reference()))
+			_private->data = desc;
+	}
 }
 
 Image::~Image() 
@@ -29,12 +42,44 @@ Image::~Image()
 
 float4 Image::pointSample(uint32_t x, uint32_t y) 
 {
-	return float4(0.5);
+	const TextureDescription::Pointer& data = _private->data;
+	if (data.invalid() || !data->valid())
+		return float4(0.5);
+
+	x = std::min(x, static_cast<uint32_t>(data->size.x - 1));
+	y = std::min(y, static_cast<uint32_t>(data->size.y - 1));
+	uint32_t index = x + y * static_cast<uint32_t>(data->size.x);
+
+	switch (data->format)
+	{
+	case TextureFormat::RGBA8:
+	{
+		const vec4ub& p = reinterpret_cast<const vec4ub*>(data->data.constData())[index];
+		return float4(static_cast<float>(p.x), static_cast<float>(p.y), static_cast<float>(p.z), static_cast<float>(p.w)) / float4(255.0f);
+	}
+	case TextureFormat::RGBA16F:
+	{
+		const uint16_t* p = reinterpret_cast<const uint16_t*>(data->data.constData()) + 4 * index;
+		return float4(halfToFloat(p[0]), halfToFloat(p[1]), halfToFloat(p[2]), halfToFloat(p[3]));
+	}
+	case TextureFormat::RGBA32F:
+		return float4(reinterpret_cast<const vec4*>(data->data.constData())[index]);
+
+	default:
+		return float4(0.5);
+	}
 }
 
 rt::float4 Image::sample(float u, float v)
 {
-	return float4(0.333333f);
+	const TextureDescription::Pointer& data = _private->data;
+	if (data.invalid() || !data->valid())
+		return float4(0.333333f);
+
+	u -= std::floor(u);
+	v -= std::floor(v);
+	return pointSample(static_cast<uint32_t>(u * static_cast<float>(data->size.x)),
+		static_cast<uint32_t>(v * static_cast<float>(data->size.y)));
 }
 
 float4 Image::quirectangularSample(float phi, float theta)
@@ -13,13 +13,23 @@ namespace rt
 {
 #define ET_RT_USE_RUSSIAN_ROULETTE 1
 
+inline TraverseResult traversePrimaryRay(Scene& scene, const Ray& inRay, Evaluate& eval)
+{
+	if (eval.primaryHit == nullptr)
+		return scene.traverse(inRay);
+
+	TraverseResult result = *eval.primaryHit;
+	eval.primaryHit = nullptr;
+	return result;
+}
+
 float4 evaluateNormals(Scene& scene, const Ray& inRay, Evaluate& eval)
 {
-	KDTree::TraverseResult hit0 = scene.kdTree.traverse(inRay);
+	TraverseResult hit0 = traversePrimaryRay(scene, inRay, eval);
 	if (hit0.triangleIndex == InvalidIndex)
 		return float4(1.0f); // TODO : sample light? env->sampleInDirection(inRay.direction);
 
-	const auto& tri = scene.kdTree.triangleAtIndex(hit0.triangleIndex);
+	Triangle tri = scene.triangleAtIndex(hit0.triangleIndex);
 	return tri.interpolatedNormal(hit0.intersectionPointBarycentric) * 0.5f + float4(0.5f);
 }
 
@@ -27,19 +37,19 @@ float4 evaluateAmbientOcclusion(Scene& scene, const Ray& inRay, Evaluate& eval)
 {
 	float4 result(1.0f);
 
-	KDTree::TraverseResult hit = scene.kdTree.traverse(inRay);
+	TraverseResult hit = traversePrimaryRay(scene, inRay, eval);
 	if (hit.triangleIndex != InvalidIndex)
 	{
 		++eval.pathLength;
 		
 		vec4simd randomSample(fastRandomFloat(), fastRandomFloat(), 0.0f, 0.0f);
 
-		const Triangle& tri = scene.kdTree.triangleAtIndex(hit.triangleIndex);
+		Triangle tri = scene.triangleAtIndex(hit.triangleIndex);
 		float4 surfaceNormal = tri.interpolatedNormal(hit.intersectionPointBarycentric);
 		float4 nextDirection = randomVectorOnHemisphere(randomSample, surfaceNormal, uniformDistribution);
 
 		float4 origin = hit.intersectionPoint;
-		hit = scene.kdTree.traverse(Ray(origin, nextDirection));
+		hit = scene.traverse(Ray(origin, nextDirection));
 
 		if (hit.triangleIndex != InvalidIndex)
 			result = float4(0.0f);
@@ -59,7 +69,8 @@ float4 evaluateGlobalIllumination(Scene& scene, const Ray& inRay, Evaluate& eval
 	Ray currentRay = inRay;
 	for (eval.pathLength = 0; eval.pathLength < eval.maxPathLength; ++eval.pathLength)
 	{
-		KDTree::TraverseResult intersection = scene.kdTree.traverse(currentRay);
+		TraverseResult intersection = (eval.pathLength == 0) ?
+			traversePrimaryRay(scene, currentRay, eval) : scene.traverse(currentRay);
 		if (intersection.triangleIndex == InvalidIndex)
 		{
 			for (const Emitter::Pointer& em : scene.emitters)
@@ -76,7 +87,7 @@ float4 evaluateGlobalIllumination(Scene& scene, const Ray& inRay, Evaluate& eval
 			break;
 		}
 
-		const Triangle& tri = scene.kdTree.triangleAtIndex(intersection.triangleIndex);
+		Triangle tri = scene.triangleAtIndex(intersection.triangleIndex);
 		const Material& mtl = scene.materials[tri.materialIndex];
 		float4 nrm = tri.interpolatedNormal(intersection.intersectionPointBarycentric);
 		float4 uv0 = tri.interpolatedTexCoord0(intersection.intersectionPointBarycentric);
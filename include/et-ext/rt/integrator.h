@@ -20,6 +20,11 @@ struct Evaluate
 	uint32_t totalRayCount = 0;
 	uint32_t maxPathLength = 0;
 	uint32_t pathLength = 0;
+
+	/*
+	 * intersection of the primary ray, if it was already found with ray packet
+	 */
+	const TraverseResult* primaryHit = nullptr;
 };
 
 using EvaluateFunction = float4(*)(Scene&, const Ray&, Evaluate&);
@@ -30,33 +30,27 @@ KDTree::~KDTree()
 
 rt::KDTree::Node KDTree::buildRootNode()
 {
-	_intersectionData.reserve(_triangles.size());
-	_boundingBoxes.reserve(32 + _triangles.size() / 32);
+	_boundingBoxes.reserve(32 + _trianglesCount / 32);
 	
 	float4 minVertex = float4(+std::numeric_limits<float>::max());
 	float4 maxVertex = float4(-std::numeric_limits<float>::max());;
 	
-	for (const auto& t : _triangles)
+	for (size_t i = 0; i < _trianglesCount; ++i)
 	{
-		minVertex = minVertex.minWith(t.v[0]);
-		minVertex = minVertex.minWith(t.v[1]);
-		minVertex = minVertex.minWith(t.v[2]);
-		maxVertex = maxVertex.maxWith(t.v[0]);
-		maxVertex = maxVertex.maxWith(t.v[1]);
-		maxVertex = maxVertex.maxWith(t.v[2]);
-		_intersectionData.emplace_back(t.v[0], t.edge1to0, t.edge2to0);
+		minVertex = minVertex.minWith(_triangles->minVertex(i));
+		maxVertex = maxVertex.maxWith(_triangles->maxVertex(i));
 	}
 	
 	float4 center = (minVertex + maxVertex) * float4(0.5f);
 	float4 halfSize = (maxVertex - minVertex) * float4(0.5f);
-	_indices.reserve(16 * _triangles.size());
+	_indices.reserve(16 * _trianglesCount);
 	
 	_boundingBoxes.clear();
     _boundingBoxes.emplace_back(center, halfSize);
 	_sceneBoundingBox = _boundingBoxes.back();
 
 	KDTree::Node result;
-	result.endIndex = static_cast<uint32_t>(_triangles.size());
+	result.endIndex = static_cast<uint32_t>(_trianglesCount);
 	for (uint32_t i = 0; i < result.endIndex; ++i)
 	{
 		_indices.emplace_back(i);
@@ -64,12 +58,13 @@ rt::KDTree::Node KDTree::buildRootNode()
 	return result;
 }
 
-void KDTree::build(const TriangleList& triangles, size_t maxDepth)
+void KDTree::build(const TriangleStorage& triangles, size_t maxDepth)
 {
 	cleanUp();
 	
 	_maxBuildDepth = 0;
-	_triangles = triangles;
+	_triangles = &triangles;
+	_trianglesCount = triangles.size();
 	
 	_maxDepth = std::min(DepthLimit, maxDepth);
 	_nodes.reserve(maxDepth * maxDepth);
@@ -77,6 +72,8 @@ void KDTree::build(const TriangleList& triangles, size_t maxDepth)
 
 	uint64_t t0 = queryContiniousTimeInMilliSeconds();
 	splitNodeUsingSortedArray(0, 0);
+	packLeafTriangles();
+	_triangles = nullptr;
 	uint64_t t1 = queryContiniousTimeInMilliSeconds();
 	log::info("kD-tree building time: %llu", t1 - t0);
 }
@@ -142,9 +139,8 @@ void KDTree::distributeTrianglesToChildren(size_t nodeIndex)
 	for (uint32_t i = node.startIndex, e = node.startIndex + node.numIndexes(); i < e; ++i)
 	{
 		uint32_t triIndex = _indices[i];
-		const auto& tri = _triangles[triIndex];
-		tri.minVertex().loadToFloats(minVertex.data());
-		tri.maxVertex().loadToFloats(maxVertex.data());
+		_triangles->minVertex(triIndex).loadToFloats(minVertex.data());
+		_triangles->maxVertex(triIndex).loadToFloats(maxVertex.data());
 		
 		if (minVertex[node.axis] > node.distance)
 		{
@@ -172,10 +168,26 @@ void KDTree::distributeTrianglesToChildren(size_t nodeIndex)
 	_indices.insert(_indices.end(), rightIndexes.begin(), rightIndexes.end());
 }
 
+void KDTree::packLeafTriangles()
+{
+	_packets.clear();
+	for (Node& node : _nodes)
+	{
+		if ((node.axis == InvalidIndex) && node.nonEmpty())
+		{
+			node.firstPacket = packTriangles(_packets, *_triangles, _indices.data() + node.startIndex, node.numIndexes());
+			node.packetsCount = packetsCount(node.numIndexes());
+		}
+	}
+}
+
 void KDTree::cleanUp()
 {
 	_nodes.clear();
-	_triangles.clear();
+	_packets.clear();
+	_indices.clear();
+	_boundingBoxes.clear();
+	_trianglesCount = 0;
 }
 
 void KDTree::splitNodeUsingSortedArray(size_t nodeIndex, size_t depth)
@@ -236,9 +248,8 @@ void KDTree::splitNodeUsingSortedArray(size_t nodeIndex, size_t depth)
 	maxPoints.clear();
 	for (uint32_t i = localNode.startIndex, e = localNode.endIndex; i < e; ++i)
 	{
-		const auto& tri = _triangles[_indices[i]];
-		minPoints.emplace_back(tri.minVertex().xyz());
-		maxPoints.emplace_back(tri.maxVertex().xyz());
+		minPoints.emplace_back(_triangles->minVertex(_indices[i]).xyz());
+		maxPoints.emplace_back(_triangles->maxVertex(_indices[i]).xyz());
 	}
 	
 	float3 splitPosition = minPoints[minPoints.size() / 2];
@@ -310,11 +321,6 @@ void KDTree::printStructure(const Node& node, const std::string& tag)
 	}
 }
 
-const Triangle& KDTree::triangleAtIndex(size_t i) const
-{
-	return _triangles[i];
-}
-
 struct KDTreeSearchNode
 {
 	uint32_t ind;
@@ -345,8 +351,7 @@ KDTree::TraverseResult KDTree::traverse(const Ray& ray) const
 	ET_ALIGNED(16) float originDivDirection[4];
 	(ray.origin / (ray.direction + rt::float4(std::numeric_limits<float>::epsilon()))).loadToFloats(originDivDirection);
     
-	const IntersectionData* intersectionDataPtr = _intersectionData.data();
-	const uint32_t* indicesPtr = _indices.data();
+	const TrianglePacket* packetsPtr = _packets.data();
 
 	Node localNode = _nodes.front();
 	FastStack<DepthLimit + 1, KDTreeSearchNode> traverseStack;
@@ -374,53 +379,13 @@ KDTree::TraverseResult KDTree::traverse(const Ray& ray) const
 			}
 		}
 
-		if (localNode.nonEmpty())
+		PacketHit hit;
+		if (localNode.nonEmpty() && intersectTrianglePackets(ray, packetsPtr + localNode.firstPacket, localNode.packetsCount, tFar, hit))
 		{
-			result.triangleIndex = InvalidIndex;
-
-			ET_ALIGNED(16) float minDistance = std::numeric_limits<float>::max();
-			for (uint32_t i = localNode.startIndex, e = localNode.endIndex; i < e; ++i)
-			{
-				uint32_t triangleIndex = indicesPtr[i];
-				IntersectionData data = intersectionDataPtr[triangleIndex];
-				
-				float4 pvec = ray.direction.crossXYZ(data.edge2to0);
-				union
-				{
-					float f;
-					uint32_t i;
-				} det = { data.edge1to0.dot(pvec) };
-
-				if (!(det.i & 0x7fffffff))
-					continue;
-
-				float inv_dev = 1.0f / det.f;
-
-				float4 tvec = ray.origin - data.v0;
-				float u = tvec.dot(pvec) * inv_dev;
-				if ((u < 0.0f) || (u > 1.0f))
-					continue;
-
-				float4 qvec = tvec.crossXYZ(data.edge1to0);
-				float t = data.edge2to0.dot(qvec) * inv_dev;
-				if ((t < minDistance) && (t <= tFar) && (t > Constants::epsilon))
-				{
-					float v = ray.direction.dot(qvec) * inv_dev;
-					float uv = u + v;
-					if ((v >= 0.0f) && (uv <= 1.0f))
-					{
-						minDistance = t;
-						result.triangleIndex = triangleIndex;
-						result.intersectionPointBarycentric = float4(1.0f - uv, u, v, 0.0f);
-					}
-				}
-			}
-
-			if (result.triangleIndex < InvalidIndex)
-			{
-				result.intersectionPoint = ray.origin + ray.direction * minDistance;
-				return result;
-			}
+			result.triangleIndex = hit.triangleIndex;
+			result.intersectionPointBarycentric = float4(1.0f - hit.u - hit.v, hit.u, hit.v, 0.0f);
+			result.intersectionPoint = ray.origin + ray.direction * hit.distance;
+			return result;
 		}
 		
 		if (traverseStack.empty())
@@ -444,7 +409,7 @@ KDTree::Stats KDTree::nodesStatistics() const
 	KDTree::Stats result;
 	result.totalNodes = _nodes.size();
 	result.maxDepth = _maxBuildDepth;
-	result.totalTriangles = _triangles.size();
+	result.totalTriangles = _trianglesCount;
 	for (const auto& node : _nodes)
 	{
 		if (node.axis == InvalidIndex)
@@ -8,7 +8,7 @@
 #pragma once
 
 #include <stack>
-#include <et-ext/rt/raytraceobjects.h>
+#include <et-ext/rt/packets.h>
 
 namespace et {
 namespace rt {
@@ -21,6 +21,8 @@ public:
 		uint32_t axis = InvalidIndex;
 		uint32_t startIndex = 0;
 		uint32_t endIndex = 0;
+		uint32_t firstPacket = 0;
+		uint32_t packetsCount = 0;
 
 		uint32_t numIndexes() const {
 			return endIndex - startIndex;
@@ -47,16 +49,15 @@ public:
 		uint32_t minTrianglesPerNode = std::numeric_limits<uint32_t>::max();
 	};
 
-	struct ET_ALIGNED(16) TraverseResult {
-		float4 intersectionPoint;
-		float4 intersectionPointBarycentric;
-		uint32_t triangleIndex = InvalidIndex;
-	};
+	using TraverseResult = rt::TraverseResult;
 
 public:
 	~KDTree();
 
-	void build(const TriangleList&, size_t maxDepth);
+	/*
+	 * triangles are only accessed during build
+	 */
+	void build(const TriangleStorage&, size_t maxDepth);
 	Stats nodesStatistics() const;
 	void cleanUp();
 
@@ -67,12 +68,14 @@ public:
 		return _boundingBoxes[i];
 	}
 
+	bool empty() const {
+		return _nodes.empty();
+	}
+
 	TraverseResult traverse(const Ray& r) const;
 
 	void printStructure();
 
-	const Triangle& triangleAtIndex(size_t) const;
-
 private:
 	void printStructure(const Node&, const std::string&);
 
@@ -80,16 +83,18 @@ private:
 	void splitNodeUsingSortedArray(size_t, size_t);
 	void buildSplitBoxesUsingAxisAndPosition(size_t nodeIndex, int axis, float position);
 	void distributeTrianglesToChildren(size_t nodeIndex);
+	void packLeafTriangles();
 
 private:
 	BoundingBox _sceneBoundingBox;
 
 	Vector<Node> _nodes;
 	Vector<uint32_t> _indices;
-	Vector<IntersectionData> _intersectionData;
 	Vector<BoundingBox> _boundingBoxes;
+	TrianglePacketList _packets;
 
-	TriangleList _triangles;
+	const TriangleStorage* _triangles = nullptr;
+	size_t _trianglesCount = 0;
 	size_t _maxDepth = 0;
 	size_t _maxBuildDepth = 0;
 };
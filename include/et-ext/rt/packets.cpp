@@ -0,0 +1,361 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et-ext/rt/packets.h>
+
+#if (ET_SIMD_SSE)
+#	include <immintrin.h>
+#endif
+
+namespace et
+{
+namespace rt
+{
+
+namespace
+{
+
+/*
+ * Lanes wraps SIMD register of PacketWidth floats, masks are lanes with all bits set
+ */
+#if (ET_SIMD_SSE)
+
+struct Lanes
+{
+	using Type = __m128;
+
+	static Type load(const float* p) { return _mm_load_ps(p); }
+	static Type set(float v) { return _mm_set1_ps(v); }
+	static void store(float* p, Type a) { _mm_store_ps(p, a); }
+	static Type add(Type a, Type b) { return _mm_add_ps(a, b); }
+	static Type sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+	static Type mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+	static Type div(Type a, Type b) { return _mm_div_ps(a, b); }
+	static Type min(Type a, Type b) { return _mm_min_ps(a, b); }
+	static Type max(Type a, Type b) { return _mm_max_ps(a, b); }
+	static Type maskAnd(Type a, Type b) { return _mm_and_ps(a, b); }
+	static Type lessThan(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+	static Type lessOrEqual(Type a, Type b) { return _mm_cmple_ps(a, b); }
+	static Type notEqual(Type a, Type b) { return _mm_cmpneq_ps(a, b); }
+	static Type select(Type mask, Type a, Type b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static uint32_t toBits(Type mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+};
+
+#else
+
+struct Lanes
+{
+	struct Type
+	{
+		float f[PacketWidth];
+	};
+
+	template <class F>
+	static Type apply(Type a, Type b, F func)
+	{
+		Type result;
+		for (uint32_t i = 0; i < PacketWidth; ++i)
+			result.f[i] = func(a.f[i], b.f[i]);
+		return result;
+	}
+
+	static float fromBool(bool b)
+	{
+		uint32_t bits = b ? 0xffffffff : 0;
+		float result = 0.0f;
+		memcpy(&result, &bits, sizeof(float));
+		return result;
+	}
+
+	static bool toBool(float f)
+	{
+		uint32_t bits = 0;
+		memcpy(&bits, &f, sizeof(float));
+		return bits != 0;
+	}
+
+	static Type load(const float* p) { Type result; memcpy(result.f, p, sizeof(result.f)); return result; }
+	static Type set(float v) { Type result; std::fill(result.f, result.f + PacketWidth, v); return result; }
+	static void store(float* p, Type a) { memcpy(p, a.f, sizeof(a.f)); }
+	static Type add(Type a, Type b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+	static Type sub(Type a, Type b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+	static Type mul(Type a, Type b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+	static Type div(Type a, Type b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+	static Type min(Type a, Type b) { return apply(a, b, [](float x, float y) { return (x < y) ? x : y; }); }
+	static Type max(Type a, Type b) { return apply(a, b, [](float x, float y) { return (x > y) ? x : y; }); }
+	static Type maskAnd(Type a, Type b) { return apply(a, b, [](float x, float y) { return fromBool(toBool(x) && toBool(y)); }); }
+	static Type lessThan(Type a, Type b) { return apply(a, b, [](float x, float y) { return fromBool(x < y); }); }
+	static Type lessOrEqual(Type a, Type b) { return apply(a, b, [](float x, float y) { return fromBool(x <= y); }); }
+	static Type notEqual(Type a, Type b) { return apply(a, b, [](float x, float y) { return fromBool(!(x == y)); }); }
+
+	static Type select(Type mask, Type a, Type b)
+	{
+		Type result;
+		for (uint32_t i = 0; i < PacketWidth; ++i)
+			result.f[i] = toBool(mask.f[i]) ? a.f[i] : b.f[i];
+		return result;
+	}
+
+	static uint32_t toBits(Type mask)
+	{
+		uint32_t result = 0;
+		for (uint32_t i = 0; i < PacketWidth; ++i)
+			result |= toBool(mask.f[i]) ? (1u << i) : 0;
+		return result;
+	}
+};
+
+#endif
+
+using Lane = Lanes::Type;
+
+struct Vector3Lanes
+{
+	Lane x;
+	Lane y;
+	Lane z;
+
+	Vector3Lanes(const Lane& ax, const Lane& ay, const Lane& az) :
+		x(ax), y(ay), z(az) { }
+
+	Vector3Lanes(const float v[3][PacketWidth]) :
+		x(Lanes::load(v[0])), y(Lanes::load(v[1])), z(Lanes::load(v[2])) { }
+
+	Vector3Lanes(const float v[3][PacketWidth], uint32_t lane) :
+		x(Lanes::set(v[0][lane])), y(Lanes::set(v[1][lane])), z(Lanes::set(v[2][lane])) { }
+
+	explicit Vector3Lanes(const float4& v)
+	{
+		ET_ALIGNED(16) float f[4];
+		v.loadToFloats(f);
+		x = Lanes::set(f[0]);
+		y = Lanes::set(f[1]);
+		z = Lanes::set(f[2]);
+	}
+};
+
+inline Lane dot(const Vector3Lanes& a, const Vector3Lanes& b)
+{
+	return Lanes::add(Lanes::add(Lanes::mul(a.x, b.x), Lanes::mul(a.y, b.y)), Lanes::mul(a.z, b.z));
+}
+
+inline Vector3Lanes cross(const Vector3Lanes& a, const Vector3Lanes& b)
+{
+	return Vector3Lanes(
+		Lanes::sub(Lanes::mul(a.y, b.z), Lanes::mul(a.z, b.y)),
+		Lanes::sub(Lanes::mul(a.z, b.x), Lanes::mul(a.x, b.z)),
+		Lanes::sub(Lanes::mul(a.x, b.y), Lanes::mul(a.y, b.x)));
+}
+
+inline Vector3Lanes sub(const Vector3Lanes& a, const Vector3Lanes& b)
+{
+	return Vector3Lanes(Lanes::sub(a.x, b.x), Lanes::sub(a.y, b.y), Lanes::sub(a.z, b.z));
+}
+
+/*
+ * Moller-Trumbore intersection, lanes are either triangles (single ray) or rays (single triangle),
+ * returns mask of lanes with intersection in (epsilon, closest) and (epsilon, farthest]
+ */
+inline Lane intersectLanes(const Vector3Lanes& origin, const Vector3Lanes& direction, const Vector3Lanes& v0,
+	const Vector3Lanes& edge1to0, const Vector3Lanes& edge2to0, const Lane& closest, const Lane& farthest,
+	Lane& t, Lane& u, Lane& v)
+{
+	const Lane zero = Lanes::set(0.0f);
+	const Lane one = Lanes::set(1.0f);
+
+	Vector3Lanes pvec = cross(direction, edge2to0);
+	Lane det = dot(edge1to0, pvec);
+	Lane invDet = Lanes::div(one, det);
+
+	Vector3Lanes tvec = sub(origin, v0);
+	u = Lanes::mul(dot(tvec, pvec), invDet);
+
+	Vector3Lanes qvec = cross(tvec, edge1to0);
+	t = Lanes::mul(dot(edge2to0, qvec), invDet);
+	v = Lanes::mul(dot(direction, qvec), invDet);
+
+	Lane mask = Lanes::notEqual(det, zero);
+	mask = Lanes::maskAnd(mask, Lanes::lessOrEqual(zero, u));
+	mask = Lanes::maskAnd(mask, Lanes::lessOrEqual(u, one));
+	mask = Lanes::maskAnd(mask, Lanes::lessOrEqual(zero, v));
+	mask = Lanes::maskAnd(mask, Lanes::lessOrEqual(Lanes::add(u, v), one));
+	mask = Lanes::maskAnd(mask, Lanes::lessThan(Lanes::set(Constants::epsilon), t));
+	mask = Lanes::maskAnd(mask, Lanes::lessThan(t, closest));
+	return Lanes::maskAnd(mask, Lanes::lessOrEqual(t, farthest));
+}
+
+}
+
+uint32_t packTriangles(TrianglePacketList& packets, const TriangleStorage& triangles, const uint32_t* indices, uint32_t count)
+{
+	uint32_t firstPacket = static_cast<uint32_t>(packets.size());
+	packets.resize(packets.size() + packetsCount(count));
+
+	ET_ALIGNED(16) float v0[4];
+	ET_ALIGNED(16) float e1[4];
+	ET_ALIGNED(16) float e2[4];
+	for (uint32_t i = 0, e = packetsCount(count) * PacketWidth; i < e; ++i)
+	{
+		TrianglePacket& packet = packets[firstPacket + i / PacketWidth];
+		uint32_t lane = i % PacketWidth;
+		if (i < count)
+		{
+			float4 vertex0 = triangles.vertex(indices[i], 0);
+			vertex0.loadToFloats(v0);
+			(triangles.vertex(indices[i], 1) - vertex0).loadToFloats(e1);
+			(triangles.vertex(indices[i], 2) - vertex0).loadToFloats(e2);
+			packet.triangleIndex[lane] = indices[i];
+		}
+		else
+		{
+			std::fill(v0, v0 + 4, 0.0f);
+			std::fill(e1, e1 + 4, 0.0f);
+			std::fill(e2, e2 + 4, 0.0f);
+			packet.triangleIndex[lane] = InvalidIndex;
+		}
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			packet.v0[axis][lane] = v0[axis];
+			packet.edge1to0[axis][lane] = e1[axis];
+			packet.edge2to0[axis][lane] = e2[axis];
+		}
+	}
+	return firstPacket;
+}
+
+bool intersectTrianglePackets(const Ray& ray, const TrianglePacket* packets, uint32_t count, float maxDistance, PacketHit& hit)
+{
+	Vector3Lanes origin(ray.origin);
+	Vector3Lanes direction(ray.direction);
+	Lane farthest = Lanes::set(maxDistance);
+
+	ET_ALIGNED(16) float t[PacketWidth];
+	ET_ALIGNED(16) float u[PacketWidth];
+	ET_ALIGNED(16) float v[PacketWidth];
+
+	bool result = false;
+	for (const TrianglePacket* packet = packets, *end = packets + count; packet < end; ++packet)
+	{
+		Lane tLanes;
+		Lane uLanes;
+		Lane vLanes;
+		Lane mask = intersectLanes(origin, direction, Vector3Lanes(packet->v0), Vector3Lanes(packet->edge1to0),
+			Vector3Lanes(packet->edge2to0), Lanes::set(hit.distance), farthest, tLanes, uLanes, vLanes);
+
+		uint32_t bits = Lanes::toBits(mask);
+		if (bits == 0)
+			continue;
+
+		Lanes::store(t, tLanes);
+		Lanes::store(u, uLanes);
+		Lanes::store(v, vLanes);
+		do
+		{
+			uint32_t lane = findFirstSetBit(bits);
+			if (t[lane] < hit.distance)
+			{
+				hit.distance = t[lane];
+				hit.u = u[lane];
+				hit.v = v[lane];
+				hit.triangleIndex = packet->triangleIndex[lane];
+				result = true;
+			}
+			bits &= bits - 1;
+		}
+		while (bits != 0);
+	}
+	return result;
+}
+
+RayPacket::RayPacket(const Ray* rays, uint32_t aCount) :
+	count(aCount)
+{
+	ET_ASSERT((count > 0) && (count <= PacketWidth));
+
+	ET_ALIGNED(16) float o[4];
+	ET_ALIGNED(16) float d[4];
+	for (uint32_t lane = 0; lane < PacketWidth; ++lane)
+	{
+		const Ray& ray = rays[std::min(lane, count - 1)];
+		ray.origin.loadToFloats(o);
+		ray.direction.loadToFloats(d);
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			origin[axis][lane] = o[axis];
+			direction[axis][lane] = d[axis];
+			invDirection[axis][lane] = safeInverse(d[axis]);
+		}
+	}
+}
+
+PacketHits::PacketHits()
+{
+	std::fill(distance, distance + PacketWidth, std::numeric_limits<float>::max());
+	std::fill(u, u + PacketWidth, 0.0f);
+	std::fill(v, v + PacketWidth, 0.0f);
+	std::fill(triangleIndex, triangleIndex + PacketWidth, static_cast<uint32_t>(InvalidIndex));
+}
+
+uint32_t intersectBoundingBox(const RayPacket& rays, const float minVertex[3], const float maxVertex[3],
+	const PacketHits& hits, uint32_t activeMask)
+{
+	Lane tNear = Lanes::set(0.0f);
+	Lane tFar = Lanes::load(hits.distance);
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		Lane origin = Lanes::load(rays.origin[axis]);
+		Lane invDirection = Lanes::load(rays.invDirection[axis]);
+		Lane t0 = Lanes::mul(Lanes::sub(Lanes::set(minVertex[axis]), origin), invDirection);
+		Lane t1 = Lanes::mul(Lanes::sub(Lanes::set(maxVertex[axis]), origin), invDirection);
+		tNear = Lanes::max(Lanes::min(t0, t1), tNear);
+		tFar = Lanes::min(Lanes::max(t0, t1), tFar);
+	}
+	return Lanes::toBits(Lanes::lessOrEqual(tNear, tFar)) & activeMask;
+}
+
+void intersectTriangle(const RayPacket& rays, const TrianglePacket& packet, uint32_t lane, PacketHits& hits)
+{
+	Lane t;
+	Lane u;
+	Lane v;
+	Lane closest = Lanes::load(hits.distance);
+	Lane mask = intersectLanes(Vector3Lanes(rays.origin), Vector3Lanes(rays.direction), Vector3Lanes(packet.v0, lane),
+		Vector3Lanes(packet.edge1to0, lane), Vector3Lanes(packet.edge2to0, lane), closest,
+		Lanes::set(std::numeric_limits<float>::max()), t, u, v);
+
+	uint32_t bits = Lanes::toBits(mask);
+	if (bits == 0)
+		return;
+
+	Lanes::store(hits.distance, Lanes::select(mask, t, closest));
+	Lanes::store(hits.u, Lanes::select(mask, u, Lanes::load(hits.u)));
+	Lanes::store(hits.v, Lanes::select(mask, v, Lanes::load(hits.v)));
+	do
+	{
+		hits.triangleIndex[findFirstSetBit(bits)] = packet.triangleIndex[lane];
+		bits &= bits - 1;
+	}
+	while (bits != 0);
+}
+
+TraverseResult packetHitToTraverseResult(const RayPacket& rays, const PacketHits& hits, uint32_t lane)
+{
+	TraverseResult result;
+	result.triangleIndex = hits.triangleIndex[lane];
+	if (result.triangleIndex != InvalidIndex)
+	{
+		float d = hits.distance[lane];
+		result.intersectionPoint = float4(rays.origin[0][lane] + rays.direction[0][lane] * d,
+			rays.origin[1][lane] + rays.direction[1][lane] * d, rays.origin[2][lane] + rays.direction[2][lane] * d, 1.0f);
+		result.intersectionPointBarycentric = float4(1.0f - hits.u[lane] - hits.v[lane], hits.u[lane], hits.v[lane], 0.0f);
+	}
+	return result;
+}
+
+}
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et-ext/rt/trianglestorage.h>
+
+namespace et {
+namespace rt {
+
+/*
+ * Width of the packets matches SSE register, layout is fixed at compile time,
+ * so wider instruction sets (which are only available via runtime dispatch) are not used
+ */
+enum : uint32_t
+{
+	PacketWidth = 4,
+	PacketMask = (1u << PacketWidth) - 1
+};
+
+/*
+ * Triangles in structure-of-arrays layout, single ray is tested against all lanes at once.
+ * Unused lanes contain degenerate triangles with InvalidIndex
+ */
+struct ET_ALIGNED(16) TrianglePacket
+{
+	float v0[3][PacketWidth];
+	float edge1to0[3][PacketWidth];
+	float edge2to0[3][PacketWidth];
+	uint32_t triangleIndex[PacketWidth];
+};
+using TrianglePacketList = Vector<TrianglePacket>;
+
+/*
+ * zero direction components are replaced with tiny values, so ray lying in the plane
+ * of the bounding box face gives finite distances instead of NaN (0 * inf)
+ */
+inline float safeInverse(float d)
+{
+	const float minValue = 1.0e-20f;
+	return 1.0f / ((std::abs(d) < minValue) ? std::copysign(minValue, d) : d);
+}
+
+inline uint32_t packetsCount(uint32_t trianglesCount)
+{
+	return (trianglesCount + PacketWidth - 1) / PacketWidth;
+}
+
+/*
+ * appends packetsCount(count) packets, built from triangles[indices[i]], returns index of the first one
+ */
+uint32_t packTriangles(TrianglePacketList&, const TriangleStorage&, const uint32_t* indices, uint32_t count);
+
+struct ET_ALIGNED(16) PacketHit
+{
+	float distance = std::numeric_limits<float>::max();
+	float u = 0.0f;
+	float v = 0.0f;
+	uint32_t triangleIndex = InvalidIndex;
+};
+
+/*
+ * looks for intersection closer than hit.distance and not farther than maxDistance,
+ * returns true and updates hit if one was found
+ */
+bool intersectTrianglePackets(const Ray&, const TrianglePacket* packets, uint32_t count, float maxDistance, PacketHit& hit);
+
+/*
+ * Coherent rays (e.g. primary rays of the same pixel) in structure-of-arrays layout,
+ * traversed together through the acceleration structure
+ */
+struct ET_ALIGNED(16) RayPacket
+{
+	float origin[3][PacketWidth];
+	float direction[3][PacketWidth];
+	float invDirection[3][PacketWidth];
+	uint32_t count = 0;
+
+	/*
+	 * count should not exceed PacketWidth, unused lanes repeat the last ray
+	 */
+	RayPacket(const Ray* rays, uint32_t count);
+};
+
+struct ET_ALIGNED(16) PacketHits
+{
+	float distance[PacketWidth];
+	float u[PacketWidth];
+	float v[PacketWidth];
+	uint32_t triangleIndex[PacketWidth];
+
+	PacketHits();
+};
+
+/*
+ * returns bit mask of active rays, which intersect box closer than their current hit distances
+ */
+uint32_t intersectBoundingBox(const RayPacket&, const float minVertex[3], const float maxVertex[3],
+	const PacketHits&, uint32_t activeMask);
+
+/*
+ * intersects all rays of the packet with triangle at the lane of triangle packet, updates closer hits
+ */
+void intersectTriangle(const RayPacket&, const TrianglePacket&, uint32_t lane, PacketHits&);
+
+/*
+ * fills traverse result for the ray at the lane (intersection point and barycentric coordinates)
+ */
+TraverseResult packetHitToTraverseResult(const RayPacket&, const PacketHits&, uint32_t lane);
+
+}
+}
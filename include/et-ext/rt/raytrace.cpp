@@ -5,8 +5,9 @@
  *
  */
 
-#include <thread>
 #include <mutex>
+#include <thread>
+#include <et/core/jobsystem.h>
 #include <et-ext/rt/raytrace.h>
 #include <et-ext/rt/raytraceobjects.h>
 #include <et-ext/rt/reconstruction.h>
@@ -25,14 +26,13 @@ public:
 	RaytracePrivate(Raytrace* owner);
 	~RaytracePrivate();
 
-	void backwardPathTraceThreadFunction(uint32_t index);
 	void forwardPathTraceThreadFunction(uint32_t index);
 	void visualizeDistributionThreadFunction(uint32_t index);
 	void visualizeSamplerThreadFunction(uint32_t index);
 
-	void emitWorkerThreads();
+	void emitWorkerJobs();
 	void waitForCompletion();
-	void stopWorkerThreads();
+	void stopWorkerJobs();
 
 	void buildScene(const s3d::Scene::Pointer&);	
 
@@ -40,8 +40,17 @@ public:
 	void estimateRegionsOrder();
 
 	vec4 raytracePixel(const vec2i&, uint32_t samples, uint32_t& bounces);
-
-	Region getNextRegion();
+	void samplePixel(const vec2i&, uint32_t samples, uint32_t& bounces, PixelStatistics&);
+	bool pixelNeedsSamples(const PixelStatistics&) const;
+	uint32_t maxSamplesPerPixel() const;
+	uint32_t planAdaptivePass(uint32_t renderedSamples);
+
+	void scheduleRegion(const Region&);
+	void renderRegion(Region);
+	bool shouldSplitRegion(uint64_t elapsedTime, int32_t renderedRows, int32_t remainingRows, int32_t width);
+	void finishPass();
+	uint32_t schedulePassRegions();
+	void outputSampleCountHeatmap();
 
 	void renderSpacePartitioning();
 	void renderKDTreeRecursive(uint32_t nodeIndex, uint32_t index);
@@ -62,24 +71,30 @@ public:
 	EvaluateFunction evaluateFunction = nullptr;
 	Camera camera;
 
+	JobCounter workerJobs;
 	Vector<std::thread> workerThreads;
 
 	Map<uint32_t, uint32_t> lightTriangleToIndex;
 	Vector<Region> regions;
 	Vector<float4> forwardTraceBuffer;
+	Vector<PixelStatistics> pixelStatistics;
 	TriangleList lightTriangles;
 
-	std::mutex regionsLock;
 	std::mutex forwardTraceBufferMutex;
 	std::atomic<bool> running{false};
-	std::atomic<uint32_t> threadCounter{0};
+	std::atomic<uint32_t> pendingRegions{0};
+	std::atomic<uint32_t> queuedRegions{0};
 	std::atomic<uint32_t> processedRegions{0};
+	std::atomic<uint64_t> processedSamples{0};
 	std::atomic<uint64_t> startTime{0};
 	std::atomic<uint64_t> minTimePerRegion{0};
 	std::atomic<uint64_t> maxTimePerRegion{0};
 	std::atomic<uint64_t> totalTimePerRegions{0};
+	std::atomic<uint64_t> tracedRays{0};
 
-	uint32_t totalRegions = 0;
+	uint32_t passFirstSample = 0;
+	uint32_t passSamples = 0;
+	float adaptiveErrorCutoff = 0.0f;
 	uint32_t flushCounter = 0;
 	vec2i viewportSize;
 	vec2i regionSize;
@@ -107,7 +122,7 @@ void Raytrace::perform(s3d::Scene::Pointer scene, const vec2i& dimension)
 	ET_ASSERT(_private->viewportSize.y > 0);
 
 	_private->buildRegions(vec2i(static_cast<int>(_private->scene.options.renderRegionSize)));
-	_private->emitWorkerThreads();
+	_private->emitWorkerJobs();
 }
 
 void Raytrace::waitForCompletion()
@@ -131,7 +146,7 @@ vec4 Raytrace::performAtPoint(const vec2i& pixel)
 
 void Raytrace::stop()
 {
-	_private->stopWorkerThreads();
+	_private->stopWorkerJobs();
 }
 
 void Raytrace::setOptions(const Options& options)
@@ -162,20 +177,28 @@ bool Raytrace::running() const
 void Raytrace::reportProgress()
 {
 	uint32_t processedRegions = _private->processedRegions.load();
-	if (processedRegions == 0)
+	uint64_t processedSamples = _private->processedSamples.load();
+	if ((processedRegions == 0) || (processedSamples == 0))
 		return;
 
+	/*
+	 * regions are split while rendering and revisited by progressive passes,
+	 * so progress is measured in samples
+	 */
+	uint64_t totalSamples = static_cast<uint64_t>(_private->viewportSize.square()) * _private->scene.options.raysPerPixel;
 	uint64_t elapsedTime = queryContiniousTimeInMilliSeconds() - _private->startTime;
 	uint64_t minTime = _private->minTimePerRegion.load();
 	uint64_t maxTime = _private->maxTimePerRegion.load();
 	uint64_t avgTime = elapsedTime / processedRegions;
-	uint64_t remTime = (_private->totalRegions - processedRegions) * avgTime;
+	uint64_t remTime = (totalSamples > processedSamples) ? elapsedTime * (totalSamples - processedSamples) / processedSamples : 0;
+	double raysPerMillisecond = static_cast<double>(_private->tracedRays.load()) / static_cast<double>(std::max(elapsedTime, uint64_t(1)));
 
-	log::info("[%s] region %3u / %3u, min: %llu.%03llu, max: %llu.%03llu, avg: %llu.%03llu, remaining: %llu.%03llu",
+	log::info("[%s] %5.1f%%, %u spp, %3u regions, min: %llu.%03llu, max: %llu.%03llu, avg: %llu.%03llu, remaining: %llu.%03llu, %.2f Mrays/s",
 		floatToTimeStr(static_cast<float>(elapsedTime) / 1000.0f, false).c_str(),
-		processedRegions, _private->totalRegions,
+		100.0 * static_cast<double>(processedSamples) / static_cast<double>(totalSamples),
+		_private->passFirstSample + _private->passSamples, processedRegions,
 		minTime / 1000, minTime % 1000, maxTime / 1000, maxTime % 1000,
-		avgTime / 1000, avgTime % 1000, remTime / 1000, remTime % 1000);
+		avgTime / 1000, avgTime % 1000, remTime / 1000, remTime % 1000, raysPerMillisecond / 1000.0);
 }
 
 
@@ -189,15 +212,18 @@ RaytracePrivate::RaytracePrivate(Raytrace* o) :
 
 RaytracePrivate::~RaytracePrivate()
 {
-	stopWorkerThreads();
+	stopWorkerJobs();
 }
 
-void RaytracePrivate::emitWorkerThreads()
+void RaytracePrivate::emitWorkerJobs()
 {
 	srand(static_cast<unsigned int>(time(nullptr)));
 	startTime = queryContiniousTimeInMilliSeconds();
 	minTimePerRegion.store(std::numeric_limits<uint64_t>::max());
 	maxTimePerRegion.store(0);
+	tracedRays.store(0);
+	processedRegions.store(0);
+	processedSamples.store(0);
 
 	forwardTraceBuffer.clear();
 	forwardTraceBuffer.resize(viewportSize.square());
@@ -211,37 +237,71 @@ void RaytracePrivate::emitWorkerThreads()
 
 	if (scene.options.threads == 0)
 	{
-		scene.options.threads = std::thread::hardware_concurrency();
+		scene.options.threads = static_cast<uint32_t>(std::max(size_t(1), sharedJobSystem().workersCount()));
 	}
 
-	threadCounter.store(scene.options.threads);
+	/*
+	 * backward tracing splits image into regions, rendered as separate jobs,
+	 * other methods run until stopped, so they are using own threads
+	 * instead of occupying workers of the shared job system
+	 */
+#if (ET_RT_EVALUATE_DISTRIBUTION || ET_RT_EVALUATE_SAMPLER)
+	bool renderRegions = false;
+#else
+	bool renderRegions = (scene.options.method != RaytraceMethod::ForwardLightTracing);
+#endif
+
+	if (renderRegions)
+	{
+		/*
+		 * adaptive sampling starts with minimal amount of samples per pixel,
+		 * further passes are sampling only pixels with relative error above threshold
+		 */
+		bool adaptiveSampling = (scene.options.adaptiveSamplingThreshold > 0.0f);
+		adaptiveErrorCutoff = 0.0f;
+		passFirstSample = 0;
+		passSamples = scene.options.raysPerPixel;
+		if (adaptiveSampling)
+			passSamples = std::min(scene.options.minRaysPerPixel, scene.options.raysPerPixel);
+		else if (scene.options.progressiveRendering)
+			passSamples = 1;
+
+		pixelStatistics.clear();
+		if (adaptiveSampling || scene.options.progressiveRendering)
+			pixelStatistics.resize(viewportSize.square());
+
+		for (const Region& region : regions)
+			scheduleRegion(region);
+		return;
+	}
+
+	ET_ASSERT(workerThreads.empty());
+	workerThreads.reserve(scene.options.threads);
 	for (uint32_t i = 0; i < scene.options.threads; ++i)
 	{
-#   if (ET_RT_EVALUATE_DISTRIBUTION)
-		workerThreads.emplace_back(&RaytracePrivate::visualizeDistributionThreadFunction, this, i);
-#	elif (ET_RT_EVALUATE_SAMPLER)
-		workerThreads.emplace_back(&RaytracePrivate::visualizeSamplerThreadFunction, this, i);
-#	else
-		if (scene.options.method == RaytraceMethod::ForwardLightTracing)
+		workerThreads.emplace_back([this, i]()
 		{
-			workerThreads.emplace_back(&RaytracePrivate::forwardPathTraceThreadFunction, this, i);
-		}
-		else
-		{
-			workerThreads.emplace_back(&RaytracePrivate::backwardPathTraceThreadFunction, this, i);
-		}
-#   endif
+#		if (ET_RT_EVALUATE_DISTRIBUTION)
+			visualizeDistributionThreadFunction(i);
+#		elif (ET_RT_EVALUATE_SAMPLER)
+			visualizeSamplerThreadFunction(i);
+#		else
+			forwardPathTraceThreadFunction(i);
+#		endif
+		});
 	}
 }
 
 void RaytracePrivate::waitForCompletion()
 {
-	for (auto& t : workerThreads)
-		t.join();
+	sharedJobSystem().wait(workerJobs);
+
+	for (std::thread& thread : workerThreads)
+		thread.join();
 	workerThreads.clear();
 }
 
-void RaytracePrivate::stopWorkerThreads()
+void RaytracePrivate::stopWorkerJobs()
 {
 	running = false;
 	waitForCompletion();
@@ -272,7 +332,6 @@ void RaytracePrivate::buildScene(const s3d::Scene::Pointer& input)
 
 void RaytracePrivate::buildRegions(const vec2i& aSize)
 {
-	std::unique_lock<std::mutex> lock(regionsLock);
 	regions.clear();
 
 	regionSize = aSize;
@@ -325,22 +384,13 @@ void RaytracePrivate::buildRegions(const vec2i& aSize)
 		}
 	}
 
-	totalRegions = static_cast<uint32_t>(regions.size());
-	processedRegions.store(0);
-}
-
-Region RaytracePrivate::getNextRegion()
-{
-	std::unique_lock<std::mutex> lock(regionsLock);
-	for (auto& rgn : regions)
+	/*
+	 * neighbour regions are rendered one after another, so they share cached scene data
+	 */
+	std::sort(regions.begin(), regions.end(), [this](const Region& l, const Region& r)
 	{
-		if (rgn.sampled == false)
-		{
-			rgn.sampled = true;
-			return rgn;
-		}
-	}
-	return Region();
+		return mortonCode(l.origin / regionSize) < mortonCode(r.origin / regionSize);
+	});
 }
 
 /*
@@ -535,13 +585,13 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 	float4 cameraDir(-camera.direction(), 0.0f);
 	vec3 viewport = vector3ToFloat(vec3i(viewportSize, 0));
 
-	auto projectToCamera = [&](const Ray& inRay, const KDTree::TraverseResult& hit,
+	auto projectToCamera = [&](const Ray& inRay, const TraverseResult& hit,
 		const float4& color, const float4& nrm)
 	{
 		float4 toCamera = cameraPos - hit.intersectionPoint;
 		toCamera.normalize();
 
-		const auto& tri = scene.kdTree.triangleAtIndex(hit.triangleIndex);
+		Triangle tri = scene.triangleAtIndex(hit.triangleIndex);
 		const auto& mat = scene.materials[tri.materialIndex];
 		float4 uv0 = tri.interpolatedTexCoord0(hit.intersectionPointBarycentric);
 		BSDFSample sample(inRay.direction, toCamera, nrm, mat, uv0, BSDFSample::Direction::Forward);
@@ -553,7 +603,7 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 		if ((projected.x * projected.x > 1.0f) || (projected.y * projected.y > 1.0f) || (projected.z * projected.z > 1.0f))
 			return;
 
-		auto backHit = scene.kdTree.traverse(Ray(cameraPos, sample.Wo * (-1.0f)));
+		auto backHit = scene.traverse(Ray(cameraPos, sample.Wo * (-1.0f)));
 		if (backHit.triangleIndex != hit.triangleIndex)
 			return;
 
@@ -579,12 +629,13 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 
 	while (running)
 	{
+		uint64_t threadRays = Scene::threadTracedRays();
 		for (uint32_t ir = 0; running && (ir < raysPerIteration); ++ir)
 		{
 			uint32_t emitterIndex = rand() % lightTriangles.size();
 			const auto& emitterTriangle = lightTriangles[emitterIndex];
 
-			KDTree::TraverseResult source;
+			TraverseResult source;
 			source.intersectionPointBarycentric = randomBarycentric();
 			source.intersectionPoint = emitterTriangle.interpolatedPosition(source.intersectionPointBarycentric);
 			source.triangleIndex = lightTriangleToIndex[emitterIndex];
@@ -603,13 +654,13 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 
 			for (uint32_t pathLength = 0; pathLength < scene.options.maxPathLength; ++pathLength)
 			{
-				auto hit = scene.kdTree.traverse(currentRay);
+				auto hit = scene.traverse(currentRay);
 				if (hit.triangleIndex == InvalidIndex)
 				{
 					break;
 				}
 
-				const auto& tri = scene.kdTree.triangleAtIndex(hit.triangleIndex);
+				Triangle tri = scene.triangleAtIndex(hit.triangleIndex);
 				const auto& mat = scene.materials[tri.materialIndex];
 
 				if (mat.emissive.dotSelf() > 0.0f)
@@ -634,6 +685,7 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 			}
 		}
 
+		tracedRays += Scene::threadTracedRays() - threadRays;
 		log::info("Iteration finished");
 		flushToForwardTraceBuffer(localBuffer);
 		std::fill(localBuffer.begin(), localBuffer.end(), float4(0.0f));
@@ -641,88 +693,285 @@ void RaytracePrivate::forwardPathTraceThreadFunction(uint32_t threadId)
 	log::info("Thread finished");
 }
 
-void RaytracePrivate::backwardPathTraceThreadFunction(uint32_t threadId)
+void RaytracePrivate::scheduleRegion(const Region& region)
 {
-	DataStorage<vec4> localData(sqr(scene.options.renderRegionSize), 0);
+	++pendingRegions;
+	++queuedRegions;
+	sharedJobSystem().schedule([this, region]() { renderRegion(region); }, &workerJobs);
+}
 
-	while (running)
-	{
-		auto region = getNextRegion();
-		if (region.sampled == false)
-			break;
+/*
+ * region is split (remaining rows are halved and the lower half is scheduled as a new job)
+ * when there are no more queued regions, so idle workers could steal part of it,
+ * or when it is much more expensive than an average region (e.g. glass or lights)
+ */
+bool RaytracePrivate::shouldSplitRegion(uint64_t elapsedTime, int32_t renderedRows, int32_t remainingRows, int32_t width)
+{
+	const int32_t minRowsToSplit = 8;
+	const double expensiveRegionFactor = 4.0;
+
+	if (remainingRows < minRowsToSplit)
+		return false;
+
+	if (queuedRegions.load() == 0)
+		return true;
+
+	uint64_t samples = processedSamples.load();
+	if ((renderedRows == 0) || (samples == 0))
+		return false;
+
+	double timePerSample = static_cast<double>(totalTimePerRegions.load()) / static_cast<double>(samples);
+	double expectedTime = timePerSample * static_cast<double>(remainingRows * width) * static_cast<double>(passSamples);
+	double projectedTime = static_cast<double>(elapsedTime * remainingRows) / static_cast<double>(renderedRows);
+	return projectedTime > expensiveRegionFactor * expectedTime;
+}
+
+void RaytracePrivate::renderRegion(Region region)
+{
+	--queuedRegions;
 
+	if (running)
+	{
 		uint64_t runTime = queryContiniousTimeInMilliSeconds();
+		uint64_t threadRays = Scene::threadTracedRays();
 
 		vec2i pixel;
-		for (pixel.y = region.origin.y; pixel.y < region.origin.y + region.size.y; ++pixel.y)
+		if (passFirstSample == 0)
 		{
-			owner->_outputMethod(vec2i(region.origin.x, pixel.y), vec4(1.0f, 0.0f, 0.0f, 1.0f));
-			owner->_outputMethod(vec2i(region.origin.x + region.size.x - 1, pixel.y), vec4(1.0f, 0.0f, 0.0f, 1.0f));
-		}
-		for (pixel.x = region.origin.x; pixel.x < region.origin.x + region.size.x; ++pixel.x)
-		{
-			owner->_outputMethod(vec2i(pixel.x, region.origin.y), vec4(1.0f, 0.0f, 0.0f, 1.0f));
-			owner->_outputMethod(vec2i(pixel.x, region.origin.y + region.size.y - 1), vec4(1.0f, 0.0f, 0.0f, 1.0f));
+			for (pixel.y = region.origin.y; pixel.y < region.origin.y + region.size.y; ++pixel.y)
+			{
+				owner->_outputMethod(vec2i(region.origin.x, pixel.y), vec4(1.0f, 0.0f, 0.0f, 1.0f));
+				owner->_outputMethod(vec2i(region.origin.x + region.size.x - 1, pixel.y), vec4(1.0f, 0.0f, 0.0f, 1.0f));
+			}
+			for (pixel.x = region.origin.x; pixel.x < region.origin.x + region.size.x; ++pixel.x)
+			{
+				owner->_outputMethod(vec2i(pixel.x, region.origin.y), vec4(1.0f, 0.0f, 0.0f, 1.0f));
+				owner->_outputMethod(vec2i(pixel.x, region.origin.y + region.size.y - 1), vec4(1.0f, 0.0f, 0.0f, 1.0f));
+			}
 		}
 
-		uint32_t k = 0;
-		for (pixel.y = region.origin.y; running && (pixel.y < region.origin.y + region.size.y); ++pixel.y)
+		Vector<vec4> rowColors(region.size.x);
+		uint64_t regionSamples = 0;
+		int32_t endRow = region.origin.y + region.size.y;
+		for (pixel.y = region.origin.y; running && (pixel.y < endRow); ++pixel.y)
 		{
-			for (pixel.x = region.origin.x; running && (pixel.x < region.origin.x + region.size.x); ++pixel.x)
+			uint64_t elapsedTime = queryContiniousTimeInMilliSeconds() - runTime;
+			if (shouldSplitRegion(elapsedTime, pixel.y - region.origin.y, endRow - pixel.y, region.size.x))
 			{
-				uint32_t bounces = 0;
-				localData[k++] = raytracePixel(pixel, scene.options.raysPerPixel, bounces);
+				Region lowerPart;
+				lowerPart.origin = vec2i(region.origin.x, pixel.y + (endRow - pixel.y) / 2);
+				lowerPart.size = vec2i(region.size.x, endRow - lowerPart.origin.y);
+				scheduleRegion(lowerPart);
+				endRow = lowerPart.origin.y;
 			}
-		}
 
-		k = 0;
-		for (pixel.y = region.origin.y; running && (pixel.y < region.origin.y + region.size.y); ++pixel.y)
-		{
 			for (pixel.x = region.origin.x; running && (pixel.x < region.origin.x + region.size.x); ++pixel.x)
 			{
-				owner->_outputMethod(pixel, localData[k++]);
+				PixelStatistics localStatistics;
+				PixelStatistics& statistics = pixelStatistics.empty() ?
+					localStatistics : pixelStatistics[pixel.x + pixel.y * viewportSize.x];
+
+				if (pixelNeedsSamples(statistics))
+				{
+					uint32_t bounces = 0;
+					samplePixel(pixel, passSamples, bounces, statistics);
+					regionSamples += passSamples;
+				}
+				rowColors[pixel.x - region.origin.x] = vec4(statistics.mean.xyz(), 1.0f);
 			}
+
+			for (pixel.x = region.origin.x; running && (pixel.x < region.origin.x + region.size.x); ++pixel.x)
+				owner->_outputMethod(pixel, rowColors[pixel.x - region.origin.x]);
 		}
+		region.size.y = endRow - region.origin.y;
 
 		uint64_t regionTime = queryContiniousTimeInMilliSeconds() - runTime;
 		minTimePerRegion = std::min(minTimePerRegion.load(), regionTime);
 		maxTimePerRegion = std::max(maxTimePerRegion.load(), regionTime);
 		totalTimePerRegions += regionTime;
+		tracedRays += Scene::threadTracedRays() - threadRays;
+		processedSamples += regionSamples;
 		++processedRegions;
 	}
 
-	--threadCounter;
+	if (--pendingRegions == 0)
+		finishPass();
+}
 
-	if (threadCounter.load() == 0)
+/*
+ * called by the last finished region of the pass, in progressive mode each pass doubles
+ * samples per pixel until options.raysPerPixel is reached, in adaptive mode see planAdaptivePass;
+ * regions without pixels, which need more samples, are skipped
+ */
+void RaytracePrivate::finishPass()
+{
+	bool adaptiveSampling = (scene.options.adaptiveSamplingThreshold > 0.0f);
+	uint32_t renderedSamples = passFirstSample + passSamples;
+	if (running && (renderedSamples < maxSamplesPerPixel()))
 	{
-		running = false;
+		owner->reportProgress();
+		passFirstSample = renderedSamples;
+		passSamples = adaptiveSampling ? planAdaptivePass(renderedSamples) :
+			std::min(renderedSamples, scene.options.raysPerPixel - renderedSamples);
 
-		if (scene.options.renderKDTree)
-			renderSpacePartitioning();
+		if ((passSamples > 0) && (schedulePassRegions() > 0))
+			return;
+	}
 
-		owner->reportProgress();
-		owner->renderFinished.invokeInMainRunLoop();
+	running = false;
+
+	if (adaptiveSampling)
+	{
+		log::info("Adaptive sampling finished: %.2f samples per pixel on average (%u budget), %u max",
+			static_cast<double>(processedSamples.load()) / static_cast<double>(viewportSize.square()),
+			scene.options.raysPerPixel, maxSamplesPerPixel());
+	}
+
+	if (owner->_sampleCountOutputMethod && !pixelStatistics.empty())
+		outputSampleCountHeatmap();
+
+	if (scene.options.renderKDTree && (scene.options.accelerationStructure == AccelerationStructure::KDTree))
+		renderSpacePartitioning();
+
+	owner->reportProgress();
+	owner->renderFinished.invokeInMainRunLoop();
+}
+
+/*
+ * schedules regions which contain at least one pixel, which needs samples in the current pass
+ */
+uint32_t RaytracePrivate::schedulePassRegions()
+{
+	uint32_t scheduledRegions = 0;
+	for (const Region& region : regions)
+	{
+		bool needsSamples = false;
+		for (int32_t y = region.origin.y; !needsSamples && (y < region.origin.y + region.size.y); ++y)
+		{
+			for (int32_t x = region.origin.x; !needsSamples && (x < region.origin.x + region.size.x); ++x)
+				needsSamples = pixelNeedsSamples(pixelStatistics[x + y * viewportSize.x]);
+		}
+
+		if (needsSamples)
+		{
+			scheduleRegion(region);
+			++scheduledRegions;
+		}
+	}
+	return scheduledRegions;
+}
+
+/*
+ * pixels with relative error above threshold (and above cutoff of the pass, when budget is not enough
+ * for all of them) are sampled, without adaptive sampling pixels are sampled once per pass
+ */
+bool RaytracePrivate::pixelNeedsSamples(const PixelStatistics& statistics) const
+{
+	if (statistics.samples < passFirstSample + passSamples)
+	{
+		if ((statistics.samples < scene.options.minRaysPerPixel) || (scene.options.adaptiveSamplingThreshold <= 0.0f))
+			return true;
+
+		float error = statistics.relativeError();
+		return (error > scene.options.adaptiveSamplingThreshold) && (error >= adaptiveErrorCutoff);
+	}
+	return false;
+}
+
+/*
+ * options.raysPerPixel is the average amount of samples per pixel, in adaptive mode
+ * samples saved on converged pixels are given to noisy ones, up to options.maxRaysPerPixel
+ */
+uint32_t RaytracePrivate::maxSamplesPerPixel() const
+{
+	return (scene.options.adaptiveSamplingThreshold > 0.0f) ?
+		std::max(scene.options.maxRaysPerPixel, scene.options.raysPerPixel) : scene.options.raysPerPixel;
+}
+
+/*
+ * each adaptive pass adds a quarter of samples rendered so far to the pixels above threshold,
+ * while frame budget (options.raysPerPixel for every pixel) is not spent;
+ * when remaining budget is not enough for all of them, fewer samples are added,
+ * down to one sample for the noisiest pixels only; returns 0 when rendering should stop
+ */
+uint32_t RaytracePrivate::planAdaptivePass(uint32_t renderedSamples)
+{
+	uint64_t frameBudget = static_cast<uint64_t>(viewportSize.square()) * scene.options.raysPerPixel;
+	uint64_t spentSamples = processedSamples.load();
+	if (spentSamples >= frameBudget)
+		return 0;
+
+	Vector<float> errors;
+	float threshold = scene.options.adaptiveSamplingThreshold;
+	for (const PixelStatistics& statistics : pixelStatistics)
+	{
+		float error = statistics.relativeError();
+		if ((statistics.samples < scene.options.minRaysPerPixel) || (error > threshold))
+			errors.push_back(error);
+	}
+
+	if (errors.empty())
+		return 0;
+
+	uint64_t remainingBudget = frameBudget - spentSamples;
+	uint64_t pixelsToSample = errors.size();
+	uint32_t samples = std::min(std::max(1u, renderedSamples / 4), maxSamplesPerPixel() - renderedSamples);
+	adaptiveErrorCutoff = 0.0f;
+
+	if (pixelsToSample * samples > remainingBudget)
+	{
+		samples = static_cast<uint32_t>(std::max(uint64_t(1), remainingBudget / pixelsToSample));
+		if (pixelsToSample > remainingBudget)
+		{
+			auto last = errors.begin() + static_cast<ptrdiff_t>(remainingBudget - 1);
+			std::nth_element(errors.begin(), last, errors.end(), std::greater<float>());
+			adaptiveErrorCutoff = *last;
+		}
+	}
+	return samples;
+}
+
+/*
+ * outputs amount of samples per pixel to the sample count output: from blue (no samples) to red (max samples per pixel)
+ */
+void RaytracePrivate::outputSampleCountHeatmap()
+{
+	float scale = 1.0f / static_cast<float>(std::max(1u, maxSamplesPerPixel()));
+
+	vec2i pixel;
+	for (pixel.y = 0; pixel.y < viewportSize.y; ++pixel.y)
+	{
+		for (pixel.x = 0; pixel.x < viewportSize.x; ++pixel.x)
+		{
+			const PixelStatistics& statistics = pixelStatistics[pixel.x + pixel.y * viewportSize.x];
+			float t = clamp(static_cast<float>(statistics.samples) * scale, 0.0f, 1.0f);
+			vec4 color(clamp(2.0f * t - 0.5f, 0.0f, 1.0f), 1.0f - std::abs(2.0f * t - 1.0f), clamp(1.5f - 2.0f * t, 0.0f, 1.0f), 1.0f);
+			owner->_sampleCountOutputMethod(pixel, color);
+		}
 	}
 }
 
 vec4 RaytracePrivate::raytracePixel(const vec2i& intCoord, uint32_t samples, uint32_t& bounces)
+{
+	PixelStatistics statistics;
+	samplePixel(intCoord, samples, bounces, statistics);
+	return vec4(statistics.mean.xyz(), 1.0f);
+}
+
+void RaytracePrivate::samplePixel(const vec2i& intCoord, uint32_t samples, uint32_t& bounces, PixelStatistics& statistics)
 {
 	if (evaluateFunction == nullptr)
 	{
 		ET_FAIL("Integrator is not set");
-		return vec4(0.0f);
+		return;
 	}
 
-	float4 result(0.0f);
-	float weight = 0.0f;
 	vec2 pixelSize = vec2(1.0f) / vector2ToFloat(viewportSize);
 	vec2 baseCoordinate = vector2ToFloat(intCoord);
 
 	uint32_t rndOffset = static_cast<uint32_t>(intCoord.x + intCoord.x * intCoord.y);
 
-	Evaluate eval;
-	eval.totalRayCount = samples;
-	for (eval.rayIndex = 0; eval.rayIndex < eval.totalRayCount; ++eval.rayIndex)
+	auto generatePrimaryRay = [&]() -> Ray
 	{
 		vec2 normalizedCoordinate = 2.0f * (baseCoordinate) * pixelSize - vec2(1.0f);
 		ray3d baseRay = camera.castRay(normalizedCoordinate);
@@ -738,14 +987,46 @@ vec4 RaytracePrivate::raytracePixel(const vec2i& intCoord, uint32_t samples, uin
 
 		vec3 shiftedOrigin = camera.position() + uOffset * uScale + vOffset * vScale;
 		vec3 shiftedDirection = (focalPoint - shiftedOrigin).normalize();
+		return Ray(ray3d(shiftedOrigin, shiftedDirection));
+	};
+
+	/*
+	 * primary rays of the pixel are coherent, so they could be traversed as packets,
+	 * integrators continue from the found intersections
+	 */
+	ET_ALIGNED(16) Ray primaryRays[PacketWidth];
+	ET_ALIGNED(16) TraverseResult primaryHits[PacketWidth];
+	uint32_t packetBegin = 0;
+	uint32_t packetEnd = 0;
+
+	Evaluate eval;
+	eval.totalRayCount = statistics.samples + samples;
+	for (eval.rayIndex = statistics.samples; eval.rayIndex < eval.totalRayCount; ++eval.rayIndex)
+	{
+		Ray primaryRay;
+		if (scene.options.primaryRayPackets)
+		{
+			if (eval.rayIndex >= packetEnd)
+			{
+				packetBegin = eval.rayIndex;
+				packetEnd = std::min(eval.totalRayCount, packetBegin + PacketWidth);
+				for (uint32_t i = 0; i < packetEnd - packetBegin; ++i)
+					primaryRays[i] = generatePrimaryRay();
+				scene.traverse(RayPacket(primaryRays, packetEnd - packetBegin), primaryHits);
+			}
+			primaryRay = primaryRays[eval.rayIndex - packetBegin];
+			eval.primaryHit = primaryHits + (eval.rayIndex - packetBegin);
+		}
+		else
+		{
+			primaryRay = generatePrimaryRay();
+		}
 
-		float w = 1.0f;
 		eval.rayIndex += rndOffset;
-		result += evaluateFunction(scene, ray3d(shiftedOrigin, shiftedDirection), eval) * w;
+		statistics.add(evaluateFunction(scene, primaryRay, eval));
 		eval.rayIndex -= rndOffset;
-		weight += w;
+		eval.primaryHit = nullptr;
 	}
-	return vec4(result.xyz() / weight, 1.0f);
 }
 
 void RaytracePrivate::estimateRegionsOrder()
@@ -781,11 +1062,17 @@ void RaytracePrivate::estimateRegionsOrder()
 		return l.estimatedBounces > r.estimatedBounces;
 	});
 
-	emitWorkerThreads();
+	emitWorkerJobs();
 }
 
 void RaytracePrivate::renderSpacePartitioning()
 {
+	/*
+	 * bounding boxes are available only when scene was built using kd-tree
+	 */
+	if ((scene.options.accelerationStructure != AccelerationStructure::KDTree) || scene.kdTree.empty())
+		return;
+
 	renderBoundingBox(scene.kdTree.bboxAt(0), vec4(1.0f, 0.0f, 1.0f, 1.0f));
 	renderKDTreeRecursive(0, 0);
 }
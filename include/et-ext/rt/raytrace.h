@@ -31,6 +31,14 @@ public:
 	template <typename F>
 	void setOutputMethod(F func)
 		{ _outputMethod = func; }
+
+	/*
+	 * debug output, receives amount of samples per pixel (from blue to red) after adaptive rendering is finished,
+	 * not called unless set
+	 */
+	template <typename F>
+	void setSampleCountOutputMethod(F func)
+		{ _sampleCountOutputMethod = func; }
 	
 	void setIntegrator(EvaluateFunction);
 	
@@ -53,6 +61,7 @@ public:
 private:
 	friend class RaytracePrivate;
 	OutputMethod _outputMethod;
+	OutputMethod _sampleCountOutputMethod;
 };
 
 }
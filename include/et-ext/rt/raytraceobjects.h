@@ -48,6 +48,12 @@ enum class RaytraceMethod : uint32_t
 	ForwardLightTracing
 };
 
+enum class AccelerationStructure : uint32_t
+{
+	KDTree,
+	BVH
+};
+
 struct Options
 {
 	uint32_t threads = 0;
@@ -60,7 +66,14 @@ struct Options
 	float apertureSize = 0.0f;
 	float focalDistanceCorrection = 0.0f;
 	RaytraceMethod method = RaytraceMethod::BackwardPathTracing;
+	AccelerationStructure accelerationStructure = AccelerationStructure::KDTree;
 	bool renderKDTree = false;
+	bool primaryRayPackets = false;
+	bool quantizeTriangleAttributes = false;
+	bool progressiveRendering = false;
+	uint32_t minRaysPerPixel = 16;
+	uint32_t maxRaysPerPixel = 128;
+	float adaptiveSamplingThreshold = 0.0f;
 };
 
 struct ET_ALIGNED(16) Triangle
@@ -158,16 +171,11 @@ private:
 };
 using TriangleList = Vector<rt::Triangle>;
 
-struct ET_ALIGNED(16) IntersectionData
+struct ET_ALIGNED(16) TraverseResult
 {
-	float4 v0;
-	float4 edge1to0;
-	float4 edge2to0;
-
-	IntersectionData(const float4& v, const float4& e1, const float4& e2) :
-		v0(v), edge1to0(e1), edge2to0(e2)
-	{
-	}
+	float4 intersectionPoint;
+	float4 intersectionPointBarycentric;
+	uint32_t triangleIndex = InvalidIndex;
 };
 
 struct ET_ALIGNED(16) BoundingBox
@@ -235,9 +243,63 @@ struct Region
 	vec2i origin = vec2i(0);
 	vec2i size = vec2i(0);
 	size_t estimatedBounces = 0;
-	bool sampled = false;
 };
 
+/*
+ * Running mean of the pixel color and variance of it's luminance (Welford's algorithm)
+ */
+struct ET_ALIGNED(16) PixelStatistics
+{
+	float4 mean = float4(0.0f);
+	float luminanceMean = 0.0f;
+	float luminanceM2 = 0.0f;
+	uint32_t samples = 0;
+
+	void add(const float4& value)
+	{
+		++samples;
+		float invSamples = 1.0f / static_cast<float>(samples);
+		mean += (value - mean) * invSamples;
+
+		float luminance = value.dot(float4(0.2126f, 0.7152f, 0.0722f, 0.0f));
+		float delta = luminance - luminanceMean;
+		luminanceMean += delta * invSamples;
+		luminanceM2 += delta * (luminance - luminanceMean);
+	}
+
+	/*
+	 * standard error of the mean, relative to the mean,
+	 * dark pixels are compared to minimal visible luminance
+	 */
+	float relativeError() const
+	{
+		if (samples < 2)
+			return std::numeric_limits<float>::max();
+
+		const float minLuminance = 1.0f / 256.0f;
+		float variance = luminanceM2 / static_cast<float>(samples - 1);
+		return std::sqrt(variance / static_cast<float>(samples)) / std::max(luminanceMean, minLuminance);
+	}
+};
+
+/*
+ * interleaves bits of the coordinates (up to 16 bits each),
+ * sorting by the code orders 2d points along Z-order curve
+ */
+inline uint32_t mortonCode(const vec2i& p)
+{
+	auto spreadBits = [](uint32_t v)
+	{
+		v &= 0x0000ffff;
+		v = (v | (v << 8)) & 0x00ff00ff;
+		v = (v | (v << 4)) & 0x0f0f0f0f;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	};
+	return spreadBits(static_cast<uint32_t>(p.x)) | (spreadBits(static_cast<uint32_t>(p.y)) << 1);
+}
+
 inline float fastRandomFloat()
 {
 #if (ET_RT_USE_MT_GENERATOR)
@@ -1,13 +1,16 @@
 #include "raytraceobjects.h"
 
 #include "bsdf.cpp"
+#include "bvh.cpp"
 #include "integrator.cpp"
 #include "image.cpp"
 #include "kdtree.cpp"
+#include "packets.cpp"
 #include "emitter.cpp"
 #include "raytrace.cpp"
 #include "raytraceobjects.cpp"
 #include "reconstruction.cpp"
 #include "rtscene.cpp"
 #include "sampler.cpp"
+#include "trianglestorage.cpp"
 
@@ -22,7 +22,7 @@ void Scene::build(const Vector<SceneEntry>& geometry, const Camera::Pointer& cam
 	materials.clear();
 	emitters.clear();
 
-	TriangleList triangles;
+	triangles.clear(options.quantizeTriangleAttributes);
 	triangles.reserve(0xffff);
 
 	auto materialIndexWithName = [this](const std::string& name) -> uint32_t
@@ -109,32 +109,19 @@ void Scene::build(const Vector<SceneEntry>& geometry, const Camera::Pointer& cam
 		uint32_t firstTriange = static_cast<int>(triangles.size());
 
 		const mat4& t = scn.transformation;
+		vec3 positions[3];
+		vec3 normals[3];
+		vec2 texCoords[3];
 		for (uint32_t i = 0; i < scn.batch->numIndexes(); i += 3)
 		{
-			uint32_t i0 = ia->getIndex(scn.batch->firstIndex() + i + 0);
-			uint32_t i1 = ia->getIndex(scn.batch->firstIndex() + i + 1);
-			uint32_t i2 = ia->getIndex(scn.batch->firstIndex() + i + 2);
-
-			triangles.emplace_back();
-			auto& tri = triangles.back();
-			tri.v[0] = float4(t * pos[i0], 1.0f);
-			tri.v[1] = float4(t * pos[i1], 1.0f);
-			tri.v[2] = float4(t * pos[i2], 1.0f);
-			tri.n[0] = float4(t.rotationMultiply(nrm[i0]).normalized(), 0.0f);
-			tri.n[1] = float4(t.rotationMultiply(nrm[i1]).normalized(), 0.0f);
-			tri.n[2] = float4(t.rotationMultiply(nrm[i2]).normalized(), 0.0f);
-			if (hasUV)
+			for (uint32_t j = 0; j < 3; ++j)
 			{
-				tri.t[0] = float4(uv0[i0].x, uv0[i0].y, 0.0f, 0.0f);
-				tri.t[1] = float4(uv0[i1].x, uv0[i1].y, 0.0f, 0.0f);
-				tri.t[2] = float4(uv0[i2].x, uv0[i2].y, 0.0f, 0.0f);
+				uint32_t index = ia->getIndex(scn.batch->firstIndex() + i + j);
+				positions[j] = t * pos[index];
+				normals[j] = t.rotationMultiply(nrm[index]).normalized();
+				texCoords[j] = hasUV ? uv0[index] : vec2(0.0f);
 			}
-			else
-			{
-				tri.t[0] = tri.t[1] = tri.t[2] = float4(0.0f);
-			}
-			tri.materialIndex = static_cast<uint32_t>(materialIndex);
-			tri.computeSupportData();
+			triangles.addTriangle(positions, normals, texCoords, materialIndex);
 		}
 
 		uint32_t numTriangles = static_cast<uint32_t>(triangles.size()) - firstTriange;
@@ -146,31 +133,73 @@ void Scene::build(const Vector<SceneEntry>& geometry, const Camera::Pointer& cam
 		}
 	}
 
-	kdTree.build(triangles, options.maxKDTreeDepth);
+	kdTree.cleanUp();
+	bvh.cleanUp();
+	if (options.accelerationStructure == AccelerationStructure::BVH)
+		bvh.build(triangles);
+	else
+		kdTree.build(triangles, options.maxKDTreeDepth);
 
 	for (Emitter::Pointer& em : emitters)
 		em->prepare(*this);
 
 	centerRay = camera->castRay(vec2(0.0f));
-	KDTree::TraverseResult centerHit = kdTree.traverse(centerRay);
+	TraverseResult centerHit = traverse(centerRay);
 	if (centerHit.triangleIndex != InvalidIndex)
 		focalDistance = (centerHit.intersectionPoint - float4(centerRay.origin, 0.0f)).length();
 	focalDistance += options.focalDistanceCorrection;
 
-	auto stats = kdTree.nodesStatistics();
-	log::info("KD-Tree statistics:\n\t%llu nodes\n\t%llu leaf nodes\n\t%llu empty leaf nodes"
-		"\n\t%llu max depth\n\t%llu min triangles per node\n\t%llu max triangles per node"
-		"\n\t%llu total triangles\n\t%llu distributed triangles"
-		"\n\t%.2f focal distance"
-		"\n\t%.2f aperture size",
-		uint64_t(stats.totalNodes), uint64_t(stats.leafNodes), uint64_t(stats.emptyLeafNodes),
-		uint64_t(stats.maxDepth), uint64_t(stats.minTrianglesPerNode), uint64_t(stats.maxTrianglesPerNode),
-		uint64_t(stats.totalTriangles), uint64_t(stats.distributedTriangles),
-		focalDistance, options.apertureSize);
-
-	if (options.renderKDTree)
+	if (options.accelerationStructure == AccelerationStructure::BVH)
+	{
+		auto stats = bvh.nodesStatistics();
+		log::info("BVH statistics:\n\t%llu nodes\n\t%llu leaf nodes\n\t%llu max depth"
+			"\n\t%llu min triangles per node\n\t%llu max triangles per node\n\t%llu total triangles"
+			"\n\t%llu KB of triangle attributes"
+			"\n\t%.2f focal distance"
+			"\n\t%.2f aperture size",
+			uint64_t(stats.totalNodes), uint64_t(stats.leafNodes), uint64_t(stats.maxDepth),
+			uint64_t(stats.minTrianglesPerNode), uint64_t(stats.maxTrianglesPerNode), uint64_t(stats.totalTriangles),
+			uint64_t(triangles.memoryUsage() / 1024), focalDistance, options.apertureSize);
+	}
+	else
+	{
+		auto stats = kdTree.nodesStatistics();
+		log::info("KD-Tree statistics:\n\t%llu nodes\n\t%llu leaf nodes\n\t%llu empty leaf nodes"
+			"\n\t%llu max depth\n\t%llu min triangles per node\n\t%llu max triangles per node"
+			"\n\t%llu total triangles\n\t%llu distributed triangles"
+			"\n\t%llu KB of triangle attributes"
+			"\n\t%.2f focal distance"
+			"\n\t%.2f aperture size",
+			uint64_t(stats.totalNodes), uint64_t(stats.leafNodes), uint64_t(stats.emptyLeafNodes),
+			uint64_t(stats.maxDepth), uint64_t(stats.minTrianglesPerNode), uint64_t(stats.maxTrianglesPerNode),
+			uint64_t(stats.totalTriangles), uint64_t(stats.distributedTriangles),
+			uint64_t(triangles.memoryUsage() / 1024), focalDistance, options.apertureSize);
+
+		if (options.renderKDTree)
+		{
+			kdTree.printStructure();
+		}
+	}
+}
+
+void Scene::traverse(const RayPacket& rays, TraverseResult* results) const
+{
+	if (options.accelerationStructure == AccelerationStructure::BVH)
 	{
-		kdTree.printStructure();
+		PacketHits hits;
+		bvh.traverse(rays, hits);
+		for (uint32_t i = 0; i < rays.count; ++i)
+			results[i] = packetHitToTraverseResult(rays, hits, i);
+		threadTracedRays() += rays.count;
+	}
+	else
+	{
+		for (uint32_t i = 0; i < rays.count; ++i)
+		{
+			Ray ray(float4(rays.origin[0][i], rays.origin[1][i], rays.origin[2][i], 1.0f),
+				float4(rays.direction[0][i], rays.direction[1][i], rays.direction[2][i], 0.0f));
+			results[i] = traverse(ray);
+		}
 	}
 }
 
@@ -8,7 +8,9 @@
 #pragma once
 
 #include <et-ext/rt/raytraceobjects.h>
+#include <et-ext/rt/trianglestorage.h>
 #include <et-ext/rt/kdtree.h>
+#include <et-ext/rt/bvh.h>
 #include <et-ext/rt/bsdf.h>
 #include <et-ext/rt/emitter.h>
 #include <et-ext/rt/sampler.h>
@@ -40,10 +42,28 @@ public:
 	void build(const Vector<SceneEntry>&, const Camera::Pointer&);
 	void addEmitter(const Emitter::Pointer&);
 
+	/*
+	 * routed to the acceleration structure, selected in options
+	 */
+	TraverseResult traverse(const Ray&) const;
+	void traverse(const RayPacket&, TraverseResult*) const;
+
+	/*
+	 * reconstructed from compact storage, should be called for the closest hit only
+	 */
+	Triangle triangleAtIndex(size_t) const;
+
+	/*
+	 * number of rays, traced by the calling thread
+	 */
+	static uint64_t& threadTracedRays();
+
 public:
 	Options options;
 
+	TriangleStorage triangles;
 	KDTree kdTree;
+	BVH bvh;
 	Material::Collection materials;
 	Emitter::Collection emitters;
 	HammersleyQMCSampler sampler;
@@ -52,5 +72,23 @@ public:
 	ray3d centerRay;
 };
 
+inline uint64_t& Scene::threadTracedRays()
+{
+	static thread_local uint64_t tracedRays = 0;
+	return tracedRays;
+}
+
+inline TraverseResult Scene::traverse(const Ray& ray) const
+{
+	++threadTracedRays();
+	return (options.accelerationStructure == AccelerationStructure::BVH) ?
+		bvh.traverse(ray) : kdTree.traverse(ray);
+}
+
+inline Triangle Scene::triangleAtIndex(size_t i) const
+{
+	return triangles.triangle(i);
+}
+
 }
 }
@@ -0,0 +1,159 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et-ext/rt/trianglestorage.h>
+
+namespace et {
+namespace rt {
+
+namespace
+{
+
+uint32_t packTexCoord(const vec2& t)
+{
+	return static_cast<uint32_t>(floatToHalf(t.x)) | (static_cast<uint32_t>(floatToHalf(t.y)) << 16);
+}
+
+vec2 unpackTexCoord(uint32_t t)
+{
+	return vec2(halfToFloat(static_cast<uint16_t>(t & 0xffff)), halfToFloat(static_cast<uint16_t>(t >> 16)));
+}
+
+uint32_t floatToSnorm16(float value)
+{
+	float scaled = std::round(clamp(value, -1.0f, 1.0f) * 32767.0f);
+	return static_cast<uint32_t>(static_cast<int32_t>(scaled)) & 0xffff;
+}
+
+float snorm16ToFloat(uint32_t value)
+{
+	return static_cast<float>(static_cast<int16_t>(value & 0xffff)) / 32767.0f;
+}
+
+float signNotZero(float value)
+{
+	return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+/*
+ * octahedral encoding: normal is projected to octahedron, lower half is folded over the upper one
+ */
+uint32_t packNormal(const vec3& n)
+{
+	float length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	if (length == 0.0f)
+		return 0;
+
+	float x = n.x / length;
+	float y = n.y / length;
+	if (n.z < 0.0f)
+	{
+		float foldedX = (1.0f - std::abs(y)) * signNotZero(x);
+		y = (1.0f - std::abs(x)) * signNotZero(y);
+		x = foldedX;
+	}
+	return floatToSnorm16(x) | (floatToSnorm16(y) << 16);
+}
+
+vec3 unpackNormal(uint32_t n)
+{
+	float x = snorm16ToFloat(n & 0xffff);
+	float y = snorm16ToFloat(n >> 16);
+	float z = 1.0f - std::abs(x) - std::abs(y);
+	if (z < 0.0f)
+	{
+		float unfoldedX = (1.0f - std::abs(y)) * signNotZero(x);
+		y = (1.0f - std::abs(x)) * signNotZero(y);
+		x = unfoldedX;
+	}
+	return vec3(x, y, z).normalized();
+}
+
+}
+
+void TriangleStorage::clear(bool quantizeAttributes)
+{
+	_positions.clear();
+	_normals.clear();
+	_texCoords.clear();
+	_packedNormals.clear();
+	_packedTexCoords.clear();
+	_materialIndices.clear();
+	_quantized = quantizeAttributes;
+}
+
+void TriangleStorage::reserve(size_t trianglesCount)
+{
+	_positions.reserve(3 * trianglesCount);
+	_materialIndices.reserve(trianglesCount);
+	if (_quantized)
+	{
+		_packedNormals.reserve(3 * trianglesCount);
+		_packedTexCoords.reserve(3 * trianglesCount);
+	}
+	else
+	{
+		_normals.reserve(3 * trianglesCount);
+		_texCoords.reserve(3 * trianglesCount);
+	}
+}
+
+void TriangleStorage::addTriangle(const vec3 positions[3], const vec3 normals[3], const vec2 texCoords[3], uint32_t materialIndex)
+{
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		_positions.emplace_back(positions[i]);
+		if (_quantized)
+		{
+			_packedNormals.emplace_back(packNormal(normals[i]));
+			_packedTexCoords.emplace_back(packTexCoord(texCoords[i]));
+		}
+		else
+		{
+			_normals.emplace_back(normals[i]);
+			_texCoords.emplace_back(texCoords[i]);
+		}
+	}
+	_materialIndices.emplace_back(materialIndex);
+}
+
+float4 TriangleStorage::minVertex(size_t triangleIndex) const
+{
+	return vertex(triangleIndex, 0).minWith(vertex(triangleIndex, 1).minWith(vertex(triangleIndex, 2)));
+}
+
+float4 TriangleStorage::maxVertex(size_t triangleIndex) const
+{
+	return vertex(triangleIndex, 0).maxWith(vertex(triangleIndex, 1).maxWith(vertex(triangleIndex, 2)));
+}
+
+Triangle TriangleStorage::triangle(size_t triangleIndex) const
+{
+	Triangle result;
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		size_t index = 3 * triangleIndex + i;
+		vec3 n = _quantized ? unpackNormal(_packedNormals[index]) : _normals[index];
+		vec2 t = _quantized ? unpackTexCoord(_packedTexCoords[index]) : _texCoords[index];
+		result.v[i] = float4(_positions[index], 1.0f);
+		result.n[i] = float4(n, 0.0f);
+		result.t[i] = float4(t.x, t.y, 0.0f, 0.0f);
+	}
+	result.materialIndex = _materialIndices[triangleIndex];
+	result.computeSupportData();
+	return result;
+}
+
+size_t TriangleStorage::memoryUsage() const
+{
+	return _positions.size() * sizeof(vec3) + _normals.size() * sizeof(vec3) + _texCoords.size() * sizeof(vec2) +
+		_packedNormals.size() * sizeof(uint32_t) + _packedTexCoords.size() * sizeof(uint32_t) +
+		_materialIndices.size() * sizeof(uint32_t);
+}
+
+}
+}
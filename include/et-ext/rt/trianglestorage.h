@@ -0,0 +1,73 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et-ext/rt/raytraceobjects.h>
+
+namespace et {
+namespace rt {
+
+/*
+ * Scene triangles in compact form: positions (used to build acceleration structures
+ * and to locate hits), shading attributes (normals, texture coordinates, material),
+ * fetched only for the closest hit. Acceleration structures keep their own copy
+ * of the data required for intersection (see packets.h).
+ *
+ * With quantization normals are stored as octahedral 2x16 bit and texture coordinates
+ * as 2x16 bit half floats, 4 bytes each per vertex instead of 12 and 8.
+ */
+class TriangleStorage
+{
+public:
+	void clear(bool quantizeAttributes);
+	void reserve(size_t trianglesCount);
+
+	void addTriangle(const vec3 positions[3], const vec3 normals[3], const vec2 texCoords[3], uint32_t materialIndex);
+
+	size_t size() const {
+		return _materialIndices.size();
+	}
+
+	bool empty() const {
+		return _materialIndices.empty();
+	}
+
+	bool quantized() const {
+		return _quantized;
+	}
+
+	float4 vertex(size_t triangleIndex, uint32_t vertexIndex) const {
+		return float4(_positions[3 * triangleIndex + vertexIndex], 1.0f);
+	}
+
+	float4 minVertex(size_t triangleIndex) const;
+	float4 maxVertex(size_t triangleIndex) const;
+
+	uint32_t materialIndex(size_t triangleIndex) const {
+		return _materialIndices[triangleIndex];
+	}
+
+	/*
+	 * reconstructs full triangle with support data, should be used for shading only
+	 */
+	Triangle triangle(size_t triangleIndex) const;
+
+	size_t memoryUsage() const;
+
+private:
+	Vector<vec3> _positions;
+	Vector<vec3> _normals;
+	Vector<vec2> _texCoords;
+	Vector<uint32_t> _packedNormals;
+	Vector<uint32_t> _packedTexCoords;
+	Vector<uint32_t> _materialIndices;
+	bool _quantized = false;
+};
+
+}
+}
@@ -14,6 +14,7 @@
 #include <et/app/appevironment.h>
 #include <et/app/applicationdelegate.h>
 #include <et/app/backgroundthread.h>
+#include <et/core/jobsystem.h>
 #include <et/app/pathresolver.h>
 
 namespace et
@@ -147,7 +148,8 @@ private:
 };
 
 /*
- * currentRunLoop - returns background run loop if called in background and mainRunLoop otherwise
+ * currentRunLoop - returns background run loop if called from background thread and mainRunLoop otherwise,
+ * note that job system workers do not own run loops, so mainRunLoop is returned for them
  */
 Application& application();
 
@@ -0,0 +1,261 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/camera/culling.h>
+
+namespace et
+{
+
+void PackedBoundingBoxes::clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+}
+
+void PackedBoundingBoxes::resize(uint32_t count)
+{
+	centerX.resize(count);
+	centerY.resize(count);
+	centerZ.resize(count);
+	extentX.resize(count);
+	extentY.resize(count);
+	extentZ.resize(count);
+}
+
+void PackedBoundingBoxes::set(uint32_t index, const vec3& center, const vec3& halfDimension)
+{
+	ET_ASSERT(index < size());
+
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = halfDimension.x;
+	extentY[index] = halfDimension.y;
+	extentZ[index] = halfDimension.z;
+}
+
+void CullingHierarchy::clear()
+{
+	_nodes.clear();
+	_objectIndices.clear();
+	_boxes.clear();
+}
+
+void CullingHierarchy::build(const PackedBoundingBoxes& boxes)
+{
+	clear();
+
+	uint32_t objectsCount = boxes.size();
+	if (objectsCount == 0)
+		return;
+
+	_objectIndices.resize(objectsCount);
+	for (uint32_t i = 0; i < objectsCount; ++i)
+		_objectIndices[i] = i;
+
+	_nodes.reserve(2 * (objectsCount / MaxLeafSize + 1));
+	buildNode(boxes, 0, objectsCount, 0);
+
+	/*
+	 * boxes are stored in the order of leaves, so leaf tests are reading contiguous memory
+	 */
+	_boxes.resize(objectsCount);
+	for (uint32_t i = 0; i < objectsCount; ++i)
+	{
+		uint32_t source = _objectIndices[i];
+		_boxes.set(i, vec3(boxes.centerX[source], boxes.centerY[source], boxes.centerZ[source]),
+			vec3(boxes.extentX[source], boxes.extentY[source], boxes.extentZ[source]));
+	}
+}
+
+uint32_t CullingHierarchy::buildNode(const PackedBoundingBoxes& boxes, uint32_t first, uint32_t count, uint32_t depth)
+{
+	vec3 minBounds(std::numeric_limits<float>::max());
+	vec3 maxBounds(-std::numeric_limits<float>::max());
+	vec3 minCenter = minBounds;
+	vec3 maxCenter = maxBounds;
+	for (uint32_t i = first, e = first + count; i < e; ++i)
+	{
+		uint32_t index = _objectIndices[i];
+		vec3 center(boxes.centerX[index], boxes.centerY[index], boxes.centerZ[index]);
+		vec3 extent(boxes.extentX[index], boxes.extentY[index], boxes.extentZ[index]);
+		minBounds = minv(minBounds, center - extent);
+		maxBounds = maxv(maxBounds, center + extent);
+		minCenter = minv(minCenter, center);
+		maxCenter = maxv(maxCenter, center);
+	}
+
+	uint32_t nodeIndex = static_cast<uint32_t>(_nodes.size());
+	_nodes.emplace_back();
+	_nodes.back().center = 0.5f * (minBounds + maxBounds);
+	_nodes.back().halfDimension = 0.5f * (maxBounds - minBounds);
+	_nodes.back().firstObject = first;
+	_nodes.back().objectsCount = count;
+
+	if ((count <= MaxLeafSize) || (depth + 1 >= MaxDepth))
+		return nodeIndex;
+
+	/*
+	 * median split along the longest axis of centers bounds
+	 */
+	vec3 centersExtent = maxCenter - minCenter;
+	const Vector<float>* axisCenters = &boxes.centerX;
+	if ((centersExtent.y > centersExtent.x) && (centersExtent.y >= centersExtent.z))
+		axisCenters = &boxes.centerY;
+	else if ((centersExtent.z > centersExtent.x) && (centersExtent.z > centersExtent.y))
+		axisCenters = &boxes.centerZ;
+
+	const Vector<float>& centers = *axisCenters;
+	uint32_t leftCount = count / 2;
+	auto begin = _objectIndices.begin() + first;
+	std::nth_element(begin, begin + leftCount, begin + count, [&centers](uint32_t l, uint32_t r)
+		{ return centers[l] < centers[r]; });
+
+	buildNode(boxes, first, leftCount, depth + 1);
+	uint32_t rightChild = buildNode(boxes, first + leftCount, count - leftCount, depth + 1);
+	_nodes[nodeIndex].rightChild = rightChild;
+
+	return nodeIndex;
+}
+
+uint32_t CullingHierarchy::cullSubtree(const Frustum& frustum, uint32_t rootNode, uint32_t* visible) const
+{
+	uint32_t stack[MaxDepth + 1];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = rootNode;
+
+	uint32_t visibleCount = 0;
+	while (stackSize > 0)
+	{
+		uint32_t nodeIndex = stack[--stackSize];
+		const Node& node = _nodes[nodeIndex];
+
+		Frustum::Containment containment = frustum.classifyBoundingBox(node.center, node.halfDimension);
+		if (containment == Frustum::Containment::Outside)
+			continue;
+
+		if (containment == Frustum::Containment::Inside)
+		{
+			const uint32_t* objects = _objectIndices.data() + node.firstObject;
+			std::copy(objects, objects + node.objectsCount, visible + visibleCount);
+			visibleCount += node.objectsCount;
+		}
+		else if (node.leaf())
+		{
+			uint32_t* output = visible + visibleCount;
+			uint32_t leafVisible = frustum.cullBoundingBoxes(_boxes, node.firstObject, node.firstObject + node.objectsCount, output);
+			for (uint32_t i = 0; i < leafVisible; ++i)
+				output[i] = _objectIndices[output[i]];
+			visibleCount += leafVisible;
+		}
+		else
+		{
+			ET_ASSERT(stackSize + 2 <= MaxDepth + 1);
+			stack[stackSize++] = node.rightChild;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+
+	return visibleCount;
+}
+
+uint32_t CullingHierarchy::cull(const Frustum& frustum, uint32_t* visible, JobSystem* jobSystem) const
+{
+	if (_nodes.empty())
+		return 0;
+
+	if ((jobSystem == nullptr) || (jobSystem->workersCount() == 0) || _nodes.front().leaf())
+		return cullSubtree(frustum, 0, visible);
+
+	/*
+	 * top levels of the hierarchy are expanded into independent subtrees,
+	 * each of them writes visible objects into it's own range of the output
+	 */
+	uint32_t targetRoots = std::min(static_cast<uint32_t>(MaxParallelRoots), 4 * static_cast<uint32_t>(jobSystem->workersCount() + 1));
+
+	uint32_t roots[MaxParallelRoots] = { };
+	uint32_t rootsCount = 1;
+	bool expanded = true;
+	while (expanded)
+	{
+		expanded = false;
+
+		uint32_t expandedRoots[MaxParallelRoots];
+		uint32_t expandedCount = 0;
+		for (uint32_t i = 0; i < rootsCount; ++i)
+		{
+			const Node& node = _nodes[roots[i]];
+			uint32_t remaining = rootsCount - i - 1;
+			if (!node.leaf() && (expandedCount + remaining + 2 <= targetRoots))
+			{
+				expandedRoots[expandedCount++] = roots[i] + 1;
+				expandedRoots[expandedCount++] = node.rightChild;
+				expanded = true;
+			}
+			else
+			{
+				expandedRoots[expandedCount++] = roots[i];
+			}
+		}
+		std::copy(expandedRoots, expandedRoots + expandedCount, roots);
+		rootsCount = expandedCount;
+	}
+
+	uint32_t visibleInRoot[MaxParallelRoots] = { };
+	jobSystem->parallelFor(0, rootsCount, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			visibleInRoot[i] = cullSubtree(frustum, roots[i], visible + _nodes[roots[i]].firstObject);
+	}, 1);
+
+	uint32_t visibleCount = 0;
+	for (uint32_t i = 0; i < rootsCount; ++i)
+	{
+		uint32_t firstObject = _nodes[roots[i]].firstObject;
+		if ((visibleInRoot[i] > 0) && (visibleCount != firstObject))
+			std::memmove(visible + visibleCount, visible + firstObject, visibleInRoot[i] * sizeof(uint32_t));
+		visibleCount += visibleInRoot[i];
+	}
+	return visibleCount;
+}
+
+uint32_t cullBoundingBoxes(const Frustum& frustum, const PackedBoundingBoxes& boxes, uint32_t* visible, JobSystem* jobSystem)
+{
+	const uint32_t rangeSize = 4096;
+
+	uint32_t boxesCount = boxes.size();
+	if ((jobSystem == nullptr) || (jobSystem->workersCount() == 0) || (boxesCount <= rangeSize))
+		return frustum.cullBoundingBoxes(boxes, 0, boxesCount, visible);
+
+	uint32_t rangesCount = (boxesCount + rangeSize - 1) / rangeSize;
+	Vector<uint32_t> visibleInRange(rangesCount, 0);
+	jobSystem->parallelFor(0, rangesCount, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			uint32_t rangeBegin = i * rangeSize;
+			uint32_t rangeEnd = std::min(rangeBegin + rangeSize, boxesCount);
+			visibleInRange[i] = frustum.cullBoundingBoxes(boxes, rangeBegin, rangeEnd, visible + rangeBegin);
+		}
+	}, 1);
+
+	uint32_t visibleCount = 0;
+	for (uint32_t i = 0; i < rangesCount; ++i)
+	{
+		uint32_t rangeBegin = i * rangeSize;
+		if ((visibleInRange[i] > 0) && (visibleCount != rangeBegin))
+			std::memmove(visible + visibleCount, visible + rangeBegin, visibleInRange[i] * sizeof(uint32_t));
+		visibleCount += visibleInRange[i];
+	}
+	return visibleCount;
+}
+
+}
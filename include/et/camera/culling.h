@@ -0,0 +1,100 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/camera/frustum.h>
+#include <et/core/jobsystem.h>
+
+namespace et
+{
+/*
+ * Bounding boxes stored as structure of arrays, so frustum could test several boxes at once
+ */
+struct PackedBoundingBoxes
+{
+	Vector<float> centerX;
+	Vector<float> centerY;
+	Vector<float> centerZ;
+	Vector<float> extentX;
+	Vector<float> extentY;
+	Vector<float> extentZ;
+
+	void clear();
+	void resize(uint32_t);
+	void set(uint32_t index, const vec3& center, const vec3& halfDimension);
+
+	void set(uint32_t index, const BoundingBox& box)
+		{ set(index, box.center, box.halfDimension); }
+
+	uint32_t size() const
+		{ return static_cast<uint32_t>(centerX.size()); }
+};
+
+/*
+ * Bounding volume hierarchy over static boxes.
+ * Nodes are stored in depth-first order, left child immediately follows it's parent,
+ * boxes are reordered so every node references contiguous range of them.
+ * Nodes entirely inside of the frustum are accepted without testing their boxes,
+ * boxes of intersected leaves are tested with Frustum::cullBoundingBoxes.
+ */
+class CullingHierarchy
+{
+public:
+	enum : uint32_t
+	{
+		MaxLeafSize = 8,
+		MaxDepth = 64,
+		MaxParallelRoots = 256,
+	};
+
+public:
+	void build(const PackedBoundingBoxes&);
+	void clear();
+
+	bool empty() const
+		{ return _nodes.empty(); }
+
+	uint32_t objectsCount() const
+		{ return _boxes.size(); }
+
+	/*
+	 * writes indices (as they were in boxes passed to build) of visible objects,
+	 * visible should have space for objectsCount() elements; returns number of visible objects.
+	 * Order of indices matches order of the hierarchy, not original order.
+	 */
+	uint32_t cull(const Frustum&, uint32_t* visible, JobSystem* jobSystem = nullptr) const;
+
+private:
+	struct Node
+	{
+		vec3 center;
+		vec3 halfDimension;
+		uint32_t firstObject = 0;
+		uint32_t objectsCount = 0;
+		uint32_t rightChild = 0;
+
+		bool leaf() const
+			{ return rightChild == 0; }
+	};
+
+	uint32_t buildNode(const PackedBoundingBoxes&, uint32_t first, uint32_t count, uint32_t depth);
+	uint32_t cullSubtree(const Frustum&, uint32_t rootNode, uint32_t* visible) const;
+
+private:
+	Vector<Node> _nodes;
+	Vector<uint32_t> _objectIndices;
+	PackedBoundingBoxes _boxes;
+};
+
+/*
+ * tests all boxes, splitting them to ranges for the job system when it is provided,
+ * writes indices of visible boxes in ascending order; visible should have space for boxes.size() elements
+ */
+uint32_t cullBoundingBoxes(const Frustum&, const PackedBoundingBoxes&, uint32_t* visible, JobSystem* jobSystem = nullptr);
+
+}
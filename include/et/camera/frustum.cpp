@@ -6,6 +6,12 @@
  */
 
 #include <et/camera/frustum.h>
+#include <et/camera/culling.h>
+#include <et/core/tools.h>
+
+#if (ET_SIMD_SSE)
+#	include <immintrin.h>
+#endif
 
 namespace et
 {
@@ -61,4 +67,170 @@ bool Frustum::containsBoundingBox(const BoundingBox& aabb) const
 	return true;
 }
 
+Frustum::Containment Frustum::classifyBoundingBox(const vec3& center, const vec3& halfDimension) const
+{
+	/*
+	 * box is outside of the plane if it's nearest point is in front of the plane,
+	 * box intersects the plane if it's farthest point is in front of the plane
+	 */
+	Containment result = Containment::Inside;
+	for (const plane& frustumPlane : _planes)
+	{
+		const vec4& eq = frustumPlane.equation;
+		float d = (center.x * eq.x + center.y * eq.y + center.z * eq.z) - eq.w;
+		float r = halfDimension.x * std::abs(eq.x) + halfDimension.y * std::abs(eq.y) + halfDimension.z * std::abs(eq.z);
+
+		if (d - r > 0.0f)
+			return Containment::Outside;
+
+		if (d + r > 0.0f)
+			result = Containment::Intersects;
+	}
+	return result;
+}
+
+#if (ET_SIMD_DISPATCH)
+namespace
+{
+
+/*
+ * tests 8 boxes per iteration, returns index of the first box which was not tested
+ */
+ET_SIMD_TARGET("avx")
+uint32_t cullBoundingBoxesAVX(const std::array<plane, 6>& planes, const PackedBoundingBoxes& boxes, uint32_t begin, uint32_t end,
+	uint32_t* output, uint32_t& visible)
+{
+	const float* cx = boxes.centerX.data();
+	const float* cy = boxes.centerY.data();
+	const float* cz = boxes.centerZ.data();
+	const float* ex = boxes.extentX.data();
+	const float* ey = boxes.extentY.data();
+	const float* ez = boxes.extentZ.data();
+
+	uint32_t i = begin;
+
+	__m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+	for (uint32_t p = 0; p < 6; ++p)
+	{
+		const vec4& eq = planes[p].equation;
+		nx[p] = _mm256_set1_ps(eq.x);
+		ny[p] = _mm256_set1_ps(eq.y);
+		nz[p] = _mm256_set1_ps(eq.z);
+		nw[p] = _mm256_set1_ps(eq.w);
+		ax[p] = _mm256_set1_ps(std::abs(eq.x));
+		ay[p] = _mm256_set1_ps(std::abs(eq.y));
+		az[p] = _mm256_set1_ps(std::abs(eq.z));
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(cx + i);
+		__m256 y = _mm256_loadu_ps(cy + i);
+		__m256 z = _mm256_loadu_ps(cz + i);
+		__m256 hx = _mm256_loadu_ps(ex + i);
+		__m256 hy = _mm256_loadu_ps(ey + i);
+		__m256 hz = _mm256_loadu_ps(ez + i);
+
+		__m256 outside = zero;
+		for (uint32_t p = 0; p < 6; ++p)
+		{
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, nx[p]), _mm256_mul_ps(y, ny[p])), _mm256_mul_ps(z, nz[p]));
+			__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hx, ax[p]), _mm256_mul_ps(hy, ay[p])), _mm256_mul_ps(hz, az[p]));
+			__m256 distance = _mm256_sub_ps(_mm256_sub_ps(d, nw[p]), r);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_GT_OQ));
+		}
+
+		uint32_t outsideMask = static_cast<uint32_t>(_mm256_movemask_ps(outside));
+		for (uint32_t k = 0; k < 8; ++k)
+		{
+			output[visible] = i + k;
+			visible += 1 - ((outsideMask >> k) & 1);
+		}
+	}
+	return i;
+}
+
+}
+#endif
+
+uint32_t Frustum::cullBoundingBoxes(const PackedBoundingBoxes& boxes, uint32_t begin, uint32_t end, uint32_t* output) const
+{
+	ET_ASSERT(begin <= end);
+	ET_ASSERT(end <= boxes.size());
+
+	const float* cx = boxes.centerX.data();
+	const float* cy = boxes.centerY.data();
+	const float* cz = boxes.centerZ.data();
+	const float* ex = boxes.extentX.data();
+	const float* ey = boxes.extentY.data();
+	const float* ez = boxes.extentZ.data();
+
+	uint32_t visible = 0;
+	uint32_t i = begin;
+
+#if (ET_SIMD_DISPATCH)
+	if (cpuSupports(CPUFeature::AVX))
+		i = cullBoundingBoxesAVX(_planes, boxes, i, end, output, visible);
+#endif
+
+#if (ET_SIMD_SSE)
+	{
+		__m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+		for (uint32_t p = 0; p < 6; ++p)
+		{
+			const vec4& eq = _planes[p].equation;
+			nx[p] = _mm_set1_ps(eq.x);
+			ny[p] = _mm_set1_ps(eq.y);
+			nz[p] = _mm_set1_ps(eq.z);
+			nw[p] = _mm_set1_ps(eq.w);
+			ax[p] = _mm_set1_ps(std::abs(eq.x));
+			ay[p] = _mm_set1_ps(std::abs(eq.y));
+			az[p] = _mm_set1_ps(std::abs(eq.z));
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(cx + i);
+			__m128 y = _mm_loadu_ps(cy + i);
+			__m128 z = _mm_loadu_ps(cz + i);
+			__m128 hx = _mm_loadu_ps(ex + i);
+			__m128 hy = _mm_loadu_ps(ey + i);
+			__m128 hz = _mm_loadu_ps(ez + i);
+
+			__m128 outside = zero;
+			for (uint32_t p = 0; p < 6; ++p)
+			{
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx[p]), _mm_mul_ps(y, ny[p])), _mm_mul_ps(z, nz[p]));
+				__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, ax[p]), _mm_mul_ps(hy, ay[p])), _mm_mul_ps(hz, az[p]));
+				__m128 distance = _mm_sub_ps(_mm_sub_ps(d, nw[p]), r);
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(distance, zero));
+			}
+
+			/*
+			 * index is always written, but output position advances only for visible boxes
+			 */
+			uint32_t outsideMask = static_cast<uint32_t>(_mm_movemask_ps(outside));
+			output[visible] = i;
+			visible += 1 - (outsideMask & 1);
+			output[visible] = i + 1;
+			visible += 1 - ((outsideMask >> 1) & 1);
+			output[visible] = i + 2;
+			visible += 1 - ((outsideMask >> 2) & 1);
+			output[visible] = i + 3;
+			visible += 1 - ((outsideMask >> 3) & 1);
+		}
+	}
+#endif
+
+	for (; i < end; ++i)
+	{
+		if (classifyBoundingBox(vec3(cx[i], cy[i], cz[i]), vec3(ex[i], ey[i], ez[i])) != Containment::Outside)
+			output[visible++] = i;
+	}
+
+	return visible;
+}
+
 }
@@ -13,12 +13,30 @@
 namespace et
 {
 
+struct PackedBoundingBoxes;
 class Frustum
 {
+public:
+	enum class Containment : uint32_t
+	{
+		Outside,
+		Intersects,
+		Inside
+	};
+
 public:
 	void build(const mat4& inverseViewProjectionMatrix);
 	bool containsBoundingBox(const BoundingBox& aabb) const;
 
+	Containment classifyBoundingBox(const vec3& center, const vec3& halfDimension) const;
+
+	/*
+	 * tests boxes in range [begin, end) four (eight with AVX) at a time,
+	 * writes indices of visible boxes to output (which should have space for end - begin indices),
+	 * returns number of visible boxes
+	 */
+	uint32_t cullBoundingBoxes(const PackedBoundingBoxes&, uint32_t begin, uint32_t end, uint32_t* output) const;
+
 	const BoundingBox::Corners& corners() const
 		{ return _corners; }
 
@@ -5,3 +5,4 @@
 #include "../camera/cameramovingcontroller.cpp"
 #include "../camera/cameraorbitcontroller.cpp"
 #include "../camera/frustum.cpp"
+#include "../camera/culling.cpp"
@@ -6,8 +6,10 @@
 #include "../core/debug.cpp"
 #include "../core/dictionary.cpp"
 #include "../core/et.cpp"
+#include "../core/jobsystem.cpp"
 #include "../core/json.cpp"
 #include "../core/locale.cpp"
+#include "../core/mappedfile.cpp"
 #include "../core/memoryallocator.cpp"
 #include "../core/notifytimer.cpp"
 #include "../core/objectscache.cpp"
@@ -15,6 +17,7 @@
 #include "../core/stream.cpp"
 #include "../core/synchronization.cpp"
 #include "../core/taskpool.cpp"
+#include "../core/textparsing.cpp"
 #include "../core/threading.cpp"
 #include "../core/timedobject.cpp"
 #include "../core/timerpool.cpp"
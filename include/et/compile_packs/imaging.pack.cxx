@@ -1,5 +1,6 @@
 #include <et/core/et.h>
 
+#include "../imaging/blockcompression.cpp"
 #include "../imaging/bmploader.cpp"
 #include "../imaging/ddsloader.cpp"
 #include "../imaging/hdrloader.cpp"
@@ -9,5 +10,6 @@
 #include "../imaging/pngloader.cpp"
 #include "../imaging/pvrdecompressor.cpp"
 #include "../imaging/pvrloader.cpp"
+#include "../imaging/texturecache.cpp"
 #include "../imaging/texturedescription.cpp"
 #include "../imaging/tgaloader.cpp"
@@ -2,6 +2,7 @@
 
 #include "../rendering/renderoptions.cpp"
 
+#include "../rendering/base/asynctextureloader.cpp"
 #include "../rendering/base/constantbuffer.cpp"
 #include "../rendering/base/helpers.cpp"
 #include "../rendering/base/indexarray.cpp"
@@ -12,6 +13,7 @@
 #include "../rendering/base/renderbatch.cpp"
 #include "../rendering/base/rendering.cpp"
 #include "../rendering/base/renderpass.cpp"
+#include "../rendering/base/renderqueue.cpp"
 #include "../rendering/base/shadersource.cpp"
 #include "../rendering/base/variableset.cpp"
 #include "../rendering/base/vertexarray.cpp"
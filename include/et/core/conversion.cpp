@@ -6,6 +6,7 @@
  */
 
 #include <et/core/conversion.h>
+#include <et/core/textparsing.h>
 
 namespace et
 {
@@ -13,12 +14,16 @@ namespace et
 	R strToVector(const std::string& s, const std::string& delimiter)
 	{
 		R result;
-		int index = 0;
-		StringList values = split(s, delimiter);
-		for (auto& i : values)
+		const char* position = s.data();
+		const char* end = position + s.size();
+		for (int index = 0; (index < C) && (position < end); ++index)
 		{
-			result[index++] = strToFloat(i);
-			if (index >= C) break;
+			const char* fieldEnd = position;
+			while ((fieldEnd < end) && (delimiter.find(*fieldEnd) == std::string::npos))
+				++fieldEnd;
+
+			result[index] = text::parseFloat(text::Range(position, fieldEnd));
+			position = (fieldEnd < end) ? fieldEnd + 1 : end;
 		}
 		return result;
 	}
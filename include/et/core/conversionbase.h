@@ -37,14 +37,14 @@ namespace et
 		return buffer;
 	}
 
-	inline std::string intToStr(int64_t value)
+	inline std::string intToStr(long long value)
 	{
 		char buffer[64] = { };
 		sprintf(buffer, "%lld", value);
 		return buffer;
 	}
 	
-	inline std::string intToStr(uint64_t value)
+	inline std::string intToStr(unsigned long long value)
 	{
 		char buffer[64] = { };
 		sprintf(buffer, "%llu", value);
@@ -94,4 +94,61 @@ namespace et
 
 	std::string floatToStr(float value, int precission = 5);
 	std::string floatToTimeStr(float value, bool showMSec = true);
+
+	/*
+	 * round to nearest even, values out of the half range are converted to infinity
+	 */
+	inline uint16_t floatToHalf(float value)
+	{
+		union
+		{
+			uint32_t i;
+			float f;
+		} u = { };
+		u.f = value;
+
+		uint32_t sign = u.i & 0x80000000;
+		u.i ^= sign;
+
+		uint32_t result = 0;
+		if (u.i >= 0x47800000)
+		{
+			result = (u.i > 0x7f800000) ? 0x7e00 : 0x7c00;
+		}
+		else if (u.i < 0x38800000)
+		{
+			u.f += 0.5f;
+			result = u.i - 0x3f000000;
+		}
+		else
+		{
+			uint32_t mantissaOdd = (u.i >> 13) & 1;
+			u.i += 0xc8000fff;
+			u.i += mantissaOdd;
+			result = u.i >> 13;
+		}
+		return static_cast<uint16_t>(result | (sign >> 16));
+	}
+
+	inline float halfToFloat(uint16_t half)
+	{
+		uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+		uint32_t exponent = (half >> 10) & 0x1f;
+		uint32_t mantissa = half & 0x03ff;
+		if (exponent == 0)
+		{
+			float result = static_cast<float>(mantissa) / 16777216.0f;
+			return (sign != 0) ? -result : result;
+		}
+
+		union
+		{
+			uint32_t i;
+			float f;
+		} u = { };
+		u.i = (exponent == 31) ?
+			(sign | 0x7f800000 | (mantissa << 13)) :
+			(sign | ((exponent + 112) << 23) | (mantissa << 13));
+		return u.f;
+	}
 }
@@ -84,6 +84,11 @@ public:
 public:
 	DataStorage& operator = (const DataStorage& buf)
 	{
+		if (&buf == this)
+			return *this;
+
+		resize(0);
+
 		if (buf.ownsData())
 		{
 			_lastElementIndex = buf._lastElementIndex;
@@ -105,6 +110,27 @@ public:
 		return *this;
 	}
 
+	DataStorage& operator = (DataStorage&& mv)
+	{
+		if (&mv == this)
+			return *this;
+
+		resize(0);
+
+		_size = mv._size;
+		_dataSize = mv._dataSize;
+		_lastElementIndex = mv._lastElementIndex;
+		_flags = mv._flags;
+		_mutableData = mv._mutableData;
+
+		mv._size = 0;
+		mv._dataSize = 0;
+		mv._lastElementIndex = 0;
+		mv._flags = DataStorageFlag_OwnsMutableData;
+		mv._mutableData = nullptr;
+		return *this;
+	}
+
 public:
 	/*
 	 * mutable accessors
@@ -59,6 +59,8 @@
 
 namespace et
 {
+BlockMemoryAllocator& sharedBlockAllocator();
+
 template <typename T>
 struct SharedBlockAllocatorSTDProxy
 {
@@ -203,6 +205,30 @@ inline uint32_t alignDownTo(uint32_t sz, uint32_t al)
 	ET_ASSERT(al > 0);
 	return sz & (~(al - 1));
 }
+
+inline uint32_t findFirstSetBit(uint64_t value)
+{
+	ET_ASSERT(value != 0);
+#if (ET_PLATFORM_WIN)
+	unsigned long result = 0;
+	_BitScanForward64(&result, value);
+	return static_cast<uint32_t>(result);
+#else
+	return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+inline uint32_t findLastSetBit(uint64_t value)
+{
+	ET_ASSERT(value != 0);
+#if (ET_PLATFORM_WIN)
+	unsigned long result = 0;
+	_BitScanReverse64(&result, value);
+	return static_cast<uint32_t>(result);
+#else
+	return static_cast<uint32_t>(63 - __builtin_clzll(value));
+#endif
+}
 }
 
 #include <et/core/strings.hpp>
@@ -227,7 +253,6 @@ namespace et
 {
 
 ObjectFactory& sharedObjectFactory();
-BlockMemoryAllocator& sharedBlockAllocator();
 std::vector<log::Output::Pointer>& sharedLogOutputs();
 
 typedef vector2<float> vec2;
@@ -0,0 +1,533 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/jobsystem.h>
+#include <et/core/thread.h>
+#include <deque>
+
+namespace et
+{
+
+struct Job
+{
+	JobSystem::Function function;
+	JobCounter* counter = nullptr;
+};
+
+/*
+ * Chase-Lev work stealing deque (fixed capacity version):
+ * owner thread pushes and pops jobs at the bottom, other threads steal from the top.
+ * When deque is full jobs are going to the shared queue of the job system
+ */
+class WorkStealingQueue
+{
+public:
+	enum : int64_t
+	{
+		Capacity = 4096,
+		Mask = Capacity - 1
+	};
+
+public:
+	bool push(Job* job)
+	{
+		int64_t b = _bottom.load(std::memory_order_relaxed);
+		int64_t t = _top.load(std::memory_order_acquire);
+		if (b - t >= Capacity)
+			return false;
+
+		_jobs[b & Mask].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		_bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	Job* pop()
+	{
+		int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+		_bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = _top.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			_bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* result = _jobs[b & Mask].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			/*
+			 * last job in deque, racing with thieves
+			 */
+			if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				result = nullptr;
+
+			_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	Job* steal()
+	{
+		int64_t t = _top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = _bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+			return nullptr;
+
+		Job* result = _jobs[t & Mask].load(std::memory_order_relaxed);
+		if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+
+		return result;
+	}
+
+private:
+	std::atomic<int64_t> _top{ 0 };
+	char _topPadding[64 - sizeof(std::atomic<int64_t>)] { };
+	std::atomic<int64_t> _bottom{ 0 };
+	char _bottomPadding[64 - sizeof(std::atomic<int64_t>)] { };
+	std::atomic<Job*> _jobs[Capacity] { };
+};
+
+class JobWorker : public Thread
+{
+public:
+	JobWorker(JobSystemPrivate* owner, uint32_t index) :
+		Thread("et-job-worker"), _owner(owner), _index(index) { }
+
+	JobSystemPrivate* owner() const
+		{ return _owner; }
+
+	uint32_t index() const
+		{ return _index; }
+
+	WorkStealingQueue& queue()
+		{ return _queue; }
+
+private:
+	void main() override;
+
+private:
+	WorkStealingQueue _queue;
+	JobSystemPrivate* _owner = nullptr;
+	uint32_t _index = 0;
+};
+
+class JobSystemPrivate
+{
+public:
+	JobSystemPrivate(size_t workersCount);
+
+	void start();
+	void stop();
+
+	JobWorker* localWorker() const;
+
+	void push(Job*);
+	Job* findJob(JobWorker*);
+	Job* takeShared();
+	Job* steal(JobWorker*);
+
+	void execute(Job*);
+	void cancel(Job*);
+	void finish(JobCounter*);
+	void notifyWaitingThreads();
+
+	void workerMain(JobWorker*);
+
+public:
+	Vector<JobWorker*> workers;
+	std::deque<Job*> sharedQueue;
+	std::mutex sharedQueueLock;
+	std::mutex wakeLock;
+	std::condition_variable wakeCondition;
+	std::mutex completionLock;
+	std::condition_variable completionCondition;
+	std::atomic<int32_t> queuedJobs{ 0 };
+	std::atomic<int32_t> sharedJobs{ 0 };
+	std::atomic<uint32_t> sleepingWorkers{ 0 };
+	std::atomic<uint32_t> waitingThreads{ 0 };
+	std::atomic<bool> running{ false };
+	size_t workersToStart = 0;
+};
+
+namespace
+{
+	static thread_local JobWorker* localJobWorker = nullptr;
+	static thread_local uint32_t localStealSeed = 0x9e3779b9;
+}
+
+void JobWorker::main()
+{
+	_owner->workerMain(this);
+}
+
+JobSystemPrivate::JobSystemPrivate(size_t workersCount) :
+	workersToStart(workersCount)
+{
+	if (workersToStart == 0)
+		workersToStart = std::max(size_t(1), threading::maxConcurrentThreads());
+}
+
+void JobSystemPrivate::start()
+{
+	ET_ASSERT(workers.empty());
+
+	running = true;
+	workers.reserve(workersToStart);
+	for (size_t i = 0; i < workersToStart; ++i)
+		workers.push_back(etCreateObject<JobWorker>(this, static_cast<uint32_t>(i)));
+
+	for (JobWorker* worker : workers)
+		worker->run();
+}
+
+void JobSystemPrivate::stop()
+{
+	if (!running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(wakeLock);
+		running = false;
+		wakeCondition.notify_all();
+	}
+	notifyWaitingThreads();
+
+	for (JobWorker* worker : workers)
+		worker->join();
+
+	for (JobWorker* worker : workers)
+	{
+		while (Job* job = worker->queue().pop())
+			cancel(job);
+		etDestroyObject(worker);
+	}
+	workers.clear();
+
+	/*
+	 * cancelled jobs could release continuations, which are pushed to the shared queue
+	 */
+	while (Job* job = takeShared())
+		cancel(job);
+
+	queuedJobs = 0;
+}
+
+JobWorker* JobSystemPrivate::localWorker() const
+{
+	return (localJobWorker != nullptr) && (localJobWorker->owner() == this) ? localJobWorker : nullptr;
+}
+
+void JobSystemPrivate::push(Job* job)
+{
+	++queuedJobs;
+
+	JobWorker* worker = localWorker();
+	if ((worker == nullptr) || !worker->queue().push(job))
+	{
+		std::lock_guard<std::mutex> lock(sharedQueueLock);
+		sharedQueue.push_back(job);
+		++sharedJobs;
+	}
+
+	if (sleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(wakeLock);
+		wakeCondition.notify_one();
+	}
+
+	notifyWaitingThreads();
+}
+
+Job* JobSystemPrivate::findJob(JobWorker* worker)
+{
+	Job* job = (worker == nullptr) ? nullptr : worker->queue().pop();
+
+	if (job == nullptr)
+		job = takeShared();
+
+	if (job == nullptr)
+		job = steal(worker);
+
+	if (job != nullptr)
+		--queuedJobs;
+
+	return job;
+}
+
+Job* JobSystemPrivate::takeShared()
+{
+	if (sharedJobs.load() <= 0)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(sharedQueueLock);
+	if (sharedQueue.empty())
+		return nullptr;
+
+	Job* job = sharedQueue.front();
+	sharedQueue.pop_front();
+	--sharedJobs;
+	return job;
+}
+
+Job* JobSystemPrivate::steal(JobWorker* thief)
+{
+	uint32_t workersCount = static_cast<uint32_t>(workers.size());
+	if (workersCount == 0)
+		return nullptr;
+
+	localStealSeed ^= localStealSeed << 13;
+	localStealSeed ^= localStealSeed >> 17;
+	localStealSeed ^= localStealSeed << 5;
+
+	uint32_t firstVictim = localStealSeed % workersCount;
+	for (uint32_t i = 0; i < workersCount; ++i)
+	{
+		JobWorker* victim = workers[(firstVictim + i) % workersCount];
+		if (victim == thief)
+			continue;
+
+		if (Job* job = victim->queue().steal())
+			return job;
+	}
+	return nullptr;
+}
+
+void JobSystemPrivate::execute(Job* job)
+{
+	job->function();
+
+	JobCounter* counter = job->counter;
+	etDestroyObject(job);
+
+	if (counter != nullptr)
+		finish(counter);
+}
+
+/*
+ * job is destroyed without execution, but it's counter is decremented as usual,
+ * so threads waiting for it are not blocked forever
+ */
+void JobSystemPrivate::cancel(Job* job)
+{
+	JobCounter* counter = job->counter;
+	etDestroyObject(job);
+
+	if (counter != nullptr)
+		finish(counter);
+}
+
+void JobSystemPrivate::finish(JobCounter* counter)
+{
+	/*
+	 * counter could be destroyed by waiting thread as soon as lock is released,
+	 * so it should not be accessed after that
+	 */
+	bool completed = false;
+	Vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->_lock);
+		completed = (--counter->_value == 0);
+		if (completed)
+			continuations.swap(counter->_continuations);
+	}
+
+	if (completed)
+		notifyWaitingThreads();
+
+	for (Job* job : continuations)
+		push(job);
+}
+
+void JobSystemPrivate::notifyWaitingThreads()
+{
+	if (waitingThreads.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(completionLock);
+		completionCondition.notify_all();
+	}
+}
+
+void JobSystemPrivate::workerMain(JobWorker* worker)
+{
+	localJobWorker = worker;
+	localStealSeed += worker->index() * 0x9e3779b9;
+
+	while (running)
+	{
+		Job* job = findJob(worker);
+		if (job != nullptr)
+		{
+			execute(job);
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock(wakeLock);
+			++sleepingWorkers;
+			wakeCondition.wait(lock, [this]() { return !running || (queuedJobs.load() > 0); });
+			--sleepingWorkers;
+		}
+	}
+
+	localJobWorker = nullptr;
+}
+
+/*
+ * JobCounter
+ */
+JobCounter::~JobCounter()
+{
+	/*
+	 * worker could still be inside JobSystemPrivate::finish after the value reached zero,
+	 * lock waits until it leaves
+	 */
+	std::lock_guard<std::mutex> lock(_lock);
+	ET_ASSERT(_value == 0);
+	ET_ASSERT(_continuations.empty());
+}
+
+/*
+ * JobSystem
+ */
+JobSystem::JobSystem(size_t workersCount)
+{
+	ET_PIMPL_INIT(JobSystem, workersCount);
+	_private->start();
+}
+
+JobSystem::~JobSystem()
+{
+	_private->stop();
+	ET_PIMPL_FINALIZE(JobSystem);
+}
+
+void JobSystem::stop()
+{
+	_private->stop();
+}
+
+size_t JobSystem::workersCount() const
+{
+	return _private->workers.size();
+}
+
+bool JobSystem::inWorkerThread() const
+{
+	return _private->localWorker() != nullptr;
+}
+
+void JobSystem::schedule(Function function, JobCounter* counter)
+{
+	Job* job = etCreateObject<Job>();
+	job->function = std::move(function);
+	job->counter = counter;
+
+	if (counter != nullptr)
+		++counter->_value;
+
+	_private->push(job);
+}
+
+void JobSystem::scheduleAfter(JobCounter& dependency, Function function, JobCounter* counter)
+{
+	Job* job = etCreateObject<Job>();
+	job->function = std::move(function);
+	job->counter = counter;
+
+	if (counter != nullptr)
+		++counter->_value;
+
+	{
+		std::lock_guard<std::mutex> lock(dependency._lock);
+		if (dependency._value.load() > 0)
+		{
+			dependency._continuations.push_back(job);
+			return;
+		}
+	}
+
+	_private->push(job);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	JobWorker* worker = _private->localWorker();
+	while (!counter.completed())
+	{
+		Job* job = _private->findJob(worker);
+		if (job != nullptr)
+		{
+			_private->execute(job);
+		}
+		else if (worker == nullptr)
+		{
+			/*
+			 * non-worker thread sleeps until counter is completed or new job could be taken
+			 */
+			std::unique_lock<std::mutex> lock(_private->completionLock);
+			++_private->waitingThreads;
+			_private->completionCondition.wait(lock, [this, &counter]()
+			{
+				return counter.completed() || (_private->queuedJobs.load() > 0) || !_private->running;
+			});
+			--_private->waitingThreads;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	/*
+	 * make sure that thread, which completed the last job, left counter's critical section,
+	 * so counter could be safely destroyed after returning from this method
+	 */
+	std::lock_guard<std::mutex> lock(counter._lock);
+}
+
+void JobSystem::parallelFor(uint32_t begin, uint32_t end, const RangeFunction& function, uint32_t grainSize)
+{
+	if (end <= begin)
+		return;
+
+	uint32_t elementsCount = end - begin;
+	uint32_t threadsCount = static_cast<uint32_t>(workersCount()) + 1;
+
+	if (grainSize == 0)
+		grainSize = std::max(1u, elementsCount / (4 * threadsCount));
+
+	if ((threadsCount == 1) || (elementsCount <= grainSize))
+	{
+		function(begin, end);
+		return;
+	}
+
+	JobCounter counter;
+	uint32_t rangeBegin = begin;
+	while (end - rangeBegin > grainSize)
+	{
+		uint32_t rangeEnd = rangeBegin + grainSize;
+		schedule([&function, rangeBegin, rangeEnd]() { function(rangeBegin, rangeEnd); }, &counter);
+		rangeBegin = rangeEnd;
+	}
+	function(rangeBegin, end);
+
+	wait(counter);
+}
+
+JobSystem& sharedJobSystem()
+{
+	static JobSystem jobSystem;
+	return jobSystem;
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+#include <functional>
+#include <mutex>
+
+namespace et
+{
+struct Job;
+class JobSystem;
+
+/*
+ * JobCounter tracks amount of unfinished jobs, scheduled with it.
+ * Counter could be waited on (JobSystem::wait) or used as dependency
+ * for another jobs (JobSystem::scheduleAfter)
+ */
+class JobCounter
+{
+public:
+	JobCounter() = default;
+	~JobCounter();
+
+	uint32_t value() const
+		{ return _value.load(); }
+
+	bool completed() const
+		{ return _value.load() == 0; }
+
+private:
+	friend class JobSystem;
+	friend class JobSystemPrivate;
+
+	ET_DENY_COPY(JobCounter);
+
+	std::atomic<uint32_t> _value{ 0 };
+	std::mutex _lock;
+	Vector<Job*> _continuations;
+};
+
+class JobSystemPrivate;
+class JobSystem
+{
+public:
+	using Function = std::function<void()>;
+	using RangeFunction = std::function<void(uint32_t, uint32_t)>;
+
+public:
+	/*
+	 * workersCount = 0 means threading::maxConcurrentThreads()
+	 */
+	JobSystem(size_t workersCount = 0);
+	~JobSystem();
+
+	/*
+	 * stops and joins all workers, jobs which were not yet started are discarded,
+	 * their counters are decremented, so waiting threads are released
+	 */
+	void stop();
+
+	size_t workersCount() const;
+	bool inWorkerThread() const;
+
+	/*
+	 * jobs scheduled from worker thread are pushed to it's own deque,
+	 * jobs from any other thread are going to the shared queue,
+	 * idle workers are stealing jobs from each other
+	 */
+	void schedule(Function, JobCounter* counter = nullptr);
+	void scheduleAfter(JobCounter& dependency, Function, JobCounter* counter = nullptr);
+
+	/*
+	 * waiting thread executes pending jobs until counter reaches zero,
+	 * non-worker thread sleeps while there are no jobs to execute
+	 */
+	void wait(JobCounter&);
+
+	/*
+	 * splits [begin, end) into ranges of grainSize elements (0 - choose automatically)
+	 * and calls function(rangeBegin, rangeEnd) for each range, returns when all ranges are processed
+	 */
+	void parallelFor(uint32_t begin, uint32_t end, const RangeFunction&, uint32_t grainSize = 0);
+
+private:
+	ET_DENY_COPY(JobSystem);
+	ET_DECLARE_PIMPL(JobSystem, 512);
+};
+
+JobSystem& sharedJobSystem();
+}
@@ -0,0 +1,197 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/mappedfile.h>
+
+#if (ET_PLATFORM_WIN)
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
+namespace et
+{
+class MappedFilePrivate
+{
+public:
+	~MappedFilePrivate()
+	{
+		close();
+	}
+
+	bool open(const std::string& fileName);
+	void close();
+
+public:
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+
+#if (ET_PLATFORM_WIN)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+};
+}
+
+using namespace et;
+
+MappedFile::MappedFile()
+{
+	ET_PIMPL_INIT(MappedFile);
+}
+
+MappedFile::MappedFile(const std::string& fileName)
+{
+	ET_PIMPL_INIT(MappedFile);
+	open(fileName);
+}
+
+MappedFile::~MappedFile()
+{
+	ET_PIMPL_FINALIZE(MappedFile);
+}
+
+bool MappedFile::open(const std::string& fileName)
+{
+	_private->close();
+
+	if (_private->open(fileName))
+		return true;
+
+	_private->close();
+	return false;
+}
+
+void MappedFile::close()
+{
+	_private->close();
+}
+
+bool MappedFile::valid() const
+{
+	return _private->data != nullptr;
+}
+
+const uint8_t* MappedFile::data() const
+{
+	return _private->data;
+}
+
+uint64_t MappedFile::size() const
+{
+	return _private->size;
+}
+
+BinaryDataStorage MappedFile::view(uint64_t offset, uint64_t size) const
+{
+	ET_ASSERT(valid());
+	ET_ASSERT(offset + size <= _private->size);
+	return BinaryDataStorage(_private->data + offset, size);
+}
+
+#if (ET_PLATFORM_WIN)
+
+bool MappedFilePrivate::open(const std::string& fileName)
+{
+	file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		log::error("Unable to open file: %s", fileName.c_str());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = { };
+	if ((GetFileSizeEx(file, &fileSize) == 0) || (fileSize.QuadPart == 0))
+		return false;
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		log::error("Unable to create mapping for file: %s", fileName.c_str());
+		return false;
+	}
+
+	data = reinterpret_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr)
+	{
+		log::error("Unable to map file: %s", fileName.c_str());
+		return false;
+	}
+
+	size = static_cast<uint64_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFilePrivate::close()
+{
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+	file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFilePrivate::open(const std::string& fileName)
+{
+	int file = ::open(fileName.c_str(), O_RDONLY);
+	if (file == -1)
+	{
+		log::error("Unable to open file: %s", fileName.c_str());
+		return false;
+	}
+
+	struct stat fileStat = { };
+	if ((fstat(file, &fileStat) != 0) || (fileStat.st_size == 0))
+	{
+		::close(file);
+		return false;
+	}
+
+	/*
+	 * mapping stays valid after descriptor is closed
+	 */
+	void* mapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+
+	if (mapped == MAP_FAILED)
+	{
+		log::error("Unable to map file: %s", fileName.c_str());
+		return false;
+	}
+
+	posix_madvise(mapped, static_cast<size_t>(fileStat.st_size), POSIX_MADV_SEQUENTIAL);
+
+	data = reinterpret_cast<const uint8_t*>(mapped);
+	size = static_cast<uint64_t>(fileStat.st_size);
+	return true;
+}
+
+void MappedFilePrivate::close()
+{
+	if (data != nullptr)
+		munmap(const_cast<uint8_t*>(data), static_cast<size_t>(size));
+
+	data = nullptr;
+	size = 0;
+}
+
+#endif
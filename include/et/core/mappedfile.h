@@ -0,0 +1,45 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+#include <et/core/containers.h>
+
+namespace et
+{
+/*
+ * Read-only memory mapping of the whole file.
+ * Views returned by view() are not owning the data,
+ * so mapped file should be retained while they are in use.
+ */
+class MappedFilePrivate;
+class MappedFile : public Object
+{
+public:
+	ET_DECLARE_POINTER(MappedFile);
+
+public:
+	MappedFile();
+	MappedFile(const std::string& fileName);
+	~MappedFile();
+
+	bool open(const std::string& fileName);
+	void close();
+
+	bool valid() const;
+
+	const uint8_t* data() const;
+	uint64_t size() const;
+
+	BinaryDataStorage view(uint64_t offset, uint64_t size) const;
+
+private:
+	ET_DENY_COPY(MappedFile);
+	ET_DECLARE_PIMPL(MappedFile, 32);
+};
+}
@@ -5,9 +5,19 @@
  *
  */
 
+#include <thread>
 #include <et/core/criticalsection.h>
 #include <et/core/staticdatastorage.h>
 
+#if (!ET_PLATFORM_WIN)
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+#if !defined(ET_MEMORY_ALLOCATOR_USE_HUGE_PAGES)
+#	define ET_MEMORY_ALLOCATOR_USE_HUGE_PAGES	1
+#endif
+
 namespace et
 {
 
@@ -28,10 +38,91 @@ enum : uint64_t
 	defaultChunkSize = 16 * megabytes,
 	allocGranularity = 4 * megabytes,
 	minimumAllocationSize = 128,
-	smallBlockSize = 156,
-	mediumBlockSize = 284,
+	smallBlockSize = 160,
+	mediumBlockSize = 288,
+	threadCacheCapacity = 64,
+	threadCacheBatchSize = 32,
+	maxCachedAllocatorsPerThread = 4,
+	hugePagesMinimumSize = defaultChunkSize,
 };
 
+/*
+ * Platform-specific virtual memory routines.
+ * On POSIX systems memory is mapped directly, so pages which are not touched
+ * or were decommitted does not contribute to resident memory.
+ * Large mappings are marked as transparent huge pages candidates on Linux,
+ * MADV_HUGEPAGE is not available on Apple platforms, so hint is skipped there.
+ */
+static uint64_t systemPageSize()
+{
+#if (ET_PLATFORM_WIN)
+	return 4096;
+#else
+	static const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	return pageSize;
+#endif
+}
+
+static bool canDecommitMemory()
+{
+#if (ET_PLATFORM_WIN)
+	return false;
+#else
+	return true;
+#endif
+}
+
+static void* reserveMemory(uint64_t size, uint64_t alignment)
+{
+#if (ET_PLATFORM_WIN)
+	return _aligned_malloc(size, alignment);
+#else
+	ET_ASSERT(alignment <= systemPageSize());
+	(void)alignment;
+
+	void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if (result == MAP_FAILED)
+		return nullptr;
+
+#	if (ET_MEMORY_ALLOCATOR_USE_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+	if (size >= hugePagesMinimumSize)
+		madvise(result, size, MADV_HUGEPAGE);
+#	endif
+
+	return result;
+#endif
+}
+
+static void releaseMemory(void* ptr, uint64_t size)
+{
+#if (ET_PLATFORM_WIN)
+	(void)size;
+	_aligned_free(ptr);
+#else
+	munmap(ptr, size);
+#endif
+}
+
+static uint64_t decommitMemory(void* begin, void* end)
+{
+#if (ET_PLATFORM_WIN)
+	(void)begin;
+	(void)end;
+	return 0;
+#else
+	uint64_t pageSize = systemPageSize();
+	uint64_t alignedBegin = alignUpTo(reinterpret_cast<uint64_t>(begin), pageSize);
+	uint64_t alignedEnd = reinterpret_cast<uint64_t>(end) & ~(pageSize - 1);
+	if (alignedEnd <= alignedBegin)
+		return 0;
+
+	if (madvise(reinterpret_cast<void*>(alignedBegin), alignedEnd - alignedBegin, MADV_DONTNEED) != 0)
+		return 0;
+
+	return alignedEnd - alignedBegin;
+#endif
+}
+
 class MemoryChunk
 {
 public:
@@ -42,6 +133,7 @@ public:
 	bool allocate(uint64_t size, void*& result);
 	bool containsPointer(char*);
 	bool free(char*);
+	uint64_t decommit();
 
 private:
 	MemoryChunk(const MemoryChunk&) = delete;
@@ -52,9 +144,14 @@ public:
 	char* allocatedMemoryBegin = nullptr;
 	char* allocatedMemoryEnd = nullptr;
 	char* actualDataMemory = nullptr;
+	bool committed = true;
 };
 
 
+/*
+ * Fixed-size blocks pool, free blocks are tracked with three-level occupancy bitmap
+ * (bit is set for free block), so allocation and release are O(1) using find-first-set.
+ */
 template <int blockSize>
 class SmallMemoryBlockAllocator
 {
@@ -66,19 +163,27 @@ public:
 
 	SmallMemoryBlockAllocator()
 	{
-		size_t sizeToAllocate = blocksCount * sizeof(SmallMemoryBlock);
+		size_t blocksSize = blocksCount * sizeof(SmallMemoryBlock);
+		size_t sizeToAllocate = blocksSize + (blockWordsCount + groupWordsCount) * sizeof(uint64_t);
 	
-	#if (ET_PLATFORM_WIN)
-		 blocks = reinterpret_cast<SmallMemoryBlock*>(_aligned_malloc(sizeToAllocate, 32));
-	#else
-		#error Implement allocation
-	#endif
-		
-		memset(blocks, 0, sizeToAllocate);
+		char* allocatedMemory = static_cast<char*>(reserveMemory(sizeToAllocate, 32));
+		if (allocatedMemory == nullptr)
+			ET_FAIL_FMT("Failed to allocate %llu bytes for small memory blocks", static_cast<uint64_t>(sizeToAllocate));
 
-		firstBlock = blocks;
-		currentBlock = firstBlock;
+		memset(allocatedMemory + blocksSize, 0, sizeToAllocate - blocksSize);
+
+		firstBlock = reinterpret_cast<SmallMemoryBlock*>(allocatedMemory);
 		lastBlock = firstBlock + blocksCount;
+		
+		_freeBlocks = reinterpret_cast<uint64_t*>(allocatedMemory + blocksSize);
+		_freeGroups = _freeBlocks + blockWordsCount;
+		for (uint64_t i = 0; i < blocksCount; ++i)
+			markAsFree(i);
+		_allocatedBlocks = 0;
+
+#	if (ET_DEBUG)
+		_allocationIndices.resize(blocksCount);
+#	endif
 	}
 
 	~SmallMemoryBlockAllocator()
@@ -88,12 +193,12 @@ public:
 		uint64_t totalLeaked = 0;
 
 		log::ConsoleOutput lOut;
-		for (auto i = firstBlock; i != lastBlock; ++i)
+		for (uint64_t i = 0; i < blocksCount; ++i)
 		{
-			if (i->blockAllocated)
+			if (isAllocated(i))
 			{
 				totalLeaked += blockSize;
-				detectedLeaks.insert(i->allocIndex);
+				detectedLeaks.insert(_allocationIndices[i]);
 			}
 		}
 
@@ -114,59 +219,59 @@ public:
 				"et::BlockMemoryAllocator::allocateOnBreaks({ %s })", totalLeaked, buffer);
 		}
 #endif
-	#if (ET_PLATFORM_WIN)
-		_aligned_free(blocks);
-	#else
-		#error Implement deallocation
-	#endif
+		releaseMemory(firstBlock, blocksCount * sizeof(SmallMemoryBlock) + (blockWordsCount + groupWordsCount) * sizeof(uint64_t));
 	}
 
 	bool allocate(void*& result)
 	{
-		auto startBlock = currentBlock;
-
-		while (currentBlock->blockAllocated)
+		if (_freeSummary == 0)
 		{
-			currentBlock = advance(currentBlock);
-			if (currentBlock == startBlock)
+			if (!_warningShown)
 			{
-				_haveFreeBlocks = false;
-				if (!_warningShown)
-				{
-					log::warning("Small memory block (%d) filled.", blockSize);
-					_warningShown = true;
-				}
-				return false;
+				log::warning("Small memory block (%d) filled.", blockSize);
+				_warningShown = true;
 			}
+			return false;
 		}
 
-		currentBlock->blockAllocated = 1;
-#	if (ET_DEBUG)
-		currentBlock->allocIndex = BlockMemoryAllocator::allocationIndex++;
-		if (_breakOnAllocations.count(currentBlock->allocIndex))
-		{
-			debug::debugBreak();
-		}
-#	endif
-		result = currentBlock->data;
-		currentBlock = advance(currentBlock);
+		uint64_t groupWord = findFirstSetBit(_freeSummary);
+		uint64_t blockWord = groupWord * bitsPerWord + findFirstSetBit(_freeGroups[groupWord]);
+		uint64_t index = blockWord * bitsPerWord + findFirstSetBit(_freeBlocks[blockWord]);
+		markAsAllocated(index);
 
+		result = firstBlock[index].data;
 		return true;
 	}
 
 	void free(void* ptr)
 	{
-		SmallMemoryBlock* block = reinterpret_cast<SmallMemoryBlock*>(ptr);
-
-		if ((ptr < firstBlock) || (ptr > lastBlock))
+		if (!containsPointer(ptr))
 			ET_FAIL_FMT("Pointer being freed (0x%016llx) was not allocated via this allocator.", (int64_t)ptr);
 
-		block->blockAllocated = 0;
+		if (!isAllocatedBlock(ptr))
+			ET_FAIL_FMT("Pointer being freed (0x%016llx) is not an allocated block.", (int64_t)ptr);
 
-		if (!_haveFreeBlocks)
-			currentBlock = block;
+		markAsFree(blockIndex(ptr));
+	}
 
-		_haveFreeBlocks = true;
+	bool isAllocatedBlock(void* ptr) const
+	{
+		uint64_t index = blockIndex(ptr);
+		return isAllocated(index) && (firstBlock[index].data == ptr);
+	}
+
+	void trackAllocation(void* ptr)
+	{
+#	if (ET_DEBUG)
+		uint64_t& allocIndex = _allocationIndices[blockIndex(ptr)];
+		allocIndex = BlockMemoryAllocator::allocationIndex++;
+		if (_breakOnAllocations.count(allocIndex))
+		{
+			debug::debugBreak();
+		}
+#	else
+		(void)ptr;
+#	endif
 	}
 
 	bool containsPointer(void* ptr)
@@ -177,44 +282,160 @@ public:
 
 	bool haveFreeBlocks()
 	{
-		return _haveFreeBlocks;
+		return _freeSummary != 0;
+	}
+
+	uint64_t allocatedBlocks() const
+	{
+		return _allocatedBlocks;
+	}
+
+	uint64_t totalBlocks() const
+	{
+		return blocksCount;
+	}
+
+	uint64_t decommitUnusedPages()
+	{
+		if (!_allocatedSinceDecommit)
+			return 0;
+
+		_allocatedSinceDecommit = false;
+
+		uint64_t decommittedSize = 0;
+		uint64_t index = 0;
+		while (index < blocksCount)
+		{
+			if (isAllocated(index))
+			{
+				++index;
+				continue;
+			}
+
+			uint64_t rangeBegin = index;
+			while ((index < blocksCount) && !isAllocated(index))
+				++index;
+
+			decommittedSize += decommitMemory(firstBlock + rangeBegin, firstBlock + index);
+		}
+		return decommittedSize;
 	}
 
 private:
-	enum
+	enum : uint64_t
 	{
-		blocksCount = 8 * megabytes / (blockSize + 4)
+		bitsPerWord = 64,
+		blocksCount = 8 * megabytes / blockSize,
+		blockWordsCount = (blocksCount + bitsPerWord - 1) / bitsPerWord,
+		groupWordsCount = (blockWordsCount + bitsPerWord - 1) / bitsPerWord,
 	};
 
 	struct SmallMemoryBlock
 	{
 		char data[blockSize];
-		uint32_t blockAllocated : 1;
-		uint32_t allocIndex : 31;
 	};
 
 	static_assert(sizeof(SmallMemoryBlock) % 32 == 0,
 		"Invalid block size will cause troubles allocating aligned objects");
 
-	SmallMemoryBlock* advance(SmallMemoryBlock* b)
+	static_assert(groupWordsCount <= bitsPerWord,
+		"Too many blocks to be tracked with three-level bitmap");
+
+	uint64_t blockIndex(void* ptr) const
 	{
-		++b;
-		return (b == lastBlock) ? firstBlock : b;
+		return static_cast<uint64_t>(static_cast<char*>(ptr) - firstBlock->data) / sizeof(SmallMemoryBlock);
+	}
+
+	bool isAllocated(uint64_t index) const
+	{
+		return (_freeBlocks[index / bitsPerWord] & (1ull << (index % bitsPerWord))) == 0;
+	}
+
+	void markAsAllocated(uint64_t index)
+	{
+		uint64_t blockWord = index / bitsPerWord;
+		_freeBlocks[blockWord] &= ~(1ull << (index % bitsPerWord));
+		if (_freeBlocks[blockWord] == 0)
+		{
+			uint64_t groupWord = blockWord / bitsPerWord;
+			_freeGroups[groupWord] &= ~(1ull << (blockWord % bitsPerWord));
+			if (_freeGroups[groupWord] == 0)
+				_freeSummary &= ~(1ull << groupWord);
+		}
+		++_allocatedBlocks;
+		_allocatedSinceDecommit = true;
+	}
+
+	void markAsFree(uint64_t index)
+	{
+		uint64_t blockWord = index / bitsPerWord;
+		uint64_t groupWord = blockWord / bitsPerWord;
+		_freeBlocks[blockWord] |= 1ull << (index % bitsPerWord);
+		_freeGroups[groupWord] |= 1ull << (blockWord % bitsPerWord);
+		_freeSummary |= 1ull << groupWord;
+		--_allocatedBlocks;
 	}
 
 public:
-	SmallMemoryBlock* blocks = nullptr;
 	SmallMemoryBlock* firstBlock = nullptr;
 	SmallMemoryBlock* lastBlock = nullptr;
-	SmallMemoryBlock* currentBlock = nullptr;
-	bool _haveFreeBlocks = true;
+
+private:
+	uint64_t* _freeBlocks = nullptr;
+	uint64_t* _freeGroups = nullptr;
+	uint64_t _freeSummary = 0;
+	uint64_t _allocatedBlocks = 0;
+#if (ET_DEBUG)
+	std::vector<uint64_t> _allocationIndices;
+#endif
+	bool _allocatedSinceDecommit = true;
 	bool _warningShown = false;
 };
 
+/*
+ * Per-thread magazines of small and medium blocks.
+ * Blocks are moved between a magazine and the shared pools in batches,
+ * so the common allocate / release path does not take the global lock.
+ * count is only written by the thread which owns the cache (or by allocator, once cache is detached),
+ * it is atomic so printInfo could read it from another thread.
+ */
+struct ThreadCacheBin
+{
+	void* blocks[threadCacheCapacity] { };
+	std::atomic<uint32_t> count{ 0 };
+};
+
+/*
+ * owner is reset by exchange, either by the thread (when it exits)
+ * or by the allocator (when it is destroyed), whoever gets the owner releases the cache
+ */
+struct ThreadCache
+{
+	std::atomic<BlockMemoryAllocatorPrivate*> owner{ nullptr };
+	ThreadCache* next = nullptr;
+	ThreadCacheBin small;
+	ThreadCacheBin medium;
+	uint64_t smallAllocations = 0;
+	uint64_t mediumAllocations = 0;
+	uint64_t minAllocSize = std::numeric_limits<uint64_t>::max();
+	uint64_t maxAllocSize = 0;
+};
+
+struct ThreadCacheSet
+{
+	ThreadCache caches[maxCachedAllocatorsPerThread];
+
+	~ThreadCacheSet();
+	ThreadCache* cacheForAllocator(BlockMemoryAllocatorPrivate*);
+};
+
+static thread_local ThreadCacheSet localThreadCaches;
+static thread_local bool localThreadCachesReleased = false;
+
 class BlockMemoryAllocatorPrivate
 {
 public:
-	BlockMemoryAllocatorPrivate();
+	BlockMemoryAllocatorPrivate(bool useThreadCaches);
 	~BlockMemoryAllocatorPrivate();
 
 	void* alloc(uint64_t);
@@ -226,9 +447,32 @@ public:
 
 	void printInfo();
 
+	void attachThreadCache(ThreadCache*);
+	void detachThreadCache(ThreadCache*);
+
+private:
+	ThreadCache* threadCache();
+
+	template <class A>
+	bool allocateFromThreadCache(ThreadCacheBin&, A&, void*&);
+
+	template <class A>
+	void releaseToThreadCache(ThreadCacheBin&, A&, void*);
+
+	template <class A>
+	void returnBlocks(ThreadCacheBin&, A&, uint32_t);
+
+	void releaseThreadCacheBlocks(ThreadCache*);
+
+	MemoryChunk& addChunk(uint64_t capacity);
+	MemoryChunk* chunkForPointer(char*);
+
 private:
 	CriticalSection _csLock;
 	std::list<MemoryChunk> _chunks;
+	std::vector<MemoryChunk*> _chunksByAddress;
+	ThreadCache* _threadCaches = nullptr;
+	bool _useThreadCaches = true;
 
 	SmallMemoryBlockAllocator<smallBlockSize> _allocatorSmall;
 	SmallMemoryBlockAllocator<mediumBlockSize> _allocatorMedium;
@@ -239,9 +483,9 @@ private:
 	uint64_t _maxAllocSize = 0;
 };
 
-BlockMemoryAllocator::BlockMemoryAllocator()
+BlockMemoryAllocator::BlockMemoryAllocator(bool useThreadCaches)
 {
-	ET_PIMPL_INIT(BlockMemoryAllocator);
+	ET_PIMPL_INIT(BlockMemoryAllocator, useThreadCaches);
 }
 
 BlockMemoryAllocator::~BlockMemoryAllocator()
@@ -277,13 +521,42 @@ void BlockMemoryAllocator::flushUnusedBlocks()
 /*
  * Private
  */
-BlockMemoryAllocatorPrivate::BlockMemoryAllocatorPrivate()
+BlockMemoryAllocatorPrivate::BlockMemoryAllocatorPrivate(bool useThreadCaches) :
+	_useThreadCaches(useThreadCaches)
 {
-	_chunks.emplace_back(defaultChunkSize);
+	addChunk(defaultChunkSize);
 }
 
 BlockMemoryAllocatorPrivate::~BlockMemoryAllocatorPrivate()
 {
+	/*
+	 * caches, which are being detached by exiting threads, are kept in the list
+	 * until detachThreadCache removes them, allocator could not be destroyed before that
+	 */
+	bool waitForDetach = true;
+	while (waitForDetach)
+	{
+		CriticalSectionScope lock(_csLock);
+		ThreadCache** link = &_threadCaches;
+		while (*link != nullptr)
+		{
+			ThreadCache* cache = *link;
+			if (cache->owner.exchange(nullptr) == this)
+			{
+				releaseThreadCacheBlocks(cache);
+				*link = cache->next;
+				cache->next = nullptr;
+			}
+			else
+			{
+				link = &cache->next;
+			}
+		}
+		waitForDetach = (_threadCaches != nullptr);
+		if (waitForDetach)
+			std::this_thread::yield();
+	}
+
 	log::ConsoleOutput out;
 	out.info("Allocation statistics: %u / %u / %u, sizes: %u .. %u", 
 		_smallAllocations, _mediumAllocations, _largeAllocations,
@@ -292,21 +565,42 @@ BlockMemoryAllocatorPrivate::~BlockMemoryAllocatorPrivate()
 
 void* BlockMemoryAllocatorPrivate::alloc(uint64_t allocSize)
 {
-	CriticalSectionScope lock(_csLock);
-
 	void* result = nullptr;
 
+	ThreadCache* cache = (allocSize <= mediumBlockSize) ? threadCache() : nullptr;
+	if (cache != nullptr)
+	{
+		cache->minAllocSize = std::min(cache->minAllocSize, allocSize);
+		cache->maxAllocSize = std::max(cache->maxAllocSize, allocSize);
+
+		if ((allocSize <= smallBlockSize) && allocateFromThreadCache(cache->small, _allocatorSmall, result))
+		{
+			++cache->smallAllocations;
+			return result;
+		}
+
+		if (allocateFromThreadCache(cache->medium, _allocatorMedium, result))
+		{
+			++cache->mediumAllocations;
+			return result;
+		}
+	}
+
+	CriticalSectionScope lock(_csLock);
+
 	_minAllocSize = std::min(_minAllocSize, allocSize);
 	_maxAllocSize = std::max(_maxAllocSize, allocSize);
 	
 	if ((allocSize <= smallBlockSize) && _allocatorSmall.haveFreeBlocks() && _allocatorSmall.allocate(result))
 	{
+		_allocatorSmall.trackAllocation(result);
 		++_smallAllocations;
 		return result;
 	}
 	
 	if ((allocSize <= mediumBlockSize) && _allocatorMedium.haveFreeBlocks() && _allocatorMedium.allocate(result))
 	{
+		_allocatorMedium.trackAllocation(result);
 		++_mediumAllocations;
 		return result;
 	}
@@ -317,9 +611,7 @@ void* BlockMemoryAllocatorPrivate::alloc(uint64_t allocSize)
 			return result;
 	}
 
-	_chunks.emplace_back(alignUpTo(std::max(allocSize, uint64_t(defaultChunkSize)), uint64_t(allocGranularity)));
-
-	MemoryChunk& lastChunk = _chunks.back();
+	MemoryChunk& lastChunk = addChunk(alignUpTo(std::max(allocSize, uint64_t(defaultChunkSize)), uint64_t(allocGranularity)));
 	if (lastChunk.allocate(allocSize, result))
 	{
 		++_largeAllocations;
@@ -344,11 +636,9 @@ bool BlockMemoryAllocatorPrivate::validate(void* ptr, bool abortOnFail)
 		return true;
 
 	char* charPtr = static_cast<char*>(ptr);
-	for (MemoryChunk& chunk : _chunks)
-	{
-		if (chunk.containsPointer(charPtr))
-			return true;
-	}
+	MemoryChunk* chunk = chunkForPointer(charPtr);
+	if ((chunk != nullptr) && chunk->containsPointer(charPtr))
+		return true;
 
 	if (abortOnFail)
 	{
@@ -361,17 +651,32 @@ bool BlockMemoryAllocatorPrivate::validate(void* ptr, bool abortOnFail)
 
 void BlockMemoryAllocatorPrivate::flushUnusedBlocks()
 {
+	ThreadCache* cache = threadCache();
+
 	CriticalSectionScope lock(_csLock);
 
+	if (cache != nullptr)
+		releaseThreadCacheBlocks(cache);
+
 	uint64_t blocksFlushed = 0;
 	uint64_t memoryReleased = 0;
+	uint64_t memoryDecommitted = _allocatorSmall.decommitUnusedPages() + _allocatorMedium.decommitUnusedPages();
 
 	auto i = _chunks.begin();
 	while (i != _chunks.end())
 	{
 		if (i->heap.empty())
 		{
+			if ((i == _chunks.begin()) && canDecommitMemory())
+			{
+				// keep first chunk mapped, next allocations will not need to map memory again
+				memoryDecommitted += i->decommit();
+				++i;
+				continue;
+			}
+
 			memoryReleased += i->heap.capacity();
+			_chunksByAddress.erase(std::find(_chunksByAddress.begin(), _chunksByAddress.end(), &(*i)));
 			i = _chunks.erase(i);
 			++blocksFlushed;
 		}
@@ -381,9 +686,10 @@ void BlockMemoryAllocatorPrivate::flushUnusedBlocks()
 		}
 	}
 
-	if (blocksFlushed > 0)
+	if ((blocksFlushed > 0) || (memoryDecommitted > 0))
 	{
-		log::info("[BlockMemoryAllocator] %u blocks flushed, total memory released: %u", blocksFlushed, memoryReleased);
+		log::info("[BlockMemoryAllocator] %llu blocks flushed, total memory released: %llu, decommitted: %llu", 
+			blocksFlushed, memoryReleased, memoryDecommitted);
 	}
 }
 
@@ -392,24 +698,35 @@ void BlockMemoryAllocatorPrivate::free(void* ptr)
 	if (ptr == nullptr) 
 		return;
 
+	bool smallBlock = _allocatorSmall.containsPointer(ptr);
+	bool mediumBlock = !smallBlock && _allocatorMedium.containsPointer(ptr);
+	
+	ThreadCache* cache = (smallBlock || mediumBlock) ? threadCache() : nullptr;
+	if (cache != nullptr)
+	{
+		if (smallBlock)
+			releaseToThreadCache(cache->small, _allocatorSmall, ptr);
+		else
+			releaseToThreadCache(cache->medium, _allocatorMedium, ptr);
+		return;
+	}
+
 	CriticalSectionScope lock(_csLock);
 
-	if (_allocatorSmall.containsPointer(ptr))
+	if (smallBlock)
 	{
 		_allocatorSmall.free(ptr);
 	}
-	else if (_allocatorMedium.containsPointer(ptr))
+	else if (mediumBlock)
 	{
 		_allocatorMedium.free(ptr);
 	}
 	else
 	{
 		char* charPtr = static_cast<char*>(ptr);
-		for (MemoryChunk& chunk : _chunks)
-		{
-			if (chunk.free(charPtr))
-				return;
-		}
+		MemoryChunk* chunk = chunkForPointer(charPtr);
+		if ((chunk != nullptr) && chunk->free(charPtr))
+			return;
 
 		ET_FAIL_FMT("Pointer being freed (0x%016llx) was not allocated via this allocator.", (int64_t)ptr);
 	}
@@ -417,65 +734,233 @@ void BlockMemoryAllocatorPrivate::free(void* ptr)
 
 void BlockMemoryAllocatorPrivate::printInfo()
 {
-	log::info("Memory allocator has %zu chunks:", _chunks.size());
+	/*
+	 * statistics are collected under the lock, other threads keep allocating meanwhile,
+	 * output is written after the lock is released
+	 */
+	uint64_t threadCachesCount = 0;
+	uint64_t cachedBlocks = 0;
+	uint64_t smallBlocksAllocated = 0;
+	uint64_t mediumBlocksAllocated = 0;
+	std::vector<std::pair<uint64_t, uint64_t>> chunksUsage;
+	{
+		CriticalSectionScope lock(_csLock);
+		for (ThreadCache* cache = _threadCaches; cache != nullptr; cache = cache->next)
+		{
+			cachedBlocks += cache->small.count.load(std::memory_order_relaxed) +
+				cache->medium.count.load(std::memory_order_relaxed);
+			++threadCachesCount;
+		}
+
+		chunksUsage.reserve(_chunks.size());
+		for (const MemoryChunk& chunk : _chunks)
+			chunksUsage.emplace_back(chunk.heap.allocatedSize(), chunk.heap.capacity());
+
+		smallBlocksAllocated = _allocatorSmall.allocatedBlocks();
+		mediumBlocksAllocated = _allocatorMedium.allocatedBlocks();
+	}
+
+	log::info("Memory allocator has %zu chunks, %llu thread caches (%llu blocks cached):", 
+		chunksUsage.size(), threadCachesCount, cachedBlocks);
 	log::info("{");
-	for (auto& chunk : _chunks)
+	for (const auto& usage : chunksUsage)
 	{
 		log::info("\t{");
-		uint64_t allocatedMemory = chunk.heap.allocatedSize();
+		uint64_t allocatedMemory = usage.first;
 		log::info("\t\tTotal memory used: %u (%uKb, %uMb) of %u (%uKb, %uMb)", allocatedMemory, allocatedMemory / 1024,
-			allocatedMemory / megabytes, chunk.heap.capacity(), chunk.heap.capacity() / 1024, chunk.heap.capacity() / megabytes);
+			allocatedMemory / megabytes, usage.second, usage.second / 1024, usage.second / megabytes);
 		log::info("\t}");
 	}
 
-	uint64_t allocatedBlocks = 0;
-
-	log::info("\t0...48 bytes");
+	log::info("\t%d bytes blocks", static_cast<int>(smallBlockSize));
 	log::info("\t{");
-	allocatedBlocks = 0;
-	for (auto i = _allocatorSmall.firstBlock; i != _allocatorSmall.lastBlock; ++i)
-		allocatedBlocks += i->blockAllocated;
-	log::info("\t\tallocated blocks : %u of %lld", allocatedBlocks, (int64_t)(_allocatorSmall.lastBlock - _allocatorSmall.firstBlock));
-	log::info("\t\tcurrent offset : %lld", (int64_t)(_allocatorSmall.currentBlock - _allocatorSmall.firstBlock));
+	log::info("\t\tallocated blocks : %llu of %llu", smallBlocksAllocated, _allocatorSmall.totalBlocks());
 	log::info("\t},");
 
-	log::info("\t48...96");
+	log::info("\t%d bytes blocks", static_cast<int>(mediumBlockSize));
 	log::info("\t{");
-	allocatedBlocks = 0;
-	for (auto i = _allocatorMedium.firstBlock; i != _allocatorMedium.lastBlock; ++i)
-		allocatedBlocks += i->blockAllocated;
-	log::info("\t\tallocated blocks : %u of %lld", allocatedBlocks, (int64_t)(_allocatorMedium.lastBlock - _allocatorMedium.firstBlock));
-	log::info("\t\tcurrent offset : %lld", (int64_t)(_allocatorMedium.currentBlock - _allocatorMedium.firstBlock));
+	log::info("\t\tallocated blocks : %llu of %llu", mediumBlocksAllocated, _allocatorMedium.totalBlocks());
 	log::info("\t}");
 
 	log::info("}");
 }
 
+MemoryChunk& BlockMemoryAllocatorPrivate::addChunk(uint64_t capacity)
+{
+	_chunks.emplace_back(capacity);
+	
+	MemoryChunk* chunk = &_chunks.back();
+	auto position = std::upper_bound(_chunksByAddress.begin(), _chunksByAddress.end(), chunk, 
+		[](const MemoryChunk* l, const MemoryChunk* r) { return l->allocatedMemoryBegin < r->allocatedMemoryBegin; });
+	_chunksByAddress.insert(position, chunk);
+
+	return *chunk;
+}
+
+MemoryChunk* BlockMemoryAllocatorPrivate::chunkForPointer(char* ptr)
+{
+	auto i = std::upper_bound(_chunksByAddress.begin(), _chunksByAddress.end(), ptr, 
+		[](const char* p, const MemoryChunk* chunk) { return p < chunk->allocatedMemoryBegin; });
+
+	if (i == _chunksByAddress.begin())
+		return nullptr;
+
+	MemoryChunk* chunk = *(--i);
+	return (ptr < chunk->allocatedMemoryEnd) ? chunk : nullptr;
+}
+
 /*
- * Chunk
+ * Thread caches
  */
-MemoryChunk::MemoryChunk(uint64_t capacity) :
-	heap(capacity, minimumAllocationSize)
+ThreadCache* BlockMemoryAllocatorPrivate::threadCache()
 {
-	uint64_t actualDataOffset = heap.requiredInfoSize();
-	uint64_t totalSize = alignUpTo(actualDataOffset + capacity, uint64_t(minimumAllocationSize));
+	if (!_useThreadCaches || localThreadCachesReleased)
+		return nullptr;
 
-#if (ET_PLATFORM_APPLE)
+	return localThreadCaches.cacheForAllocator(this);
+}
 
-	void* allocatedPtr = nullptr;
-	posix_memalign(&allocatedPtr, minimumAllocationSize, totalSize);
-	allocatedMemoryBegin = static_cast<char*>(allocatedPtr);
+template <class A>
+bool BlockMemoryAllocatorPrivate::allocateFromThreadCache(ThreadCacheBin& bin, A& allocator, void*& result)
+{
+	uint32_t count = bin.count.load(std::memory_order_relaxed);
+	if (count == 0)
+	{
+		CriticalSectionScope lock(_csLock);
+		while ((count < threadCacheBatchSize) && allocator.haveFreeBlocks() && allocator.allocate(bin.blocks[count]))
+			++count;
+	}
 
-#elif (ET_PLATFORM_WIN)
+	if (count == 0)
+		return false;
 
-	allocatedMemoryBegin = static_cast<char*>(_aligned_malloc(totalSize, minimumAllocationSize));
+	result = bin.blocks[--count];
+	bin.count.store(count, std::memory_order_relaxed);
+	allocator.trackAllocation(result);
+	return true;
+}
 
-#else
-#
-#	error Use any available aligned malloc
-#
+template <class A>
+void BlockMemoryAllocatorPrivate::releaseToThreadCache(ThreadCacheBin& bin, A& allocator, void* ptr)
+{
+#if (ET_DEBUG)
+	/*
+	 * same check as on global path: block should be allocated in the pool
+	 * (cached blocks are allocated there as well) and should not be cached already
+	 */
+	{
+		uint32_t cachedCount = bin.count.load(std::memory_order_relaxed);
+		bool alreadyCached = std::find(bin.blocks, bin.blocks + cachedCount, ptr) != (bin.blocks + cachedCount);
+
+		CriticalSectionScope lock(_csLock);
+		if (alreadyCached || !allocator.isAllocatedBlock(ptr))
+			ET_FAIL_FMT("Pointer being freed (0x%016llx) is not an allocated block.", (int64_t)ptr);
+	}
 #endif
 
+	if (bin.count.load(std::memory_order_relaxed) == threadCacheCapacity)
+	{
+		CriticalSectionScope lock(_csLock);
+		returnBlocks(bin, allocator, threadCacheBatchSize);
+	}
+
+	uint32_t count = bin.count.load(std::memory_order_relaxed);
+	bin.blocks[count] = ptr;
+	bin.count.store(count + 1, std::memory_order_relaxed);
+}
+
+template <class A>
+void BlockMemoryAllocatorPrivate::returnBlocks(ThreadCacheBin& bin, A& allocator, uint32_t count)
+{
+	uint32_t cachedCount = bin.count.load(std::memory_order_relaxed);
+	ET_ASSERT(count <= cachedCount);
+	while (count-- > 0)
+		allocator.free(bin.blocks[--cachedCount]);
+	bin.count.store(cachedCount, std::memory_order_relaxed);
+}
+
+void BlockMemoryAllocatorPrivate::releaseThreadCacheBlocks(ThreadCache* cache)
+{
+	returnBlocks(cache->small, _allocatorSmall, cache->small.count.load(std::memory_order_relaxed));
+	returnBlocks(cache->medium, _allocatorMedium, cache->medium.count.load(std::memory_order_relaxed));
+
+	_smallAllocations += cache->smallAllocations;
+	_mediumAllocations += cache->mediumAllocations;
+	_minAllocSize = std::min(_minAllocSize, cache->minAllocSize);
+	_maxAllocSize = std::max(_maxAllocSize, cache->maxAllocSize);
+	cache->smallAllocations = 0;
+	cache->mediumAllocations = 0;
+}
+
+void BlockMemoryAllocatorPrivate::attachThreadCache(ThreadCache* cache)
+{
+	CriticalSectionScope lock(_csLock);
+	cache->owner.store(this);
+	cache->next = _threadCaches;
+	_threadCaches = cache;
+}
+
+void BlockMemoryAllocatorPrivate::detachThreadCache(ThreadCache* cache)
+{
+	CriticalSectionScope lock(_csLock);
+	ET_ASSERT(cache->owner.load() == nullptr);
+
+	releaseThreadCacheBlocks(cache);
+
+	ThreadCache** link = &_threadCaches;
+	while ((*link != nullptr) && (*link != cache))
+		link = &((*link)->next);
+
+	if (*link == cache)
+		*link = cache->next;
+
+	cache->next = nullptr;
+}
+
+ThreadCache* ThreadCacheSet::cacheForAllocator(BlockMemoryAllocatorPrivate* allocator)
+{
+	ThreadCache* freeCache = nullptr;
+	for (ThreadCache& cache : caches)
+	{
+		BlockMemoryAllocatorPrivate* owner = cache.owner.load();
+		if (owner == allocator)
+			return &cache;
+
+		if ((freeCache == nullptr) && (owner == nullptr))
+			freeCache = &cache;
+	}
+
+	if (freeCache != nullptr)
+		allocator->attachThreadCache(freeCache);
+
+	return freeCache;
+}
+
+ThreadCacheSet::~ThreadCacheSet()
+{
+	localThreadCachesReleased = true;
+	for (ThreadCache& cache : caches)
+	{
+		BlockMemoryAllocatorPrivate* owner = cache.owner.exchange(nullptr);
+		if (owner != nullptr)
+			owner->detachThreadCache(&cache);
+	}
+}
+
+/*
+ * Chunk
+ */
+MemoryChunk::MemoryChunk(uint64_t capacity) :
+	heap(capacity, minimumAllocationSize)
+{
+	/*
+	 * heap info size is arbitrary, data area should start aligned,
+	 * so aligned types (SIMD data) stay aligned in allocated blocks
+	 */
+	uint64_t actualDataOffset = alignUpTo(heap.requiredInfoSize(), uint64_t(minimumAllocationSize));
+	uint64_t totalSize = alignUpTo(actualDataOffset + capacity, uint64_t(minimumAllocationSize));
+
+	allocatedMemoryBegin = static_cast<char*>(reserveMemory(totalSize, minimumAllocationSize));
 	if (allocatedMemoryBegin == nullptr)
 	{
 		ET_FAIL_FMT("Failed to allocate %u bytes (%u requested + %u info)", totalSize, capacity, actualDataOffset);
@@ -497,11 +982,7 @@ MemoryChunk::~MemoryChunk()
 	}
 #endif
 
-#if (ET_PLATFORM_WIN)
-	_aligned_free(allocatedMemoryBegin);
-#else
-	::free(allocatedMemoryBegin);
-#endif
+	releaseMemory(allocatedMemoryBegin, static_cast<uint64_t>(allocatedMemoryEnd - allocatedMemoryBegin));
 }
 
 bool MemoryChunk::allocate(uint64_t sizeToAllocate, void*& result)
@@ -509,7 +990,9 @@ bool MemoryChunk::allocate(uint64_t sizeToAllocate, void*& result)
 	uint64_t offset = 0;
 	if (heap.allocate(sizeToAllocate, offset))
 	{
+		committed = true;
 		result = actualDataMemory + offset;
+		ET_ASSERT((reinterpret_cast<uintptr_t>(result) % 16) == 0);
 		return true;
 	}
 	return false;
@@ -529,4 +1012,14 @@ bool MemoryChunk::free(char* ptr)
 	return heap.release(static_cast<uint64_t>(ptr - actualDataMemory));
 }
 
+uint64_t MemoryChunk::decommit()
+{
+	ET_ASSERT(heap.empty());
+	if (!committed)
+		return 0;
+
+	committed = false;
+	return decommitMemory(actualDataMemory, allocatedMemoryEnd);
+}
+
 }
@@ -45,7 +45,11 @@ public:
 #endif
 
 public:
-	BlockMemoryAllocator();
+	/*
+	 * useThreadCaches enables per-thread caches for small and medium blocks,
+	 * allocations and releases of such blocks will not take global lock in most cases
+	 */
+	BlockMemoryAllocator(bool useThreadCaches = true);
 	~BlockMemoryAllocator();
 	
 	void* allocate(uint64_t);
@@ -56,7 +60,7 @@ public:
 	void flushUnusedBlocks();
 			
 private:
-	ET_DECLARE_PIMPL(BlockMemoryAllocator, 256);
+	ET_DECLARE_PIMPL(BlockMemoryAllocator, 384);
 };
 
 /*
@@ -175,11 +175,13 @@ void ObjectsCache::update(float t)
 
 	float dt = t - _updateTime;
 
-	if (dt > updateInterval)
+	if (dt >= updateInterval)
 	{
 		performUpdate();
 		_updateTime = t;
 	}
+
+	scheduleUpdate(_updateTime + updateInterval);
 }
 
 uint64_t ObjectsCache::getFileProperty(const std::string& p)
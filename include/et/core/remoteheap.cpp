@@ -10,22 +10,51 @@
 namespace et
 {
 
+/*
+ * Two-level segregated fit allocator (TLSF).
+ * All information is stored in units of granularity in external info storage:
+ * - header with first and second level bitmaps and heads of free lists;
+ * - boundary tags (size and free flag) written at first and last unit of every block;
+ * - links of free lists written at first unit of every free block.
+ * Both allocate and release are O(1) and does not depend on fragmentation:
+ * requested size is rounded up to the next size class, so lists are never scanned.
+ */
 struct RemoteHeapPrivate
 {
-	enum : uint8_t
+	enum : uint32_t
+	{
+		SecondLevelBits = 4,
+		SecondLevelCount = 1 << SecondLevelBits,
+		FirstLevelCount = 32,
+		FreeFlag = 0x80000000,
+		SizeMask = ~FreeFlag,
+		InvalidIndex = 0xffffffff,
+	};
+
+	struct Header
 	{
-		Empty = 0x00,
-		AllocationBegin = 0x01,
-		AllocationInterior = 0x02,
-		AllocationEnd = 0x03
+		uint32_t firstLevel = 0;
+		uint32_t secondLevel[FirstLevelCount] { };
+		uint32_t freeLists[FirstLevelCount][SecondLevelCount] { };
 	};
 
 	uint64_t capacity = 0;
 	uint64_t granularity = 0;
 	uint64_t infoSize = 0;
-	uint64_t firstEmpty = 0;
+	uint64_t unitsCount = 0;
 	uint64_t allocatedSize = 0;
-	uint8_t* info = nullptr;
+	Header* header = nullptr;
+	uint32_t* tags = nullptr;
+	uint32_t* nextFree = nullptr;
+	uint32_t* previousFree = nullptr;
+
+	void reset();
+
+	void mapping(uint32_t size, uint32_t& fl, uint32_t& sl) const;
+	void setTags(uint32_t index, uint32_t size, uint32_t flags);
+	void insertFreeBlock(uint32_t index, uint32_t size);
+	void removeFreeBlock(uint32_t index, uint32_t size);
+	uint32_t findFreeBlock(uint32_t size);
 };
 
 RemoteHeap::RemoteHeap()
@@ -48,12 +77,7 @@ RemoteHeap::RemoteHeap(RemoteHeap&& r)
 RemoteHeap& RemoteHeap::operator = (RemoteHeap&& r)
 {
 	std::swap(*_private, *r._private);
-	r._private->capacity = 0;
-	r._private->granularity = 0;
-	r._private->infoSize = 0;
-	r._private->firstEmpty = 0;
-	r._private->allocatedSize = 0;
-	r._private->info = nullptr;
+	*r._private = RemoteHeapPrivate();
 	return *this;
 }
 
@@ -66,65 +90,37 @@ void RemoteHeap::init(uint64_t cap, uint64_t gr)
 {
 	_private->capacity = cap;
 	_private->granularity = gr;
-	_private->infoSize = (_private->capacity + _private->granularity - 1) / _private->granularity;
+	_private->unitsCount = (_private->capacity + _private->granularity - 1) / _private->granularity;
+	ET_ASSERT(_private->unitsCount < RemoteHeapPrivate::SizeMask);
+
+	_private->infoSize = sizeof(RemoteHeapPrivate::Header) + 3 * sizeof(uint32_t) * _private->unitsCount;
 }
 
 bool RemoteHeap::allocate(uint64_t sizeToAllocate, uint64_t& offset)
 {
-	uint64_t alignedSize = alignUpTo(sizeToAllocate, _private->granularity);
-	uint64_t requiredInfoSize = alignedSize / _private->granularity;
-
-	if (_private->firstEmpty + requiredInfoSize > _private->infoSize)
+	uint64_t alignedSize = alignUpTo(std::max(sizeToAllocate, uint64_t(1)), _private->granularity);
+	uint64_t requiredUnits = alignedSize / _private->granularity;
+	if (requiredUnits > _private->unitsCount - _private->allocatedSize / _private->granularity)
 		return false;
 
-	bool allocated = false;
+	uint32_t size = static_cast<uint32_t>(requiredUnits);
+	uint32_t index = _private->findFreeBlock(size);
+	if (index == RemoteHeapPrivate::InvalidIndex)
+		return false;
 
-	uint8_t* ptr = _private->info + _private->firstEmpty;
-	uint8_t* end = _private->info + _private->infoSize;
+	uint32_t blockSize = _private->tags[index] & RemoteHeapPrivate::SizeMask;
+	_private->removeFreeBlock(index, blockSize);
 
-	ET_ASSERT(*ptr == RemoteHeapPrivate::Empty);
-	
-	uint64_t sz = 1;
-	uint8_t* seekBegin = ptr;
-	uint8_t* allocationBegin = ptr;
-	while (ptr < end)
+	if (blockSize > size)
 	{
-		if (*ptr)
-		{
-			allocationBegin += sz;
-			sz = 0;
-		}
-
-		if (sz == requiredInfoSize)
-		{
-			ET_ASSERT(*allocationBegin == RemoteHeapPrivate::Empty);
-
-			uint8_t* allocationEnd = allocationBegin + requiredInfoSize - 1;
-			ET_ASSERT(*allocationEnd == RemoteHeapPrivate::Empty);
-			
-			offset = _private->granularity * static_cast<uint64_t>(allocationBegin - _private->info);
-			_private->allocatedSize += _private->granularity * requiredInfoSize;
-
-			uint64_t usedChunks = static_cast<uint64_t>(allocationEnd - allocationBegin);
-			memset(allocationBegin, RemoteHeapPrivate::AllocationInterior, usedChunks);
-			*allocationBegin = RemoteHeapPrivate::AllocationBegin;
-			*allocationEnd = RemoteHeapPrivate::AllocationEnd;
-			
-			if (allocationBegin == seekBegin)
-			{
-				_private->firstEmpty += usedChunks;
-				while ((allocationEnd < end) && (*allocationEnd++))
-					_private->firstEmpty++;
-			}
-			allocated = true;
-			break;
-		}
-
-		++ptr;
-		++sz;
+		_private->setTags(index + size, blockSize - size, RemoteHeapPrivate::FreeFlag);
+		_private->insertFreeBlock(index + size, blockSize - size);
 	}
-	
-	return allocated;
+	_private->setTags(index, size, 0);
+
+	offset = _private->granularity * index;
+	_private->allocatedSize += _private->granularity * size;
+	return true;
 }
 
 bool RemoteHeap::release(uint64_t offset)
@@ -132,28 +128,41 @@ bool RemoteHeap::release(uint64_t offset)
 	if (offset % _private->granularity)
 		return false;
 
-	uint64_t index = offset / _private->granularity;
-	if (index >= _private->infoSize)
+	uint64_t unitIndex = offset / _private->granularity;
+	if (unitIndex >= _private->unitsCount)
 		return false;
 
-	uint8_t* ptr = _private->info + index;
-	uint8_t state = *ptr;
-	ET_ASSERT((state == RemoteHeapPrivate::AllocationBegin) || (state == RemoteHeapPrivate::AllocationEnd));
+	uint32_t index = static_cast<uint32_t>(unitIndex);
+	uint32_t tag = _private->tags[index];
+	uint32_t size = tag & RemoteHeapPrivate::SizeMask;
+	if ((tag & RemoteHeapPrivate::FreeFlag) || (size == 0) || (index + size > _private->unitsCount) || 
+		(_private->tags[index + size - 1] != tag))
+	{
+		ET_ASSERT(!"Attempt to release memory which was not allocated here");
+		return false;
+	}
+
+	ET_ASSERT(size * _private->granularity <= _private->allocatedSize);
+	_private->allocatedSize -= size * _private->granularity;
 
-	uint64_t freedSize = 0;
-	do 
+	uint32_t nextIndex = index + size;
+	if ((nextIndex < _private->unitsCount) && (_private->tags[nextIndex] & RemoteHeapPrivate::FreeFlag))
 	{
-		freedSize++;
-		state = *ptr;
-		*ptr++ = RemoteHeapPrivate::Empty;
-	} while (state != RemoteHeapPrivate::AllocationEnd);
+		uint32_t nextSize = _private->tags[nextIndex] & RemoteHeapPrivate::SizeMask;
+		_private->removeFreeBlock(nextIndex, nextSize);
+		size += nextSize;
+	}
 
-	freedSize *= _private->granularity;
-	ET_ASSERT(freedSize <= _private->allocatedSize);
+	if ((index > 0) && (_private->tags[index - 1] & RemoteHeapPrivate::FreeFlag))
+	{
+		uint32_t previousSize = _private->tags[index - 1] & RemoteHeapPrivate::SizeMask;
+		index -= previousSize;
+		_private->removeFreeBlock(index, previousSize);
+		size += previousSize;
+	}
 
-	_private->allocatedSize -= freedSize;
-	_private->firstEmpty = std::min(_private->firstEmpty, index);
-	ET_ASSERT(_private->info[_private->firstEmpty] == RemoteHeapPrivate::Empty);
+	_private->setTags(index, size, RemoteHeapPrivate::FreeFlag);
+	_private->insertFreeBlock(index, size);
 
 	return true;
 }
@@ -164,7 +173,7 @@ bool RemoteHeap::containsAllocationWithOffset(uint64_t offset)
 		return false;
 
 	uint64_t index = offset / _private->granularity;
-	if (index >= _private->infoSize)
+	if (index >= _private->unitsCount)
 		return false;
 
 	return true;
@@ -182,8 +191,14 @@ uint64_t RemoteHeap::capacity() const
 
 void RemoteHeap::setInfoStorage(void* ptr)
 {
-	_private->info = reinterpret_cast<uint8_t*>(ptr);
-	memset(_private->info, RemoteHeapPrivate::Empty, _private->infoSize);
+	uint8_t* info = reinterpret_cast<uint8_t*>(ptr);
+	ET_ASSERT(reinterpret_cast<uintptr_t>(info) % sizeof(uint32_t) == 0);
+
+	_private->header = reinterpret_cast<RemoteHeapPrivate::Header*>(info);
+	_private->tags = reinterpret_cast<uint32_t*>(info + sizeof(RemoteHeapPrivate::Header));
+	_private->nextFree = _private->tags + _private->unitsCount;
+	_private->previousFree = _private->nextFree + _private->unitsCount;
+	_private->reset();
 }
 
 bool RemoteHeap::empty() const
@@ -198,9 +213,136 @@ uint64_t RemoteHeap::allocatedSize() const
 
 void RemoteHeap::clear()
 {
-	_private->allocatedSize = 0;
-	_private->firstEmpty = 0;
-	memset(_private->info, RemoteHeapPrivate::Empty, _private->infoSize);
+	_private->reset();
+}
+
+/*
+ * Private
+ */
+void RemoteHeapPrivate::reset()
+{
+	allocatedSize = 0;
+	if (header == nullptr)
+		return;
+
+	header->firstLevel = 0;
+	memset(header->secondLevel, 0, sizeof(header->secondLevel));
+	memset(header->freeLists, 0xff, sizeof(header->freeLists));
+
+	if (unitsCount > 0)
+	{
+		uint32_t size = static_cast<uint32_t>(unitsCount);
+		setTags(0, size, FreeFlag);
+		insertFreeBlock(0, size);
+	}
+}
+
+void RemoteHeapPrivate::mapping(uint32_t size, uint32_t& fl, uint32_t& sl) const
+{
+	if (size < SecondLevelCount)
+	{
+		fl = 0;
+		sl = size;
+	}
+	else
+	{
+		uint32_t lastBit = findLastSetBit(size);
+		fl = lastBit - SecondLevelBits + 1;
+		sl = (size >> (lastBit - SecondLevelBits)) ^ SecondLevelCount;
+	}
+}
+
+void RemoteHeapPrivate::setTags(uint32_t index, uint32_t size, uint32_t flags)
+{
+	ET_ASSERT(size > 0);
+	tags[index] = size | flags;
+	tags[index + size - 1] = size | flags;
+}
+
+void RemoteHeapPrivate::insertFreeBlock(uint32_t index, uint32_t size)
+{
+	uint32_t fl = 0;
+	uint32_t sl = 0;
+	mapping(size, fl, sl);
+
+	uint32_t head = header->freeLists[fl][sl];
+	nextFree[index] = head;
+	previousFree[index] = InvalidIndex;
+	if (head != InvalidIndex)
+		previousFree[head] = index;
+
+	header->freeLists[fl][sl] = index;
+	header->firstLevel |= 1u << fl;
+	header->secondLevel[fl] |= 1u << sl;
+}
+
+void RemoteHeapPrivate::removeFreeBlock(uint32_t index, uint32_t size)
+{
+	uint32_t fl = 0;
+	uint32_t sl = 0;
+	mapping(size, fl, sl);
+
+	uint32_t next = nextFree[index];
+	uint32_t previous = previousFree[index];
+
+	if (next != InvalidIndex)
+		previousFree[next] = previous;
+
+	if (previous != InvalidIndex)
+	{
+		nextFree[previous] = next;
+	}
+	else
+	{
+		ET_ASSERT(header->freeLists[fl][sl] == index);
+		header->freeLists[fl][sl] = next;
+		if (next == InvalidIndex)
+		{
+			header->secondLevel[fl] &= ~(1u << sl);
+			if (header->secondLevel[fl] == 0)
+				header->firstLevel &= ~(1u << fl);
+		}
+	}
+}
+
+uint32_t RemoteHeapPrivate::findFreeBlock(uint32_t size)
+{
+	uint32_t fl = 0;
+	uint32_t sl = 0;
+
+	/*
+	 * Round size up to the next list, so any block from that list will fit
+	 */
+	uint32_t roundedSize = size;
+	if (size >= SecondLevelCount)
+	{
+		uint32_t roundUp = (1u << (findLastSetBit(size) - SecondLevelBits)) - 1;
+		if (roundedSize <= SizeMask - roundUp)
+			roundedSize += roundUp;
+	}
+	mapping(roundedSize, fl, sl);
+
+	uint32_t secondLevelMap = header->secondLevel[fl] & (~0u << sl);
+	if (secondLevelMap == 0)
+	{
+		uint32_t firstLevelMap = (fl + 1 < FirstLevelCount) ? header->firstLevel & (~0u << (fl + 1)) : 0;
+		if (firstLevelMap != 0)
+		{
+			fl = findFirstSetBit(firstLevelMap);
+			secondLevelMap = header->secondLevel[fl];
+		}
+	}
+
+	if (secondLevelMap != 0)
+		return header->freeLists[fl][findFirstSetBit(secondLevelMap)];
+
+	/*
+	 * Nothing found in larger lists, only the head of the list of requested size is checked,
+	 * so a block which is the only one in its class (e.g. entire free heap) still could be used
+	 */
+	mapping(size, fl, sl);
+	uint32_t head = header->freeLists[fl][sl];
+	return ((head != InvalidIndex) && ((tags[head] & SizeMask) >= size)) ? head : InvalidIndex;
 }
 
 }
@@ -12,6 +12,14 @@
 
 namespace et
 {
+/*
+ * Manages offsets in a remote memory range (e.g. GPU buffer) with two-level segregated fit.
+ * allocate and release take constant time regardless of fragmentation. Request is rounded up
+ * to the next size class (at most 1/16 larger), so allocation could fail when the only block
+ * that fits shares a class with the request and is not the first in its list.
+ * Info storage (requiredInfoSize) is 2180 bytes of header plus 12 bytes per granularity unit,
+ * e.g. ~9% of capacity with 128 byte granularity and ~0.3% with 4096 byte granularity.
+ */
 struct RemoteHeapPrivate;
 class RemoteHeap
 {
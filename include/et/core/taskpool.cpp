@@ -21,18 +21,22 @@ TaskPool::~TaskPool()
 	
 	for (auto i : _tasks)
 		etDestroyObject(i);
+
+	for (auto i : _tasksToAdd)
+		etDestroyObject(i);
 }
 
 void TaskPool::addTask(Task* t, float delay)
 {
 	CriticalSectionScope lock(_csModifying);
 	
-	auto alreadyAdded = std::find(_tasksToAdd.begin(), _tasksToAdd.end(), t);
-	if (alreadyAdded == _tasksToAdd.end())
-	{
-		t->setExecutionTime(_lastTime + delay);
-		_tasksToAdd.push_back(t); 
-	}
+	if (t->_scheduled)
+		return;
+
+	t->_scheduled = true;
+	t->_sequence = _nextSequence++;
+	t->setExecutionTime(_lastTime + delay);
+	_tasksToAdd.push_back(t);
 }
 
 void TaskPool::update(float currentTime)
@@ -41,20 +45,14 @@ void TaskPool::update(float currentTime)
 	
 	_lastTime = currentTime;
 	
-	auto i = _tasks.begin();
-	while (i != _tasks.end())
+	while (!_tasks.empty() && (_lastTime >= _tasks.front()->executionTime()))
 	{
-		Task* task = (*i);
-		if (_lastTime >= task->executionTime())
-		{
-			task->execute();
-			etDestroyObject(task);
-			i = _tasks.erase(i);
-		}
-		else
-		{
-			++i;
-		}
+		std::pop_heap(_tasks.begin(), _tasks.end(), executesLater);
+		Task* task = _tasks.back();
+		_tasks.pop_back();
+
+		task->execute();
+		etDestroyObject(task);
 	}
 }
 
@@ -64,13 +62,20 @@ bool TaskPool::hasTasks()
 	return !(_tasks.empty() && _tasksToAdd.empty());
 }
 
+bool TaskPool::executesLater(const Task* a, const Task* b)
+{
+	return (a->executionTime() > b->executionTime()) ||
+		((a->executionTime() == b->executionTime()) && (a->_sequence > b->_sequence));
+}
+
 void TaskPool::joinTasks()
 {
 	CriticalSectionScope lock(_csModifying);
 	
-	if (!_tasksToAdd.empty())
+	for (Task* task : _tasksToAdd)
 	{
-		_tasks.insert(_tasks.end(), _tasksToAdd.begin(), _tasksToAdd.end());
-		_tasksToAdd.clear();
+		_tasks.push_back(task);
+		std::push_heap(_tasks.begin(), _tasks.end(), executesLater);
 	}
+	_tasksToAdd.clear();
 }
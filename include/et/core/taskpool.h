@@ -25,13 +25,19 @@ namespace et
 				
 	private:
 		void joinTasks();
+		static bool executesLater(const Task*, const Task*);
 		
 		ET_DENY_COPY(TaskPool);
 		
 	private:
+		/*
+		 * _tasks is a binary min-heap ordered by execution time,
+		 * tasks with equal execution time are executed in order they were added
+		 */
 		CriticalSection _csModifying;
-        Task::List _tasks;
+		Task::List _tasks;
 		Task::List _tasksToAdd;
+		uint64_t _nextSequence = 0;
 		float _lastTime = 0.0f;
 	};
 }
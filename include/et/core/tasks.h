@@ -30,6 +30,8 @@ namespace et
 		friend class TaskPool;
 
 	private:
+		uint64_t _sequence = 0;
 		float _executionTime = 0.0f;
+		bool _scheduled = false;
 	};
 }
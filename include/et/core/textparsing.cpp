@@ -0,0 +1,512 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/textparsing.h>
+
+#if (ET_SIMD_SSE)
+#	include <immintrin.h>
+#endif
+
+#if (ET_PLATFORM_WIN)
+#	include <intrin.h>
+#endif
+
+namespace et
+{
+namespace
+{
+enum : int32_t
+{
+	MaxSignificantDigits = 19,
+	MaxExactPowerOfTen = 10,
+	SmallestPowerOfTen = -65,
+	LargestPowerOfTen = 38,
+};
+
+/*
+ * 128 bit approximations of 5^q for all decimal exponents, which could give finite non-zero float
+ * from the 19 digit mantissa, normalized so that the most significant bit is set
+ */
+const uint64_t powersOfFive[LargestPowerOfTen - SmallestPowerOfTen + 1][2] =
+{
+	{ 0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull }, // 5^-65
+	{ 0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull }, // 5^-64
+	{ 0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull }, // 5^-63
+	{ 0x83a3eeeef9153e89ull, 0x1953cf68300424acull }, // 5^-62
+	{ 0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull }, // 5^-61
+	{ 0xcdb02555653131b6ull, 0x3792f412cb06794dull }, // 5^-60
+	{ 0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull }, // 5^-59
+	{ 0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull }, // 5^-58
+	{ 0xc8de047564d20a8bull, 0xf245825a5a445275ull }, // 5^-57
+	{ 0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull }, // 5^-56
+	{ 0x9ced737bb6c4183dull, 0x55464dd69685606bull }, // 5^-55
+	{ 0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull }, // 5^-54
+	{ 0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull }, // 5^-53
+	{ 0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull }, // 5^-52
+	{ 0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull }, // 5^-51
+	{ 0xef73d256a5c0f77cull, 0x963e66858f6d4440ull }, // 5^-50
+	{ 0x95a8637627989aadull, 0xdde7001379a44aa8ull }, // 5^-49
+	{ 0xbb127c53b17ec159ull, 0x5560c018580d5d52ull }, // 5^-48
+	{ 0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull }, // 5^-47
+	{ 0x9226712162ab070dull, 0xcab3961304ca70e8ull }, // 5^-46
+	{ 0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull }, // 5^-45
+	{ 0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull }, // 5^-44
+	{ 0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull }, // 5^-43
+	{ 0xb267ed1940f1c61cull, 0x55f038b237591ed3ull }, // 5^-42
+	{ 0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull }, // 5^-41
+	{ 0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull }, // 5^-40
+	{ 0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull }, // 5^-39
+	{ 0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull }, // 5^-38
+	{ 0x881cea14545c7575ull, 0x7e50d64177da2e54ull }, // 5^-37
+	{ 0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull }, // 5^-36
+	{ 0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull }, // 5^-35
+	{ 0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull }, // 5^-34
+	{ 0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull }, // 5^-33
+	{ 0xcfb11ead453994baull, 0x67de18eda5814af2ull }, // 5^-32
+	{ 0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull }, // 5^-31
+	{ 0xa2425ff75e14fc31ull, 0xa1258379a94d028dull }, // 5^-30
+	{ 0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull }, // 5^-29
+	{ 0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull }, // 5^-28
+	{ 0x9e74d1b791e07e48ull, 0x775ea264cf55347eull }, // 5^-27
+	{ 0xc612062576589ddaull, 0x95364afe032a819eull }, // 5^-26
+	{ 0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull }, // 5^-25
+	{ 0x9abe14cd44753b52ull, 0xc4926a9672793543ull }, // 5^-24
+	{ 0xc16d9a0095928a27ull, 0x75b7053c0f178294ull }, // 5^-23
+	{ 0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull }, // 5^-22
+	{ 0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull }, // 5^-21
+	{ 0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull }, // 5^-20
+	{ 0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull }, // 5^-19
+	{ 0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull }, // 5^-18
+	{ 0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull }, // 5^-17
+	{ 0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull }, // 5^-16
+	{ 0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull }, // 5^-15
+	{ 0xb424dc35095cd80full, 0x538484c19ef38c95ull }, // 5^-14
+	{ 0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull }, // 5^-13
+	{ 0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull }, // 5^-12
+	{ 0xafebff0bcb24aafeull, 0xf78f69a51539d749ull }, // 5^-11
+	{ 0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull }, // 5^-10
+	{ 0x89705f4136b4a597ull, 0x31680a88f8953031ull }, // 5^-9
+	{ 0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull }, // 5^-8
+	{ 0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull }, // 5^-7
+	{ 0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull }, // 5^-6
+	{ 0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull }, // 5^-5
+	{ 0xd1b71758e219652bull, 0xd3c36113404ea4a9ull }, // 5^-4
+	{ 0x83126e978d4fdf3bull, 0x645a1cac083126eaull }, // 5^-3
+	{ 0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull }, // 5^-2
+	{ 0xccccccccccccccccull, 0xcccccccccccccccdull }, // 5^-1
+	{ 0x8000000000000000ull, 0x0000000000000000ull }, // 5^0
+	{ 0xa000000000000000ull, 0x0000000000000000ull }, // 5^1
+	{ 0xc800000000000000ull, 0x0000000000000000ull }, // 5^2
+	{ 0xfa00000000000000ull, 0x0000000000000000ull }, // 5^3
+	{ 0x9c40000000000000ull, 0x0000000000000000ull }, // 5^4
+	{ 0xc350000000000000ull, 0x0000000000000000ull }, // 5^5
+	{ 0xf424000000000000ull, 0x0000000000000000ull }, // 5^6
+	{ 0x9896800000000000ull, 0x0000000000000000ull }, // 5^7
+	{ 0xbebc200000000000ull, 0x0000000000000000ull }, // 5^8
+	{ 0xee6b280000000000ull, 0x0000000000000000ull }, // 5^9
+	{ 0x9502f90000000000ull, 0x0000000000000000ull }, // 5^10
+	{ 0xba43b74000000000ull, 0x0000000000000000ull }, // 5^11
+	{ 0xe8d4a51000000000ull, 0x0000000000000000ull }, // 5^12
+	{ 0x9184e72a00000000ull, 0x0000000000000000ull }, // 5^13
+	{ 0xb5e620f480000000ull, 0x0000000000000000ull }, // 5^14
+	{ 0xe35fa931a0000000ull, 0x0000000000000000ull }, // 5^15
+	{ 0x8e1bc9bf04000000ull, 0x0000000000000000ull }, // 5^16
+	{ 0xb1a2bc2ec5000000ull, 0x0000000000000000ull }, // 5^17
+	{ 0xde0b6b3a76400000ull, 0x0000000000000000ull }, // 5^18
+	{ 0x8ac7230489e80000ull, 0x0000000000000000ull }, // 5^19
+	{ 0xad78ebc5ac620000ull, 0x0000000000000000ull }, // 5^20
+	{ 0xd8d726b7177a8000ull, 0x0000000000000000ull }, // 5^21
+	{ 0x878678326eac9000ull, 0x0000000000000000ull }, // 5^22
+	{ 0xa968163f0a57b400ull, 0x0000000000000000ull }, // 5^23
+	{ 0xd3c21bcecceda100ull, 0x0000000000000000ull }, // 5^24
+	{ 0x84595161401484a0ull, 0x0000000000000000ull }, // 5^25
+	{ 0xa56fa5b99019a5c8ull, 0x0000000000000000ull }, // 5^26
+	{ 0xcecb8f27f4200f3aull, 0x0000000000000000ull }, // 5^27
+	{ 0x813f3978f8940984ull, 0x4000000000000000ull }, // 5^28
+	{ 0xa18f07d736b90be5ull, 0x5000000000000000ull }, // 5^29
+	{ 0xc9f2c9cd04674edeull, 0xa400000000000000ull }, // 5^30
+	{ 0xfc6f7c4045812296ull, 0x4d00000000000000ull }, // 5^31
+	{ 0x9dc5ada82b70b59dull, 0xf020000000000000ull }, // 5^32
+	{ 0xc5371912364ce305ull, 0x6c28000000000000ull }, // 5^33
+	{ 0xf684df56c3e01bc6ull, 0xc732000000000000ull }, // 5^34
+	{ 0x9a130b963a6c115cull, 0x3c7f400000000000ull }, // 5^35
+	{ 0xc097ce7bc90715b3ull, 0x4b9f100000000000ull }, // 5^36
+	{ 0xf0bdc21abb48db20ull, 0x1e86d40000000000ull }, // 5^37
+	{ 0x96769950b50d88f4ull, 0x1314448000000000ull }, // 5^38
+};
+
+const float exactPowersOfTen[MaxExactPowerOfTen + 1] =
+{
+	1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+inline bool isDigit(char c)
+{
+	return (c >= '0') && (c <= '9');
+}
+
+inline void multiply(uint64_t a, uint64_t b, uint64_t& low, uint64_t& high)
+{
+#if (ET_PLATFORM_WIN)
+	low = _umul128(a, b, &high);
+#else
+	unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+	low = static_cast<uint64_t>(product);
+	high = static_cast<uint64_t>(product >> 64);
+#endif
+}
+
+/*
+ * Eisel-Lemire: binary representation of w * 10^q, rounded to nearest even,
+ * returned as bits of positive float
+ */
+uint32_t computeFloatBits(int64_t q, uint64_t w)
+{
+	const uint32_t mantissaBits = 23;
+	const int32_t minimumExponent = -127;
+	const int32_t infiniteExponent = 0xff;
+	const uint32_t infinity = static_cast<uint32_t>(infiniteExponent) << mantissaBits;
+
+	if ((w == 0) || (q < SmallestPowerOfTen))
+		return 0;
+
+	if (q > LargestPowerOfTen)
+		return infinity;
+
+	int32_t leadingZeros = 63 - static_cast<int32_t>(findLastSetBit(w));
+	w <<= leadingZeros;
+
+	/*
+	 * second half of the power is only needed when truncated product
+	 * could be carried over to the bits which determine rounding
+	 */
+	const uint64_t* power = powersOfFive[q - SmallestPowerOfTen];
+	const uint64_t precisionMask = 0xffffffffffffffffull >> (mantissaBits + 3);
+	uint64_t low = 0;
+	uint64_t high = 0;
+	multiply(w, power[0], low, high);
+	if ((high & precisionMask) == precisionMask)
+	{
+		uint64_t secondLow = 0;
+		uint64_t secondHigh = 0;
+		multiply(w, power[1], secondLow, secondHigh);
+		low += secondHigh;
+		if (secondHigh > low)
+			++high;
+	}
+
+	int32_t upperBit = static_cast<int32_t>(high >> 63);
+	int32_t shift = upperBit + 64 - static_cast<int32_t>(mantissaBits) - 3;
+	uint64_t mantissa = high >> shift;
+
+	/*
+	 * floor(log2(10^q)) + 63
+	 */
+	int32_t binaryExponent = static_cast<int32_t>(((152170 + 65536) * q) >> 16) + 63;
+	int32_t power2 = binaryExponent + upperBit - leadingZeros - minimumExponent;
+
+	if (power2 <= 0)
+	{
+		if (1 - power2 >= 64)
+			return 0;
+
+		mantissa >>= 1 - power2;
+		mantissa += (mantissa & 1);
+		mantissa >>= 1;
+		power2 = (mantissa < (1ull << mantissaBits)) ? 0 : 1;
+		return static_cast<uint32_t>(mantissa) | (static_cast<uint32_t>(power2) << mantissaBits);
+	}
+
+	/*
+	 * exact halfway cases are only possible for small exponents
+	 */
+	if ((low <= 1) && (q >= -17) && (q <= 10) && ((mantissa & 3) == 1))
+	{
+		if ((mantissa << shift) == high)
+			mantissa &= ~1ull;
+	}
+
+	mantissa += (mantissa & 1);
+	mantissa >>= 1;
+	if (mantissa >= (2ull << mantissaBits))
+	{
+		mantissa = (1ull << mantissaBits);
+		++power2;
+	}
+	mantissa &= ~(1ull << mantissaBits);
+
+	if (power2 >= infiniteExponent)
+		return infinity;
+
+	return static_cast<uint32_t>(mantissa) | (static_cast<uint32_t>(power2) << mantissaBits);
+}
+
+#if (ET_SIMD_SSE)
+inline uint32_t whitespaceMask(const char* p)
+{
+	__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	__m128i spaceOrTab = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(ET_SPACE)), _mm_cmpeq_epi8(c, _mm_set1_epi8(ET_TAB)));
+	__m128i lineBreak = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(ET_RETURN)), _mm_cmpeq_epi8(c, _mm_set1_epi8(ET_NEWLINE)));
+	return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(spaceOrTab, lineBreak)));
+}
+#endif
+
+}
+
+const char* text::skipWhitespace(const char* begin, const char* end)
+{
+	/*
+	 * most of the separators are single characters, so the first one is checked before vector loop
+	 */
+	if ((begin < end) && !isWhitespaceChar(*begin))
+		return begin;
+
+#if (ET_SIMD_SSE)
+	while (end - begin >= 16)
+	{
+		uint32_t mask = ~whitespaceMask(begin) & 0xffff;
+		if (mask != 0)
+			return begin + findFirstSetBit(mask);
+		begin += 16;
+	}
+#endif
+
+	while ((begin < end) && isWhitespaceChar(*begin))
+		++begin;
+	return begin;
+}
+
+const char* text::skipToken(const char* begin, const char* end)
+{
+#if (ET_SIMD_SSE)
+	while (end - begin >= 16)
+	{
+		uint32_t mask = whitespaceMask(begin);
+		if (mask != 0)
+			return begin + findFirstSetBit(mask);
+		begin += 16;
+	}
+#endif
+
+	while ((begin < end) && !isWhitespaceChar(*begin))
+		++begin;
+	return begin;
+}
+
+const char* text::trimTrailingWhitespace(const char* begin, const char* end)
+{
+	while ((end > begin) && isWhitespaceChar(*(end - 1)))
+		--end;
+	return end;
+}
+
+const char* text::findCharacter(const char* begin, const char* end, char c)
+{
+	/*
+	 * memchr is vectorized in all supported runtime libraries
+	 */
+	if (begin >= end)
+		return end;
+
+	const void* result = memchr(begin, c, static_cast<size_t>(end - begin));
+	return (result == nullptr) ? end : static_cast<const char*>(result);
+}
+
+bool text::nextToken(const char*& position, const char* end, Range& token)
+{
+	const char* begin = skipWhitespace(position, end);
+	if (begin >= end)
+	{
+		position = end;
+		return false;
+	}
+
+	token.begin = begin;
+	token.end = skipToken(begin, end);
+	position = token.end;
+	return true;
+}
+
+bool text::nextField(const char*& position, const char* end, char delimiter, Range& field)
+{
+	if (position >= end)
+		return false;
+
+	const char* delimiterPosition = findCharacter(position, end, delimiter);
+	field.begin = position;
+	field.end = delimiterPosition;
+	position = (delimiterPosition < end) ? delimiterPosition + 1 : end;
+	return true;
+}
+
+bool text::nextLine(const char*& position, const char* end, Range& line)
+{
+	if (position >= end)
+		return false;
+
+	const char* lineEnd = findCharacter(position, end, ET_NEWLINE);
+	line.begin = position;
+	line.end = ((lineEnd > position) && (*(lineEnd - 1) == ET_RETURN)) ? lineEnd - 1 : lineEnd;
+	position = (lineEnd < end) ? lineEnd + 1 : end;
+	return true;
+}
+
+bool text::parseFloat(const char*& position, const char* end, float& value)
+{
+	const char* p = position;
+
+	bool negative = false;
+	if ((p < end) && ((*p == '-') || (*p == '+')))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+
+	/*
+	 * up to 19 significant digits are accumulated in the integer mantissa,
+	 * the rest only affect exponent and the flag, that the mantissa was truncated
+	 */
+	uint64_t mantissa = 0;
+	int64_t exponent = 0;
+	int32_t significantDigits = 0;
+	bool truncated = false;
+	bool hasDigits = false;
+	auto addDigit = [&](char c, bool fraction)
+	{
+		if (significantDigits < MaxSignificantDigits)
+		{
+			mantissa = 10 * mantissa + static_cast<uint64_t>(c - '0');
+			significantDigits += (mantissa > 0) ? 1 : 0;
+			exponent -= fraction ? 1 : 0;
+		}
+		else
+		{
+			truncated |= (c != '0');
+			exponent += fraction ? 0 : 1;
+		}
+		hasDigits = true;
+	};
+
+	while ((p < end) && isDigit(*p))
+		addDigit(*p++, false);
+
+	if ((p < end) && (*p == '.'))
+	{
+		++p;
+		while ((p < end) && isDigit(*p))
+			addDigit(*p++, true);
+	}
+
+	if (!hasDigits)
+		return false;
+
+	if ((p < end) && ((*p == 'e') || (*p == 'E')))
+	{
+		const char* e = p + 1;
+		bool negativeExponent = false;
+		if ((e < end) && ((*e == '-') || (*e == '+')))
+		{
+			negativeExponent = (*e == '-');
+			++e;
+		}
+
+		if ((e < end) && isDigit(*e))
+		{
+			int64_t explicitExponent = 0;
+			for (; (e < end) && isDigit(*e); ++e)
+			{
+				if (explicitExponent < 0x10000)
+					explicitExponent = 10 * explicitExponent + (*e - '0');
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+			p = e;
+		}
+	}
+
+	/*
+	 * Clinger's fast path: both mantissa and power of ten are exact floats, so result is rounded once
+	 */
+	if (!truncated && (mantissa <= (1ull << 24)) && (exponent >= -MaxExactPowerOfTen) && (exponent <= MaxExactPowerOfTen))
+	{
+		float result = static_cast<float>(mantissa);
+		result = (exponent < 0) ? result / exactPowersOfTen[-exponent] : result * exactPowersOfTen[exponent];
+		value = negative ? -result : result;
+		position = p;
+		return true;
+	}
+
+	uint32_t bits = computeFloatBits(exponent, mantissa);
+
+	/*
+	 * truncated mantissa gives the same result as the rounded up one in almost all cases,
+	 * otherwise slow, but exact conversion is used
+	 */
+	if (truncated && (bits != computeFloatBits(exponent, mantissa + 1)))
+	{
+		value = std::strtof(std::string(position, p).c_str(), nullptr);
+		position = p;
+		return true;
+	}
+
+	bits |= negative ? 0x80000000u : 0u;
+	memcpy(&value, &bits, sizeof(value));
+	position = p;
+	return true;
+}
+
+bool text::parseInteger(const char*& position, const char* end, int64_t& value)
+{
+	const char* p = position;
+
+	bool negative = false;
+	if ((p < end) && ((*p == '-') || (*p == '+')))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+
+	if ((p >= end) || !isDigit(*p))
+		return false;
+
+	uint64_t result = 0;
+	for (; (p < end) && isDigit(*p); ++p)
+		result = 10 * result + static_cast<uint64_t>(*p - '0');
+
+	value = negative ? -static_cast<int64_t>(result) : static_cast<int64_t>(result);
+	position = p;
+	return true;
+}
+
+float text::parseFloat(const Range& range, float defaultValue)
+{
+	const char* position = skipWhitespace(range.begin, range.end);
+	float result = defaultValue;
+	return parseFloat(position, range.end, result) ? result : defaultValue;
+}
+
+int64_t text::parseInteger(const Range& range, int64_t defaultValue)
+{
+	const char* position = skipWhitespace(range.begin, range.end);
+	int64_t result = defaultValue;
+	return parseInteger(position, range.end, result) ? result : defaultValue;
+}
+
+uint32_t text::parseFloats(const char*& position, const char* end, float* values, uint32_t count)
+{
+	uint32_t parsed = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		values[i] = 0.0f;
+		position = skipWhitespace(position, end);
+		if (parseFloat(position, end, values[i]))
+			++parsed;
+		position = skipToken(position, end);
+	}
+	return parsed;
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/et.h>
+
+namespace et
+{
+namespace text
+{
+/*
+ * Allocation-free parsing of the text in memory (mapped files, loaded buffers, strings).
+ * All functions work on [begin, end) ranges, do not require null-terminated input
+ * and never read past the end.
+ */
+struct Range
+{
+	const char* begin = nullptr;
+	const char* end = nullptr;
+
+	Range() = default;
+
+	Range(const char* b, const char* e) :
+		begin(b), end(e) { }
+
+	explicit Range(const std::string& s) :
+		begin(s.data()), end(s.data() + s.size()) { }
+
+	size_t size() const
+		{ return static_cast<size_t>(end - begin); }
+
+	bool empty() const
+		{ return begin >= end; }
+
+	bool equals(const char* s) const
+		{ return (strlen(s) == size()) && (strncmp(begin, s, size()) == 0); }
+
+	std::string toString() const
+		{ return std::string(begin, end); }
+};
+
+/*
+ * whitespace is the same as in isWhitespaceChar: space, tab, carriage return and new line
+ */
+const char* skipWhitespace(const char* begin, const char* end);
+const char* skipToken(const char* begin, const char* end);
+const char* trimTrailingWhitespace(const char* begin, const char* end);
+
+/*
+ * returns end if character was not found
+ */
+const char* findCharacter(const char* begin, const char* end, char c);
+
+/*
+ * tokenizers advance position past the returned token and return false when input is over.
+ * nextToken splits by whitespace and skips empty tokens, nextField splits by delimiter and keeps empty fields,
+ * nextLine returns lines without line break (LF or CR LF)
+ */
+bool nextToken(const char*& position, const char* end, Range& token);
+bool nextField(const char*& position, const char* end, char delimiter, Range& field);
+bool nextLine(const char*& position, const char* end, Range& line);
+
+/*
+ * numbers are parsed at the position (without skipping whitespace), which is advanced past the number.
+ * Position is not changed and false is returned if there is no number.
+ * Floats are correctly rounded (Eisel-Lemire algorithm with fallback to strtof for more than 19 digits)
+ */
+bool parseFloat(const char*& position, const char* end, float& value);
+bool parseInteger(const char*& position, const char* end, int64_t& value);
+
+float parseFloat(const Range&, float defaultValue = 0.0f);
+int64_t parseInteger(const Range&, int64_t defaultValue = 0);
+
+/*
+ * parses up to count whitespace separated floats and returns number of parsed values,
+ * missing values and values which could not be parsed are set to zero
+ */
+uint32_t parseFloats(const char*& position, const char* end, float* values, uint32_t count);
+}
+}
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <mutex>
+#include <condition_variable>
 #include <et/core/threading.h>
 
 namespace et
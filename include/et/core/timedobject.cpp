@@ -11,13 +11,12 @@
 
 using namespace et;
 
-TimedObject::TimedObject() : 
-	_owner(nullptr), _startTime(0.0f), _running(false), _released(false)
+TimedObject::TimedObject()
 {
 }
 
 TimedObject::TimedObject(TimerPool* tp) :
-	_owner(tp), _startTime(0.0f), _running(false), _released(false)
+	_owner(tp)
 {
 
 }
@@ -56,6 +55,31 @@ void TimedObject::cancelUpdates()
 		_owner->detachTimedObject(this);
 }
 
+void TimedObject::scheduleUpdate(float time)
+{
+	if (_owner)
+	{
+		_owner->scheduleTimedObject(this, true, time);
+	}
+	else
+	{
+		_hasScheduledTime = true;
+		_scheduledTime = time;
+	}
+}
+
+void TimedObject::updateContinuously()
+{
+	if (_owner)
+	{
+		_owner->scheduleTimedObject(this, false, 0.0f);
+	}
+	else
+	{
+		_hasScheduledTime = false;
+	}
+}
+
 float TimedObject::actualTime()
 {
 	return timerPool()->actualTime();
@@ -47,9 +47,31 @@ protected:
 	virtual void startUpdates(TimerPool* timerPool = nullptr);
 	virtual TimerPool* timerPool();
 
+	/*
+	 * by default timed object is updated every frame,
+	 * objects which needs to be updated only at specific time (like timers)
+	 * could schedule update and TimerPool will not touch them until that time
+	 */
+	void scheduleUpdate(float time);
+	void updateContinuously();
+
+private:
+	enum class PoolState : uint32_t
+	{
+		Detached,
+		Pending,
+		Continuous,
+		Scheduled,
+		Updating
+	};
+
 private:
 	TimerPool* _owner = nullptr;
 	float _startTime = 0.0f;
+	float _scheduledTime = 0.0f;
+	uint32_t _poolIndex = 0;
+	PoolState _poolState = PoolState::Detached;
+	bool _hasScheduledTime = false;
 	bool _running = false;
 	bool _released = false;
 };
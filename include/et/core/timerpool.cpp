@@ -19,25 +19,25 @@ TimerPool::TimerPool(RunLoop* owner) :
 bool TimerPool::hasObjects()
 {
 	CriticalSectionScope lock(_lock);
-	return !(_timedObjects.empty() && _queue.empty());
+	return !(_continuousObjects.empty() && _scheduledObjects.empty() && _pendingObjects.empty());
 }
 
 void TimerPool::attachTimedObject(TimedObject* obj)
 {
 	CriticalSectionScope lock(_lock);
 
-	QueueEntry entry(obj, QueueAction_Update);
-	if (std::find(_timedObjects.begin(), _timedObjects.end(), entry) != _timedObjects.end()) return;
+	if (obj->_poolState != TimedObject::PoolState::Detached)
+		return;
 
 	if (_updating)
 	{
-		entry.action = QueueAction_Add;
-		if (std::find(_queue.begin(), _queue.end(), entry) == _queue.end())
-			_queue.push_back(entry);
+		obj->_poolState = TimedObject::PoolState::Pending;
+		obj->_poolIndex = static_cast<uint32_t>(_pendingObjects.size());
+		_pendingObjects.push_back(obj);
 	}
 	else
 	{
-		_timedObjects.push_back(entry);
+		insertTimedObject(obj);
 	}
 }
 
@@ -45,24 +45,46 @@ void TimerPool::detachTimedObject(TimedObject* obj)
 {
 	CriticalSectionScope lock(_lock);
 
-	QueueEntry existsAddingEntry(obj, QueueAction_Add);
-	auto existsAddingValue = std::find(_queue.begin(), _queue.end(), existsAddingEntry);
-	if (existsAddingValue != _queue.end())
+	if (obj == _currentlyUpdating)
+		_currentlyUpdating = nullptr;
+
+	switch (obj->_poolState)
 	{
-		if (_updating)
-			existsAddingEntry.action = QueueAction_Remove;
-		else
-			_queue.erase(existsAddingValue);
+	case TimedObject::PoolState::Pending:
+		_pendingObjects[obj->_poolIndex] = nullptr;
+		break;
+
+	case TimedObject::PoolState::Continuous:
+		_continuousObjects[obj->_poolIndex] = nullptr;
+		break;
+
+	case TimedObject::PoolState::Scheduled:
+		removeScheduledObject(obj->_poolIndex);
+		break;
+
+	default:
+		break;
 	}
 
-	QueueEntry existsUpdatingEntry(obj, QueueAction_Update);
-	auto existsUpdatingValue = std::find(_timedObjects.begin(), _timedObjects.end(), existsUpdatingEntry);
-	if (existsUpdatingValue != _timedObjects.end()) 
+	obj->_poolState = TimedObject::PoolState::Detached;
+}
+
+void TimerPool::scheduleTimedObject(TimedObject* obj, bool scheduled, float time)
+{
+	CriticalSectionScope lock(_lock);
+
+	TimedObject::PoolState state = obj->_poolState;
+	if ((state == TimedObject::PoolState::Continuous) || (state == TimedObject::PoolState::Scheduled))
 	{
-		if (_updating)
-			existsUpdatingValue->action = QueueAction_Remove;
-		else
-			_timedObjects.erase(existsUpdatingValue);
+		detachTimedObject(obj);
+		obj->_hasScheduledTime = scheduled;
+		obj->_scheduledTime = time;
+		insertTimedObject(obj);
+	}
+	else
+	{
+		obj->_hasScheduledTime = scheduled;
+		obj->_scheduledTime = time;
 	}
 }
 
@@ -70,31 +92,63 @@ void TimerPool::update(float t)
 {
 	CriticalSectionScope lock(_lock);
 
-	if (_queue.size() > 0)
+	for (TimedObject* obj : _pendingObjects)
 	{
-		for (auto& i : _queue)
+		if (obj != nullptr)
 		{
-			if (i.action == QueueAction_Add)
-			{
-				i.action = QueueAction_Update;
-				_timedObjects.push_back(i);
-			}
+			obj->_poolState = TimedObject::PoolState::Detached;
+			insertTimedObject(obj);
 		}
-		_queue.clear();
 	}
+	_pendingObjects.clear();
 
 	_updating = true;
 
-	for (auto& object : _timedObjects)
+	while (!_scheduledObjects.empty() && (_scheduledObjects.front()->_scheduledTime <= t))
 	{
-		auto updatableObject = object.object;
-		if ((object.action == QueueAction_Update) && updatableObject->running())
-			updatableObject->update(t);
+		TimedObject* obj = _scheduledObjects.front();
+		removeScheduledObject(0);
+		obj->_poolState = TimedObject::PoolState::Updating;
+
+		/*
+		 * object could be detached (or even deleted) from it's own update,
+		 * in this case it should not be accessed after update
+		 */
+		_currentlyUpdating = obj;
+		if (obj->running())
+			obj->update(t);
+
+		if (_currentlyUpdating == nullptr)
+			continue;
+
+		_currentlyUpdating = nullptr;
+		if (obj->_poolState == TimedObject::PoolState::Updating)
+		{
+			/*
+			 * object is inserted back on the next update,
+			 * so object which did not move it's scheduled time will not be updated twice per frame
+			 */
+			obj->_poolState = TimedObject::PoolState::Detached;
+			if (obj->running())
+			{
+				obj->_poolState = TimedObject::PoolState::Pending;
+				obj->_poolIndex = static_cast<uint32_t>(_pendingObjects.size());
+				_pendingObjects.push_back(obj);
+			}
+		}
 	}
 
-	auto e = std::remove_if(_timedObjects.begin(), _timedObjects.end(), [](const QueueEntry& entry)
-		{ return (entry.action == QueueAction_Remove) || (!entry.object->running()); });
-	_timedObjects.erase(e, _timedObjects.end());
+	/*
+	 * objects added to _continuousObjects during this loop will be updated in the next frame
+	 */
+	for (size_t i = 0, e = _continuousObjects.size(); i < e; ++i)
+	{
+		TimedObject* obj = _continuousObjects[i];
+		if ((obj != nullptr) && obj->running())
+			obj->update(t);
+	}
+
+	compactContinuousObjects();
 
 	_updating = false;
 }
@@ -103,3 +157,107 @@ float TimerPool::actualTime() const
 {
 	return _owner->time();
 }
+
+void TimerPool::insertTimedObject(TimedObject* obj)
+{
+	ET_ASSERT(obj->_poolState == TimedObject::PoolState::Detached);
+
+	if (obj->_hasScheduledTime)
+	{
+		pushScheduledObject(obj);
+	}
+	else
+	{
+		obj->_poolState = TimedObject::PoolState::Continuous;
+		obj->_poolIndex = static_cast<uint32_t>(_continuousObjects.size());
+		_continuousObjects.push_back(obj);
+	}
+}
+
+void TimerPool::compactContinuousObjects()
+{
+	uint32_t count = 0;
+	for (TimedObject* obj : _continuousObjects)
+	{
+		if (obj == nullptr)
+			continue;
+
+		if (obj->running())
+		{
+			obj->_poolIndex = count;
+			_continuousObjects[count++] = obj;
+		}
+		else
+		{
+			obj->_poolState = TimedObject::PoolState::Detached;
+		}
+	}
+	_continuousObjects.resize(count);
+}
+
+void TimerPool::pushScheduledObject(TimedObject* obj)
+{
+	obj->_poolState = TimedObject::PoolState::Scheduled;
+	obj->_poolIndex = static_cast<uint32_t>(_scheduledObjects.size());
+	_scheduledObjects.push_back(obj);
+	siftScheduledObjectUp(obj->_poolIndex);
+}
+
+void TimerPool::removeScheduledObject(uint32_t index)
+{
+	ET_ASSERT(index < _scheduledObjects.size());
+
+	TimedObject* last = _scheduledObjects.back();
+	_scheduledObjects.pop_back();
+
+	if (index < _scheduledObjects.size())
+	{
+		last->_poolIndex = index;
+		_scheduledObjects[index] = last;
+		siftScheduledObjectUp(index);
+		siftScheduledObjectDown(last->_poolIndex);
+	}
+}
+
+void TimerPool::siftScheduledObjectUp(uint32_t index)
+{
+	TimedObject* obj = _scheduledObjects[index];
+	while (index > 0)
+	{
+		uint32_t parentIndex = (index - 1) / 2;
+		TimedObject* parent = _scheduledObjects[parentIndex];
+		if (parent->_scheduledTime <= obj->_scheduledTime)
+			break;
+
+		parent->_poolIndex = index;
+		_scheduledObjects[index] = parent;
+		index = parentIndex;
+	}
+	obj->_poolIndex = index;
+	_scheduledObjects[index] = obj;
+}
+
+void TimerPool::siftScheduledObjectDown(uint32_t index)
+{
+	uint32_t count = static_cast<uint32_t>(_scheduledObjects.size());
+	TimedObject* obj = _scheduledObjects[index];
+	for (;;)
+	{
+		uint32_t childIndex = 2 * index + 1;
+		if (childIndex >= count)
+			break;
+
+		if ((childIndex + 1 < count) && (_scheduledObjects[childIndex + 1]->_scheduledTime < _scheduledObjects[childIndex]->_scheduledTime))
+			++childIndex;
+
+		TimedObject* child = _scheduledObjects[childIndex];
+		if (obj->_scheduledTime <= child->_scheduledTime)
+			break;
+
+		child->_poolIndex = index;
+		_scheduledObjects[index] = child;
+		index = childIndex;
+	}
+	obj->_poolIndex = index;
+	_scheduledObjects[index] = obj;
+}
@@ -26,6 +26,7 @@ namespace et
 
 		void attachTimedObject(TimedObject* obj);
 		void detachTimedObject(TimedObject* obj);
+		void scheduleTimedObject(TimedObject* obj, bool scheduled, float time);
 
 		void setOwner(RunLoop* owner)
 			{ _owner = owner; }
@@ -35,34 +36,29 @@ namespace et
 	private:
 		ET_DENY_COPY(TimerPool);
 		
-		enum QueueAction
-		{
-			QueueAction_Add,
-			QueueAction_Update,
-			QueueAction_Remove
-		};
+		using TimedObjectList = Vector<TimedObject*>;
 
-		struct QueueEntry
-		{
-		public:
-			TimedObject* object;
-			QueueAction action;
-
-		public:
-			QueueEntry(TimedObject* o, QueueAction a) : 
-					object(o), action(a) { }
-
-			bool operator == (const QueueEntry& e)
-				{ return (e.object == object) && (e.action == action); }
-		};
-
-		typedef std::vector<QueueEntry> TimerPoolQueue;
+		void insertTimedObject(TimedObject*);
+		void pushScheduledObject(TimedObject*);
+		void removeScheduledObject(uint32_t);
+		void siftScheduledObjectUp(uint32_t);
+		void siftScheduledObjectDown(uint32_t);
+		void compactContinuousObjects();
 
 	private:
-		TimerPoolQueue _timedObjects;
-		TimerPoolQueue _queue;
+		/*
+		 * objects updated every frame are kept in _continuousObjects,
+		 * objects with scheduled update time are kept in _scheduledObjects (binary min-heap),
+		 * objects attached during update are kept in _pendingObjects until the next update,
+		 * every object stores it's index in the corresponding list,
+		 * detached continuous and pending objects are replaced with nullptr and removed on update
+		 */
+		TimedObjectList _continuousObjects;
+		TimedObjectList _scheduledObjects;
+		TimedObjectList _pendingObjects;
 		CriticalSection _lock;
 		RunLoop* _owner = nullptr;
+		TimedObject* _currentlyUpdating = nullptr;
 		bool _updating = false;
 	};
 }
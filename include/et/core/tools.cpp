@@ -6,12 +6,108 @@
  */
 
 #include <et/core/datastorage.h>
+#include <et/core/textparsing.h>
 #include <et/core/tools.h>
 #include <et/core/cout.h>
 
+#if (ET_SIMD_DISPATCH)
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
 namespace et
 {
 
+#if (ET_SIMD_DISPATCH)
+namespace
+{
+
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4])
+{
+#if defined(_MSC_VER)
+	int values[4] = { };
+	__cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+	for (uint32_t i = 0; i < 4; ++i)
+		registers[i] = static_cast<uint32_t>(values[i]);
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+/*
+ * YMM registers are usable only if OS saves their state on context switch
+ */
+bool osSavesAVXState()
+{
+#if defined(_MSC_VER)
+	return (_xgetbv(0) & 0x06) == 0x06;
+#else
+	uint32_t eax = 0;
+	uint32_t edx = 0;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (eax & 0x06) == 0x06;
+#endif
+}
+
+uint32_t detectCPUFeatures()
+{
+	uint32_t registers[4] = { };
+	cpuid(0, 0, registers);
+	uint32_t maxLeaf = registers[0];
+	if (maxLeaf < 1)
+		return 0;
+
+	uint32_t result = 0;
+	cpuid(1, 0, registers);
+	uint32_t ecx = registers[2];
+	if (ecx & (1u << 19))
+		result |= 1u << static_cast<uint32_t>(CPUFeature::SSE41);
+
+	bool avx = (ecx & (1u << 27)) && (ecx & (1u << 28)) && osSavesAVXState();
+	if (!avx)
+		return result;
+
+	result |= 1u << static_cast<uint32_t>(CPUFeature::AVX);
+	if (ecx & (1u << 29))
+		result |= 1u << static_cast<uint32_t>(CPUFeature::F16C);
+
+	if (maxLeaf >= 7)
+	{
+		cpuid(7, 0, registers);
+		if (registers[1] & (1u << 5))
+			result |= 1u << static_cast<uint32_t>(CPUFeature::AVX2);
+	}
+	return result;
+}
+
+}
+#endif
+
+bool cpuSupports(CPUFeature feature)
+{
+#if (ET_SIMD_DISPATCH)
+	static const uint32_t features = detectCPUFeatures();
+	return (features & (1u << static_cast<uint32_t>(feature))) != 0;
+#else
+	(void)feature;
+	return false;
+#endif
+}
+
+uint64_t contentHash(const uint8_t* data, uint64_t size)
+{
+	uint64_t result = 0xcbf29ce484222325ull;
+	for (uint64_t i = 0; i < size; ++i)
+	{
+		result ^= data[i];
+		result *= 0x100000001b3ull;
+	}
+	return result;
+}
+
 intptr_t streamSize(std::istream& s)
 {
 	std::streamoff currentPos = s.tellg();
@@ -190,47 +286,12 @@ std::string getFileExt(std::string name)
 
 float extractFloat(std::string& s)
 {
-	size_t len = s.length();
-	const char* data = s.c_str();
-	bool hasMinus = data[0] == '-';
-	bool dotFound = false;
-	size_t offset = static_cast<size_t>(hasMinus);
 	float value = 0.0f;
-	float scale = 1.0f;
-	for (; offset < len; ++offset)
-	{
-		char c = data[offset];
-		if (((c >= '0') && (c <= '9')) || (c == '.'))
-		{
-			if (c == '.')
-			{
-				if (dotFound) break;
-				dotFound = true;
-				scale = 0.1f;
-			}
-			else 
-			{
-				float cValue = static_cast<float>(c - '0');
-				if (dotFound)
-				{
-					value += cValue * scale;
-					scale /= 10.0f;
-				}
-				else
-				{
-					value = value * 10.0f + cValue;
-					scale *= 10.0f;
-				}
-			}
-		}
-		else 
-		{
-			break;
-		}
-	}
-
-	s.erase(0, offset);
-	return hasMinus ? -value : value;
+	const char* begin = s.data();
+	const char* position = begin;
+	text::parseFloat(position, begin + s.size(), value);
+	s.erase(0, static_cast<size_t>(position - begin));
+	return value;
 }
 
 StringList split(const std::string& s, const std::string& delim)
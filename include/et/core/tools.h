@@ -46,6 +46,24 @@ inline bool isPowerOfTwo(T x)
 	return (x & (x - 1)) == 0;
 }
 
+/*
+ * Instruction sets beyond SSE2, detected at runtime (cpuid), always false outside of x86 / x64
+ */
+enum class CPUFeature : uint32_t
+{
+	SSE41,
+	AVX,
+	AVX2,
+	F16C
+};
+
+bool cpuSupports(CPUFeature);
+
+/*
+ * FNV-1a, 64 bit - fast non-cryptographic hash used to validate cached files
+ */
+uint64_t contentHash(const uint8_t* data, uint64_t size);
+
 inline bool platformHasHardwareKeyboard()
 {
 	return true;
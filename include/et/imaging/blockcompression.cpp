@@ -0,0 +1,1530 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/jobsystem.h>
+#include <et/core/tools.h>
+#include <et/imaging/blockcompression.h>
+#include <external/pvr/PVRTDecompress.h>
+
+#if (ET_SIMD_DISPATCH)
+#	include <immintrin.h>
+#endif
+
+namespace et
+{
+namespace bc
+{
+
+struct Block
+{
+	float pixels[16][4];
+	uint8_t alpha[16];
+	bool hasTransparentPixels = false;
+};
+
+void loadBlock(const vec4ub* source, const vec2i& size, int bx, int by, Block&);
+void encodeColorBlock(const Block&, bool allowTransparency, uint8_t* output);
+void encodeAlphaBlock(const Block&, int channel, uint8_t* output);
+void encodeBC7Block(const Block&, uint8_t* output);
+void decodeBlocksRow(TextureFormat, const uint8_t* source, const vec2i& size, uint32_t blockY, uint32_t* destination);
+
+bool compressionSupported(TextureFormat format)
+{
+	return (format == TextureFormat::DXT1_RGB) || (format == TextureFormat::DXT1_RGBA) ||
+		(format == TextureFormat::DXT5) || (format == TextureFormat::RGTC2) || (format == TextureFormat::BC7);
+}
+
+uint32_t compressedBlockSize(TextureFormat format)
+{
+	return bitsPerPixelForTextureFormat(format) * 2;
+}
+
+uint64_t compressedDataSize(TextureFormat format, const vec2i& size)
+{
+	uint64_t blocksX = static_cast<uint64_t>((size.x + 3) / 4);
+	uint64_t blocksY = static_cast<uint64_t>((size.y + 3) / 4);
+	return blocksX * blocksY * compressedBlockSize(format);
+}
+
+bool compress(TextureFormat format, const vec4ub* source, const vec2i& size, uint8_t* destination)
+{
+	if (!compressionSupported(format))
+	{
+		log::error("Block compression is not supported for format %u", static_cast<uint32_t>(format));
+		return false;
+	}
+
+	int blocksX = (size.x + 3) / 4;
+	int blocksY = (size.y + 3) / 4;
+	uint32_t blockSize = compressedBlockSize(format);
+
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(blocksY), [&](uint32_t begin, uint32_t end)
+	{
+		Block block;
+		for (uint32_t by = begin; by < end; ++by)
+		{
+			uint8_t* output = destination + by * blocksX * blockSize;
+			for (int bx = 0; bx < blocksX; ++bx, output += blockSize)
+			{
+				loadBlock(source, size, bx, static_cast<int>(by), block);
+				switch (format)
+				{
+				case TextureFormat::DXT1_RGB:
+					encodeColorBlock(block, false, output);
+					break;
+				case TextureFormat::DXT1_RGBA:
+					encodeColorBlock(block, true, output);
+					break;
+				case TextureFormat::DXT5:
+					encodeAlphaBlock(block, 3, output);
+					encodeColorBlock(block, false, output + 8);
+					break;
+				case TextureFormat::RGTC2:
+					encodeAlphaBlock(block, 0, output);
+					encodeAlphaBlock(block, 1, output + 8);
+					break;
+				case TextureFormat::BC7:
+					encodeBC7Block(block, output);
+					break;
+				default:
+					ET_FAIL("Invalid format");
+				}
+			}
+		}
+	}, 4);
+
+	return true;
+}
+
+
+bool decompressionSupported(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+	case TextureFormat::DXT3:
+	case TextureFormat::DXT5:
+	case TextureFormat::RGTC1:
+	case TextureFormat::RGTC2:
+	case TextureFormat::BC7:
+	case TextureFormat::ETC1:
+	case TextureFormat::PVR_2bpp_RGB:
+	case TextureFormat::PVR_2bpp_sRGB:
+	case TextureFormat::PVR_2bpp_RGBA:
+	case TextureFormat::PVR_2bpp_sRGBA:
+	case TextureFormat::PVR_4bpp_RGB:
+	case TextureFormat::PVR_4bpp_sRGB:
+	case TextureFormat::PVR_4bpp_RGBA:
+	case TextureFormat::PVR_4bpp_sRGBA:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool decompressBlocks(TextureFormat format, const uint8_t* source, const vec2i& size, vec4ub* destination)
+{
+	if (!decompressionSupported(format))
+	{
+		log::error("Block decompression is not supported for format %u", static_cast<uint32_t>(format));
+		return false;
+	}
+
+	if ((format >= TextureFormat::PVR_2bpp_RGB) && (format <= TextureFormat::PVR_4bpp_sRGBA))
+	{
+		PVRTDecompressPVRTC(source, (bitsPerPixelForTextureFormat(format) == 2) ? 1 : 0, size.x, size.y, reinterpret_cast<uint8_t*>(destination));
+		return true;
+	}
+
+	if (format == TextureFormat::ETC1)
+	{
+		unsigned int width = static_cast<unsigned int>(size.x);
+		unsigned int height = static_cast<unsigned int>(size.y);
+		PVRTDecompressETC(source, width, height, destination, 0);
+		return true;
+	}
+
+	uint32_t blocksY = static_cast<uint32_t>((size.y + 3) / 4);
+	uint32_t blocksRowSize = static_cast<uint32_t>((size.x + 3) / 4) * compressedBlockSize(format);
+	uint32_t* output = reinterpret_cast<uint32_t*>(destination);
+	sharedJobSystem().parallelFor(0, blocksY, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t by = begin; by < end; ++by)
+			decodeBlocksRow(format, source + by * blocksRowSize, size, by, output);
+	}, 4);
+
+	return true;
+}
+
+bool decompressBlocks(const TextureDescription& source, TextureDescription& destination)
+{
+	if (!decompressionSupported(source.format))
+	{
+		log::error("Block decompression is not supported for format %u", static_cast<uint32_t>(source.format));
+		return false;
+	}
+
+	destination.size = source.size;
+	destination.format = TextureFormat::RGBA8;
+	destination.target = source.target;
+	destination.dataLayout = source.dataLayout;
+	destination.levelCount = source.levelCount;
+	destination.layerCount = source.layerCount;
+	destination.flags = source.flags;
+	destination.data.resize(destination.dataSizeForAllMipLevels());
+
+	/*
+	 * layers of each mip level are stored one after another (the same way they are uploaded),
+	 * sizes of compressed mip levels are clamped to the block size, such levels are cropped
+	 */
+	Vector<vec4ub> levelData;
+	for (uint32_t level = 0; level < source.levelCount; ++level)
+	{
+		vec2i sourceSize = source.sizeForMipLevel(level);
+		vec2i targetSize = destination.sizeForMipLevel(level);
+		uint32_t sourceLayerSize = source.dataSizeForMipLevel(level) / source.layerCount;
+		uint32_t targetLayerSize = destination.dataSizeForMipLevel(level) / destination.layerCount;
+		for (uint32_t layer = 0; layer < source.layerCount; ++layer)
+		{
+			const uint8_t* sourceData = source.data.constData() + source.dataOffsetForMipLevel(level, 0) + layer * sourceLayerSize;
+			vec4ub* targetData = reinterpret_cast<vec4ub*>(destination.data.begin() + destination.dataOffsetForMipLevel(level, 0) + layer * targetLayerSize);
+
+			if (sourceSize == targetSize)
+			{
+				decompressBlocks(source.format, sourceData, sourceSize, targetData);
+			}
+			else
+			{
+				levelData.resize(static_cast<size_t>(sourceSize.square()));
+				decompressBlocks(source.format, sourceData, sourceSize, levelData.data());
+				for (int y = 0; y < targetSize.y; ++y)
+					memcpy(targetData + y * targetSize.x, levelData.data() + y * sourceSize.x, targetSize.x * sizeof(vec4ub));
+			}
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Internal Stuff
+ */
+const uint32_t bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+void loadBlock(const vec4ub* source, const vec2i& size, int bx, int by, Block& block)
+{
+	block.hasTransparentPixels = false;
+	for (int y = 0; y < 4; ++y)
+	{
+		int sy = std::min(4 * by + y, size.y - 1);
+		for (int x = 0; x < 4; ++x)
+		{
+			int sx = std::min(4 * bx + x, size.x - 1);
+			const vec4ub& pixel = source[sy * size.x + sx];
+			float* target = block.pixels[4 * y + x];
+			target[0] = static_cast<float>(pixel.x);
+			target[1] = static_cast<float>(pixel.y);
+			target[2] = static_cast<float>(pixel.z);
+			target[3] = static_cast<float>(pixel.w);
+			block.alpha[4 * y + x] = pixel.w;
+			block.hasTransparentPixels |= (pixel.w < 128);
+		}
+	}
+}
+
+/*
+ * principal axis of the pixels (channels [0, components)) using power iteration on covariance matrix
+ */
+void principalAxis(const Block& block, const bool* used, int components, float* mean, float* axis)
+{
+	float count = 0.0f;
+	std::fill(mean, mean + 4, 0.0f);
+	for (int i = 0; i < 16; ++i)
+	{
+		if (used[i])
+		{
+			for (int c = 0; c < components; ++c)
+				mean[c] += block.pixels[i][c];
+			count += 1.0f;
+		}
+	}
+	for (int c = 0; c < components; ++c)
+		mean[c] /= std::max(1.0f, count);
+
+	float covariance[4][4] = { };
+	for (int i = 0; i < 16; ++i)
+	{
+		if (!used[i])
+			continue;
+
+		float d[4] = { };
+		for (int c = 0; c < components; ++c)
+			d[c] = block.pixels[i][c] - mean[c];
+
+		for (int r = 0; r < components; ++r)
+		{
+			for (int c = 0; c < components; ++c)
+				covariance[r][c] += d[r] * d[c];
+		}
+	}
+
+	std::fill(axis, axis + 4, 0.0f);
+	for (int c = 0; c < components; ++c)
+		axis[c] = 1.0f;
+
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4] = { };
+		float length = 0.0f;
+		for (int r = 0; r < components; ++r)
+		{
+			for (int c = 0; c < components; ++c)
+				next[r] += covariance[r][c] * axis[c];
+			length = std::max(length, std::abs(next[r]));
+		}
+
+		if (length < std::numeric_limits<float>::epsilon())
+			break;
+
+		for (int c = 0; c < components; ++c)
+			axis[c] = next[c] / length;
+	}
+
+	float length = 0.0f;
+	for (int c = 0; c < components; ++c)
+		length += axis[c] * axis[c];
+
+	length = std::sqrt(length);
+	for (int c = 0; c < components; ++c)
+		axis[c] = (length > 0.0f) ? axis[c] / length : 0.0f;
+}
+
+/*
+ * endpoints at the extremes of the pixels projections to principal axis, inset by 1/16 of the range
+ */
+void initialEndpoints(const Block& block, const bool* used, int components, float* e0, float* e1)
+{
+	float mean[4];
+	float axis[4];
+	principalAxis(block, used, components, mean, axis);
+
+	float minT = std::numeric_limits<float>::max();
+	float maxT = -std::numeric_limits<float>::max();
+	for (int i = 0; i < 16; ++i)
+	{
+		if (!used[i])
+			continue;
+
+		float t = 0.0f;
+		for (int c = 0; c < components; ++c)
+			t += (block.pixels[i][c] - mean[c]) * axis[c];
+
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	float inset = (maxT - minT) / 16.0f;
+	for (int c = 0; c < components; ++c)
+	{
+		e0[c] = clamp(mean[c] + axis[c] * (maxT - inset), 0.0f, 255.0f);
+		e1[c] = clamp(mean[c] + axis[c] * (minT + inset), 0.0f, 255.0f);
+	}
+}
+
+/*
+ * least squares fit of endpoints for the selected indices, returns false for degenerate cases
+ */
+bool refineEndpoints(const Block& block, const bool* used, int components,
+	const uint32_t* indices, const float* weights, float* e0, float* e1)
+{
+	float alpha2 = 0.0f;
+	float beta2 = 0.0f;
+	float alphaBeta = 0.0f;
+	float alphaX[4] = { };
+	float betaX[4] = { };
+	for (int i = 0; i < 16; ++i)
+	{
+		if (!used[i])
+			continue;
+
+		float beta = weights[indices[i]];
+		float alpha = 1.0f - beta;
+		alpha2 += alpha * alpha;
+		beta2 += beta * beta;
+		alphaBeta += alpha * beta;
+		for (int c = 0; c < components; ++c)
+		{
+			alphaX[c] += alpha * block.pixels[i][c];
+			betaX[c] += beta * block.pixels[i][c];
+		}
+	}
+
+	float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+	if (std::abs(determinant) < std::numeric_limits<float>::epsilon())
+		return false;
+
+	float scale = 1.0f / determinant;
+	for (int c = 0; c < components; ++c)
+	{
+		e0[c] = clamp((alphaX[c] * beta2 - betaX[c] * alphaBeta) * scale, 0.0f, 255.0f);
+		e1[c] = clamp((betaX[c] * alpha2 - alphaX[c] * alphaBeta) * scale, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+float selectIndices(const Block& block, const bool* used, int components,
+	const float palette[][4], uint32_t paletteSize, uint32_t* indices)
+{
+	float totalError = 0.0f;
+	for (int i = 0; i < 16; ++i)
+	{
+		if (!used[i])
+			continue;
+
+		float bestError = std::numeric_limits<float>::max();
+		for (uint32_t p = 0; p < paletteSize; ++p)
+		{
+			float error = 0.0f;
+			for (int c = 0; c < components; ++c)
+			{
+				float d = block.pixels[i][c] - palette[p][c];
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				indices[i] = p;
+			}
+		}
+		totalError += bestError;
+	}
+	return totalError;
+}
+
+/*
+ * BC1 color block
+ */
+uint16_t packColor565(const float* color)
+{
+	uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+	uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+	uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void unpackColor565(uint16_t value, float* color)
+{
+	uint32_t r = (value >> 11) & 0x1f;
+	uint32_t g = (value >> 5) & 0x3f;
+	uint32_t b = value & 0x1f;
+	color[0] = static_cast<float>((r << 3) | (r >> 2));
+	color[1] = static_cast<float>((g << 2) | (g >> 4));
+	color[2] = static_cast<float>((b << 3) | (b >> 2));
+	color[3] = 255.0f;
+}
+
+/*
+ * palette in the order of indices; in three color mode c0 <= c1 and index 3 is transparent black
+ */
+uint32_t colorPalette(uint16_t c0, uint16_t c1, bool threeColorMode, float palette[4][4])
+{
+	unpackColor565(c0, palette[0]);
+	unpackColor565(c1, palette[1]);
+	for (int c = 0; c < 3; ++c)
+	{
+		if (threeColorMode)
+		{
+			palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.0f);
+			palette[3][c] = 0.0f;
+		}
+		else
+		{
+			palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+			palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+		}
+	}
+	return threeColorMode ? 3 : 4;
+}
+
+float fitColorEndpoints(const Block& block, const bool* used, bool threeColorMode,
+	const float* e0, const float* e1, uint16_t& c0, uint16_t& c1, uint32_t* indices)
+{
+	c0 = packColor565(e0);
+	c1 = packColor565(e1);
+
+	if ((threeColorMode && (c0 > c1)) || (!threeColorMode && (c0 < c1)))
+		std::swap(c0, c1);
+
+	/*
+	 * in four color mode equal endpoints would switch decoder to three color mode,
+	 * it is still correct while every pixel references the first endpoint
+	 */
+	if (!threeColorMode && (c0 == c1))
+	{
+		float palette[4][4];
+		colorPalette(c0, c1, false, palette);
+		return selectIndices(block, used, 3, palette, 1, indices);
+	}
+
+	float palette[4][4];
+	uint32_t paletteSize = colorPalette(c0, c1, threeColorMode, palette);
+	return selectIndices(block, used, 3, palette, paletteSize, indices);
+}
+
+void encodeColorBlock(const Block& block, bool allowTransparency, uint8_t* output)
+{
+	bool threeColorMode = allowTransparency && block.hasTransparentPixels;
+
+	bool used[16];
+	bool anyUsed = false;
+	for (int i = 0; i < 16; ++i)
+	{
+		used[i] = !threeColorMode || (block.alpha[i] >= 128);
+		anyUsed |= used[i];
+	}
+
+	uint16_t c0 = 0;
+	uint16_t c1 = 0;
+	uint32_t indices[16] = { };
+	if (anyUsed)
+	{
+		float e0[4] = { };
+		float e1[4] = { };
+		initialEndpoints(block, used, 3, e0, e1);
+		float error = fitColorEndpoints(block, used, threeColorMode, e0, e1, c0, c1, indices);
+
+		static const float fourColorWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		static const float threeColorWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+		if (refineEndpoints(block, used, 3, indices, threeColorMode ? threeColorWeights : fourColorWeights, e0, e1))
+		{
+			uint16_t refined0 = 0;
+			uint16_t refined1 = 0;
+			uint32_t refinedIndices[16] = { };
+			float refinedError = fitColorEndpoints(block, used, threeColorMode, e0, e1, refined0, refined1, refinedIndices);
+			if (refinedError < error)
+			{
+				c0 = refined0;
+				c1 = refined1;
+				std::copy(refinedIndices, refinedIndices + 16, indices);
+			}
+		}
+	}
+
+	uint32_t packedIndices = 0;
+	for (int i = 0; i < 16; ++i)
+		packedIndices |= (used[i] ? indices[i] : 3) << (2 * i);
+
+	output[0] = static_cast<uint8_t>(c0 & 0xff);
+	output[1] = static_cast<uint8_t>(c0 >> 8);
+	output[2] = static_cast<uint8_t>(c1 & 0xff);
+	output[3] = static_cast<uint8_t>(c1 >> 8);
+	for (int i = 0; i < 4; ++i)
+		output[4 + i] = static_cast<uint8_t>((packedIndices >> (8 * i)) & 0xff);
+}
+
+/*
+ * BC4 block, used for alpha of BC3 and both channels of BC5, always in eight values mode
+ */
+void encodeAlphaBlock(const Block& block, int channel, uint8_t* output)
+{
+	uint32_t minValue = 255;
+	uint32_t maxValue = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		uint32_t value = static_cast<uint32_t>(block.pixels[i][channel]);
+		minValue = std::min(minValue, value);
+		maxValue = std::max(maxValue, value);
+	}
+
+	uint32_t palette[8] = { maxValue, minValue };
+	for (uint32_t i = 1; i < 7; ++i)
+		palette[i + 1] = ((7 - i) * maxValue + i * minValue) / 7;
+
+	uint64_t packedIndices = 0;
+	if (maxValue > minValue)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			uint32_t value = static_cast<uint32_t>(block.pixels[i][channel]);
+			uint32_t bestIndex = 0;
+			uint32_t bestError = 256;
+			for (uint32_t p = 0; p < 8; ++p)
+			{
+				uint32_t error = (value > palette[p]) ? value - palette[p] : palette[p] - value;
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+			packedIndices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+		}
+	}
+
+	output[0] = static_cast<uint8_t>(maxValue);
+	output[1] = static_cast<uint8_t>(minValue);
+	for (int i = 0; i < 6; ++i)
+		output[2 + i] = static_cast<uint8_t>((packedIndices >> (8 * i)) & 0xff);
+}
+
+/*
+ * BC7 mode 6: single subset, RGBA 7 bit endpoints with unique p-bits, 4 bit indices
+ */
+struct BC7Endpoints
+{
+	uint32_t values[2][4];
+	uint32_t pbits[2];
+};
+
+void quantizeBC7Endpoint(const float* endpoint, uint32_t* values, uint32_t& pbit)
+{
+	float bestError = std::numeric_limits<float>::max();
+	for (uint32_t p = 0; p < 2; ++p)
+	{
+		float error = 0.0f;
+		uint32_t quantized[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			int q = static_cast<int>((endpoint[c] - static_cast<float>(p)) / 2.0f + 0.5f);
+			quantized[c] = static_cast<uint32_t>(clamp(q, 0, 127));
+			float d = endpoint[c] - static_cast<float>((quantized[c] << 1) | p);
+			error += d * d;
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			pbit = p;
+			std::copy(quantized, quantized + 4, values);
+		}
+	}
+}
+
+float fitBC7Endpoints(const Block& block, const bool* used, const float* e0, const float* e1,
+	BC7Endpoints& endpoints, uint32_t* indices)
+{
+	quantizeBC7Endpoint(e0, endpoints.values[0], endpoints.pbits[0]);
+	quantizeBC7Endpoint(e1, endpoints.values[1], endpoints.pbits[1]);
+
+	float palette[16][4];
+	for (int c = 0; c < 4; ++c)
+	{
+		uint32_t v0 = (endpoints.values[0][c] << 1) | endpoints.pbits[0];
+		uint32_t v1 = (endpoints.values[1][c] << 1) | endpoints.pbits[1];
+		for (uint32_t i = 0; i < 16; ++i)
+			palette[i][c] = static_cast<float>(((64 - bc7Weights[i]) * v0 + bc7Weights[i] * v1 + 32) >> 6);
+	}
+	return selectIndices(block, used, 4, palette, 16, indices);
+}
+
+class BitWriter
+{
+public:
+	BitWriter(uint8_t* output) :
+		_output(output) { std::fill(_output, _output + 16, uint8_t(0)); }
+
+	void write(uint32_t value, uint32_t bits)
+	{
+		for (uint32_t i = 0; i < bits; ++i, ++_position)
+		{
+			if (value & (1u << i))
+				_output[_position / 8] |= static_cast<uint8_t>(1u << (_position % 8));
+		}
+	}
+
+private:
+	uint8_t* _output = nullptr;
+	uint32_t _position = 0;
+};
+
+void encodeBC7Block(const Block& block, uint8_t* output)
+{
+	bool used[16];
+	std::fill(used, used + 16, true);
+
+	float e0[4] = { };
+	float e1[4] = { };
+	initialEndpoints(block, used, 4, e0, e1);
+
+	BC7Endpoints endpoints = { };
+	uint32_t indices[16] = { };
+	float error = fitBC7Endpoints(block, used, e0, e1, endpoints, indices);
+
+	float weights[16];
+	for (uint32_t i = 0; i < 16; ++i)
+		weights[i] = static_cast<float>(bc7Weights[i]) / 64.0f;
+
+	if (refineEndpoints(block, used, 4, indices, weights, e0, e1))
+	{
+		BC7Endpoints refinedEndpoints = { };
+		uint32_t refinedIndices[16] = { };
+		if (fitBC7Endpoints(block, used, e0, e1, refinedEndpoints, refinedIndices) < error)
+		{
+			endpoints = refinedEndpoints;
+			std::copy(refinedIndices, refinedIndices + 16, indices);
+		}
+	}
+
+	/*
+	 * the most significant bit of the first index is implicit zero
+	 */
+	if (indices[0] >= 8)
+	{
+		std::swap(endpoints.values[0], endpoints.values[1]);
+		std::swap(endpoints.pbits[0], endpoints.pbits[1]);
+		for (uint32_t& index : indices)
+			index = 15 - index;
+	}
+
+	BitWriter writer(output);
+	writer.write(1u << 6, 7);
+	for (int c = 0; c < 4; ++c)
+	{
+		writer.write(endpoints.values[0][c], 7);
+		writer.write(endpoints.values[1][c], 7);
+	}
+	writer.write(endpoints.pbits[0], 1);
+	writer.write(endpoints.pbits[1], 1);
+	writer.write(indices[0], 3);
+	for (int i = 1; i < 16; ++i)
+		writer.write(indices[i], 4);
+}
+
+/*
+ * Decoders: every block is decoded to 4 rows of 4 pixels, packed as RGBA8 into uint32_t.
+ * Palettes and BC7 bit fields are decoded with scalar code, index expansion, interpolation
+ * and stores are vectorized with SSE4.1 (single block) and AVX2 (pairs of blocks) when available.
+ */
+const uint32_t bc7Weights2[4] = { 0, 21, 43, 64 };
+const uint32_t bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+
+/*
+ * subset of the pixel i is in the bit i (two subsets) or in the bits [2i, 2i + 1] (three subsets)
+ */
+const uint16_t bc7Partitions2[64] =
+{
+	0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80, 0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+	0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce, 0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+	0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a, 0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+	0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c, 0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+};
+
+const uint32_t bc7Partitions3[64] =
+{
+	0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+	0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+	0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+	0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+	0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+	0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+	0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+	0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+};
+
+const uint8_t bc7Anchors2[64] =
+{
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+	15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+	 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+const uint8_t bc7Anchors3Second[64] =
+{
+	 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+	 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+	 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+	 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+};
+
+const uint8_t bc7Anchors3Third[64] =
+{
+	15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+	15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+	15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+	15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+};
+
+struct BC7Mode
+{
+	uint32_t subsets;
+	uint32_t partitionBits;
+	uint32_t rotationBits;
+	uint32_t indexSelectionBits;
+	uint32_t colorBits;
+	uint32_t alphaBits;
+	uint32_t endpointPBits;
+	uint32_t sharedPBits;
+	uint32_t indexBits;
+	uint32_t secondaryIndexBits;
+};
+
+const BC7Mode bc7Modes[8] =
+{
+	{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+	{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+	{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+	{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+	{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+	{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+	{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+	{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+};
+
+/*
+ * decoded BC7 block: endpoints of the subsets (RGBA, subset s at bytes [4s, 4s + 3]),
+ * subset and interpolation weights (0..64) of every pixel
+ */
+struct BC7Block
+{
+	uint8_t endpoints0[16];
+	uint8_t endpoints1[16];
+	uint8_t subsets[16];
+	uint8_t colorWeights[16];
+	uint8_t alphaWeights[16];
+	uint32_t rotation = 0;
+};
+
+/*
+ * block is kept in two 64 bit words, which are shifted as fields are read (fields are at most 8 bits)
+ */
+class BitReader
+{
+public:
+	BitReader(const uint8_t* data)
+	{
+		memcpy(&_low, data, sizeof(_low));
+		memcpy(&_high, data + sizeof(_low), sizeof(_high));
+	}
+
+	uint32_t read(uint32_t bits)
+	{
+		if (bits == 0)
+			return 0;
+
+		uint32_t result = static_cast<uint32_t>(_low & ((1ull << bits) - 1));
+		_low = (_low >> bits) | (_high << (64 - bits));
+		_high >>= bits;
+		return result;
+	}
+
+private:
+	uint64_t _low = 0;
+	uint64_t _high = 0;
+};
+
+inline uint32_t read32(const uint8_t* data)
+{
+	uint32_t result = 0;
+	memcpy(&result, data, sizeof(result));
+	return result;
+}
+
+inline uint32_t packPixel(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+/*
+ * BC1 palette, blocks of BC2 and BC3 are always decoded in four colors mode
+ */
+void colorBlockPalette(const uint8_t* block, bool forceFourColors, uint32_t* palette)
+{
+	uint32_t c0 = static_cast<uint32_t>(block[0] | (block[1] << 8));
+	uint32_t c1 = static_cast<uint32_t>(block[2] | (block[3] << 8));
+
+	uint32_t r0 = (c0 >> 11) & 0x1f;
+	uint32_t g0 = (c0 >> 5) & 0x3f;
+	uint32_t b0 = c0 & 0x1f;
+	r0 = (r0 << 3) | (r0 >> 2);
+	g0 = (g0 << 2) | (g0 >> 4);
+	b0 = (b0 << 3) | (b0 >> 2);
+
+	uint32_t r1 = (c1 >> 11) & 0x1f;
+	uint32_t g1 = (c1 >> 5) & 0x3f;
+	uint32_t b1 = c1 & 0x1f;
+	r1 = (r1 << 3) | (r1 >> 2);
+	g1 = (g1 << 2) | (g1 >> 4);
+	b1 = (b1 << 3) | (b1 >> 2);
+
+	palette[0] = packPixel(r0, g0, b0, 255);
+	palette[1] = packPixel(r1, g1, b1, 255);
+	if ((c0 > c1) || forceFourColors)
+	{
+		palette[2] = packPixel((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
+		palette[3] = packPixel((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
+	}
+	else
+	{
+		palette[2] = packPixel((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+		palette[3] = 0;
+	}
+}
+
+/*
+ * BC4 palette and indices
+ */
+void alphaBlockPalette(const uint8_t* block, uint8_t* palette)
+{
+	uint32_t a0 = block[0];
+	uint32_t a1 = block[1];
+	palette[0] = static_cast<uint8_t>(a0);
+	palette[1] = static_cast<uint8_t>(a1);
+	if (a0 > a1)
+	{
+		for (uint32_t i = 1; i < 7; ++i)
+			palette[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1) / 7);
+	}
+	else
+	{
+		for (uint32_t i = 1; i < 5; ++i)
+			palette[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1) / 5);
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+void alphaBlockIndices(const uint8_t* block, uint8_t* indices)
+{
+	uint64_t bits = 0;
+	for (uint32_t i = 0; i < 6; ++i)
+		bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+
+	for (uint32_t i = 0; i < 16; ++i, bits >>= 3)
+		indices[i] = static_cast<uint8_t>(bits & 7);
+}
+
+void alphaBlockValues(const uint8_t* block, uint8_t* values)
+{
+	uint8_t palette[8];
+	uint8_t indices[16];
+	alphaBlockPalette(block, palette);
+	alphaBlockIndices(block, indices);
+	for (uint32_t i = 0; i < 16; ++i)
+		values[i] = palette[indices[i]];
+}
+
+void explicitAlphaValues(const uint8_t* block, uint8_t* values)
+{
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		values[2 * i + 0] = static_cast<uint8_t>((block[i] & 0x0f) * 17);
+		values[2 * i + 1] = static_cast<uint8_t>((block[i] >> 4) * 17);
+	}
+}
+
+/*
+ * returns false for reserved mode, which should be decoded as transparent black
+ */
+bool parseBC7Block(const uint8_t* data, BC7Block& block)
+{
+	uint32_t modeIndex = 0;
+	while ((modeIndex < 8) && ((data[0] & (1u << modeIndex)) == 0))
+		++modeIndex;
+
+	if (modeIndex == 8)
+		return false;
+
+	const BC7Mode& mode = bc7Modes[modeIndex];
+	BitReader reader(data);
+	reader.read(modeIndex + 1);
+
+	uint32_t partition = reader.read(mode.partitionBits);
+	block.rotation = reader.read(mode.rotationBits);
+	uint32_t indexSelection = reader.read(mode.indexSelectionBits);
+
+	uint32_t endpoints[3][2][4] = { };
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		for (uint32_t s = 0; s < mode.subsets; ++s)
+		{
+			endpoints[s][0][c] = reader.read(mode.colorBits);
+			endpoints[s][1][c] = reader.read(mode.colorBits);
+		}
+	}
+
+	for (uint32_t s = 0; s < mode.subsets; ++s)
+	{
+		endpoints[s][0][3] = reader.read(mode.alphaBits);
+		endpoints[s][1][3] = reader.read(mode.alphaBits);
+	}
+
+	uint32_t pbits[3][2] = { };
+	for (uint32_t s = 0; s < mode.subsets; ++s)
+	{
+		if (mode.endpointPBits)
+		{
+			pbits[s][0] = reader.read(1);
+			pbits[s][1] = reader.read(1);
+		}
+		else if (mode.sharedPBits)
+		{
+			pbits[s][0] = reader.read(1);
+			pbits[s][1] = pbits[s][0];
+		}
+	}
+
+	bool hasPBits = (mode.endpointPBits + mode.sharedPBits) > 0;
+	for (uint32_t s = 0; s < mode.subsets; ++s)
+	{
+		for (uint32_t e = 0; e < 2; ++e)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				uint32_t bits = (c < 3) ? mode.colorBits : mode.alphaBits;
+				uint32_t value = 255;
+				if (bits > 0)
+				{
+					value = endpoints[s][e][c];
+					if (hasPBits)
+					{
+						value = (value << 1) | pbits[s][e];
+						++bits;
+					}
+					value = (value << (8 - bits)) | (value >> (2 * bits - 8));
+				}
+				uint8_t* target = (e == 0) ? block.endpoints0 : block.endpoints1;
+				target[4 * s + c] = static_cast<uint8_t>(value);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		if (mode.subsets == 2)
+			block.subsets[i] = static_cast<uint8_t>((bc7Partitions2[partition] >> i) & 1);
+		else if (mode.subsets == 3)
+			block.subsets[i] = static_cast<uint8_t>((bc7Partitions3[partition] >> (2 * i)) & 3);
+		else
+			block.subsets[i] = 0;
+	}
+
+	auto isAnchor = [&mode, partition](uint32_t i) -> bool
+	{
+		if (i == 0)
+			return true;
+		if (mode.subsets == 2)
+			return i == bc7Anchors2[partition];
+		if (mode.subsets == 3)
+			return (i == bc7Anchors3Second[partition]) || (i == bc7Anchors3Third[partition]);
+		return false;
+	};
+
+	const uint32_t* primaryWeights = (mode.indexBits == 2) ? bc7Weights2 : ((mode.indexBits == 3) ? bc7Weights3 : bc7Weights);
+	uint8_t primary[16];
+	for (uint32_t i = 0; i < 16; ++i)
+		primary[i] = static_cast<uint8_t>(primaryWeights[reader.read(mode.indexBits - (isAnchor(i) ? 1 : 0))]);
+
+	if (mode.secondaryIndexBits > 0)
+	{
+		const uint32_t* secondaryWeights = (mode.secondaryIndexBits == 2) ? bc7Weights2 : bc7Weights3;
+		uint8_t secondary[16];
+		for (uint32_t i = 0; i < 16; ++i)
+			secondary[i] = static_cast<uint8_t>(secondaryWeights[reader.read(mode.secondaryIndexBits - ((i == 0) ? 1 : 0))]);
+
+		memcpy(block.colorWeights, indexSelection ? secondary : primary, 16);
+		memcpy(block.alphaWeights, indexSelection ? primary : secondary, 16);
+	}
+	else
+	{
+		memcpy(block.colorWeights, primary, 16);
+		memcpy(block.alphaWeights, primary, 16);
+	}
+
+	return true;
+}
+
+/*
+ * scalar decoders
+ */
+void decodeColorBlock(const uint8_t* block, bool forceFourColors, uint32_t* output, uint32_t stride)
+{
+	uint32_t palette[4];
+	colorBlockPalette(block, forceFourColors, palette);
+
+	uint32_t bits = read32(block + 4);
+	for (uint32_t y = 0; y < 4; ++y, output += stride)
+	{
+		for (uint32_t x = 0; x < 4; ++x, bits >>= 2)
+			output[x] = palette[bits & 3];
+	}
+}
+
+void insertChannel(const uint8_t* values, uint32_t channel, uint32_t* output, uint32_t stride)
+{
+	uint32_t shift = 8 * channel;
+	uint32_t mask = ~(0xffu << shift);
+	for (uint32_t y = 0; y < 4; ++y, output += stride)
+	{
+		for (uint32_t x = 0; x < 4; ++x)
+			output[x] = (output[x] & mask) | (static_cast<uint32_t>(values[4 * y + x]) << shift);
+	}
+}
+
+void decodeBC7Block(const uint8_t* data, uint32_t* output, uint32_t stride)
+{
+	BC7Block block;
+	if (!parseBC7Block(data, block))
+	{
+		for (uint32_t y = 0; y < 4; ++y, output += stride)
+			std::fill(output, output + 4, 0u);
+		return;
+	}
+
+	for (uint32_t y = 0; y < 4; ++y, output += stride)
+	{
+		for (uint32_t x = 0; x < 4; ++x)
+		{
+			uint32_t i = 4 * y + x;
+			const uint8_t* e0 = block.endpoints0 + 4 * block.subsets[i];
+			const uint8_t* e1 = block.endpoints1 + 4 * block.subsets[i];
+
+			uint32_t value[4];
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				uint32_t w = (c < 3) ? block.colorWeights[i] : block.alphaWeights[i];
+				value[c] = ((64 - w) * e0[c] + w * e1[c] + 32) >> 6;
+			}
+
+			if (block.rotation > 0)
+				std::swap(value[3], value[block.rotation - 1]);
+
+			output[x] = packPixel(value[0], value[1], value[2], value[3]);
+		}
+	}
+}
+
+void decodeBlock(TextureFormat format, const uint8_t* block, uint32_t* output, uint32_t stride)
+{
+	uint8_t values[16];
+	switch (format)
+	{
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+		decodeColorBlock(block, false, output, stride);
+		break;
+
+	case TextureFormat::DXT3:
+		decodeColorBlock(block + 8, true, output, stride);
+		explicitAlphaValues(block, values);
+		insertChannel(values, 3, output, stride);
+		break;
+
+	case TextureFormat::DXT5:
+		decodeColorBlock(block + 8, true, output, stride);
+		alphaBlockValues(block, values);
+		insertChannel(values, 3, output, stride);
+		break;
+
+	case TextureFormat::RGTC1:
+	{
+		alphaBlockValues(block, values);
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			for (uint32_t x = 0; x < 4; ++x)
+				output[y * stride + x] = packPixel(values[4 * y + x], 0, 0, 255);
+		}
+		break;
+	}
+
+	case TextureFormat::RGTC2:
+	{
+		uint8_t green[16];
+		alphaBlockValues(block, values);
+		alphaBlockValues(block + 8, green);
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			for (uint32_t x = 0; x < 4; ++x)
+				output[y * stride + x] = packPixel(values[4 * y + x], green[4 * y + x], 0, 255);
+		}
+		break;
+	}
+
+	case TextureFormat::BC7:
+		decodeBC7Block(block, output, stride);
+		break;
+
+	default:
+		ET_FAIL("Invalid format");
+	}
+}
+
+#if (ET_SIMD_DISPATCH)
+/*
+ * byte 4 * y + x of the result is 4 * (2 bit index of the pixel (x, y))
+ */
+ET_SIMD_TARGET("sse4.1")
+inline __m128i colorIndicesOffsets(uint32_t bits)
+{
+	__m128i indices = _mm_setr_epi32(static_cast<int>(bits & 0x03030303), static_cast<int>((bits >> 2) & 0x03030303),
+		static_cast<int>((bits >> 4) & 0x03030303), static_cast<int>((bits >> 6) & 0x03030303));
+	indices = _mm_shuffle_epi8(indices, _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15));
+	return _mm_slli_epi16(indices, 2);
+}
+
+/*
+ * shuffle mask, which selects 4 byte entries using offsets of the row y
+ */
+ET_SIMD_TARGET("sse4.1")
+inline __m128i rowEntriesMask(__m128i offsets, uint32_t y)
+{
+	__m128i spread = _mm_add_epi8(_mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3), _mm_set1_epi8(static_cast<char>(4 * y)));
+	return _mm_add_epi8(_mm_shuffle_epi8(offsets, spread), _mm_setr_epi8(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3));
+}
+
+/*
+ * shuffle mask, which moves values of the row y to the channel of each pixel and zeroes other channels
+ */
+ET_SIMD_TARGET("sse4.1")
+inline __m128i rowChannelMask(uint32_t channel, uint32_t y)
+{
+	const char z = static_cast<char>(0x80);
+	__m128i mask = _mm_setr_epi8(0, z, z, z, 1, z, z, z, 2, z, z, z, 3, z, z, z);
+	switch (channel)
+	{
+	case 1:
+		mask = _mm_setr_epi8(z, 0, z, z, z, 1, z, z, z, 2, z, z, z, 3, z, z);
+		break;
+	case 3:
+		mask = _mm_setr_epi8(z, z, z, 0, z, z, z, 1, z, z, z, 2, z, z, z, 3);
+		break;
+	default:
+		break;
+	}
+	return _mm_add_epi8(mask, _mm_set1_epi8(static_cast<char>(4 * y)));
+}
+
+ET_SIMD_TARGET("sse4.1")
+inline __m128i alphaBlockValuesSSE(const uint8_t* block)
+{
+	alignas(16) uint8_t palette[16] = { };
+	alignas(16) uint8_t indices[16];
+	alphaBlockPalette(block, palette);
+	alphaBlockIndices(block, indices);
+	return _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(palette)),
+		_mm_load_si128(reinterpret_cast<const __m128i*>(indices)));
+}
+
+ET_SIMD_TARGET("sse4.1")
+inline __m128i explicitAlphaValuesSSE(const uint8_t* block)
+{
+	__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+	__m128i nibbleMask = _mm_set1_epi8(0x0f);
+	__m128i values = _mm_unpacklo_epi8(_mm_and_si128(packed, nibbleMask), _mm_and_si128(_mm_srli_epi16(packed, 4), nibbleMask));
+	return _mm_or_si128(values, _mm_slli_epi16(values, 4));
+}
+
+ET_SIMD_TARGET("sse4.1")
+void decodeColorRowsSSE(const uint8_t* block, bool forceFourColors, __m128i* rows)
+{
+	alignas(16) uint32_t palette[4];
+	colorBlockPalette(block, forceFourColors, palette);
+
+	__m128i paletteVector = _mm_load_si128(reinterpret_cast<const __m128i*>(palette));
+	__m128i offsets = colorIndicesOffsets(read32(block + 4));
+	for (uint32_t y = 0; y < 4; ++y)
+		rows[y] = _mm_shuffle_epi8(paletteVector, rowEntriesMask(offsets, y));
+}
+
+ET_SIMD_TARGET("sse4.1")
+void insertChannelSSE(__m128i values, uint32_t channel, __m128i* rows)
+{
+	__m128i keepMask = _mm_set1_epi32(static_cast<int>(~(0xffu << (8 * channel))));
+	for (uint32_t y = 0; y < 4; ++y)
+		rows[y] = _mm_or_si128(_mm_and_si128(rows[y], keepMask), _mm_shuffle_epi8(values, rowChannelMask(channel, y)));
+}
+
+/*
+ * ((64 - w) * e0 + w * e1 + 32) >> 6 == (64 * e0 + w * (e1 - e0) + 32) >> 6, fits into 16 bit lanes
+ */
+ET_SIMD_TARGET("sse4.1")
+inline __m128i interpolateBC7(__m128i e0, __m128i e1, __m128i w)
+{
+	__m128i bias = _mm_set1_epi16(32);
+	__m128i lo0 = _mm_cvtepu8_epi16(e0);
+	__m128i lo1 = _mm_cvtepu8_epi16(e1);
+	__m128i loW = _mm_cvtepu8_epi16(w);
+	__m128i hi0 = _mm_cvtepu8_epi16(_mm_srli_si128(e0, 8));
+	__m128i hi1 = _mm_cvtepu8_epi16(_mm_srli_si128(e1, 8));
+	__m128i hiW = _mm_cvtepu8_epi16(_mm_srli_si128(w, 8));
+	__m128i lo = _mm_add_epi16(_mm_slli_epi16(lo0, 6), _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(lo1, lo0), loW), bias));
+	__m128i hi = _mm_add_epi16(_mm_slli_epi16(hi0, 6), _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(hi1, hi0), hiW), bias));
+	return _mm_packus_epi16(_mm_srai_epi16(lo, 6), _mm_srai_epi16(hi, 6));
+}
+
+ET_SIMD_TARGET("sse4.1")
+inline __m128i bc7RotationMask(uint32_t rotation)
+{
+	switch (rotation)
+	{
+	case 1:
+		return _mm_setr_epi8(3, 1, 2, 0, 7, 5, 6, 4, 11, 9, 10, 8, 15, 13, 14, 12);
+	case 2:
+		return _mm_setr_epi8(0, 3, 2, 1, 4, 7, 6, 5, 8, 11, 10, 9, 12, 15, 14, 13);
+	case 3:
+		return _mm_setr_epi8(0, 1, 3, 2, 4, 5, 7, 6, 8, 9, 11, 10, 12, 13, 15, 14);
+	default:
+		return _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	}
+}
+
+ET_SIMD_TARGET("sse4.1")
+void decodeBC7RowsSSE(const uint8_t* data, __m128i* rows)
+{
+	alignas(16) BC7Block block;
+	if (!parseBC7Block(data, block))
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+			rows[y] = _mm_setzero_si128();
+		return;
+	}
+
+	__m128i endpoints0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.endpoints0));
+	__m128i endpoints1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.endpoints1));
+	__m128i subsetOffsets = _mm_slli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block.subsets)), 2);
+	__m128i colorWeights = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.colorWeights));
+	__m128i alphaWeights = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.alphaWeights));
+	__m128i alphaLanes = _mm_set1_epi32(static_cast<int>(0xff000000));
+	__m128i rotation = bc7RotationMask(block.rotation);
+	__m128i weightsSpread = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		__m128i entries = rowEntriesMask(subsetOffsets, y);
+		__m128i spread = _mm_add_epi8(weightsSpread, _mm_set1_epi8(static_cast<char>(4 * y)));
+		__m128i weights = _mm_blendv_epi8(_mm_shuffle_epi8(colorWeights, spread), _mm_shuffle_epi8(alphaWeights, spread), alphaLanes);
+		__m128i row = interpolateBC7(_mm_shuffle_epi8(endpoints0, entries), _mm_shuffle_epi8(endpoints1, entries), weights);
+		rows[y] = _mm_shuffle_epi8(row, rotation);
+	}
+}
+
+ET_SIMD_TARGET("sse4.1")
+void decodeRowsSSE(TextureFormat format, const uint8_t* block, __m128i* rows)
+{
+	switch (format)
+	{
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+		decodeColorRowsSSE(block, false, rows);
+		break;
+
+	case TextureFormat::DXT3:
+		decodeColorRowsSSE(block + 8, true, rows);
+		insertChannelSSE(explicitAlphaValuesSSE(block), 3, rows);
+		break;
+
+	case TextureFormat::DXT5:
+		decodeColorRowsSSE(block + 8, true, rows);
+		insertChannelSSE(alphaBlockValuesSSE(block), 3, rows);
+		break;
+
+	case TextureFormat::RGTC1:
+	{
+		__m128i red = alphaBlockValuesSSE(block);
+		__m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+		for (uint32_t y = 0; y < 4; ++y)
+			rows[y] = _mm_or_si128(alpha, _mm_shuffle_epi8(red, rowChannelMask(0, y)));
+		break;
+	}
+
+	case TextureFormat::RGTC2:
+	{
+		__m128i red = alphaBlockValuesSSE(block);
+		__m128i green = alphaBlockValuesSSE(block + 8);
+		__m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			rows[y] = _mm_or_si128(_mm_or_si128(alpha, _mm_shuffle_epi8(red, rowChannelMask(0, y))),
+				_mm_shuffle_epi8(green, rowChannelMask(1, y)));
+		}
+		break;
+	}
+
+	case TextureFormat::BC7:
+		decodeBC7RowsSSE(block, rows);
+		break;
+
+	default:
+		ET_FAIL("Invalid format");
+	}
+}
+
+/*
+ * two adjacent blocks are decoded into the lanes of 256 bit rows, so each row of both blocks is a single store;
+ * shuffles of BC1 - BC5 are done for both blocks at once, BC7 is interpolated per block
+ */
+ET_SIMD_TARGET("avx2")
+inline __m256i combineLanes(__m128i low, __m128i high)
+{
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+ET_SIMD_TARGET("avx2")
+void decodeColorRowsAVX2(const uint8_t* block0, const uint8_t* block1, bool forceFourColors, __m256i* rows)
+{
+	alignas(32) uint32_t palette[8];
+	colorBlockPalette(block0, forceFourColors, palette);
+	colorBlockPalette(block1, forceFourColors, palette + 4);
+
+	__m256i paletteVector = _mm256_load_si256(reinterpret_cast<const __m256i*>(palette));
+	__m256i offsets = combineLanes(colorIndicesOffsets(read32(block0 + 4)), colorIndicesOffsets(read32(block1 + 4)));
+	__m256i channels = _mm256_setr_epi8(0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+	__m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		__m256i rowSpread = _mm256_add_epi8(spread, _mm256_set1_epi8(static_cast<char>(4 * y)));
+		__m256i entries = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, rowSpread), channels);
+		rows[y] = _mm256_shuffle_epi8(paletteVector, entries);
+	}
+}
+
+ET_SIMD_TARGET("avx2")
+inline __m256i rowChannelMaskAVX2(uint32_t channel, uint32_t y)
+{
+	__m128i mask = rowChannelMask(channel, y);
+	return combineLanes(mask, mask);
+}
+
+ET_SIMD_TARGET("avx2")
+void insertChannelAVX2(__m256i values, uint32_t channel, __m256i* rows)
+{
+	__m256i keepMask = _mm256_set1_epi32(static_cast<int>(~(0xffu << (8 * channel))));
+	for (uint32_t y = 0; y < 4; ++y)
+		rows[y] = _mm256_or_si256(_mm256_and_si256(rows[y], keepMask), _mm256_shuffle_epi8(values, rowChannelMaskAVX2(channel, y)));
+}
+
+ET_SIMD_TARGET("avx2")
+void decodeRowsAVX2(TextureFormat format, const uint8_t* block0, const uint8_t* block1, __m256i* rows)
+{
+	switch (format)
+	{
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+		decodeColorRowsAVX2(block0, block1, false, rows);
+		break;
+
+	case TextureFormat::DXT3:
+		decodeColorRowsAVX2(block0 + 8, block1 + 8, true, rows);
+		insertChannelAVX2(combineLanes(explicitAlphaValuesSSE(block0), explicitAlphaValuesSSE(block1)), 3, rows);
+		break;
+
+	case TextureFormat::DXT5:
+		decodeColorRowsAVX2(block0 + 8, block1 + 8, true, rows);
+		insertChannelAVX2(combineLanes(alphaBlockValuesSSE(block0), alphaBlockValuesSSE(block1)), 3, rows);
+		break;
+
+	case TextureFormat::RGTC1:
+	{
+		__m256i red = combineLanes(alphaBlockValuesSSE(block0), alphaBlockValuesSSE(block1));
+		__m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+		for (uint32_t y = 0; y < 4; ++y)
+			rows[y] = _mm256_or_si256(alpha, _mm256_shuffle_epi8(red, rowChannelMaskAVX2(0, y)));
+		break;
+	}
+
+	case TextureFormat::RGTC2:
+	{
+		__m256i red = combineLanes(alphaBlockValuesSSE(block0), alphaBlockValuesSSE(block1));
+		__m256i green = combineLanes(alphaBlockValuesSSE(block0 + 8), alphaBlockValuesSSE(block1 + 8));
+		__m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			rows[y] = _mm256_or_si256(_mm256_or_si256(alpha, _mm256_shuffle_epi8(red, rowChannelMaskAVX2(0, y))),
+				_mm256_shuffle_epi8(green, rowChannelMaskAVX2(1, y)));
+		}
+		break;
+	}
+
+	default:
+	{
+		__m128i rows0[4];
+		__m128i rows1[4];
+		decodeRowsSSE(format, block0, rows0);
+		decodeRowsSSE(format, block1, rows1);
+		for (uint32_t y = 0; y < 4; ++y)
+			rows[y] = combineLanes(rows0[y], rows1[y]);
+	}
+	}
+}
+
+/*
+ * decode blocks [firstBlock, lastBlock) of the row with all 4 rows inside of the image, return first block not decoded
+ */
+ET_SIMD_TARGET("avx2")
+uint32_t decodeFullBlocksAVX2(TextureFormat format, const uint8_t* source, uint32_t blockSize,
+	uint32_t firstBlock, uint32_t lastBlock, uint32_t* output, uint32_t width)
+{
+	uint32_t bx = firstBlock;
+	for (; bx + 2 <= lastBlock; bx += 2)
+	{
+		__m256i rows[4];
+		decodeRowsAVX2(format, source + bx * blockSize, source + (bx + 1) * blockSize, rows);
+		for (uint32_t y = 0; y < 4; ++y)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + y * width + 4 * bx), rows[y]);
+	}
+	return bx;
+}
+
+ET_SIMD_TARGET("sse4.1")
+uint32_t decodeFullBlocksSSE(TextureFormat format, const uint8_t* source, uint32_t blockSize,
+	uint32_t firstBlock, uint32_t lastBlock, uint32_t* output, uint32_t width)
+{
+	uint32_t bx = firstBlock;
+	for (; bx < lastBlock; ++bx)
+	{
+		__m128i rows[4];
+		decodeRowsSSE(format, source + bx * blockSize, rows);
+		for (uint32_t y = 0; y < 4; ++y)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + y * width + 4 * bx), rows[y]);
+	}
+	return bx;
+}
+#endif
+
+/*
+ * decodes one row of blocks, blocks which are not entirely inside of the image are decoded to temporary storage
+ */
+void decodeBlocksRow(TextureFormat format, const uint8_t* source, const vec2i& size, uint32_t blockY, uint32_t* destination)
+{
+	uint32_t width = static_cast<uint32_t>(size.x);
+	uint32_t height = static_cast<uint32_t>(size.y);
+	uint32_t blockSize = compressedBlockSize(format);
+	uint32_t blocksX = (width + 3) / 4;
+	uint32_t fullBlocksX = width / 4;
+	uint32_t rowsCount = std::min(4u, height - 4 * blockY);
+	uint32_t* output = destination + 4 * blockY * width;
+
+	uint32_t bx = 0;
+	if (rowsCount == 4)
+	{
+#	if (ET_SIMD_DISPATCH)
+		if (cpuSupports(CPUFeature::AVX2))
+			bx = decodeFullBlocksAVX2(format, source, blockSize, bx, fullBlocksX, output, width);
+
+		if (cpuSupports(CPUFeature::SSE41))
+			bx = decodeFullBlocksSSE(format, source, blockSize, bx, fullBlocksX, output, width);
+#	endif
+
+		for (; bx < fullBlocksX; ++bx)
+			decodeBlock(format, source + bx * blockSize, output + 4 * bx, width);
+	}
+
+	for (; bx < blocksX; ++bx)
+	{
+		uint32_t pixels[16];
+		decodeBlock(format, source + bx * blockSize, pixels, 4);
+
+		uint32_t columnsCount = std::min(4u, width - 4 * bx);
+		for (uint32_t y = 0; y < rowsCount; ++y)
+			memcpy(output + y * width + 4 * bx, pixels + 4 * y, columnsCount * sizeof(uint32_t));
+	}
+}
+
+}
+}
@@ -0,0 +1,52 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/containers.h>
+#include <et/rendering/base/rendering.h>
+#include <et/imaging/texturedescription.h>
+
+namespace et
+{
+namespace bc
+{
+/*
+ * CPU encoders for block compressed formats:
+ * DXT1_RGB / DXT1_RGBA (BC1), DXT5 (BC3), RGTC2 (BC5) and BC7 (mode 6 only).
+ * Partial blocks at the image edges are filled by clamping pixel coordinates.
+ */
+bool compressionSupported(TextureFormat);
+
+uint32_t compressedBlockSize(TextureFormat);
+uint64_t compressedDataSize(TextureFormat, const vec2i& size);
+
+/*
+ * destination should have space for compressedDataSize(format, size) bytes,
+ * block rows are encoded in parallel on the shared job system
+ */
+bool compress(TextureFormat, const vec4ub* source, const vec2i& size, uint8_t* destination);
+
+/*
+ * CPU decoders for DXT1 / DXT3 / DXT5 (BC1 - BC3), RGTC1 / RGTC2 (BC4, BC5), BC7, ETC1 and PVRTC,
+ * used when format is not supported by the device and for tools.
+ * Output is RGBA8, BC4 and BC5 are decoded to (r, 0, 0, 1) and (r, g, 0, 1).
+ * Block rows are decoded in parallel, BC1 - BC5 and BC7 blocks are decoded with SSE4.1 / AVX2 when available.
+ */
+bool decompressionSupported(TextureFormat);
+
+/*
+ * destination should have space for size.x * size.y pixels
+ */
+bool decompressBlocks(TextureFormat, const uint8_t* source, const vec2i& size, vec4ub* destination);
+
+/*
+ * decodes all mip levels and layers into RGBA8 texture description
+ */
+bool decompressBlocks(const TextureDescription& source, TextureDescription& destination);
+}
+}
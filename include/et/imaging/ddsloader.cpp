@@ -204,10 +204,12 @@ const uint32_t DDS_HEADER_ID = ET_COMPOSE_UINT32(' ', 'S', 'D', 'D');
 const uint32_t FOURCC_DXT1 = ET_COMPOSE_UINT32('1', 'T', 'X', 'D');
 const uint32_t FOURCC_DXT3 = ET_COMPOSE_UINT32('3', 'T', 'X', 'D');
 const uint32_t FOURCC_DXT5 = ET_COMPOSE_UINT32('5', 'T', 'X', 'D');
-const uint32_t FOURCC_ATI2 = ET_COMPOSE_UINT32('1', 'I', 'T', 'A');
+const uint32_t FOURCC_ATI1 = ET_COMPOSE_UINT32('1', 'I', 'T', 'A');
+const uint32_t FOURCC_ATI2 = ET_COMPOSE_UINT32('2', 'I', 'T', 'A');
 const uint32_t FOURCC_DX10 = ET_COMPOSE_UINT32('0', '1', 'X', 'D');
 
 void fillDescriptionWithFormat(TextureDescription&, DXGI_FORMAT);
+bool fillDescriptionWithHeader(TextureDescription&, const DDS_HEADER&, const DDS_HEADER_DXT10*);
 
 void dds::loadInfoFromStream(std::istream& source, TextureDescription& desc)
 {
@@ -222,7 +224,106 @@ void dds::loadInfoFromStream(std::istream& source, TextureDescription& desc)
 	
 	DDS_HEADER header = { };
 	source.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	DDS_HEADER_DXT10 dx10Header = { };
+	if (header.ddspf.dwFourCC == FOURCC_DX10)
+		source.read(reinterpret_cast<char*>(&dx10Header), sizeof(dx10Header));
+
+	fillDescriptionWithHeader(desc, header, &dx10Header);
+}
+
+void dds::loadFromStream(std::istream& source, TextureDescription& desc)
+{
+	if (source.fail())
+	{
+		log::error("Unable to load DDS image from stream: %s", desc.origin().c_str());
+		return;
+	}
+	
+	loadInfoFromStream(source, desc);
 	
+	uint32_t dataSize = desc.layerCount * desc.dataSizeForAllMipLevels();
+	if (dataSize)
+	{
+		desc.data = BinaryDataStorage(dataSize);
+		source.read(desc.data.binary(), dataSize);
+	}
+}
+
+bool dds::loadFromMappedFile(const MappedFile::Pointer& file, TextureDescription& desc, bool loadData)
+{
+	uint64_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+	if (file->size() < offset)
+	{
+		log::error("Unable to load DDS. File is too small: %s", desc.origin().c_str());
+		return false;
+	}
+
+	uint32_t headerId = 0;
+	etCopyMemory(&headerId, file->data(), sizeof(headerId));
+	if (headerId != DDS_HEADER_ID)
+	{
+		log::error("Unable to load DDS. Invalid file signature.");
+		return false;
+	}
+
+	DDS_HEADER header = { };
+	etCopyMemory(&header, file->data() + sizeof(headerId), sizeof(header));
+
+	DDS_HEADER_DXT10 dx10Header = { };
+	if (header.ddspf.dwFourCC == FOURCC_DX10)
+	{
+		if (file->size() < offset + sizeof(dx10Header))
+		{
+			log::error("Unable to load DDS. File is too small: %s", desc.origin().c_str());
+			return false;
+		}
+		etCopyMemory(&dx10Header, file->data() + offset, sizeof(dx10Header));
+		offset += sizeof(dx10Header);
+	}
+
+	if (!fillDescriptionWithHeader(desc, header, &dx10Header))
+		return false;
+
+	if (loadData)
+	{
+		uint64_t dataSize = desc.layerCount * desc.dataSizeForAllMipLevels();
+		if (file->size() < offset + dataSize)
+		{
+			log::error("Unable to load DDS. File is truncated: %s", desc.origin().c_str());
+			return false;
+		}
+		desc.data = file->view(offset, dataSize);
+		desc.mappedFile = file;
+	}
+	return true;
+}
+
+void dds::loadFromFile(const std::string& path, TextureDescription& desc)
+{
+	MappedFile::Pointer file = MappedFile::Pointer::create(path);
+	if (file->valid())
+	{
+		desc.setOrigin(path);
+		loadFromMappedFile(file, desc, true);
+	}
+}
+
+void dds::loadInfoFromFile(const std::string& path, TextureDescription& desc)
+{
+	InputStream file(path, StreamMode_Binary);
+	if (file.valid())
+	{
+		desc.setOrigin(path);
+		loadInfoFromStream(file.stream(), desc);
+	}
+}
+
+/*
+ * Service
+ */
+bool fillDescriptionWithHeader(TextureDescription& desc, const DDS_HEADER& header, const DDS_HEADER_DXT10* dx10Header)
+{
 	desc.size = vec2i(static_cast<int32_t>(header.dwWidth), static_cast<int32_t>(header.dwHeight));
 	desc.levelCount = (header.dwMipMapCount < 1) ? 1 : header.dwMipMapCount;
 	desc.target = (header.dwCaps2 & DDSCAPS2_CUBEMAP) ? TextureTarget::Texture_Cube : TextureTarget::Texture_2D;
@@ -315,6 +416,12 @@ void dds::loadInfoFromStream(std::istream& source, TextureDescription& desc)
 			break;
 		}
 			
+		case FOURCC_ATI1:
+		{
+			desc.format = TextureFormat::RGTC1;
+			break;
+		}
+
 		case FOURCC_ATI2:
 		{
 			desc.format = TextureFormat::RGTC2;
@@ -323,9 +430,8 @@ void dds::loadInfoFromStream(std::istream& source, TextureDescription& desc)
 			
 		case FOURCC_DX10:
 		{
-			DDS_HEADER_DXT10 dx10Header = { };
-			source.read(reinterpret_cast<char*>(&dx10Header), sizeof(dx10Header));
-			fillDescriptionWithFormat(desc, dx10Header.dxgiFormat);
+			ET_ASSERT(dx10Header != nullptr);
+			fillDescriptionWithFormat(desc, dx10Header->dxgiFormat);
 			break;
 		}
 
@@ -334,52 +440,13 @@ void dds::loadInfoFromStream(std::istream& source, TextureDescription& desc)
 			char fourcc_str[5] = { };
 			etCopyMemory(fourcc_str, &header.ddspf.dwFourCC, 4);
 			log::error("Unsupported FOURCC: %u, text: %s", header.ddspf.dwFourCC, fourcc_str);
-			return;
+			return false;
 		}
 	};
-}
 
-void dds::loadFromStream(std::istream& source, TextureDescription& desc)
-{
-	if (source.fail())
-	{
-		log::error("Unable to load DDS image from stream: %s", desc.origin().c_str());
-		return;
-	}
-	
-	loadInfoFromStream(source, desc);
-	
-	uint32_t dataSize = desc.layerCount * desc.dataSizeForAllMipLevels();
-	if (dataSize)
-	{
-		desc.data = BinaryDataStorage(dataSize);
-		source.read(desc.data.binary(), dataSize);
-	}
-}
-
-void dds::loadFromFile(const std::string& path, TextureDescription& desc)
-{
-	InputStream file(path, StreamMode_Binary);
-	if (file.valid())
-	{
-		desc.setOrigin(path);
-		loadFromStream(file.stream(), desc);
-	}
+	return true;
 }
 
-void dds::loadInfoFromFile(const std::string& path, TextureDescription& desc)
-{
-	InputStream file(path, StreamMode_Binary);
-	if (file.valid())
-	{
-		desc.setOrigin(path);
-		loadInfoFromStream(file.stream(), desc);
-	}
-}
-
-/*
- * Service
- */
 void fillDescriptionWithFormat(TextureDescription& desc, DXGI_FORMAT format)
 {
 	switch (format)
@@ -400,6 +467,36 @@ void fillDescriptionWithFormat(TextureDescription& desc, DXGI_FORMAT format)
 			desc.format = TextureFormat::RGBA32F;
 			break;
 		}
+		case DXGI_FORMAT_BC1_UNORM:
+		{
+			desc.format = TextureFormat::DXT1_RGBA;
+			break;
+		}
+		case DXGI_FORMAT_BC2_UNORM:
+		{
+			desc.format = TextureFormat::DXT3;
+			break;
+		}
+		case DXGI_FORMAT_BC3_UNORM:
+		{
+			desc.format = TextureFormat::DXT5;
+			break;
+		}
+		case DXGI_FORMAT_BC4_UNORM:
+		{
+			desc.format = TextureFormat::RGTC1;
+			break;
+		}
+		case DXGI_FORMAT_BC5_UNORM:
+		{
+			desc.format = TextureFormat::RGTC2;
+			break;
+		}
+		case DXGI_FORMAT_BC7_UNORM:
+		{
+			desc.format = TextureFormat::BC7;
+			break;
+		}
 			
 		default:
 		{
@@ -16,6 +16,11 @@ namespace et
 		void loadFromStream(std::istream& stream, TextureDescription& desc);
 		void loadFromFile(const std::string& path, TextureDescription& desc);
 
+		/*
+		 * data of the description is set to the view over the mapped file, no copies are made
+		 */
+		bool loadFromMappedFile(const MappedFile::Pointer& file, TextureDescription& desc, bool loadData);
+
 		void loadInfoFromStream(std::istream& stream, TextureDescription& desc);
 		void loadInfoFromFile(const std::string& path, TextureDescription& desc);
 	}
@@ -5,209 +5,478 @@
  *
  */
 
+#include <et/core/jobsystem.h>
+#include <et/core/textparsing.h>
+#include <et/core/tools.h>
 #include <et/imaging/hdrloader.h>
 
+#if (ET_SIMD_SSE)
+#	include <immintrin.h>
+#endif
+
 using namespace et;
 
 const std::string kRadianceHeader = "#?RADIANCE";
 const std::string kRadianceFormatEntry = "FORMAT=";
 const std::string kRadiance32Bit_RLE_RGBE = "32-BIT_RLE_RGBE";
 
-static bool shouldConvertRGBEToFloat = true;
+static hdr::OutputFormat hdrOutputFormat = hdr::OutputFormat::Float32;
+
+void et::hdr::setOutputFormat(OutputFormat value)
+{
+	hdrOutputFormat = value;
+}
+
+et::hdr::OutputFormat et::hdr::outputFormat()
+{
+	return hdrOutputFormat;
+}
 
 void et::hdr::setShouldConvertRGBEToFloat(bool value)
 {
-	shouldConvertRGBEToFloat = value;
+	hdrOutputFormat = value ? OutputFormat::Float32 : OutputFormat::RGBE;
 }
 
-unsigned char* readScanline(unsigned char*, int, vec4ub*);
+namespace
+{
+using ReadLineFunction = std::function<bool(std::string&)>;
+
+bool parseHeader(const ReadLineFunction&, TextureDescription&);
+bool decodeScanlines(const uint8_t* begin, const uint8_t* end, TextureDescription&, const uint8_t*& dataEnd);
+}
 
 void et::hdr::loadInfoFromStream(std::istream& source, TextureDescription& desc)
+{
+	parseHeader([&source](std::string& line) -> bool
+		{ return static_cast<bool>(std::getline(source, line)); }, desc);
+}
+
+void et::hdr::loadFromStream(std::istream& source, TextureDescription& desc)
+{
+	loadInfoFromStream(source, desc);
+
+	auto sourcePos = source.tellg();
+	source.seekg(0, std::ios::end);
+	uint64_t availableSize = static_cast<uint64_t>(source.tellg() - sourcePos);
+	source.seekg(sourcePos, std::ios::beg);
+
+	BinaryDataStorage inData(availableSize);
+	source.read(inData.binary(), availableSize);
+
+	const uint8_t* dataEnd = nullptr;
+	if (decodeScanlines(inData.begin(), inData.end(), desc, dataEnd))
+	{
+		decltype(sourcePos) dataSize = dataEnd - inData.begin();
+		source.seekg(sourcePos + dataSize, std::ios::beg);
+	}
+}
+
+void et::hdr::loadFromMemory(const uint8_t* data, uint64_t size, TextureDescription& desc)
+{
+	const char* position = reinterpret_cast<const char*>(data);
+	const char* end = position + size;
+	bool headerParsed = parseHeader([&position, end](std::string& line) -> bool
+	{
+		if (position >= end)
+			return false;
+
+		const char* lineEnd = std::find(position, end, '\n');
+		line.assign(position, lineEnd);
+		position = (lineEnd < end) ? lineEnd + 1 : end;
+		return true;
+	}, desc);
+
+	const uint8_t* dataEnd = nullptr;
+	if (headerParsed)
+		decodeScanlines(reinterpret_cast<const uint8_t*>(position), data + size, desc, dataEnd);
+}
+
+void et::hdr::loadFromFile(const std::string& path, TextureDescription& desc)
+{
+	MappedFile file(path);
+	if (file.valid())
+	{
+		desc.setOrigin(path);
+		loadFromMemory(file.data(), file.size(), desc);
+	}
+}
+
+void et::hdr::loadInfoFromFile(const std::string& path, TextureDescription& desc)
+{
+	InputStream file(path, StreamMode_Binary);
+	if (file.valid())
+	{
+		desc.setOrigin(path);
+		loadInfoFromStream(file.stream(), desc);
+	}
+}
+
+/*
+ * Internal stuff
+ */
+namespace
+{
+
+bool readHeaderLine(const ReadLineFunction& readLine, std::string& line)
+{
+	if (!readLine(line))
+		return false;
+
+	if (!line.empty() && (line.back() == '\r'))
+		line.pop_back();
+
+	return true;
+}
+
+bool parseHeader(const ReadLineFunction& readLine, TextureDescription& desc)
 {
 	std::string line;
-	std::getline(source, line);
-	
-	if (line != kRadianceHeader)
+	if (!readHeaderLine(readLine, line) || (line != kRadianceHeader))
 	{
 		log::error("Failed to load HDR image: invalid header");
-		return;
+		return false;
 	}
 
-	std::getline(source, line);
-	while (line.empty() || (line.find('#') == 0))
-		std::getline(source, line);
-		
+	do
+	{
+		if (!readHeaderLine(readLine, line))
+		{
+			log::error("Failed to load HDR image: can't find format in header");
+			return false;
+		}
+	}
+	while (line.empty() || (line.find('#') == 0));
+
 	uppercase(line);
-	
+
 	if (line.find(kRadianceFormatEntry) != 0)
 	{
 		log::error("Failed to load HDR image: can't find format in header");
-		return;
+		return false;
 	}
-	
+
 	std::string format = line.substr(kRadianceFormatEntry.size());
 	if (format != kRadiance32Bit_RLE_RGBE)
 	{
 		log::error("Failed to load HDR image: invalid format (%s)", format.c_str());
-		return;
+		return false;
 	}
 
-	std::getline(source, line);
-	uppercase(line);
-
-	while (line.empty() || (line.find('#') == 0) || (line.find("EXPOSURE") == 0) || (line.find("GAMMA") == 0))
+	do
 	{
-		std::getline(source, line);
+		if (!readHeaderLine(readLine, line))
+		{
+			log::error("Failed to load HDR image: can't find dimensions in header");
+			return false;
+		}
 		uppercase(line);
 	}
-	
+	while (line.empty() || (line.find('#') == 0) || (line.find("EXPOSURE") == 0) || (line.find("GAMMA") == 0));
+
 	line = removeWhitespace(line);
-	
+
 	size_t xpos = line.find('X');
 	size_t ypos = line.find('Y');
 	if ((xpos == std::string::npos) || (ypos == std::string::npos))
 	{
 		log::error("Failed to load HDR image: can't find dimensions in header (last checked line: %s)", line.c_str());
-		return;
+		return false;
 	}
 
-	std::string ws;
-	std::string hs;
-	
-	if (xpos < ypos)
+	/*
+	 * dimension follows the axis and ends at the sign of the next axis or at the end of line
+	 */
+	auto parseDimension = [&line](size_t axisPosition, int32_t& value) -> bool
 	{
-		ws = line.substr(xpos + 1, ypos - xpos - 2);
-		hs = line.substr(ypos + 1);
-	}
-	else
+		int64_t dimension = 0;
+		const char* position = line.data() + axisPosition + 1;
+		if (!text::parseInteger(position, line.data() + line.size(), dimension) || (dimension <= 0) || (dimension > 0x7fffffff))
+			return false;
+
+		value = static_cast<int32_t>(dimension);
+		return true;
+	};
+
+	if (!parseDimension(xpos, desc.size.x) || !parseDimension(ypos, desc.size.y))
 	{
-		hs = line.substr(ypos + 1, xpos - ypos - 2);
-		ws = line.substr(xpos + 1);
+		log::error("Failed to load HDR image: invalid dimensions in header (%s)", line.c_str());
+		return false;
 	}
-	
-	desc.size.x = strToInt(ws);
-	desc.size.y = strToInt(hs);
+
 	desc.target = TextureTarget::Texture_2D;
-	desc.format = shouldConvertRGBEToFloat ? TextureFormat::RGBA32F : TextureFormat::RGBA8;	
 	desc.levelCount = 1;
 	desc.layerCount = 1;
-}
-
-void et::hdr::loadFromStream(std::istream& source, TextureDescription& desc)
-{
-	loadInfoFromStream(source, desc);
 
-	if ((desc.size.x < 8) || (desc.size.x > 0x7fff))
+	switch (hdr::outputFormat())
 	{
-		log::error("Failed to load HDR image");
-		return;
+	case hdr::OutputFormat::RGBE:
+		desc.format = TextureFormat::RGBA8;
+		break;
+	case hdr::OutputFormat::Float16:
+		desc.format = TextureFormat::RGBA16F;
+		break;
+	default:
+		desc.format = TextureFormat::RGBA32F;
 	}
 
-	auto sourcePos = source.tellg();
+	return true;
+}
 
-    uint64_t square = desc.size.square();
-    uint64_t maxDataSize = square * bitsPerPixelForTextureFormat(desc.format) / 8;
-    
-    uint64_t rowSize = desc.size.x * 4;
-	BinaryDataStorage inData(maxDataSize, 0);
-	source.read(inData.binary(), maxDataSize);
-	uint8_t* ptr = inData.begin();
+/*
+ * scanline is stored as four RLE-encoded planes (r, g, b, e);
+ * skipping only reads run headers, so positions of all scanlines are found quickly
+ * and scanlines could be decoded in parallel
+ */
+const uint8_t* skipScanline(const uint8_t* ptr, const uint8_t* end, int32_t width)
+{
+	if ((end - ptr < 4) || (ptr[0] != 2) || (ptr[1] != 2) || (((ptr[2] << 8) | ptr[3]) != width))
+		return nullptr;
 
-	if (shouldConvertRGBEToFloat)
+	ptr += 4;
+	for (uint32_t i = 0; i < 4; ++i)
 	{
-		desc.data.resize(desc.size.square() * sizeof(vec4));
+		for (int32_t j = 0; j < width; )
+		{
+			if (ptr >= end)
+				return nullptr;
 
-		DataStorage<vec4ub> rgbeData(desc.size.square(), 0);
-		DataStorage<vec4> floatDataWrapper(reinterpret_cast<vec4*>(desc.data.data()), desc.data.size());
+			int32_t code = *ptr++;
+			if (code > 128)
+			{
+				code &= 127;
+				++ptr;
+			}
+			else
+			{
+				ptr += code;
+			}
 
-		for (int32_t y = 0; y < desc.size.y; ++y)
-		{
-			auto rowPtr = rgbeData.binary() + rowSize * (desc.size.y - 1 - y);
-			ptr = readScanline(ptr, desc.size.x, reinterpret_cast<vec4ub*>(rowPtr));
+			j += code;
+			if ((code == 0) || (j > width) || (ptr > end))
+				return nullptr;
 		}
+	}
+	return ptr;
+}
 
-		for (int32_t i = 0; i < desc.size.square(); ++i)
+/*
+ * scanline should be validated with skipScanline
+ */
+void readScanline(const uint8_t* ptr, int32_t width, vec4ub* scanline)
+{
+	ptr += 4;
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		uint8_t* out = reinterpret_cast<uint8_t*>(scanline) + i;
+		for (int32_t j = 0; j < width; )
 		{
-			int8_t expo = rgbeData[i].w - 128;
-			float scale = (expo > 0) ? static_cast<float>(1 << expo) : 1.0f / static_cast<float>(1 << -expo);
-			float fx = scale * static_cast<float>(rgbeData[i].x);
-			float fy = scale * static_cast<float>(rgbeData[i].y);
-			float fz = scale * static_cast<float>(rgbeData[i].z);
-			floatDataWrapper[i] = vec4(fx, fy, fz, 1.0f);
+			int32_t code = *ptr++;
+			if (code > 128)
+			{
+				code &= 127;
+				uint8_t value = *ptr++;
+				for (int32_t k = 0; k < code; ++k, out += 4)
+					*out = value;
+			}
+			else
+			{
+				for (int32_t k = 0; k < code; ++k, out += 4)
+					*out = *ptr++;
+			}
+			j += code;
 		}
 	}
-	else
+}
+
+/*
+ * value = mantissa * 2 ^ (exponent - 128), exponents 0 and 1 are treated as zero
+ */
+inline float rgbeScale(uint8_t exponent)
+{
+	union
 	{
-		desc.data.resize(desc.size.y * rowSize);
-		for (int y = 0; y < desc.size.y; ++y)
+		uint32_t i;
+		float f;
+	} scale = { (exponent > 1) ? static_cast<uint32_t>(exponent - 1) << 23 : 0 };
+	return scale.f;
+}
+
+#if (ET_SIMD_SSE)
+
+inline __m128 rgbePixelToFloat(__m128i pixel)
+{
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128 colorMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 alpha = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+	__m128i exponent = _mm_shuffle_epi32(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+	__m128i scale = _mm_and_si128(_mm_slli_epi32(_mm_sub_epi32(exponent, one), 23), _mm_cmpgt_epi32(exponent, one));
+	__m128 value = _mm_mul_ps(_mm_cvtepi32_ps(pixel), _mm_castsi128_ps(scale));
+	return _mm_or_ps(_mm_and_ps(value, colorMask), alpha);
+}
+
+inline void unpackRGBEPixels(const vec4ub* rgbe, __m128i pixels[4])
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgbe));
+	__m128i lo = _mm_unpacklo_epi8(packed, zero);
+	__m128i hi = _mm_unpackhi_epi8(packed, zero);
+	pixels[0] = _mm_unpacklo_epi16(lo, zero);
+	pixels[1] = _mm_unpackhi_epi16(lo, zero);
+	pixels[2] = _mm_unpacklo_epi16(hi, zero);
+	pixels[3] = _mm_unpackhi_epi16(hi, zero);
+}
+
+/*
+ * vector version of et::floatToHalf for non-negative values, which is always the case for RGBE,
+ * returns four halfs in the lower 64 bits
+ */
+using et::floatToHalf;
+inline __m128i floatToHalf(__m128 value)
+{
+	__m128i u = _mm_castps_si128(value);
+	__m128i overflow = _mm_cmpgt_epi32(u, _mm_set1_epi32(0x477fffff));
+	__m128i denormal = _mm_cmplt_epi32(u, _mm_set1_epi32(0x38800000));
+
+	__m128i denormalResult = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(value, _mm_set1_ps(0.5f))), _mm_set1_epi32(0x3f000000));
+	__m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(u, 13), _mm_set1_epi32(1));
+	__m128i normalResult = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(u, _mm_set1_epi32(static_cast<int32_t>(0xc8000fff))), mantissaOdd), 13);
+
+	__m128i result = _mm_or_si128(_mm_and_si128(denormal, denormalResult), _mm_andnot_si128(denormal, normalResult));
+	result = _mm_or_si128(_mm_and_si128(overflow, _mm_set1_epi32(0x7c00)), _mm_andnot_si128(overflow, result));
+	return _mm_packs_epi32(result, _mm_setzero_si128());
+}
+
+#endif
+
+#if (ET_SIMD_DISPATCH)
+/*
+ * converts groups of four pixels with vcvtps2ph, returns number of converted pixels
+ */
+ET_SIMD_TARGET("f16c")
+int32_t convertRGBEToHalfF16C(const vec4ub* rgbe, uint16_t* output, int32_t count)
+{
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i pixels[4];
+		unpackRGBEPixels(rgbe + i, pixels);
+		for (uint32_t k = 0; k < 4; ++k)
 		{
-			auto rowPtr = desc.data.element_ptr((desc.size.y - 1 - y) * rowSize);
-			ptr = readScanline(ptr, desc.size.x, reinterpret_cast<vec4ub*>(rowPtr));
+			__m128i halfs = _mm_cvtps_ph(rgbePixelToFloat(pixels[k]), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(output + 4 * (i + k)), halfs);
 		}
 	}
-	
-	
-	decltype(sourcePos) dataSize = ptr - inData.begin();
-	source.seekg(sourcePos + dataSize, std::ios::beg);
+	return i;
 }
+#endif
 
-void et::hdr::loadFromFile(const std::string& path, TextureDescription& desc)
+void convertRGBEToFloat(const vec4ub* rgbe, vec4* output, int32_t count)
 {
-	InputStream file(path, StreamMode_Binary);
-	if (file.valid())
+	int32_t i = 0;
+#if (ET_SIMD_SSE)
+	for (; i + 4 <= count; i += 4)
 	{
-		desc.setOrigin(path);
-		loadFromStream(file.stream(), desc);
+		__m128i pixels[4];
+		unpackRGBEPixels(rgbe + i, pixels);
+		for (uint32_t k = 0; k < 4; ++k)
+			_mm_storeu_ps(output[i + k].data(), rgbePixelToFloat(pixels[k]));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		float scale = rgbeScale(rgbe[i].w);
+		output[i] = vec4(scale * static_cast<float>(rgbe[i].x), scale * static_cast<float>(rgbe[i].y),
+			scale * static_cast<float>(rgbe[i].z), 1.0f);
 	}
 }
 
-void et::hdr::loadInfoFromFile(const std::string& path, TextureDescription& desc)
+void convertRGBEToHalf(const vec4ub* rgbe, uint16_t* output, int32_t count)
 {
-	InputStream file(path, StreamMode_Binary);
-	if (file.valid())
+	int32_t i = 0;
+#if (ET_SIMD_DISPATCH)
+	if (cpuSupports(CPUFeature::F16C))
+		i = convertRGBEToHalfF16C(rgbe, output, count);
+#endif
+#if (ET_SIMD_SSE)
+	for (; i + 4 <= count; i += 4)
 	{
-		desc.setOrigin(path);
-		loadInfoFromStream(file.stream(), desc);
+		__m128i pixels[4];
+		unpackRGBEPixels(rgbe + i, pixels);
+		for (uint32_t k = 0; k < 4; ++k)
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(output + 4 * (i + k)), floatToHalf(rgbePixelToFloat(pixels[k])));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		float scale = rgbeScale(rgbe[i].w);
+		output[4 * i + 0] = floatToHalf(scale * static_cast<float>(rgbe[i].x));
+		output[4 * i + 1] = floatToHalf(scale * static_cast<float>(rgbe[i].y));
+		output[4 * i + 2] = floatToHalf(scale * static_cast<float>(rgbe[i].z));
+		output[4 * i + 3] = 0x3c00;
 	}
 }
 
-/*
- * Internal stuff
- */
-
-unsigned char* readScanline(unsigned char* ptr, int width, vec4ub* scanline)
+bool decodeScanlines(const uint8_t* begin, const uint8_t* end, TextureDescription& desc, const uint8_t*& dataEnd)
 {
-	if (*ptr++ == 2)
+	int32_t width = desc.size.x;
+	int32_t height = desc.size.y;
+	/*
+	 * each scanline starts with 4 byte header, so height is validated before allocating scanline positions
+	 */
+	if ((width < 8) || (width > 0x7fff) || (height <= 0) || (static_cast<ptrdiff_t>(height) > (end - begin) / 4))
+	{
+		log::error("Failed to load HDR image");
+		desc.size = vec2i(0);
+		return false;
+	}
+
+	Vector<const uint8_t*> scanlines(static_cast<size_t>(height));
+	const uint8_t* ptr = begin;
+	for (int32_t y = 0; y < height; ++y)
 	{
-		scanline->y = *ptr++;
-		scanline->z = *ptr++;
+		scanlines[y] = ptr;
+		ptr = skipScanline(ptr, end, width);
+		if (ptr == nullptr)
+		{
+			log::error("Failed to load HDR image: invalid or legacy scanline %d in %s", y, desc.origin().c_str());
+			desc.size = vec2i(0);
+			return false;
+		}
+	}
+	dataEnd = ptr;
 
-		++ptr;
+	uint64_t rowSize = static_cast<uint64_t>(width) * bitsPerPixelForTextureFormat(desc.format) / 8;
+	desc.data.resize(rowSize * height);
 
-		for (int i = 0; i < 4; ++i)
+	/*
+	 * rows are flipped, first scanline of the file is the top one
+	 */
+	uint8_t* output = desc.data.data();
+	TextureFormat format = desc.format;
+	uint32_t rowsPerJob = static_cast<uint32_t>(std::max(1, 32768 / width));
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(height), [&](uint32_t rowBegin, uint32_t rowEnd)
+	{
+		Vector<vec4ub> rgbe((format == TextureFormat::RGBA8) ? 0 : width);
+		for (uint32_t y = rowBegin; y < rowEnd; ++y)
 		{
-			for (int j = 0; j < width;)
+			uint8_t* row = output + (height - 1 - y) * rowSize;
+			if (format == TextureFormat::RGBA8)
 			{
-				unsigned char code = *ptr++;
-				if (code > 128)
-				{
-					code &= 127;
-					unsigned char val = *ptr++;
-					while (code--)
-						scanline[j++][i] = val;
-				}
+				readScanline(scanlines[y], width, reinterpret_cast<vec4ub*>(row));
+			}
+			else
+			{
+				readScanline(scanlines[y], width, rgbe.data());
+				if (format == TextureFormat::RGBA16F)
+					convertRGBEToHalf(rgbe.data(), reinterpret_cast<uint16_t*>(row), width);
 				else
-				{
-					while (code--)
-						scanline[j++][i] = *ptr++;
-				}
+					convertRGBEToFloat(rgbe.data(), reinterpret_cast<vec4*>(row), width);
 			}
 		}
-	}
-	else
-	{
-		ET_FAIL("Legacy scanlines are not supported");
-	}
+	}, rowsPerJob);
+
+	return true;
+}
 
-	return ptr;
 }
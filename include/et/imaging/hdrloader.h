@@ -13,10 +13,28 @@ namespace et
 {
 	namespace hdr
 	{
+		enum class OutputFormat : uint32_t
+		{
+			RGBE,
+			Float32,
+			Float16
+		};
+
+		/*
+		 * RGBE - RGBA8 texture with encoded values, Float32 (default) - RGBA32F, Float16 - RGBA16F
+		 */
+		void setOutputFormat(OutputFormat);
+		OutputFormat outputFormat();
+
 		void setShouldConvertRGBEToFloat(bool);
 		
 		void loadInfoFromStream(std::istream& stream, TextureDescription& desc);
 		void loadFromStream(std::istream& stream, TextureDescription& desc);
+
+		/*
+		 * scanlines are decoded in parallel on the shared job system
+		 */
+		void loadFromMemory(const uint8_t* data, uint64_t size, TextureDescription& desc);
 		
 		void loadInfoFromFile(const std::string& path, TextureDescription& desc);
 		void loadFromFile(const std::string& path, TextureDescription& desc);
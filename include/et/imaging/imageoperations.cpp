@@ -6,8 +6,14 @@
  */
 
 #include <et/geometry/geometry.h>
+#include <et/core/jobsystem.h>
+#include <et/core/tools.h>
 #include <et/imaging/imageoperations.h>
 
+#if (ET_SIMD_SSE)
+#	include <immintrin.h>
+#endif
+
 using namespace et;
 
 mat3i ImageOperations::matrixFilterBlur = mat3i(
@@ -26,7 +32,43 @@ mat3i ImageOperations::matrixFilterSharpen = mat3i(
 	 0, -1,  0);
 
 int indexForCoord(const vec2i& coord, const vec2i& size);
-bool grayscaleSortFunction(const vec4ub& v1, const vec4ub& v2);
+
+namespace
+{
+struct BlurLineBuffers
+{
+	Vector<uint8_t> padded;
+	Vector<int32_t> sum;
+	Vector<int32_t> left;
+	Vector<int32_t> right;
+};
+
+struct MedianHistograms
+{
+	Vector<uint16_t> columns;
+	Vector<uint16_t> columnsCoarse;
+	Vector<uint16_t> kernel;
+	Vector<uint16_t> kernelCoarse;
+};
+
+struct DownsampleWeights
+{
+	Vector<int32_t> first;
+	Vector<float> weights;
+	int32_t taps = 0;
+};
+
+uint32_t imageRowsPerJob(int rowsCount);
+void gaussianBoxRadii(int radius, int* radii);
+void blurLine(uint8_t* line, int count, int stride, int elementSize, int radius, bool linear, BlurLineBuffers&);
+void blurDirect(BinaryDataStorage& data, const vec2i& size, int components, const vec2i& direction, int radius, bool linear);
+void medianTile(const uint8_t* source, uint8_t* output, const vec2i& size, int components, int radius, const recti& tile, MedianHistograms&);
+void updateHistogram(uint16_t* histogram, const uint16_t* added, const uint16_t* removed, int count);
+void loadPaddedRow(uint8_t* destination, const uint8_t* row, int rowSize, int components);
+void matrixFilterRow(uint8_t* const rows[3], uint8_t* output, int count, int components, const int* weights, int divisor);
+void normalMapRow(const uint8_t* heights, uint8_t* output, const vec2i& size, int components, int y, const vec2& scale);
+void downsampleWeights(int srcSize, int dstSize, ImageDownsampleFilter filter, DownsampleWeights&);
+}
 
 inline int roundf(float v, int minV, int maxV)
 	{ return clamp(static_cast<int32_t>(v), minV, maxV); }
@@ -154,8 +196,458 @@ void ImageOperations::applyPixelFilter(BinaryDataStorage& data, const vec2i& siz
 
 void ImageOperations::blur(BinaryDataStorage& data, const vec2i& size, int components, vec2i direction, int radius, ImageBlurType type)
 {
-	type = ImageBlurType_Average;
+	if ((radius <= 0) || (size.x <= 0) || (size.y <= 0))
+		return;
+
+	int radii[3] = { radius, 0, 0 };
+	if (type == ImageBlurType_Gaussian)
+		gaussianBoxRadii(radius, radii);
+
+	bool linear = (type == ImageBlurType_Linear);
+	bool horizontal = (direction.y == 0) && (std::abs(direction.x) == 1);
+	bool vertical = (direction.x == 0) && (std::abs(direction.y) == 1);
+
+	if (!horizontal && !vertical)
+	{
+		for (int pass = 0; pass < 3; ++pass)
+		{
+			if (radii[pass] > 0)
+				blurDirect(data, size, components, direction, radii[pass], linear);
+		}
+		return;
+	}
+
+	uint8_t* pixels = data.data();
+	int rowSize = size.x * components;
+
+	if (horizontal)
+	{
+		sharedJobSystem().parallelFor(0, static_cast<uint32_t>(size.y), [&](uint32_t begin, uint32_t end)
+		{
+			BlurLineBuffers buffers;
+			for (uint32_t y = begin; y < end; ++y)
+			{
+				for (int pass = 0; pass < 3; ++pass)
+				{
+					if (radii[pass] > 0)
+						blurLine(pixels + y * rowSize, size.x, components, components, radii[pass], linear, buffers);
+				}
+			}
+		}, imageRowsPerJob(size.y));
+	}
+	else
+	{
+		/*
+		 * columns are processed in strips, so every step of the sliding window reads contiguous memory
+		 */
+		const int stripWidth = 64;
+		uint32_t stripsCount = static_cast<uint32_t>((size.x + stripWidth - 1) / stripWidth);
+		sharedJobSystem().parallelFor(0, stripsCount, [&](uint32_t begin, uint32_t end)
+		{
+			BlurLineBuffers buffers;
+			for (uint32_t strip = begin; strip < end; ++strip)
+			{
+				int x0 = static_cast<int>(strip) * stripWidth;
+				int width = std::min(stripWidth, size.x - x0);
+				for (int pass = 0; pass < 3; ++pass)
+				{
+					if (radii[pass] > 0)
+						blurLine(pixels + x0 * components, size.y, rowSize, width * components, radii[pass], linear, buffers);
+				}
+			}
+		}, 1);
+	}
+}
+
+void ImageOperations::median(BinaryDataStorage& data, const vec2i& size, int components, int radius)
+{
+	if ((radius <= 0) || (size.x <= 0) || (size.y <= 0))
+		return;
+
+	ET_ASSERT(radius <= MaxMedianRadius);
+	ET_ASSERT((components > 0) && (components <= 4));
+
+	const int tileSize = 128;
+	int tilesX = (size.x + tileSize - 1) / tileSize;
+	int tilesY = (size.y + tileSize - 1) / tileSize;
+
+	BinaryDataStorage result(data.size());
+	const uint8_t* source = data.data();
+	uint8_t* output = result.data();
+
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(tilesX * tilesY), [&](uint32_t begin, uint32_t end)
+	{
+		MedianHistograms histograms;
+		for (uint32_t tile = begin; tile < end; ++tile)
+		{
+			int x0 = static_cast<int>(tile) % tilesX * tileSize;
+			int y0 = static_cast<int>(tile) / tilesX * tileSize;
+			recti tileRect(x0, y0, std::min(tileSize, size.x - x0), std::min(tileSize, size.y - y0));
+			medianTile(source, output, size, components, radius, tileRect, histograms);
+		}
+	}, 1);
+
+	etCopyMemory(data.data(), result.data(), result.dataSize());
+}
+
+void ImageOperations::applyMatrixFilter(BinaryDataStorage& data, const vec2i& size, int components, const mat3i& m)
+{
+	if ((size.x <= 0) || (size.y <= 0))
+		return;
+
+	int weights[9] = { };
+	int divisor = 0;
+	for (int v = 0; v < 3; ++v)
+	{
+		for (int u = 0; u < 3; ++u)
+		{
+			weights[3 * v + u] = m[v][u];
+			divisor += m[v][u];
+			ET_ASSERT((m[v][u] >= std::numeric_limits<int16_t>::min()) && (m[v][u] <= std::numeric_limits<int16_t>::max()));
+		}
+	}
+
+	uint8_t* pixels = data.data();
+	int rowSize = size.x * components;
+	int bandHeight = static_cast<int>(imageRowsPerJob(size.y));
+	int bandsCount = (size.y + bandHeight - 1) / bandHeight;
+
+	/*
+	 * image is filtered in place by bands of rows, rows surrounding each band
+	 * are saved first, since they are modified concurrently by neighbour bands
+	 */
+	BinaryDataStorage bandEdges(static_cast<uint64_t>(2 * bandsCount * rowSize));
+	for (int band = 0; band < bandsCount; ++band)
+	{
+		int y0 = band * bandHeight;
+		int y1 = std::min(y0 + bandHeight, size.y);
+		etCopyMemory(bandEdges.data() + (2 * band + 0) * rowSize, pixels + std::max(y0 - 1, 0) * rowSize, rowSize);
+		etCopyMemory(bandEdges.data() + (2 * band + 1) * rowSize, pixels + std::min(y1, size.y - 1) * rowSize, rowSize);
+	}
+
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(bandsCount), [&](uint32_t begin, uint32_t end)
+	{
+		int paddedRowSize = rowSize + 2 * components;
+		BinaryDataStorage rowsStorage(static_cast<uint64_t>(3 * paddedRowSize));
+
+		for (uint32_t band = begin; band < end; ++band)
+		{
+			int y0 = static_cast<int>(band) * bandHeight;
+			int y1 = std::min(y0 + bandHeight, size.y);
+			const uint8_t* topEdge = bandEdges.data() + (2 * band + 0) * rowSize;
+			const uint8_t* bottomEdge = bandEdges.data() + (2 * band + 1) * rowSize;
+
+			uint8_t* rows[3] = { rowsStorage.data(), rowsStorage.data() + paddedRowSize, rowsStorage.data() + 2 * paddedRowSize };
+			loadPaddedRow(rows[0], topEdge, rowSize, components);
+			loadPaddedRow(rows[1], pixels + y0 * rowSize, rowSize, components);
+			for (int y = y0; y < y1; ++y)
+			{
+				loadPaddedRow(rows[2], (y + 1 < y1) ? pixels + (y + 1) * rowSize : bottomEdge, rowSize, components);
+				matrixFilterRow(rows, pixels + y * rowSize, rowSize, components, weights, divisor);
+				std::swap(rows[0], rows[1]);
+				std::swap(rows[1], rows[2]);
+			}
+		}
+	}, 1);
+}
+
+void ImageOperations::normalMapFilter(BinaryDataStorage& data, const vec2i& size, int components, const vec2& scale)
+{
+	ET_ASSERT(components > 2);
+
+	if ((size.x <= 0) || (size.y <= 0))
+		return;
+
+	/*
+	 * only heights are required from the source image, so they are copied instead of the whole image
+	 */
+	uint32_t pixelsCount = static_cast<uint32_t>(size.x * size.y);
+	BinaryDataStorage heights(pixelsCount);
+	for (uint32_t i = 0; i < pixelsCount; ++i)
+		heights[i] = data[i * components];
+
+	vec2 fScale = scale / 255.0f;
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(size.y), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; ++y)
+			normalMapRow(heights.data(), data.data(), size, components, static_cast<int>(y), fScale);
+	}, imageRowsPerJob(size.y));
+}
+
+void ImageOperations::downsample(const BinaryDataStorage& src, const vec2i& srcSize, int components,
+	BinaryDataStorage& dst, vec2i& dstSize, ImageDownsampleFilter filter)
+{
+	ET_ASSERT(src.size() >= static_cast<uint64_t>(srcSize.square() * components));
+
+	dstSize = maxv(vec2i(1), srcSize / 2);
+	dst.resize(static_cast<uint64_t>(dstSize.square() * components));
+
+	DownsampleWeights horizontal;
+	DownsampleWeights vertical;
+	downsampleWeights(srcSize.x, dstSize.x, filter, horizontal);
+	downsampleWeights(srcSize.y, dstSize.y, filter, vertical);
+
+	/*
+	 * horizontal pass to floating point rows, then vertical pass to the output
+	 */
+	int rowSize = dstSize.x * components;
+	Vector<float> rows(static_cast<size_t>(rowSize * srcSize.y));
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(srcSize.y), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; ++y)
+		{
+			const uint8_t* source = src.data() + y * srcSize.x * components;
+			float* output = rows.data() + y * rowSize;
+			for (int x = 0; x < dstSize.x; ++x)
+			{
+				const float* w = horizontal.weights.data() + x * horizontal.taps;
+				for (int c = 0; c < components; ++c)
+				{
+					float value = 0.0f;
+					for (int k = 0; k < horizontal.taps; ++k)
+					{
+						int sx = clamp(horizontal.first[x] + k, 0, srcSize.x - 1);
+						value += w[k] * static_cast<float>(source[sx * components + c]);
+					}
+					output[x * components + c] = value;
+				}
+			}
+		}
+	}, imageRowsPerJob(srcSize.y));
+
+	uint8_t* output = dst.data();
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(dstSize.y), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; ++y)
+		{
+			const float* w = vertical.weights.data() + y * vertical.taps;
+			uint8_t* outputRow = output + y * rowSize;
+			for (int i = 0; i < rowSize; ++i)
+			{
+				float value = 0.0f;
+				for (int k = 0; k < vertical.taps; ++k)
+				{
+					int sy = clamp(vertical.first[y] + k, 0, srcSize.y - 1);
+					value += w[k] * rows[sy * rowSize + i];
+				}
+				outputRow[i] = static_cast<uint8_t>(clamp(static_cast<int>(value + 0.5f), 0, 255));
+			}
+		}
+	}, imageRowsPerJob(dstSize.y));
+}
+
+/*
+ * Internal Stuff
+ */
+int indexForCoord(const vec2i& coord, const vec2i& size)
+{
+	int xVal = coord.x < 0 ? 0 : (coord.x >= size.x ? size.x - 1 : coord.x);
+	int yVal = coord.y < 0 ? 0 : (coord.y >= size.y ? size.y - 1 : coord.y);
+	return yVal * size.x + xVal;
+}
+
+namespace
+{
+uint32_t imageRowsPerJob(int rowsCount)
+{
+	int threadsCount = static_cast<int>(sharedJobSystem().workersCount()) + 1;
+	return static_cast<uint32_t>(std::max(8, rowsCount / (4 * threadsCount)));
+}
+
+/*
+ * zero order modified Bessel function of the first kind, used by Kaiser window
+ */
+float besselI0(float x)
+{
+	float sum = 1.0f;
+	float term = 1.0f;
+	float halfX = 0.5f * x;
+	for (int k = 1; k < 32; ++k)
+	{
+		term *= (halfX / static_cast<float>(k)) * (halfX / static_cast<float>(k));
+		sum += term;
+		if (term < sum * 1.0e-7f)
+			break;
+	}
+	return sum;
+}
+
+/*
+ * weights of source pixels for each of destination pixels,
+ * box filter averages covered area, Kaiser filter is sinc windowed with width = 3, alpha = 4
+ */
+void downsampleWeights(int srcSize, int dstSize, ImageDownsampleFilter filter, DownsampleWeights& result)
+{
+	const float kaiserWidth = 3.0f;
+	const float kaiserAlpha = 4.0f;
+
+	float scale = static_cast<float>(srcSize) / static_cast<float>(dstSize);
+	float support = (filter == ImageDownsampleFilter_Kaiser) ? kaiserWidth * scale : 0.5f * scale;
+	float kaiserNormalization = 1.0f / besselI0(kaiserAlpha);
+
+	result.taps = static_cast<int32_t>(std::ceil(2.0f * support)) + 1;
+	result.first.resize(dstSize);
+	result.weights.resize(dstSize * result.taps);
+
+	for (int x = 0; x < dstSize; ++x)
+	{
+		float center = (static_cast<float>(x) + 0.5f) * scale;
+		int32_t first = static_cast<int32_t>(std::floor(center - support));
+		float* w = result.weights.data() + x * result.taps;
+
+		float sum = 0.0f;
+		for (int k = 0; k < result.taps; ++k)
+		{
+			float position = static_cast<float>(first + k) + 0.5f;
+			float weight = 0.0f;
+			if (filter == ImageDownsampleFilter_Kaiser)
+			{
+				float t = (position - center) / scale;
+				if (std::abs(t) < kaiserWidth)
+				{
+					float r = t / kaiserWidth;
+					float sinc = (std::abs(t) < 1.0e-5f) ? 1.0f : std::sin(PI * t) / (PI * t);
+					weight = sinc * besselI0(kaiserAlpha * std::sqrt(1.0f - r * r)) * kaiserNormalization;
+				}
+			}
+			else
+			{
+				float covered = std::min(position + 0.5f, center + support) - std::max(position - 0.5f, center - support);
+				weight = std::max(0.0f, covered);
+			}
+			w[k] = weight;
+			sum += weight;
+		}
+
+		for (int k = 0; k < result.taps; ++k)
+			w[k] /= sum;
+
+		result.first[x] = first;
+	}
+}
+
+/*
+ * Three box filters approximating gaussian with sigma = radius / 2
+ * http://www.peterkovesi.com/papers/FastGaussianSmoothing.pdf
+ */
+void gaussianBoxRadii(int radius, int* radii)
+{
+	const int passes = 3;
+	float sigmaSq = 0.25f * static_cast<float>(radius * radius);
+	int lowerWidth = static_cast<int>(std::floor(std::sqrt(12.0f * sigmaSq / static_cast<float>(passes) + 1.0f)));
+	if (lowerWidth % 2 == 0)
+		--lowerWidth;
+	lowerWidth = std::max(1, lowerWidth);
+
+	float lowerPasses = (12.0f * sigmaSq - static_cast<float>(passes * lowerWidth * lowerWidth + 4 * passes * lowerWidth + 3 * passes)) /
+		static_cast<float>(-4 * lowerWidth - 4);
+	int lowerPassesCount = static_cast<int>(std::round(lowerPasses));
+
+	for (int i = 0; i < passes; ++i)
+		radii[i] = ((i < lowerPassesCount) ? lowerWidth - 1 : lowerWidth + 1) / 2;
+
+	if (radii[passes - 1] == 0)
+		radii[passes - 1] = 1;
+}
+
+/*
+ * Sliding window filter over line of count elements, each element is elementSize bytes and elements
+ * are placed with stride bytes. Values outside of the line are clamped to the edge, like in indexForCoord.
+ * Linear filter has weights (radius + 1 - |offset|) and is maintained by two half-window sums:
+ * moving to the next element adds right half of the window and removes left half.
+ */
+void blurLine(uint8_t* line, int count, int stride, int elementSize, int radius, bool linear, BlurLineBuffers& buffers)
+{
+	int padding = radius + 2;
+	buffers.padded.resize(static_cast<size_t>((count + 2 * padding) * elementSize));
+	for (int i = -padding; i < count + padding; ++i)
+	{
+		const uint8_t* element = line + clamp(i, 0, count - 1) * stride;
+		etCopyMemory(buffers.padded.data() + (i + padding) * elementSize, element, elementSize);
+	}
+
+	const uint8_t* padded = buffers.padded.data() + padding * elementSize;
+	auto at = [padded, elementSize](int i) { return padded + i * elementSize; };
+
+	buffers.sum.assign(static_cast<size_t>(elementSize), 0);
+	int32_t* sum = buffers.sum.data();
+
+	if (linear)
+	{
+		buffers.left.assign(static_cast<size_t>(elementSize), 0);
+		buffers.right.assign(static_cast<size_t>(elementSize), 0);
+		int32_t* left = buffers.left.data();
+		int32_t* right = buffers.right.data();
+
+		for (int k = -radius; k <= radius; ++k)
+		{
+			int32_t weight = radius + 1 - std::abs(k);
+			const uint8_t* value = at(k);
+			for (int e = 0; e < elementSize; ++e)
+				sum[e] += weight * value[e];
+		}
+
+		for (int k = -radius; k <= 0; ++k)
+		{
+			const uint8_t* value = at(k);
+			for (int e = 0; e < elementSize; ++e)
+				left[e] += value[e];
+		}
+
+		for (int k = 1; k <= radius + 1; ++k)
+		{
+			const uint8_t* value = at(k);
+			for (int e = 0; e < elementSize; ++e)
+				right[e] += value[e];
+		}
+
+		int32_t scale = (radius + 1) * (radius + 1);
+		for (int x = 0; x < count; ++x)
+		{
+			uint8_t* output = line + x * stride;
+			for (int e = 0; e < elementSize; ++e)
+				output[e] = static_cast<uint8_t>(sum[e] / scale);
+
+			const uint8_t* next = at(x + 1);
+			const uint8_t* leftRemoved = at(x - radius);
+			const uint8_t* rightAdded = at(x + radius + 2);
+			for (int e = 0; e < elementSize; ++e)
+			{
+				sum[e] += right[e] - left[e];
+				left[e] += next[e] - leftRemoved[e];
+				right[e] += rightAdded[e] - next[e];
+			}
+		}
+	}
+	else
+	{
+		for (int k = -radius; k <= radius; ++k)
+		{
+			const uint8_t* value = at(k);
+			for (int e = 0; e < elementSize; ++e)
+				sum[e] += value[e];
+		}
 
+		int32_t scale = 2 * radius + 1;
+		for (int x = 0; x < count; ++x)
+		{
+			uint8_t* output = line + x * stride;
+			for (int e = 0; e < elementSize; ++e)
+				output[e] = static_cast<uint8_t>(sum[e] / scale);
+
+			const uint8_t* added = at(x + radius + 1);
+			const uint8_t* removed = at(x - radius);
+			for (int e = 0; e < elementSize; ++e)
+				sum[e] += added[e] - removed[e];
+		}
+	}
+}
+
+/*
+ * Per-pixel filter along arbitrary direction, used when direction is not a unit axis
+ */
+void blurDirect(BinaryDataStorage& data, const vec2i& size, int components, const vec2i& direction, int radius, bool linear)
+{
 	BinaryDataStorage source(data);
 	for (int y = 0; y < size.y; ++y)
 	{
@@ -164,7 +656,7 @@ void ImageOperations::blur(BinaryDataStorage& data, const vec2i& size, int compo
 			int i0 = components * indexForCoord(vec2i(x, y), size);
 
 			vec4i sum;
-			int scale = (type == ImageBlurType_Average) ? 1 : (radius + 1);
+			int scale = linear ? (radius + 1) : 1;
 			int totalScale = scale;
 			for (int c = 0; c < components; ++c)
 				sum[c] = source[i0 + c] * scale;
@@ -175,14 +667,13 @@ void ImageOperations::blur(BinaryDataStorage& data, const vec2i& size, int compo
 				vec2i vPrev = vec2i(x, y) - direction * r;
 				int iNext = components * indexForCoord(vNext, size);
 				int iPrev = components * indexForCoord(vPrev, size);
-				scale = (type == ImageBlurType_Average) ? 1 : (radius + 1 - r);
+				scale = linear ? (radius + 1 - r) : 1;
 				totalScale += 2 * scale;
 				for (int c = 0; c < components; ++c)
 				{
 					sum[c] += source[iNext + c] * scale;
 					sum[c] += source[iPrev + c] * scale;
 				}
-
 			}
 
 			sum /= totalScale;
@@ -192,136 +683,353 @@ void ImageOperations::blur(BinaryDataStorage& data, const vec2i& size, int compo
 	}
 }
 
-void ImageOperations::median(BinaryDataStorage& data, const vec2i& size, int components, int radius)
+/*
+ * Constant time median filter (Perreault, Hebert: Median Filtering in Constant Time):
+ * every column of the tile keeps histogram of (2 * radius + 1) pixels around current row,
+ * kernel histogram is updated by adding entering column and removing leaving one.
+ * Coarse histograms (16 bins) are maintained together with fine ones to speed up median search.
+ */
+void medianTile(const uint8_t* source, uint8_t* output, const vec2i& size, int components, int radius,
+	const recti& tile, MedianHistograms& histograms)
 {
-	BinaryDataStorage source(data);
+	const int fineBins = 256;
+	const int coarseBins = 16;
 
-	std::vector<vec4ub> matrix;
-	matrix.reserve(static_cast<std::vector<vec4ub>::size_type>((1 + 2 * radius) * (1 + 2 * radius)));
+	int rowSize = size.x * components;
+	int slotsCount = tile.width + 2 * radius;
+	int fineSlotSize = components * fineBins;
+	int coarseSlotSize = components * coarseBins;
 
-	for (int y = 0; y < size.y; ++y)
+	histograms.columns.assign(static_cast<size_t>(slotsCount * fineSlotSize), 0);
+	histograms.columnsCoarse.assign(static_cast<size_t>(slotsCount * coarseSlotSize), 0);
+	histograms.kernel.resize(static_cast<size_t>(fineSlotSize));
+	histograms.kernelCoarse.resize(static_cast<size_t>(coarseSlotSize));
+
+	uint16_t* columns = histograms.columns.data();
+	uint16_t* columnsCoarse = histograms.columnsCoarse.data();
+	uint16_t* kernel = histograms.kernel.data();
+	uint16_t* kernelCoarse = histograms.kernelCoarse.data();
+
+	auto updateColumns = [&](int row, uint16_t delta)
 	{
-		for (int x = 0; x < size.x; ++x)
+		const uint8_t* rowData = source + clamp(row, 0, size.y - 1) * rowSize;
+		for (int slot = 0; slot < slotsCount; ++slot)
 		{
-			int i0 = components * indexForCoord(vec2i(x, y), size);
-
-			matrix.clear();
-			for (int v = -radius; v <= radius; ++v)
+			const uint8_t* pixel = rowData + clamp(tile.left - radius + slot, 0, size.x - 1) * components;
+			for (int c = 0; c < components; ++c)
 			{
-				for (int u = - radius; u <= radius; ++u)
-				{
-					int index = components * indexForCoord(vec2i(x + u, y + v), size);
-					vec4ub color(0);
-					for (int c = 0; c < components; ++c)
-						color[c] = source[index+c];
-					matrix.push_back(color);
-				}
+				columns[slot * fineSlotSize + c * fineBins + pixel[c]] += delta;
+				columnsCoarse[slot * coarseSlotSize + c * coarseBins + (pixel[c] >> 4)] += delta;
 			}
+		}
+	};
 
-			std::sort(matrix.begin(), matrix.end(), grayscaleSortFunction);
+	for (int v = -radius; v <= radius; ++v)
+		updateColumns(tile.top + v, 1);
 
-			vec4ub& middle = matrix.at(matrix.size() / 2);
-			for (int c = 0; c < components; ++c)
-				data[i0 + c] = middle[c];
+	uint32_t half = static_cast<uint32_t>((2 * radius + 1) * (2 * radius + 1) / 2);
+	for (int y = tile.top, yEnd = tile.top + tile.height; y < yEnd; ++y)
+	{
+		if (y > tile.top)
+		{
+			updateColumns(y - radius - 1, static_cast<uint16_t>(-1));
+			updateColumns(y + radius, 1);
 		}
-	}
-}
 
-void ImageOperations::applyMatrixFilter(BinaryDataStorage& data, const vec2i& size, int components, const mat3i& m)
-{
-	BinaryDataStorage source(data);
-	matrix3<uint8_t> colorMatrix[4];
+		std::fill(kernel, kernel + fineSlotSize, static_cast<uint16_t>(0));
+		std::fill(kernelCoarse, kernelCoarse + coarseSlotSize, static_cast<uint16_t>(0));
+		for (int slot = 0; slot <= 2 * radius; ++slot)
+		{
+			const uint16_t* column = columns + slot * fineSlotSize;
+			for (int i = 0; i < fineSlotSize; ++i)
+				kernel[i] += column[i];
 
-	for (int y = 0; y < size.y; ++y)
-	{
-		for (int x = 0; x < size.x; ++x)
+			const uint16_t* columnCoarse = columnsCoarse + slot * coarseSlotSize;
+			for (int i = 0; i < coarseSlotSize; ++i)
+				kernelCoarse[i] += columnCoarse[i];
+		}
+
+		uint8_t* outputRow = output + y * rowSize;
+		for (int x = tile.left, xEnd = tile.left + tile.width; x < xEnd; ++x)
 		{
-			for (int dy = -1; dy <= 1; ++dy)
+			if (x > tile.left)
 			{
-				for (int dx = -1; dx <= 1; ++dx)
-				{
-					int index = components * indexForCoord(vec2i(x + dx, y + dy), size);
-					for (int c = 0; c < components; ++c)
-						colorMatrix[c][dy+1][dx+1] = source[index+c];
-				}
+				int enteringSlot = x - tile.left + 2 * radius;
+				int leavingSlot = x - tile.left - 1;
+
+				updateHistogram(kernel, columns + enteringSlot * fineSlotSize, columns + leavingSlot * fineSlotSize, fineSlotSize);
+				updateHistogram(kernelCoarse, columnsCoarse + enteringSlot * coarseSlotSize,
+					columnsCoarse + leavingSlot * coarseSlotSize, coarseSlotSize);
 			}
 
-			vec4i result(0);
-			int cSum = 0;
-			for (int v = 0; v < 3; ++v)
+			for (int c = 0; c < components; ++c)
 			{
-				for (int u = 0; u < 3; ++u)
-				{
-					int value = m[v][u];
-					result.x += colorMatrix[0][v][u] * value;
-					result.y += colorMatrix[1][v][u] * value;
-					result.z += colorMatrix[2][v][u] * value;
-					result.w += colorMatrix[3][v][u] * value;
-					cSum += value;
-				}
-			}
+				const uint16_t* fine = kernel + c * fineBins;
+				const uint16_t* coarse = kernelCoarse + c * coarseBins;
 
-			if (cSum)
-				result /= cSum;
+				uint32_t accumulated = 0;
+				int bin = 0;
+				while (accumulated + coarse[bin] <= half)
+					accumulated += coarse[bin++];
 
-			int i0 = components * indexForCoord(vec2i(x, y), size);
-			for (int c = 0; c < components; ++c)
-				data[i0 + c] = static_cast<uint8_t>(clamp(result[c], 0, 255));
+				bin *= coarseBins;
+				while (accumulated + fine[bin] <= half)
+					accumulated += fine[bin++];
+
+				outputRow[x * components + c] = static_cast<uint8_t>(bin);
+			}
 		}
 	}
 }
 
-void ImageOperations::normalMapFilter(BinaryDataStorage& data, const vec2i& size, int components, const vec2& scale)
+#if (ET_SIMD_DISPATCH)
+/*
+ * AVX2 parts process as many elements as possible and return index of the first unprocessed one
+ */
+ET_SIMD_TARGET("avx2")
+int updateHistogramAVX2(uint16_t* histogram, const uint16_t* added, const uint16_t* removed, int count)
 {
-	ET_ASSERT(components > 2);
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(histogram + i));
+		value = _mm256_add_epi16(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(added + i)));
+		value = _mm256_sub_epi16(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(removed + i)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(histogram + i), value);
+	}
+	return i;
+}
 
-	vec2 fScale = scale / 255.0f;
-	BinaryDataStorage source(data);
-	for (int y = 0; y < size.y; ++y)
+ET_SIMD_TARGET("avx2")
+int matrixFilterRowAVX2(const uint8_t* const taps[9], const int32_t pairWeights[5], uint8_t* output, int count, int divisor)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256 divisorVector = _mm256_set1_ps(static_cast<float>(divisor));
+
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
 	{
-		bool halfY = y < size.y / 2;
-		for (int x = 0; x < size.x; ++x)
+		__m256i low = _mm256_setzero_si256();
+		__m256i high = _mm256_setzero_si256();
+		for (int t = 0; t < 5; ++t)
 		{
-			bool halfX = x < size.x / 2;
-			vec2i nextX(x + (halfX ? 1 : -1), y);
-			vec2i nextY(x, y + (halfY ? 1 : -1));
-
-			int c00 = components * indexForCoord(vec2i(x, y), size);
-			int c01 = components * indexForCoord(nextX, size);
-			int c10 = components * indexForCoord(nextY, size);
+			__m256i first = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[2 * t] + i)));
+			__m256i second = (t < 4) ? _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[2 * t + 1] + i))) : zero;
+			__m256i pairWeight = _mm256_set1_epi32(pairWeights[t]);
+			low = _mm256_add_epi32(low, _mm256_madd_epi16(_mm256_unpacklo_epi16(first, second), pairWeight));
+			high = _mm256_add_epi32(high, _mm256_madd_epi16(_mm256_unpackhi_epi16(first, second), pairWeight));
+		}
 
-			short h00 = source[c00];
-			short h01 = source[c01];
-			short h10 = source[c10];
+		if (divisor != 0)
+		{
+			low = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(low), divisorVector));
+			high = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(high), divisorVector));
+		}
 
-			float dx = static_cast<float>(halfX ? h01 - h00 : h00 - h01) * fScale.x;
-			float dy = static_cast<float>(halfY ? h10 - h00 : h00 - h10) * fScale.y;
+		/*
+		 * unpack and pack are working within 128-bit lanes, so lanes are restored with permute
+		 */
+		__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(low, high), zero);
+		packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm256_castsi256_si128(packed));
+	}
+	return i;
+}
+#endif
 
-			vec3 du(1.0f, 0.0f, dx);
-			vec3 dv(0.0f, 1.0f, dy);
+void updateHistogram(uint16_t* histogram, const uint16_t* added, const uint16_t* removed, int count)
+{
+	int i = 0;
 
-			vec3 produce = normalize(cross(du, dv));
+#if (ET_SIMD_DISPATCH)
+	static const bool useAVX2 = cpuSupports(CPUFeature::AVX2);
+	if (useAVX2)
+		i = updateHistogramAVX2(histogram, added, removed, count);
+#endif
 
-			data[c00+0] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.x));
-			data[c00+1] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.y));
-			data[c00+2] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.z));
-		}
+#if (ET_SIMD_SSE)
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(histogram + i));
+		value = _mm_add_epi16(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(added + i)));
+		value = _mm_sub_epi16(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(removed + i)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(histogram + i), value);
 	}
+#endif
+
+	for (; i < count; ++i)
+		histogram[i] = static_cast<uint16_t>(histogram[i] + added[i] - removed[i]);
+}
+
+void loadPaddedRow(uint8_t* destination, const uint8_t* row, int rowSize, int components)
+{
+	etCopyMemory(destination, row, components);
+	etCopyMemory(destination + components, row, rowSize);
+	etCopyMemory(destination + components + rowSize, row + rowSize - components, components);
 }
 
 /*
- * Internal Stuff
+ * rows are padded with one pixel on both sides, so filter could be applied to the row as to the array of bytes,
+ * neighbour pixel of any byte is components bytes away
  */
-int indexForCoord(const vec2i& coord, const vec2i& size)
+void matrixFilterRow(uint8_t* const rows[3], uint8_t* output, int count, int components, const int* weights, int divisor)
 {
-	int xVal = coord.x < 0 ? 0 : (coord.x >= size.x ? size.x - 1 : coord.x);
-	int yVal = coord.y < 0 ? 0 : (coord.y >= size.y ? size.y - 1 : coord.y);
-	return yVal * size.x + xVal;
+	const uint8_t* taps[9];
+	for (int v = 0; v < 3; ++v)
+	{
+		for (int u = 0; u < 3; ++u)
+			taps[3 * v + u] = rows[v] + u * components;
+	}
+
+	int i = 0;
+
+#if (ET_SIMD_SSE)
+	/*
+	 * pairs of taps are interleaved and multiplied by pairs of weights with madd,
+	 * the last tap is paired with zero
+	 */
+	int32_t pairWeights[5] = { };
+	for (int t = 0; t < 5; ++t)
+	{
+		uint32_t first = static_cast<uint32_t>(weights[2 * t]) & 0xffff;
+		uint32_t second = (t < 4) ? static_cast<uint32_t>(weights[2 * t + 1]) & 0xffff : 0;
+		pairWeights[t] = static_cast<int32_t>(first | (second << 16));
+	}
+#endif
+
+#if (ET_SIMD_DISPATCH)
+	if (cpuSupports(CPUFeature::AVX2))
+		i = matrixFilterRowAVX2(taps, pairWeights, output, count, divisor);
+#endif
+
+#if (ET_SIMD_SSE)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 divisorVector = _mm_set1_ps(static_cast<float>(divisor));
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i low = _mm_setzero_si128();
+			__m128i high = _mm_setzero_si128();
+			for (int t = 0; t < 5; ++t)
+			{
+				__m128i first = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(taps[2 * t] + i)), zero);
+				__m128i second = (t < 4) ? _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(taps[2 * t + 1] + i)), zero) : zero;
+				__m128i pairWeight = _mm_set1_epi32(pairWeights[t]);
+				low = _mm_add_epi32(low, _mm_madd_epi16(_mm_unpacklo_epi16(first, second), pairWeight));
+				high = _mm_add_epi32(high, _mm_madd_epi16(_mm_unpackhi_epi16(first, second), pairWeight));
+			}
+
+			/*
+			 * division is correctly rounded, so truncation gives the same result as integer division
+			 */
+			if (divisor != 0)
+			{
+				low = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(low), divisorVector));
+				high = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(high), divisorVector));
+			}
+
+			__m128i packed = _mm_packus_epi16(_mm_packs_epi32(low, high), zero);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), packed);
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		int result = 0;
+		for (int t = 0; t < 9; ++t)
+			result += weights[t] * taps[t][i];
+
+		if (divisor != 0)
+			result /= divisor;
+
+		output[i] = static_cast<uint8_t>(clamp(result, 0, 255));
+	}
 }
 
-bool grayscaleSortFunction(const vec4ub& v1, const vec4ub& v2)
+/*
+ * normal of the height map is (-dx, -dy, 1) normalized,
+ * neighbour is taken towards the center of the image
+ */
+void normalMapRow(const uint8_t* heights, uint8_t* output, const vec2i& size, int components, int y, const vec2& scale)
 {
-	int g1 = 76 * v1.x + 150 * v1.y + 29 * v1.z;
-	int g2 = 76 * v2.x + 150 * v2.y + 29 * v2.z;
-	return g1 < g2;
+	bool halfY = y < size.y / 2;
+	const uint8_t* row = heights + y * size.x;
+	const uint8_t* rowNext = heights + clamp(y + (halfY ? 1 : -1), 0, size.y - 1) * size.x;
+
+	auto writeNormal = [output, components, y, &size](int x, int nx, int ny, int nz)
+	{
+		uint8_t* pixel = output + components * (y * size.x + x);
+		pixel[0] = static_cast<uint8_t>(nx);
+		pixel[1] = static_cast<uint8_t>(ny);
+		pixel[2] = static_cast<uint8_t>(nz);
+	};
+
+	int halfX = size.x / 2;
+	for (int segment = 0; segment < 2; ++segment)
+	{
+		bool forward = (segment == 0);
+		int x = forward ? 0 : halfX;
+		int xEnd = forward ? halfX : size.x;
+
+#if (ET_SIMD_SSE)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 maxValue = _mm_set1_ps(255.0f);
+		const __m128 scaleX = _mm_set1_ps(scale.x);
+		const __m128 scaleY = _mm_set1_ps(scale.y);
+		auto load4 = [zero](const uint8_t* ptr)
+		{
+			int32_t value = 0;
+			etCopyMemory(&value, ptr, sizeof(value));
+			return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+		};
+		auto encode = [&](__m128 value)
+			{ return _mm_cvttps_epi32(_mm_mul_ps(maxValue, _mm_add_ps(half, _mm_mul_ps(half, value)))); };
+
+		if (forward || (x > 0))
+		{
+			int neighbour = forward ? 1 : -1;
+			for (; x + 4 <= xEnd; x += 4)
+			{
+				__m128i h00 = load4(row + x);
+				__m128i h01 = load4(row + x + neighbour);
+				__m128i h10 = load4(rowNext + x);
+
+				__m128i diffX = forward ? _mm_sub_epi32(h01, h00) : _mm_sub_epi32(h00, h01);
+				__m128i diffY = halfY ? _mm_sub_epi32(h10, h00) : _mm_sub_epi32(h00, h10);
+				__m128 dx = _mm_mul_ps(_mm_cvtepi32_ps(diffX), scaleX);
+				__m128 dy = _mm_mul_ps(_mm_cvtepi32_ps(diffY), scaleY);
+
+				__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), one));
+				__m128 nx = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), dx), length);
+				__m128 ny = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), dy), length);
+				__m128 nz = _mm_div_ps(one, length);
+
+				alignas(16) int32_t encoded[3][4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(encoded[0]), encode(nx));
+				_mm_store_si128(reinterpret_cast<__m128i*>(encoded[1]), encode(ny));
+				_mm_store_si128(reinterpret_cast<__m128i*>(encoded[2]), encode(nz));
+				for (int k = 0; k < 4; ++k)
+					writeNormal(x + k, encoded[0][k], encoded[1][k], encoded[2][k]);
+			}
+		}
+#endif
+
+		for (; x < xEnd; ++x)
+		{
+			short h00 = row[x];
+			short h01 = row[clamp(x + (forward ? 1 : -1), 0, size.x - 1)];
+			short h10 = rowNext[x];
+
+			float dx = static_cast<float>(forward ? h01 - h00 : h00 - h01) * scale.x;
+			float dy = static_cast<float>(halfY ? h10 - h00 : h00 - h10) * scale.y;
+			vec3 produce = normalize(cross(vec3(1.0f, 0.0f, dx), vec3(0.0f, 1.0f, dy)));
+
+			writeNormal(x, static_cast<int>(255.0f * (0.5f + 0.5f * produce.x)),
+				static_cast<int>(255.0f * (0.5f + 0.5f * produce.y)), static_cast<int>(255.0f * (0.5f + 0.5f * produce.z)));
+		}
+	}
+}
 }
@@ -27,7 +27,8 @@ namespace et
 	enum ImageBlurType
 	{
 		ImageBlurType_Average,
-		ImageBlurType_Linear
+		ImageBlurType_Linear,
+		ImageBlurType_Gaussian
 	};
 
 	enum ImageFilteringType
@@ -36,8 +37,20 @@ namespace et
 		ImageFilteringType_Linear
 	};
 
+	enum ImageDownsampleFilter
+	{
+		ImageDownsampleFilter_Box,
+		ImageDownsampleFilter_Kaiser
+	};
+
 	class ImageOperations
 	{
+	public:
+		enum : int
+		{
+			MaxMedianRadius = 127
+		};
+
 	public:
 		static mat3i matrixFilterBlur;
 		static mat3i matrixFilterSharpen;
@@ -55,10 +68,24 @@ namespace et
 		static void applyPixelFilter(BinaryDataStorage& data, const vec2i& size, int components, PixelFilter* filter, void* context);
 		static void applyMatrixFilter(BinaryDataStorage& data, const vec2i& size, int components, const mat3i& m);
 
+		/*
+		 * blur along one of the axes runs in constant time per pixel, Gaussian is approximated with three box filters
+		 */
 		static void blur(BinaryDataStorage& data, const vec2i& size, int components, vec2i direction, int radius, ImageBlurType type);
+
+		/*
+		 * median of each component in (2 * radius + 1)^2 window, constant time per pixel
+		 */
 		static void median(BinaryDataStorage& data, const vec2i& size, int components, int radius);
 
 		static void normalMapFilter(BinaryDataStorage& data, const vec2i& size, int components, const vec2& scale);
 
+		/*
+		 * produces next mip level: halves each dimension (down to 1), components are 8 bit,
+		 * Kaiser filter is a windowed sinc, which keeps mip levels sharper than box
+		 */
+		static void downsample(const BinaryDataStorage& src, const vec2i& srcSize, int components,
+			BinaryDataStorage& dst, vec2i& dstSize, ImageDownsampleFilter filter);
+
 	};
 }
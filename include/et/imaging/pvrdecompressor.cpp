@@ -19,6 +19,7 @@
  *****************************************************************************/
 #include <external/pvr/PVRTTexture.h>
 #include <external/pvr/PVRTDecompress.h>
+#include <et/core/jobsystem.h>
 
 /***********************************************************
 				DECOMPRESSION ROUTINES
@@ -653,54 +654,56 @@ static int pvrtcDecompress(	PVRTuint8 *pCompressedData,
 	int i32NumXWords = (int)(ui32Width / ui32WordWidth);
 	int i32NumYWords = (int)(ui32Height / ui32WordHeight);
 
-	// Structs used for decompression
-	PVRTCWordIndices indices;
-	Pixel32 *pPixels;
-	pPixels = (Pixel32*)(et::sharedBlockAllocator().allocate(ui32WordWidth*ui32WordHeight*sizeof(Pixel32)));
-	
-	// For each row of words
-	for(int wordY=-1; wordY < i32NumYWords-1; wordY++)
+	// Rows of words are decompressed in parallel: every pixel is written by exactly one word quad,
+	// quads are only reading compressed data, so each job just needs it's own pixels buffer.
+	et::sharedJobSystem().parallelFor(0, static_cast<PVRTuint32>(i32NumYWords), [&](PVRTuint32 rowBegin, PVRTuint32 rowEnd)
 	{
-		// for each column of words
-		for(int wordX=-1; wordX < i32NumXWords-1; wordX++)
+		PVRTCWordIndices indices;
+		Pixel32 pPixels[8 * 4];
+
+		// For each row of words
+		for(int wordY=static_cast<int>(rowBegin)-1; wordY < static_cast<int>(rowEnd)-1; wordY++)
 		{
-			indices.P[0] = wrapWordIndex(i32NumXWords, wordX);
-			indices.P[1] = wrapWordIndex(i32NumYWords, wordY);
-			indices.Q[0] = wrapWordIndex(i32NumXWords, wordX + 1); 
-			indices.Q[1] = wrapWordIndex(i32NumYWords, wordY);
-			indices.R[0] = wrapWordIndex(i32NumXWords, wordX); 
-			indices.R[1] = wrapWordIndex(i32NumYWords, wordY + 1);
-			indices.S[0] = wrapWordIndex(i32NumXWords, wordX + 1);
-			indices.S[1] = wrapWordIndex(i32NumYWords, wordY + 1);
-
-			//Work out the offsets into the twiddle structs, multiply by two as there are two members per word.
-			PVRTuint32 WordOffsets[4] =
+			// for each column of words
+			for(int wordX=-1; wordX < i32NumXWords-1; wordX++)
 			{
-				TwiddleUV(i32NumXWords,i32NumYWords,indices.P[0], indices.P[1])*2,
-				TwiddleUV(i32NumXWords,i32NumYWords,indices.Q[0], indices.Q[1])*2,
-				TwiddleUV(i32NumXWords,i32NumYWords,indices.R[0], indices.R[1])*2,
-				TwiddleUV(i32NumXWords,i32NumYWords,indices.S[0], indices.S[1])*2,
-			};
-
-			//Access individual elements to fill out PVRTCWord
-			PVRTCWord P,Q,R,S;
-			P.u32ColourData = pWordMembers[WordOffsets[0]+1];
-			P.u32ModulationData = pWordMembers[WordOffsets[0]];
-			Q.u32ColourData = pWordMembers[WordOffsets[1]+1];
-			Q.u32ModulationData = pWordMembers[WordOffsets[1]];
-			R.u32ColourData = pWordMembers[WordOffsets[2]+1];
-			R.u32ModulationData = pWordMembers[WordOffsets[2]];
-			S.u32ColourData = pWordMembers[WordOffsets[3]+1];
-			S.u32ModulationData = pWordMembers[WordOffsets[3]];
+				indices.P[0] = wrapWordIndex(i32NumXWords, wordX);
+				indices.P[1] = wrapWordIndex(i32NumYWords, wordY);
+				indices.Q[0] = wrapWordIndex(i32NumXWords, wordX + 1); 
+				indices.Q[1] = wrapWordIndex(i32NumYWords, wordY);
+				indices.R[0] = wrapWordIndex(i32NumXWords, wordX); 
+				indices.R[1] = wrapWordIndex(i32NumYWords, wordY + 1);
+				indices.S[0] = wrapWordIndex(i32NumXWords, wordX + 1);
+				indices.S[1] = wrapWordIndex(i32NumYWords, wordY + 1);
+
+				//Work out the offsets into the twiddle structs, multiply by two as there are two members per word.
+				PVRTuint32 WordOffsets[4] =
+				{
+					TwiddleUV(i32NumXWords,i32NumYWords,indices.P[0], indices.P[1])*2,
+					TwiddleUV(i32NumXWords,i32NumYWords,indices.Q[0], indices.Q[1])*2,
+					TwiddleUV(i32NumXWords,i32NumYWords,indices.R[0], indices.R[1])*2,
+					TwiddleUV(i32NumXWords,i32NumYWords,indices.S[0], indices.S[1])*2,
+				};
+
+				//Access individual elements to fill out PVRTCWord
+				PVRTCWord P,Q,R,S;
+				P.u32ColourData = pWordMembers[WordOffsets[0]+1];
+				P.u32ModulationData = pWordMembers[WordOffsets[0]];
+				Q.u32ColourData = pWordMembers[WordOffsets[1]+1];
+				Q.u32ModulationData = pWordMembers[WordOffsets[1]];
+				R.u32ColourData = pWordMembers[WordOffsets[2]+1];
+				R.u32ModulationData = pWordMembers[WordOffsets[2]];
+				S.u32ColourData = pWordMembers[WordOffsets[3]+1];
+				S.u32ModulationData = pWordMembers[WordOffsets[3]];
 							
-			// assemble 4 words into struct to get decompressed pixels from
-			pvrtcGetDecompressedPixels(P,Q,R,S,pPixels,ui8Bpp);
-			mapDecompressedData(pOutData, ui32Width, pPixels, indices, ui8Bpp);
+				// assemble 4 words into struct to get decompressed pixels from
+				pvrtcGetDecompressedPixels(P,Q,R,S,pPixels,ui8Bpp);
+				mapDecompressedData(pOutData, ui32Width, pPixels, indices, ui8Bpp);
 			
-		} // for each word
-	} // for each row of words
+			} // for each word
+		} // for each row of words
+	}, 8);
 
-	et::sharedBlockAllocator().release(pPixels);
 	//Return the data size
 	return ui32Width * ui32Height / (PVRTuint32)(ui32WordWidth/2);
 }
@@ -817,96 +820,100 @@ static unsigned int modifyPixel(int red, int green, int blue, int x, int y, unsi
 *************************************************************************/
 static int ETCTextureDecompress(const void * const pSrcData, const int &x, const int &y, const void *pDestData,const int &/*nMode*/)
 {
-	unsigned int blockTop, blockBot, *input = (unsigned int*)pSrcData, *output;
-	unsigned char red1, green1, blue1, red2, green2, blue2;
-	bool bFlip, bDiff;
-	int modtable1,modtable2;
-
-	for(int i=0;i<y;i+=4)
+	// rows of blocks are independent, so they are decompressed in parallel
+	et::sharedJobSystem().parallelFor(0, static_cast<unsigned int>(y / 4), [&](unsigned int rowBegin, unsigned int rowEnd)
 	{
-		for(int m=0;m<x;m+=4)
+		unsigned int blockTop, blockBot, *input = (unsigned int*)pSrcData + rowBegin * (x / 4) * 2, *output;
+		unsigned char red1, green1, blue1, red2, green2, blue2;
+		bool bFlip, bDiff;
+		int modtable1,modtable2;
+
+		for(int i=4*rowBegin;i<4*static_cast<int>(rowEnd);i+=4)
 		{
-				blockTop = *(input++);
-				blockBot = *(input++);
-
-			output = (unsigned int*)pDestData + i*x +m;
-
-			// check flipbit
-			bFlip = (blockTop & ETC_FLIP) != 0;
-			bDiff = (blockTop & ETC_DIFF) != 0;
-
-			if(bDiff)
-			{	// differential mode 5 colour bits + 3 difference bits
-				// get base colour for subblock 1
-				blue1 = (unsigned char)((blockTop&0xf80000)>>16);
-				green1 = (unsigned char)((blockTop&0xf800)>>8);
-				red1 = (unsigned char)(blockTop&0xf8);
-
-				// get differential colour for subblock 2
-				signed char blues = (signed char)(blue1>>3) + ((signed char) ((blockTop & 0x70000) >> 11)>>5);
-				signed char greens = (signed char)(green1>>3) + ((signed char)((blockTop & 0x700) >>3)>>5);
-				signed char reds = (signed char)(red1>>3) + ((signed char)((blockTop & 0x7)<<5)>>5);
-
-				blue2 = (unsigned char)blues;
-				green2 = (unsigned char)greens;
-				red2 = (unsigned char)reds;
-
-				red1 = red1 +(red1>>5);	// copy bits to lower sig
-				green1 = green1 + (green1>>5);	// copy bits to lower sig
-				blue1 = blue1 + (blue1>>5);	// copy bits to lower sig
-
-				red2 = ((red2<<3) +(red2>>2)) & 0xff;	// copy bits to lower sig
-				green2 = ((green2<<3) + (green2>>2)) & 0xff;	// copy bits to lower sig
-				blue2 = ((blue2<<3) + (blue2>>2)) & 0xff;	// copy bits to lower sig
-			}
-			else
-			{	// individual mode 4 + 4 colour bits
-				// get base colour for subblock 1
-				blue1 = (unsigned char)((blockTop&0xf00000)>>16);
-				blue1 = blue1 +(blue1>>4);	// copy bits to lower sig
-				green1 = (unsigned char)((blockTop&0xf000)>>8);
-				green1 = green1 + (green1>>4);	// copy bits to lower sig
-				red1 = (unsigned char)(blockTop&0xf0);
-				red1 = red1 + (red1>>4);	// copy bits to lower sig
-
-				// get base colour for subblock 2
-				blue2 = (unsigned char)((blockTop&0xf0000)>>12);
-				blue2 = blue2 +(blue2>>4);	// copy bits to lower sig
-				green2 = (unsigned char)((blockTop&0xf00)>>4);
-				green2 = green2 + (green2>>4);	// copy bits to lower sig
-				red2 = (unsigned char)((blockTop&0xf)<<4);
-				red2 = red2 + (red2>>4);	// copy bits to lower sig
-			}
-			// get the modtables for each subblock
-			modtable1 = (blockTop>>29)&0x7;
-			modtable2 = (blockTop>>26)&0x7;
+			for(int m=0;m<x;m+=4)
+			{
+					blockTop = *(input++);
+					blockBot = *(input++);
+
+				output = (unsigned int*)pDestData + i*x +m;
+
+				// check flipbit
+				bFlip = (blockTop & ETC_FLIP) != 0;
+				bDiff = (blockTop & ETC_DIFF) != 0;
+
+				if(bDiff)
+				{	// differential mode 5 colour bits + 3 difference bits
+					// get base colour for subblock 1
+					blue1 = (unsigned char)((blockTop&0xf80000)>>16);
+					green1 = (unsigned char)((blockTop&0xf800)>>8);
+					red1 = (unsigned char)(blockTop&0xf8);
+
+					// get differential colour for subblock 2
+					signed char blues = (signed char)(blue1>>3) + ((signed char) ((blockTop & 0x70000) >> 11)>>5);
+					signed char greens = (signed char)(green1>>3) + ((signed char)((blockTop & 0x700) >>3)>>5);
+					signed char reds = (signed char)(red1>>3) + ((signed char)((blockTop & 0x7)<<5)>>5);
+
+					blue2 = (unsigned char)blues;
+					green2 = (unsigned char)greens;
+					red2 = (unsigned char)reds;
+
+					red1 = red1 +(red1>>5);	// copy bits to lower sig
+					green1 = green1 + (green1>>5);	// copy bits to lower sig
+					blue1 = blue1 + (blue1>>5);	// copy bits to lower sig
+
+					red2 = ((red2<<3) +(red2>>2)) & 0xff;	// copy bits to lower sig
+					green2 = ((green2<<3) + (green2>>2)) & 0xff;	// copy bits to lower sig
+					blue2 = ((blue2<<3) + (blue2>>2)) & 0xff;	// copy bits to lower sig
+				}
+				else
+				{	// individual mode 4 + 4 colour bits
+					// get base colour for subblock 1
+					blue1 = (unsigned char)((blockTop&0xf00000)>>16);
+					blue1 = blue1 +(blue1>>4);	// copy bits to lower sig
+					green1 = (unsigned char)((blockTop&0xf000)>>8);
+					green1 = green1 + (green1>>4);	// copy bits to lower sig
+					red1 = (unsigned char)(blockTop&0xf0);
+					red1 = red1 + (red1>>4);	// copy bits to lower sig
+
+					// get base colour for subblock 2
+					blue2 = (unsigned char)((blockTop&0xf0000)>>12);
+					blue2 = blue2 +(blue2>>4);	// copy bits to lower sig
+					green2 = (unsigned char)((blockTop&0xf00)>>4);
+					green2 = green2 + (green2>>4);	// copy bits to lower sig
+					red2 = (unsigned char)((blockTop&0xf)<<4);
+					red2 = red2 + (red2>>4);	// copy bits to lower sig
+				}
+				// get the modtables for each subblock
+				modtable1 = (blockTop>>29)&0x7;
+				modtable2 = (blockTop>>26)&0x7;
 
-			if(!bFlip)
-			{	// 2 2x4 blocks side by side
+				if(!bFlip)
+				{	// 2 2x4 blocks side by side
 
-				for(int j=0;j<4;j++)	// vertical
-				{
-					for(int k=0;k<2;k++)	// horizontal
+					for(int j=0;j<4;j++)	// vertical
 					{
-						*(output+j*x+k) = modifyPixel(red1,green1,blue1,k,j,blockBot,modtable1);
-						*(output+j*x+k+2) = modifyPixel(red2,green2,blue2,k+2,j,blockBot,modtable2);
+						for(int k=0;k<2;k++)	// horizontal
+						{
+							*(output+j*x+k) = modifyPixel(red1,green1,blue1,k,j,blockBot,modtable1);
+							*(output+j*x+k+2) = modifyPixel(red2,green2,blue2,k+2,j,blockBot,modtable2);
+						}
 					}
-				}
 
-			}
-			else
-			{	// 2 4x2 blocks on top of each other
-				for(int j=0;j<2;j++)
-				{
-					for(int k=0;k<4;k++)
+				}
+				else
+				{	// 2 4x2 blocks on top of each other
+					for(int j=0;j<2;j++)
 					{
-						*(output+j*x+k) = modifyPixel(red1,green1,blue1,k,j,blockBot,modtable1);
-						*(output+(j+2)*x+k) = modifyPixel(red2,green2,blue2,k,j+2,blockBot,modtable2);
+						for(int k=0;k<4;k++)
+						{
+							*(output+j*x+k) = modifyPixel(red1,green1,blue1,k,j,blockBot,modtable1);
+							*(output+(j+2)*x+k) = modifyPixel(red2,green2,blue2,k,j+2,blockBot,modtable2);
+						}
 					}
 				}
 			}
 		}
-	}
+	}, 16);
 
 	return x*y/2;
 }
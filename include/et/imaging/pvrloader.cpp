@@ -72,6 +72,67 @@ void pvr::loadFromStream(std::istream& stream, TextureDescription& desc)
 	}
 }
 
+bool pvr::loadFromMappedFile(const MappedFile::Pointer& file, TextureDescription& desc, bool loadData)
+{
+	desc.dataLayout = TextureDataLayout::MipsFirst;
+
+	PVR_Texture_Header header2 = {};
+	if (file->size() >= sizeof(header2))
+	{
+		etCopyMemory(&header2, file->data(), sizeof(header2));
+		if (header2.dwPVR == ET_COMPOSE_UINT32_INVERTED('P', 'V', 'R', '!'))
+		{
+			ET_FAIL("Legacy PVR files are not supported anymore.")
+			return false;
+		}
+	}
+
+	PVRTextureHeaderV3 header3 = {};
+	if (file->size() >= sizeof(header3))
+		etCopyMemory(&header3, file->data(), sizeof(header3));
+
+	if (header3.u32Version != PVRTEX3_IDENT)
+	{
+		log::error("Unrecognized PVR file: %s", desc.origin().c_str());
+		return false;
+	}
+
+	uint64_t offset = sizeof(header3) + header3.u32MetaDataSize;
+	if (file->size() < offset)
+	{
+		log::error("Unable to load PVR. File is too small: %s", desc.origin().c_str());
+		return false;
+	}
+
+	loadInfoFromV3Header(header3, file->view(sizeof(header3), header3.u32MetaDataSize), desc);
+
+	if (loadData)
+	{
+		uint64_t dataSize = desc.layerCount * desc.dataSizeForAllMipLevels();
+		if (file->size() < offset + dataSize)
+		{
+			log::error("Unable to load PVR. File is truncated: %s", desc.origin().c_str());
+			return false;
+		}
+
+		bool decompress = (desc.format >= TextureFormat::PVR_2bpp_RGB) && (desc.format <= TextureFormat::PVR_4bpp_sRGBA);
+		if (decompress)
+		{
+			BinaryDataStorage rgbaData(desc.size.square() * 4, 0);
+			PVRTDecompressPVRTC(file->data() + offset, (bitsPerPixelForTextureFormat(desc.format) == 2), desc.size.x, desc.size.y, rgbaData.data());
+			desc.levelCount = 1;
+			desc.format = TextureFormat::RGBA8;
+			desc.data = std::move(rgbaData);
+		}
+		else
+		{
+			desc.data = file->view(offset, dataSize);
+			desc.mappedFile = file;
+		}
+	}
+	return true;
+}
+
 void pvr::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 {
 	InputStream file(path, StreamMode_Binary);
@@ -84,11 +145,11 @@ void pvr::loadInfoFromFile(const std::string& path, TextureDescription& desc)
 
 void pvr::loadFromFile(const std::string& path, TextureDescription& desc)
 {
-	InputStream file(path, StreamMode_Binary);
-	if (file.valid())
+	MappedFile::Pointer file = MappedFile::Pointer::create(path);
+	if (file->valid())
 	{
 		desc.setOrigin(path);
-		loadFromStream(file.stream(), desc);
+		loadFromMappedFile(file, desc, true);
 	}
 }
 
@@ -146,6 +207,12 @@ void parseTextureFormat(const PVRTextureHeaderV3& sTextureHeader, TextureDescrip
 			return;
 		}
 
+		case ePVRTPF_ETC1:
+		{
+			desc.format = TextureFormat::ETC1;
+			return;
+		}
+
 		default:
 			ET_FAIL_FMT("Invalid PVR compressed format: %llu", PixelFormat)
 		}
@@ -18,6 +18,12 @@ namespace et
 
 		void loadFromStream(std::istream& stream, TextureDescription& desc);
 		void loadFromFile(const std::string& path, TextureDescription& desc);
+
+		/*
+		 * data of the description is set to the view over the mapped file,
+		 * only PVRTC textures (which are decompressed on load) are copied
+		 */
+		bool loadFromMappedFile(const MappedFile::Pointer& file, TextureDescription& desc, bool loadData);
 	}
 
 }
@@ -0,0 +1,367 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/tools.h>
+#include <et/imaging/blockcompression.h>
+#include <et/imaging/texturecache.h>
+
+using namespace et;
+
+static std::atomic<bool> textureCacheEnabled(true);
+static std::atomic<bool> textureCacheHashVerification(false);
+
+namespace
+{
+enum : uint32_t
+{
+	TextureCacheSignature = ET_COMPOSE_UINT32('E', 'T', 'T', 'C'),
+	TextureCacheVersion = 1,
+	TextureCacheDataAlignment = 64,
+};
+
+enum : uint32_t
+{
+	CookOption_KaiserFilter = 1 << 0,
+	CookOption_GenerateMips = 1 << 1,
+	CookOption_AutomaticCompression = 1 << 2,
+	CookOption_CompressionShift = 8,
+};
+
+struct TextureCacheHeader
+{
+	uint32_t signature = TextureCacheSignature;
+	uint32_t version = TextureCacheVersion;
+	uint64_t sourceHash = 0;
+	uint64_t sourceSize = 0;
+	uint32_t format = 0;
+	uint32_t target = 0;
+	uint32_t dataLayout = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t levelCount = 0;
+	uint32_t layerCount = 0;
+	uint32_t options = 0;
+	uint64_t dataOffset = 0;
+	uint64_t dataSize = 0;
+};
+
+uint32_t packCookOptions(const texturecache::CookOptions&);
+bool readTextureCacheHeader(const MappedFile::Pointer&, TextureCacheHeader&);
+bool sourceMatchesHeader(const std::string& source, const TextureCacheHeader&);
+bool buildCookedLevels(const TextureDescription& source, TextureFormat format,
+	const texturecache::CookOptions&, TextureDescription& cooked);
+}
+
+std::string et::texturecache::cachedFileName(const std::string& source)
+{
+	return source + ".ettex";
+}
+
+void et::texturecache::setEnabled(bool value)
+{
+	textureCacheEnabled = value;
+}
+
+bool et::texturecache::enabled()
+{
+	return textureCacheEnabled;
+}
+
+void et::texturecache::setHashVerificationEnabled(bool value)
+{
+	textureCacheHashVerification = value;
+}
+
+bool et::texturecache::hashVerificationEnabled()
+{
+	return textureCacheHashVerification;
+}
+
+bool et::texturecache::load(const std::string& source, TextureDescription& desc)
+{
+	std::string cacheName = cachedFileName(source);
+	if (!fileExists(cacheName))
+		return false;
+
+	if (fileExists(source) && (getFileDate(source) > getFileDate(cacheName)))
+		return false;
+
+	MappedFile::Pointer file = MappedFile::Pointer::create(cacheName);
+	TextureCacheHeader header;
+	if (!readTextureCacheHeader(file, header))
+		return false;
+
+	if (hashVerificationEnabled() && fileExists(source) && !sourceMatchesHeader(source, header))
+		return false;
+
+	desc.size = vec2i(static_cast<int32_t>(header.width), static_cast<int32_t>(header.height));
+	desc.format = static_cast<TextureFormat>(header.format);
+	desc.target = static_cast<TextureTarget>(header.target);
+	desc.dataLayout = static_cast<TextureDataLayout>(header.dataLayout);
+	desc.levelCount = header.levelCount;
+	desc.layerCount = header.layerCount;
+
+	if (desc.dataSizeForAllMipLevels() != header.dataSize)
+	{
+		log::error("Texture cache %s has invalid data size", cacheName.c_str());
+		desc.size = vec2i(0);
+		return false;
+	}
+
+	desc.data = file->view(header.dataOffset, header.dataSize);
+	desc.mappedFile = file;
+	desc.setOrigin(source);
+	return true;
+}
+
+TextureFormat et::texturecache::automaticCompressionFormat(const TextureDescription& desc)
+{
+	switch (desc.format)
+	{
+	case TextureFormat::RG8:
+		return TextureFormat::RGTC2;
+
+	case TextureFormat::RGBA8:
+	case TextureFormat::BGRA8:
+	{
+		const vec4ub* pixels = reinterpret_cast<const vec4ub*>(desc.data.constData());
+		uint32_t pixelsCount = static_cast<uint32_t>(desc.size.square());
+		for (uint32_t i = 0; i < pixelsCount; ++i)
+		{
+			if (pixels[i].w < 255)
+				return TextureFormat::DXT5;
+		}
+		return TextureFormat::DXT1_RGB;
+	}
+
+	default:
+		return TextureFormat::Invalid;
+	}
+}
+
+et::texturecache::CookResult et::texturecache::cook(const std::string& source, const CookOptions& options)
+{
+	return cook(source, cachedFileName(source), options);
+}
+
+et::texturecache::CookResult et::texturecache::cook(const std::string& source, const std::string& output, const CookOptions& options)
+{
+	if (!options.force && fileExists(output) && (getFileDate(output) >= getFileDate(source)))
+	{
+		TextureCacheHeader header;
+		MappedFile::Pointer existing = MappedFile::Pointer::create(output);
+		if (readTextureCacheHeader(existing, header) && (header.options == packCookOptions(options)))
+			return CookResult::UpToDate;
+	}
+
+	MappedFile::Pointer sourceFile = MappedFile::Pointer::create(source);
+	if (!sourceFile->valid())
+	{
+		log::error("Unable to open texture %s", source.c_str());
+		return CookResult::Failed;
+	}
+
+	TextureDescription sourceDesc;
+	if (!sourceDesc.loadSource(source))
+	{
+		log::error("Unable to load texture %s", source.c_str());
+		return CookResult::Failed;
+	}
+
+	if ((sourceDesc.target != TextureTarget::Texture_2D) || (sourceDesc.layerCount != 1) || (sourceDesc.levelCount != 1) ||
+		((sourceDesc.format != TextureFormat::R8) && (sourceDesc.format != TextureFormat::RG8) &&
+		(sourceDesc.format != TextureFormat::RGBA8) && (sourceDesc.format != TextureFormat::BGRA8)))
+	{
+		log::error("Unable to cook %s: only 2D textures with 8 bit components and without mip levels are supported", source.c_str());
+		return CookResult::Failed;
+	}
+
+	TextureFormat format = options.automaticCompression ? automaticCompressionFormat(sourceDesc) : options.compression;
+	if ((format != TextureFormat::Invalid) && !bc::compressionSupported(format))
+	{
+		log::error("Unable to cook %s: compression to format %u is not supported", source.c_str(), static_cast<uint32_t>(format));
+		return CookResult::Failed;
+	}
+
+	/*
+	 * size of the mip levels of compressed textures are clamped to the block size,
+	 * which is only correct for power of two dimensions
+	 */
+	if ((format != TextureFormat::Invalid) && (!isPowerOfTwo(static_cast<uint32_t>(sourceDesc.size.x)) || !isPowerOfTwo(static_cast<uint32_t>(sourceDesc.size.y))))
+	{
+		log::info("Texture %s has non power of two size (%d x %d) and will not be compressed",
+			source.c_str(), sourceDesc.size.x, sourceDesc.size.y);
+		format = TextureFormat::Invalid;
+	}
+
+	TextureDescription cooked;
+	if (!buildCookedLevels(sourceDesc, format, options, cooked))
+		return CookResult::Failed;
+
+	TextureCacheHeader header;
+	header.sourceHash = contentHash(sourceFile->data(), sourceFile->size());
+	header.sourceSize = sourceFile->size();
+	header.format = static_cast<uint32_t>(cooked.format);
+	header.target = static_cast<uint32_t>(cooked.target);
+	header.dataLayout = static_cast<uint32_t>(cooked.dataLayout);
+	header.width = static_cast<uint32_t>(cooked.size.x);
+	header.height = static_cast<uint32_t>(cooked.size.y);
+	header.levelCount = cooked.levelCount;
+	header.layerCount = cooked.layerCount;
+	header.options = packCookOptions(options);
+	header.dataOffset = alignUpTo<uint64_t>(sizeof(TextureCacheHeader), TextureCacheDataAlignment);
+	header.dataSize = cooked.data.size();
+
+	std::ofstream out(output, std::ios::out | std::ios::binary);
+	if (out.fail())
+	{
+		log::error("Unable to write texture cache %s", output.c_str());
+		return CookResult::Failed;
+	}
+
+	char padding[TextureCacheDataAlignment] = { };
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(padding, static_cast<std::streamsize>(header.dataOffset - sizeof(header)));
+	out.write(cooked.data.binary(), static_cast<std::streamsize>(cooked.data.size()));
+	out.flush();
+
+	if (out.fail())
+	{
+		log::error("Unable to write texture cache %s", output.c_str());
+		return CookResult::Failed;
+	}
+
+	return CookResult::Cooked;
+}
+
+namespace
+{
+
+uint32_t packCookOptions(const texturecache::CookOptions& options)
+{
+	uint32_t result = static_cast<uint32_t>(options.compression) << CookOption_CompressionShift;
+
+	if (options.filter == ImageDownsampleFilter_Kaiser)
+		result |= CookOption_KaiserFilter;
+
+	if (options.generateMips)
+		result |= CookOption_GenerateMips;
+
+	if (options.automaticCompression)
+		result |= CookOption_AutomaticCompression;
+
+	return result;
+}
+
+bool readTextureCacheHeader(const MappedFile::Pointer& file, TextureCacheHeader& header)
+{
+	if (!file->valid() || (file->size() < sizeof(TextureCacheHeader)))
+		return false;
+
+	memcpy(&header, file->data(), sizeof(TextureCacheHeader));
+	if ((header.signature != TextureCacheSignature) || (header.version != TextureCacheVersion))
+		return false;
+
+	if ((header.format >= static_cast<uint32_t>(TextureFormat::max)) ||
+		(header.target >= static_cast<uint32_t>(TextureTarget::max)) ||
+		(header.dataLayout >= static_cast<uint32_t>(TextureDataLayout::max)))
+	{
+		return false;
+	}
+
+	return (header.dataOffset >= sizeof(TextureCacheHeader)) && (header.dataOffset <= file->size()) &&
+		(header.dataSize <= file->size() - header.dataOffset);
+}
+
+bool sourceMatchesHeader(const std::string& source, const TextureCacheHeader& header)
+{
+	MappedFile sourceFile(source);
+	return sourceFile.valid() && (sourceFile.size() == header.sourceSize) &&
+		(contentHash(sourceFile.data(), sourceFile.size()) == header.sourceHash);
+}
+
+/*
+ * expands pixels of the cookable source formats to RGBA, as expected by block encoders
+ */
+void expandToRGBA(const BinaryDataStorage& data, TextureFormat format, const vec2i& size, Vector<vec4ub>& output)
+{
+	uint32_t pixelsCount = static_cast<uint32_t>(size.square());
+	output.resize(pixelsCount);
+
+	const uint8_t* source = data.constData();
+	for (uint32_t i = 0; i < pixelsCount; ++i)
+	{
+		switch (format)
+		{
+		case TextureFormat::R8:
+			output[i] = vec4ub(source[i], 0, 0, 255);
+			break;
+		case TextureFormat::RG8:
+			output[i] = vec4ub(source[2 * i], source[2 * i + 1], 0, 255);
+			break;
+		case TextureFormat::BGRA8:
+			output[i] = vec4ub(source[4 * i + 2], source[4 * i + 1], source[4 * i], source[4 * i + 3]);
+			break;
+		default:
+			output[i] = vec4ub(source[4 * i], source[4 * i + 1], source[4 * i + 2], source[4 * i + 3]);
+		}
+	}
+}
+
+bool buildCookedLevels(const TextureDescription& source, TextureFormat format,
+	const texturecache::CookOptions& options, TextureDescription& cooked)
+{
+	int components = static_cast<int>(channelsForTextureFormat(source.format));
+
+	cooked.size = source.size;
+	cooked.format = (format == TextureFormat::Invalid) ? source.format : format;
+	cooked.target = TextureTarget::Texture_2D;
+	cooked.layerCount = 1;
+	cooked.levelCount = 1;
+	if (options.generateMips)
+	{
+		int largestDimension = std::max(source.size.x, source.size.y);
+		while ((largestDimension >> cooked.levelCount) > 0)
+			++cooked.levelCount;
+	}
+
+	cooked.data.resize(cooked.dataSizeForAllMipLevels());
+
+	BinaryDataStorage level(source.data.constData(), source.data.size());
+	vec2i levelSize = source.size;
+	Vector<vec4ub> expanded;
+	for (uint32_t l = 0; l < cooked.levelCount; ++l)
+	{
+		if (l > 0)
+		{
+			BinaryDataStorage nextLevel;
+			vec2i nextLevelSize;
+			ImageOperations::downsample(level, levelSize, components, nextLevel, nextLevelSize, options.filter);
+			level = std::move(nextLevel);
+			levelSize = nextLevelSize;
+		}
+
+		uint8_t* destination = cooked.data.begin() + cooked.dataOffsetForMipLevel(l, 0);
+		uint64_t levelDataSize = cooked.dataSizeForMipLevel(l);
+		if (format == TextureFormat::Invalid)
+		{
+			ET_ASSERT(level.size() == levelDataSize);
+			memcpy(destination, level.constData(), levelDataSize);
+		}
+		else
+		{
+			ET_ASSERT(bc::compressedDataSize(format, levelSize) == levelDataSize);
+			expandToRGBA(level, source.format, levelSize, expanded);
+			if (!bc::compress(format, expanded.data(), levelSize, destination))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+}
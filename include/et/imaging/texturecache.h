@@ -0,0 +1,60 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/imaging/imageoperations.h>
+#include <et/imaging/texturedescription.h>
+
+namespace et
+{
+namespace texturecache
+{
+/*
+ * Cooked texture is stored next to the source file (source + ".ettex"):
+ * versioned header followed by all mip levels in the final GPU format,
+ * so it is loaded with a single memory mapping and uploaded without conversion.
+ * Cache is considered valid if it is not older than the source (or source is missing),
+ * optionally content hash of the source is verified as well.
+ */
+struct CookOptions
+{
+	ImageDownsampleFilter filter = ImageDownsampleFilter_Kaiser;
+
+	/*
+	 * TextureFormat::Invalid keeps source format, automatic compression selects
+	 * BC1 for opaque, BC3 for transparent and BC5 for two channel images
+	 */
+	TextureFormat compression = TextureFormat::Invalid;
+	bool automaticCompression = false;
+	bool generateMips = true;
+	bool force = false;
+};
+
+enum class CookResult : uint32_t
+{
+	Cooked,
+	UpToDate,
+	Failed
+};
+
+std::string cachedFileName(const std::string& source);
+
+void setEnabled(bool);
+bool enabled();
+
+void setHashVerificationEnabled(bool);
+bool hashVerificationEnabled();
+
+bool load(const std::string& source, TextureDescription&);
+
+CookResult cook(const std::string& source, const CookOptions&);
+CookResult cook(const std::string& source, const std::string& output, const CookOptions&);
+
+TextureFormat automaticCompressionFormat(const TextureDescription&);
+}
+}
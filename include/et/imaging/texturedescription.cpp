@@ -12,7 +12,7 @@
 #include <et/imaging/jpegloader.h>
 #include <et/imaging/tgaloader.h>
 #include <et/imaging/bmploader.h>
-#include <et/imaging/texturedescription.h>
+#include <et/imaging/texturecache.h>
 
 namespace et
 {
@@ -84,6 +84,14 @@ bool TextureDescription::preload(const std::string& fileName, bool initWithZero)
 }
 
 bool TextureDescription::load(const std::string& fileName)
+{
+    if (texturecache::enabled() && texturecache::load(fileName, *this))
+        return true;
+    
+    return loadSource(fileName);
+}
+
+bool TextureDescription::loadSource(const std::string& fileName)
 {
     if (!fileExists(fileName))
         return false;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <et/core/containers.h>
+#include <et/core/mappedfile.h>
 #include <et/rendering/interface/texture.h>
 
 namespace et
@@ -20,7 +21,18 @@ public:
 public:
 	BinaryDataStorage data;
 
+	/*
+	 * when set, data is a read-only view over this mapping (used for DDS and PVR files),
+	 * so texture is uploaded directly from the file without intermediate copy
+	 */
+	MappedFile::Pointer mappedFile;
+
+	/*
+	 * loads cooked texture (see texturecache.h) when it is available and up to date,
+	 * loadSource always decodes the original file
+	 */
 	bool load(const std::string& name);
+	bool loadSource(const std::string& name);
 	bool preload(const std::string& name, bool fillWithZero);
 
 	const Texture::Description& desc() const { return *this; }
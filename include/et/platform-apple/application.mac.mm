@@ -85,6 +85,7 @@ Application::~Application()
 {
 	_backgroundThread.stop();
 	_backgroundThread.join();
+	sharedJobSystem().stop();
 	
 	platformFinalize();
     freeContext();
@@ -112,6 +112,7 @@ void RenderContext::shutdown()
 bool RenderContext::beginRender()
 {
 	ET_ASSERT(_private->initialized);
+	_renderer->createLoadedTextures();
 	_renderer->begin();
 	return true;
 }
@@ -137,6 +137,7 @@ Application::~Application()
 {
 	_backgroundThread.stop();
 	_backgroundThread.join();
+	sharedJobSystem().stop();
 }
 
 void Application::setTitle(const std::string& s)
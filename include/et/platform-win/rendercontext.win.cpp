@@ -123,6 +123,7 @@ bool RenderContext::beginRender()
 		_private->resizeScheduled = false;
 	}
 
+	_renderer->createLoadedTextures();
 	_renderer->begin();
 
 	return true;
@@ -20,6 +20,8 @@
 #	pragma warning(disable:4204)
 #	pragma warning(disable:4996)
 #
+#	include <intrin.h>
+#
 #elif defined(__MACH__)
 #
 #	include <TargetConditionals.h>
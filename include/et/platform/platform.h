@@ -43,6 +43,11 @@
 #	define ET_PLATFORM_MAC				1
 #	define CurrentPlatform				Platform::Mac
 #
+#elif defined(__linux__)
+#
+#	define ET_PLATFORM_LINUX			1
+#	define CurrentPlatform				Platform::Linux
+#
 #else
 #
 #	error Unable to determine current platform
@@ -69,6 +74,31 @@
 #
 #endif
 
+/*
+ * instruction sets available at compile time, code using them includes <immintrin.h>
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#	define ET_SIMD_SSE	1
+#else
+#	define ET_SIMD_SSE	0
+#endif
+
+/*
+ * wider instruction sets are not enabled by project settings, functions using them are compiled
+ * with ET_SIMD_TARGET and selected at runtime using cpuSupports (see et/core/tools.h)
+ */
+#if (ET_SIMD_SSE) && (defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__))
+#	define ET_SIMD_DISPATCH	1
+#else
+#	define ET_SIMD_DISPATCH	0
+#endif
+
+#if (ET_SIMD_DISPATCH) && (defined(__GNUC__) || defined(__clang__))
+#	define ET_SIMD_TARGET(isa)	__attribute__((target(isa)))
+#else
+#	define ET_SIMD_TARGET(isa)
+#endif
+
 #define ET_TO_CONST_CHAR_IMPL(a)	#a
 #define ET_TO_CONST_CHAR(a)			ET_TO_CONST_CHAR_IMPL(a)
 
@@ -78,6 +108,7 @@ namespace et
 	{
 		Windows,
 		Mac,
+		Linux,
 	};
 	
 	enum Architecture : uint32_t
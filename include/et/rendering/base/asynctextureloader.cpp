@@ -0,0 +1,282 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/core/tools.h>
+#include <et/imaging/blockcompression.h>
+#include <et/rendering/interface/renderer.h>
+
+namespace et
+{
+
+void TextureLoadingRequest::onCompleted(Callback callback)
+{
+	if (completed())
+		callback(_texture);
+	else
+		_callbacks.emplace_back(callback);
+}
+
+AsyncTextureLoader::AsyncTextureLoader(RenderInterface* renderer) :
+	_renderer(renderer), _jobSystem(&sharedJobSystem())
+{
+}
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+	/*
+	 * workers are referencing pending requests, so they should be decoded before loader is gone
+	 */
+	Vector<TextureLoadingRequest::Pointer> pending;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		pending.swap(_pendingRequests);
+	}
+
+	for (TextureLoadingRequest::Pointer& request : pending)
+		_jobSystem->wait(request->_decoding);
+}
+
+void AsyncTextureLoader::setJobSystem(JobSystem* jobSystem)
+{
+	ET_ASSERT(jobSystem != nullptr);
+	ET_ASSERT(pendingRequestsCount() == 0);
+	_jobSystem = jobSystem;
+}
+
+TextureLoadingRequest::Pointer AsyncTextureLoader::load(const std::string& fileName, ObjectsCache& cache,
+	TextureDescriptionUpdateMethod* update)
+{
+	TextureLoadingRequest::Pointer request;
+
+	LoadableObject::Collection existingObjects = cache.findObjects(fileName);
+	if (!existingObjects.empty())
+	{
+		request = TextureLoadingRequest::Pointer::create(fileName, cache, update);
+		request->_texture = existingObjects.front();
+		request->_state = TextureLoadingRequest::State::Completed;
+
+		std::lock_guard<std::mutex> lock(_lock);
+		++_statistics.requestsDeduplicated;
+		return request;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		for (const TextureLoadingRequest::Pointer& pending : _pendingRequests)
+		{
+			if ((&pending->_cache == &cache) && (pending->_fileName == fileName))
+			{
+				++_statistics.requestsDeduplicated;
+				return pending;
+			}
+		}
+
+		request = TextureLoadingRequest::Pointer::create(fileName, cache, update);
+		_pendingRequests.emplace_back(request);
+	}
+
+	/*
+	 * request is retained by the pending list until it is completed on the rendering thread
+	 */
+	TextureLoadingRequest* pendingRequest = request.pointer();
+	_jobSystem->schedule([this, pendingRequest]()
+	{
+		TextureDescription::Pointer description = decode(pendingRequest->_fileName);
+		if (description.valid())
+		{
+			pendingRequest->_update(description);
+			pendingRequest->_description = description;
+			pendingRequest->_state = TextureLoadingRequest::State::Decoded;
+		}
+		else
+		{
+			pendingRequest->_state = TextureLoadingRequest::State::Failed;
+		}
+	}, &pendingRequest->_decoding);
+
+	return request;
+}
+
+uint32_t AsyncTextureLoader::createLoadedTextures()
+{
+	Vector<TextureLoadingRequest::Pointer> readyRequests;
+	{
+		/*
+		 * state is set inside of the job, request is ready only when the job is finished
+		 * (decoding counter reached zero), so worker no longer references it
+		 */
+		std::lock_guard<std::mutex> lock(_lock);
+		auto i = std::stable_partition(_pendingRequests.begin(), _pendingRequests.end(), [](const TextureLoadingRequest::Pointer& r)
+			{ return (r->state() == TextureLoadingRequest::State::Decoding) || !r->_decoding.completed(); });
+
+		readyRequests.insert(readyRequests.end(), i, _pendingRequests.end());
+		_pendingRequests.erase(i, _pendingRequests.end());
+	}
+
+	if (readyRequests.empty())
+		return 0;
+
+	uint64_t startTime = queryCurrentTimeInMicroSeconds();
+
+	Vector<TextureDescription::Pointer> descriptions;
+	descriptions.reserve(readyRequests.size());
+	for (const TextureLoadingRequest::Pointer& request : readyRequests)
+	{
+		if (request->state() == TextureLoadingRequest::State::Decoded)
+			descriptions.emplace_back(request->_description);
+	}
+
+	Vector<Texture::Pointer> textures;
+	if (!descriptions.empty())
+		_renderer->createTextures(descriptions, textures);
+
+	uint32_t texturesCreated = 0;
+	size_t textureIndex = 0;
+	for (TextureLoadingRequest::Pointer& request : readyRequests)
+	{
+		if (request->state() == TextureLoadingRequest::State::Decoded)
+			request->_texture = textures[textureIndex++];
+
+		if (request->_texture.valid())
+		{
+			request->_texture->setOrigin(request->_fileName);
+			request->_cache.manage(request->_texture, ObjectLoader::Pointer());
+			++texturesCreated;
+		}
+		else
+		{
+			log::error("Unable to load texture from %s", request->_fileName.c_str());
+			request->_texture = _renderer->checkersTexture();
+		}
+
+		request->_description.reset(nullptr);
+		request->_state = TextureLoadingRequest::State::Completed;
+
+		for (const TextureLoadingRequest::Callback& callback : request->_callbacks)
+			callback(request->_texture);
+		request->_callbacks.clear();
+	}
+
+	uint64_t creationTime = queryCurrentTimeInMicroSeconds() - startTime;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_statistics.texturesCreated += texturesCreated;
+		_statistics.creationTime += creationTime;
+	}
+
+	return static_cast<uint32_t>(readyRequests.size());
+}
+
+Texture::Pointer AsyncTextureLoader::finish(TextureLoadingRequest::Pointer request)
+{
+	if (!request->completed())
+	{
+		_jobSystem->wait(request->_decoding);
+		createLoadedTextures();
+	}
+
+	ET_ASSERT(request->completed());
+	return request->texture();
+}
+
+void AsyncTextureLoader::finishAll()
+{
+	Vector<TextureLoadingRequest::Pointer> pending;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		pending = _pendingRequests;
+	}
+
+	for (TextureLoadingRequest::Pointer& request : pending)
+		_jobSystem->wait(request->_decoding);
+
+	createLoadedTextures();
+}
+
+TextureLoadingRequest::Pointer AsyncTextureLoader::pendingRequest(const std::string& fileName, const ObjectsCache& cache) const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	for (const TextureLoadingRequest::Pointer& pending : _pendingRequests)
+	{
+		if ((&pending->_cache == &cache) && (pending->_fileName == fileName))
+			return pending;
+	}
+	return TextureLoadingRequest::Pointer();
+}
+
+uint32_t AsyncTextureLoader::pendingRequestsCount() const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return static_cast<uint32_t>(_pendingRequests.size());
+}
+
+TextureDescription::Pointer AsyncTextureLoader::decode(const std::string& fileName)
+{
+	uint64_t startTime = queryCurrentTimeInMicroSeconds();
+
+	TextureDescription::Pointer description = TextureDescription::Pointer::create();
+	bool loaded = description->load(fileName);
+
+	if (loaded && bc::decompressionSupported(description->format) && !_renderer->textureFormatSupported(description->format))
+	{
+		TextureDescription::Pointer decompressed = TextureDescription::Pointer::create();
+		loaded = bc::decompressBlocks(description.reference(), decompressed.reference());
+		decompressed->setOrigin(description->origin());
+		description = decompressed;
+	}
+
+	uint64_t decodingTime = queryCurrentTimeInMicroSeconds() - startTime;
+	std::string ext = lowercase(getFileExt(fileName));
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		TextureLoadingStatistics::Format& format = _statistics.formats[ext];
+		if (loaded)
+		{
+			++format.filesLoaded;
+			format.bytesDecoded += description->data.size();
+		}
+		else
+		{
+			++format.filesFailed;
+		}
+		format.decodingTime += decodingTime;
+		format.maxDecodingTime = std::max(format.maxDecodingTime, decodingTime);
+	}
+
+	return loaded ? description : TextureDescription::Pointer();
+}
+
+TextureLoadingStatistics AsyncTextureLoader::statistics() const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _statistics;
+}
+
+void AsyncTextureLoader::resetStatistics()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_statistics = TextureLoadingStatistics();
+}
+
+void AsyncTextureLoader::reportStatistics() const
+{
+	TextureLoadingStatistics stats = statistics();
+	log::info("[AsyncTextureLoader] %u textures created in %llu.%03llu ms, %u requests deduplicated", stats.texturesCreated,
+		stats.creationTime / 1000, stats.creationTime % 1000, stats.requestsDeduplicated);
+
+	for (const auto& i : stats.formats)
+	{
+		const TextureLoadingStatistics::Format& format = i.second;
+		uint64_t averageTime = format.decodingTime / std::max(1u, format.filesLoaded + format.filesFailed);
+		log::info("[AsyncTextureLoader] %s: %u loaded, %u failed, %llu KB, decoding %llu.%03llu ms (average %llu.%03llu ms, max %llu.%03llu ms)",
+			i.first.c_str(), format.filesLoaded, format.filesFailed, format.bytesDecoded / 1024,
+			format.decodingTime / 1000, format.decodingTime % 1000, averageTime / 1000, averageTime % 1000,
+			format.maxDecodingTime / 1000, format.maxDecodingTime % 1000);
+	}
+}
+
+}
@@ -0,0 +1,144 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/core/jobsystem.h>
+#include <et/core/objectscache.h>
+#include <et/imaging/texturedescription.h>
+
+namespace et
+{
+class RenderInterface;
+
+class TextureLoadingRequest : public Object
+{
+public:
+	ET_DECLARE_POINTER(TextureLoadingRequest);
+
+	using Callback = std::function<void(const Texture::Pointer&)>;
+
+	enum class State : uint32_t
+	{
+		Decoding,
+		Decoded,
+		Failed,
+		Completed
+	};
+
+public:
+	TextureLoadingRequest(const std::string& fileName, ObjectsCache& cache, TextureDescriptionUpdateMethod* update) :
+		_fileName(fileName), _cache(cache), _update(update) { }
+
+	const std::string& fileName() const
+		{ return _fileName; }
+
+	State state() const
+		{ return _state.load(); }
+
+	bool completed() const
+		{ return _state.load() == State::Completed; }
+
+	/*
+	 * valid when request is completed, checkers texture is returned for files which failed to load
+	 */
+	const Texture::Pointer& texture() const
+		{ return _texture; }
+
+	/*
+	 * callback is called on the rendering thread when texture is created,
+	 * or immediately if request is already completed
+	 */
+	void onCompleted(Callback);
+
+private:
+	friend class AsyncTextureLoader;
+
+	std::string _fileName;
+	ObjectsCache& _cache;
+	TextureDescriptionUpdateMethod* _update = nullptr;
+	TextureDescription::Pointer _description;
+	Texture::Pointer _texture;
+	Vector<Callback> _callbacks;
+	JobCounter _decoding;
+	std::atomic<State> _state{ State::Decoding };
+};
+
+struct TextureLoadingStatistics
+{
+	struct Format
+	{
+		uint32_t filesLoaded = 0;
+		uint32_t filesFailed = 0;
+		uint64_t bytesDecoded = 0;
+		uint64_t decodingTime = 0;
+		uint64_t maxDecodingTime = 0;
+	};
+
+	/*
+	 * keys are lowercase file extensions, times are in microseconds,
+	 * decoding time is accumulated over all threads
+	 */
+	Map<std::string, Format> formats;
+	uint32_t requestsDeduplicated = 0;
+	uint32_t texturesCreated = 0;
+	uint64_t creationTime = 0;
+};
+
+/*
+ * Decodes textures on the job system and creates them in batches on the rendering thread.
+ * Requests for the file which is already in the cache or is being decoded for the same cache
+ * are sharing single texture. Update method is called on the worker thread right after decoding.
+ * Cache should outlive requests made with it.
+ */
+class AsyncTextureLoader
+{
+public:
+	AsyncTextureLoader(RenderInterface*);
+	~AsyncTextureLoader();
+
+	void setJobSystem(JobSystem*);
+
+	TextureLoadingRequest::Pointer load(const std::string& fileName, ObjectsCache&,
+		TextureDescriptionUpdateMethod* = nullTextureDescriptionUpdateMethod);
+
+	/*
+	 * creates textures of all decoded requests with single RenderInterface::createTextures call,
+	 * should be called on the rendering thread, returns number of completed requests
+	 */
+	uint32_t createLoadedTextures();
+
+	/*
+	 * waits until request is decoded and creates it's texture
+	 */
+	Texture::Pointer finish(TextureLoadingRequest::Pointer);
+	void finishAll();
+
+	TextureLoadingRequest::Pointer pendingRequest(const std::string& fileName, const ObjectsCache&) const;
+	uint32_t pendingRequestsCount() const;
+
+	/*
+	 * synchronous decoding, accounted in statistics
+	 */
+	TextureDescription::Pointer decode(const std::string& fileName);
+
+	TextureLoadingStatistics statistics() const;
+	void resetStatistics();
+	void reportStatistics() const;
+
+private:
+	ET_DENY_COPY(AsyncTextureLoader);
+
+private:
+	RenderInterface* _renderer = nullptr;
+	JobSystem* _jobSystem = nullptr;
+	mutable std::mutex _lock;
+	Vector<TextureLoadingRequest::Pointer> _pendingRequests;
+	TextureLoadingStatistics _statistics;
+};
+
+}
@@ -18,6 +18,9 @@ public:
 	BinaryDataStorage heapInfo;
 	BinaryDataStorage localData;
 	Vector<ConstantBufferEntry::Pointer> allocations;
+	std::atomic<uint32_t> dynamicOffset{ 0 };
+	uint32_t dynamicRegionBegin = ConstantBuffer::StaticCapacity;
+	uint32_t dynamicRegionIndex = 0;
 	uint32_t allowedAllocations = 0;
 	bool modified = false;
 
@@ -37,12 +40,22 @@ ConstantBuffer::~ConstantBuffer()
 
 void ConstantBuffer::init(RenderInterface* renderer, uint32_t allowedAllocations)
 {
+	static_assert(StaticCapacity % Granularity == 0, "Dynamic regions should be aligned to granularity");
+	static_assert(DynamicRegionCapacity % Granularity == 0, "Dynamic regions should be aligned to granularity");
+
 	_private->allowedAllocations = allowedAllocations;
 
-	_private->heap.init(Capacity, Granularity);
+	_private->heap.init(StaticCapacity, Granularity);
 	_private->heapInfo.resize(_private->heap.requiredInfoSize());
 	_private->heap.setInfoStorage(_private->heapInfo.begin());
 
+	_private->localData.resize(Capacity);
+	_private->localData.fill(0);
+
+	_private->dynamicOffset = 0;
+	_private->dynamicRegionIndex = 0;
+	_private->dynamicRegionBegin = StaticCapacity;
+
 	_private->buffer = renderer->createDataBuffer("shared-const-buffer", Capacity);
 }
 
@@ -61,21 +74,59 @@ Buffer::Pointer ConstantBuffer::buffer() const
 
 void ConstantBuffer::flush(uint32_t frameNumber)
 {
+	uint32_t dynamicSize = std::min(_private->dynamicOffset.load(), uint32_t(DynamicRegionCapacity));
+
+	uint64_t dirtyBegin = std::numeric_limits<uint64_t>::max();
+	uint64_t dirtyEnd = 0;
 	if (_private->modified)
 	{
-		uint8_t* mappedMemory = _private->buffer->map(0, Capacity);
-		for (ConstantBufferEntry::Pointer& allocation : _private->allocations)
+		for (const ConstantBufferEntry::Pointer& allocation : _private->allocations)
 		{
 			if (allocation->flushFrame() == InvalidFlushFrame)
 			{
-				memcpy(mappedMemory + allocation->offset(), _private->localData.begin() + allocation->offset(), allocation->length());
-				_private->buffer->modifyRange(allocation->offset(), allocation->length());
-				allocation->flush(frameNumber);
+				dirtyBegin = std::min(dirtyBegin, allocation->offset());
+				dirtyEnd = std::max(dirtyEnd, allocation->offset() + allocation->length());
+			}
+		}
+	}
+	
+	if (dynamicSize > 0)
+	{
+		dirtyBegin = std::min(dirtyBegin, uint64_t(_private->dynamicRegionBegin));
+		dirtyEnd = std::max(dirtyEnd, uint64_t(_private->dynamicRegionBegin + dynamicSize));
+	}
+
+	if (dirtyEnd > dirtyBegin)
+	{
+		uint8_t* mappedMemory = _private->buffer->map(dirtyBegin, dirtyEnd - dirtyBegin);
+		if (_private->modified)
+		{
+			for (ConstantBufferEntry::Pointer& allocation : _private->allocations)
+			{
+				if (allocation->flushFrame() == InvalidFlushFrame)
+				{
+					memcpy(mappedMemory + (allocation->offset() - dirtyBegin), _private->localData.begin() + allocation->offset(), allocation->length());
+					_private->buffer->modifyRange(allocation->offset(), allocation->length());
+					allocation->flush(frameNumber);
+				}
 			}
 		}
+
+		if (dynamicSize > 0)
+		{
+			memcpy(mappedMemory + (_private->dynamicRegionBegin - dirtyBegin), _private->localData.begin() + _private->dynamicRegionBegin, dynamicSize);
+			_private->buffer->modifyRange(_private->dynamicRegionBegin, dynamicSize);
+		}
 		_private->buffer->unmap();
-		_private->modified = false;
 	}
+	_private->modified = false;
+
+	/*
+	 * Region of the next frame was used RendererFrameCount frames ago and is retired by now
+	 */
+	_private->dynamicRegionIndex = (_private->dynamicRegionIndex + 1) % RendererFrameCount;
+	_private->dynamicRegionBegin = StaticCapacity + _private->dynamicRegionIndex * DynamicRegionCapacity;
+	_private->dynamicOffset = 0;
 	
 	auto i = std::remove_if(_private->allocations.begin(), _private->allocations.end(), [this, frameNumber](const ConstantBufferEntry::Pointer& e)
 	{
@@ -97,6 +148,25 @@ const ConstantBufferEntry::Pointer& ConstantBuffer::allocate(uint64_t size, uint
 	return _private->allocateInternal(size, allocationClass);
 }
 
+ConstantBufferDynamicEntry ConstantBuffer::allocateDynamic(uint64_t size)
+{
+	ET_ASSERT(_private->allowedAllocations & ConstantBufferDynamicAllocation);
+	
+	uint32_t alignedSize = alignUpTo(static_cast<uint32_t>(size), uint32_t(Granularity));
+	uint32_t offset = _private->dynamicOffset.fetch_add(alignedSize);
+	if (offset + alignedSize > DynamicRegionCapacity)
+	{
+		ET_FAIL("Failed to allocate dynamic data in shared constant buffer");
+		return ConstantBufferDynamicEntry();
+	}
+
+	ConstantBufferDynamicEntry result;
+	result.offset = _private->dynamicRegionBegin + offset;
+	result.length = static_cast<uint32_t>(size);
+	result.data = _private->localData.begin() + result.offset;
+	return result;
+}
+
 const ConstantBufferEntry::Pointer& ConstantBufferPrivate::allocateInternal(uint64_t size, uint32_t cls)
 {
 	uint64_t offset = 0;
@@ -104,12 +174,6 @@ const ConstantBufferEntry::Pointer& ConstantBufferPrivate::allocateInternal(uint
 	if (!heap.allocate(size, offset))
 		ET_FAIL("Failed to allocate data in shared constant buffer");
 
-	if (localData.empty())
-	{
-		localData.resize(ConstantBuffer::Capacity);
-		localData.fill(0);
-	}
-
 	modified = true;
 	allocations.emplace_back(ConstantBufferEntry::Pointer::create(offset, size, localData.begin() + offset, cls));
 	return allocations.back();
@@ -9,6 +9,7 @@
 
 #include <et/core/containers.h>
 #include <et/camera/camera.h>
+#include <et/rendering/base/rendering.h>
 #include <et/rendering/interface/buffer.h>
 
 namespace et
@@ -68,15 +69,36 @@ private:
 	uint32_t _flushFrame = InvalidFlushFrame;
 };
 
+/*
+ * Per-frame allocation, valid only until the end of the frame it was allocated in.
+ * Plain handle, no reference counting and no explicit release required.
+ */
+struct ConstantBufferDynamicEntry
+{
+	uint8_t* data = nullptr;
+	uint32_t offset = 0;
+	uint32_t length = 0;
+
+	bool valid() const
+		{ return (length > 0) && (data != nullptr); }
+};
+
 class RenderInterface;
 class ConstantBufferPrivate;
 class ConstantBuffer
 {
 public:
-	enum
+	enum : uint32_t
 	{
 		Capacity = 16 * 1024 * 1024,
 		Granularity = 256,
+
+		/*
+		 * Tail of the buffer is split into RendererFrameCount regions,
+		 * used by linear allocator for dynamic (per-frame) allocations
+		 */
+		DynamicRegionCapacity = 2 * 1024 * 1024,
+		StaticCapacity = Capacity - RendererFrameCount * DynamicRegionCapacity,
 	};
 
 public:
@@ -90,6 +112,12 @@ public:
 	void flush(uint32_t);
 
 	const ConstantBufferEntry::Pointer& allocate(uint64_t size, uint32_t allocationClass);
+	
+	/*
+	 * Lock-free bump allocation from the region of the current frame,
+	 * region is reused after RendererFrameCount frames
+	 */
+	ConstantBufferDynamicEntry allocateDynamic(uint64_t size);
 
 private:
 	ET_DECLARE_PIMPL(ConstantBuffer, 384);
@@ -18,6 +18,7 @@ const std::string kOptions = "options";
 const std::string kDefault = "default";
 
 std::string Material::_shaderDefaultHeader;
+static std::atomic<uint32_t> materialSortingIndex{ 0 };
 /*
  * Material
  */
@@ -25,11 +26,19 @@ Material::Material(RenderInterface* ren)
 	: _renderer(ren) {
 	_activeInstances.reserve(8);
 	_instancesPool.reserve(8);
+	_sortingIndex = materialSortingIndex.fetch_add(1);
 	initDefaultHeader();
 }
 
 uint64_t Material::sortingKey() const {
-	return 0;
+	const Material* baseMaterial = isInstance() ? static_cast<const MaterialInstance*>(this)->base().pointer() : this;
+	uint64_t instanceIndex = isInstance() ? (_sortingIndex & 0xFFFF) : 0;
+	return (static_cast<uint64_t>(baseMaterial->_translucent) << 63) |
+		(static_cast<uint64_t>(baseMaterial->_sortingIndex & 0xFFFFF) << 16) | instanceIndex;
+}
+
+bool Material::translucent() const {
+	return isInstance() ? static_cast<const MaterialInstance*>(this)->base()->_translucent : _translucent;
 }
 
 void Material::setTexture(MaterialTexture t, const Texture::Pointer& tex, const ResourceRange& range) {
@@ -117,6 +126,10 @@ void Material::setDepthState(const DepthState& ds, const std::string& pt) {
 
 void Material::setBlendState(const BlendState& bs, const std::string& pt) {
 	_configurations[pt].blendState = bs;
+
+	_translucent = false;
+	for (const auto& config : _configurations)
+		_translucent |= config.second.blendState.enabled;
 }
 
 void Material::setCullMode(CullMode cm, const std::string& pt) {
@@ -58,7 +58,12 @@ public:
 	void setFloat(MaterialVariable, float);
 	float getFloat(MaterialVariable) const;
 
+	/*
+	 * translucency (bit 63), base material index (bits 16-35) and instance index (bits 0-15),
+	 * batches sorted by this key are grouped by pipeline state first and by texture set second
+	 */
 	uint64_t sortingKey() const;
+	bool translucent() const;
 
 	const Configuration& configuration(const std::string&) const;
 	const ConfigurationMap& configurations() const { return _configurations; }
@@ -106,6 +111,8 @@ private: // permanent private data
 	ConfigurationMap _configurations;
 	PipelineClass _pipelineClass = PipelineClass::Graphics;
 	uint32_t _instancesCounter = 0;
+	uint32_t _sortingIndex = 0;
+	bool _translucent = false;
 };
 
 class MaterialInstance : public Material
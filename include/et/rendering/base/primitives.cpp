@@ -1241,3 +1241,213 @@ VertexArray::Pointer primitives::linearizeTrianglesIndexArray(VertexArray::Point
 	}
 	return result;
 }
+
+/*
+ * Vertex cache optimization, "Linear-Speed Vertex Cache Optimisation" by Tom Forsyth
+ */
+const uint32_t forsythCacheSize = 32;
+const float forsythCacheDecayPower = 1.5f;
+const float forsythLastTriangleScore = 0.75f;
+const float forsythValenceBoostScale = 2.0f;
+const float forsythValenceBoostPower = 0.5f;
+
+const uint32_t forsythValenceTableSize = 64;
+
+/*
+ * scores are tabulated, entry 0 of the cache table is for vertices outside of the cache
+ */
+struct ForsythScoreTables
+{
+	float cache[forsythCacheSize + 1] = { };
+	float valence[forsythValenceTableSize] = { };
+
+	ForsythScoreTables()
+	{
+		for (uint32_t i = 0; i < forsythCacheSize; ++i)
+		{
+			float scaler = 1.0f / static_cast<float>(forsythCacheSize - 3);
+			cache[i + 1] = (i < 3) ? forsythLastTriangleScore :
+				std::pow(1.0f - static_cast<float>(i - 3) * scaler, forsythCacheDecayPower);
+		}
+
+		for (uint32_t i = 1; i < forsythValenceTableSize; ++i)
+			valence[i] = forsythValenceBoostScale * std::pow(static_cast<float>(i), -forsythValenceBoostPower);
+	}
+};
+
+inline float forsythVertexScore(const ForsythScoreTables& tables, int32_t cachePosition, uint32_t liveTriangles)
+{
+	if (liveTriangles == 0)
+		return -1.0f;
+
+	float valenceScore = (liveTriangles < forsythValenceTableSize) ? tables.valence[liveTriangles] :
+		forsythValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -forsythValenceBoostPower);
+
+	return tables.cache[cachePosition + 1] + valenceScore;
+}
+
+void primitives::optimizeVertexCache(uint32_t* indices, uint32_t indexCount)
+{
+	uint32_t trianglesCount = indexCount / 3;
+	if (trianglesCount < 2)
+		return;
+
+	/*
+	 * vertices are addressed relative to the smallest index, so ranges of the
+	 * large index buffer could be optimized without allocating per-vertex data for the whole buffer
+	 */
+	uint32_t minIndex = *std::min_element(indices, indices + 3 * trianglesCount);
+	uint32_t maxIndex = *std::max_element(indices, indices + 3 * trianglesCount);
+	uint32_t vertexCount = maxIndex - minIndex + 1;
+
+	Vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (uint32_t i = 0; i < 3 * trianglesCount; ++i)
+		++liveTriangles[indices[i] - minIndex];
+
+	Vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+
+	Vector<uint32_t> adjacency(3 * trianglesCount);
+	{
+		Vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (uint32_t i = 0; i < 3 * trianglesCount; ++i)
+			adjacency[fill[indices[i] - minIndex]++] = i / 3;
+	}
+
+	static const ForsythScoreTables tables;
+
+	Vector<int32_t> cachePosition(vertexCount, -1);
+	Vector<float> vertexScore(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		vertexScore[v] = forsythVertexScore(tables, -1, liveTriangles[v]);
+
+	Vector<float> triangleScore(trianglesCount);
+	Vector<bool> triangleAdded(trianglesCount, false);
+	for (uint32_t t = 0; t < trianglesCount; ++t)
+	{
+		triangleScore[t] = vertexScore[indices[3 * t + 0] - minIndex] + vertexScore[indices[3 * t + 1] - minIndex] +
+			vertexScore[indices[3 * t + 2] - minIndex];
+	}
+
+	uint32_t bestTriangle = static_cast<uint32_t>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+
+	uint32_t cache[forsythCacheSize + 3] = { };
+	uint32_t cacheSize = 0;
+	uint32_t nextUnaddedTriangle = 0;
+
+	Vector<uint32_t> output(3 * trianglesCount);
+	for (uint32_t outputTriangle = 0; outputTriangle < trianglesCount; ++outputTriangle)
+	{
+		if (bestTriangle == IndexArray::MaxIndex)
+		{
+			while (triangleAdded[nextUnaddedTriangle])
+				++nextUnaddedTriangle;
+			bestTriangle = nextUnaddedTriangle;
+		}
+
+		const uint32_t* triangle = indices + 3 * bestTriangle;
+		triangleAdded[bestTriangle] = true;
+
+		uint32_t newCache[forsythCacheSize + 3] = { };
+		uint32_t newCacheSize = 0;
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			uint32_t v = triangle[k] - minIndex;
+			output[3 * outputTriangle + k] = triangle[k];
+			if (std::find(newCache, newCache + newCacheSize, v) == newCache + newCacheSize)
+				newCache[newCacheSize++] = v;
+
+			uint32_t* begin = adjacency.data() + adjacencyOffset[v];
+			uint32_t* end = begin + liveTriangles[v];
+			*std::find(begin, end, bestTriangle) = *(end - 1);
+			--liveTriangles[v];
+		}
+
+		uint32_t triangleVertices = newCacheSize;
+		for (uint32_t i = 0; i < cacheSize; ++i)
+		{
+			if (std::find(newCache, newCache + triangleVertices, cache[i]) == newCache + triangleVertices)
+				newCache[newCacheSize++] = cache[i];
+		}
+
+		/*
+		 * vertices pushed out of the cache lose cache score, vertices in cache are updated
+		 * along with scores of their remaining triangles, best of which is emitted next
+		 */
+		for (uint32_t i = forsythCacheSize; i < newCacheSize; ++i)
+		{
+			uint32_t v = newCache[i];
+			cachePosition[v] = -1;
+			vertexScore[v] = forsythVertexScore(tables, -1, liveTriangles[v]);
+		}
+
+		cacheSize = std::min(newCacheSize, forsythCacheSize);
+		for (uint32_t i = 0; i < cacheSize; ++i)
+		{
+			uint32_t v = newCache[i];
+			cache[i] = v;
+			cachePosition[v] = static_cast<int32_t>(i);
+			vertexScore[v] = forsythVertexScore(tables, static_cast<int32_t>(i), liveTriangles[v]);
+		}
+
+		float bestScore = -1.0f;
+		bestTriangle = IndexArray::MaxIndex;
+		for (uint32_t i = 0; i < newCacheSize; ++i)
+		{
+			uint32_t v = newCache[i];
+			for (uint32_t a = adjacencyOffset[v], e = adjacencyOffset[v] + liveTriangles[v]; a < e; ++a)
+			{
+				uint32_t t = adjacency[a];
+				float score = vertexScore[indices[3 * t + 0] - minIndex] + vertexScore[indices[3 * t + 1] - minIndex] +
+					vertexScore[indices[3 * t + 2] - minIndex];
+				triangleScore[t] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void primitives::optimizeVertexFetch(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, Vector<uint32_t>& vertexOrder)
+{
+	Vector<uint32_t> remap(vertexCount, IndexArray::MaxIndex);
+	vertexOrder.clear();
+	vertexOrder.reserve(vertexCount);
+
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t& target = remap[indices[i]];
+		if (target == IndexArray::MaxIndex)
+		{
+			target = static_cast<uint32_t>(vertexOrder.size());
+			vertexOrder.push_back(indices[i]);
+		}
+		indices[i] = target;
+	}
+}
+
+float primitives::averageCacheMissRatio(const uint32_t* indices, uint32_t indexCount, uint32_t cacheSize)
+{
+	if (indexCount < 3)
+		return 0.0f;
+
+	Vector<uint32_t> cache(cacheSize, IndexArray::MaxIndex);
+	uint32_t cacheHead = 0;
+	uint32_t misses = 0;
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		if (std::find(cache.begin(), cache.end(), indices[i]) == cache.end())
+		{
+			cache[cacheHead] = indices[i];
+			cacheHead = (cacheHead + 1) % cacheSize;
+			++misses;
+		}
+	}
+	return static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+}
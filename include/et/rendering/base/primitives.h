@@ -77,5 +77,16 @@ namespace et
 		VertexArray::Pointer linearizeTrianglesIndexArray(VertexArray::Pointer data, IndexArray::Pointer indexArray);
 		
 		uint64_t vector3Hash(const vec3&);
+
+		/*
+		 * Triangle list optimizations:
+		 * optimizeVertexCache reorders triangles for post-transform vertex cache (Forsyth),
+		 * optimizeVertexFetch renumbers vertices in order of their first use, vertexOrder receives
+		 * source vertex for each of the new vertices, so vertex data could be rearranged accordingly,
+		 * averageCacheMissRatio simulates FIFO cache and returns transformed vertices per triangle (ACMR)
+		 */
+		void optimizeVertexCache(uint32_t* indices, uint32_t indexCount);
+		void optimizeVertexFetch(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, Vector<uint32_t>& vertexOrder);
+		float averageCacheMissRatio(const uint32_t* indices, uint32_t indexCount, uint32_t cacheSize);
 	}
 }
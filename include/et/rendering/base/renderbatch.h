@@ -79,6 +79,17 @@ private:
 	uint32_t _numIndexes = 0;
 };
 
+/*
+ * batch with transformations, used to record list of batches in one call,
+ * transformations are written to WorldTransform and WorldRotationTransform variables
+ */
+struct RenderBatchInstance
+{
+	RenderBatch* batch = nullptr;
+	const mat4* transform = nullptr;
+	const mat4* rotationTransform = nullptr;
+};
+
 class RenderBatchPool
 {
 public:
@@ -317,7 +317,26 @@ uint32_t bitsPerPixelForTextureFormat(TextureFormat format)
 	case TextureFormat::RGBA32F:
 		return 128;
 
+	case TextureFormat::PVR_2bpp_RGB:
+	case TextureFormat::PVR_2bpp_sRGB:
+	case TextureFormat::PVR_2bpp_RGBA:
+	case TextureFormat::PVR_2bpp_sRGBA:
+		return 2;
+
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+	case TextureFormat::RGTC1:
+	case TextureFormat::ETC1:
+	case TextureFormat::PVR_4bpp_RGB:
+	case TextureFormat::PVR_4bpp_sRGB:
+	case TextureFormat::PVR_4bpp_RGBA:
+	case TextureFormat::PVR_4bpp_sRGBA:
+		return 4;
+
+	case TextureFormat::DXT3:
 	case TextureFormat::DXT5:
+	case TextureFormat::RGTC2:
+	case TextureFormat::BC7:
 		return 8;
 
 	default:
@@ -378,7 +397,10 @@ bool isCompressedTextureFormat(TextureFormat internalFormat)
 	case TextureFormat::DXT1_RGBA:
 	case TextureFormat::DXT3:
 	case TextureFormat::DXT5:
+	case TextureFormat::RGTC1:
 	case TextureFormat::RGTC2:
+	case TextureFormat::BC7:
+	case TextureFormat::ETC1:
 		return true;
 
 	default:
@@ -390,7 +412,14 @@ vec2i compressedFormatBlockSize(TextureFormat internalFormat)
 {
 	switch (internalFormat)
 	{
+	case TextureFormat::DXT1_RGB:
+	case TextureFormat::DXT1_RGBA:
+	case TextureFormat::DXT3:
 	case TextureFormat::DXT5:
+	case TextureFormat::RGTC1:
+	case TextureFormat::RGTC2:
+	case TextureFormat::BC7:
+	case TextureFormat::ETC1:
 		return vec2i(4);
 	
 	default:
@@ -423,6 +452,7 @@ uint32_t channelsForTextureFormat(TextureFormat internalFormat)
 	case TextureFormat::R16F:
 	case TextureFormat::R32F:
 	case TextureFormat::R11G11B10F:
+	case TextureFormat::RGTC1:
 		return 1;
 
 	case TextureFormat::RG8:
@@ -433,6 +463,7 @@ uint32_t channelsForTextureFormat(TextureFormat internalFormat)
 		return 2;
 
 	case TextureFormat::DXT1_RGB:
+	case TextureFormat::ETC1:
 		return 3;
 
 	case TextureFormat::RGBA8:
@@ -443,6 +474,7 @@ uint32_t channelsForTextureFormat(TextureFormat internalFormat)
 	case TextureFormat::DXT1_RGBA:
 	case TextureFormat::DXT3:
 	case TextureFormat::DXT5:
+	case TextureFormat::BC7:
 		return 4;
 
 	default:
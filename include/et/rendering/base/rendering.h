@@ -202,6 +202,9 @@ enum class TextureFormat : uint32_t
 	PVR_4bpp_RGBA,
 	PVR_4bpp_sRGBA,
 	R11G11B10F,
+	BC7,
+	RGTC1,
+	ETC1,
 	max
 };
 
@@ -555,11 +558,17 @@ struct RenderPassStatistics
 	char name[MaxRenderPassName] = { };
 	uint64_t cpuBuild = 0;
 	uint64_t gpuExecution = 0;
+	uint32_t renderBatches = 0;
+	uint32_t pipelineBinds = 0;
+	uint32_t descriptorSetBinds = 0;
 };
 
 struct FrameStatistics
 {
 	uint32_t activeRenderPasses = 0;
+	uint32_t renderBatches = 0;
+	uint32_t pipelineBinds = 0;
+	uint32_t descriptorSetBinds = 0;
 	RenderPassStatistics passes[MaxRenderPasses] = { };
 };
 
@@ -27,7 +27,7 @@ RenderPass::ConstructionInfo RenderPass::renderTargetPassInfo(const std::string&
 }
 
 RenderPass::RenderPass(RenderInterface*, const ConstructionInfo& info) :
-	_info(info)
+	_info(info), _recordingJobSystem(&sharedJobSystem())
 {
 }
 
@@ -44,6 +44,48 @@ void RenderPass::setSharedTexture(MaterialTexture texId, const Texture::Pointer&
 	_sharedTextures[texId].second = smp;
 }
 
+void RenderPass::setRecordingJobSystem(JobSystem* jobSystem)
+{
+	_recordingJobSystem = jobSystem;
+}
+
+void RenderPass::pushRenderBatches(const RenderBatchInstance* batches, uint32_t count)
+{
+	uint32_t threadsCount = (_recordingJobSystem == nullptr) ? 1 : static_cast<uint32_t>(_recordingJobSystem->workersCount()) + 1;
+	uint32_t chunkSize = std::max(uint32_t(MinRecordingChunkSize), count / (2 * threadsCount) + 1);
+	uint32_t chunksCount = (count + chunkSize - 1) / chunkSize;
+
+	/*
+	 * shared transformations are left in the same state as after serial recording
+	 */
+	if (count > 0)
+	{
+		setSharedVariable(ObjectVariable::WorldTransform, *batches[count - 1].transform);
+		setSharedVariable(ObjectVariable::WorldRotationTransform, *batches[count - 1].rotationTransform);
+	}
+
+	if ((threadsCount > 1) && (chunksCount > 1) && beginParallelRecording(batches, count, chunksCount))
+	{
+		_recordingJobSystem->parallelFor(0, chunksCount, [this, chunkSize, count](uint32_t begin, uint32_t end) {
+			for (uint32_t chunk = begin; chunk < end; ++chunk)
+			{
+				uint32_t first = chunk * chunkSize;
+				recordParallelChunk(chunk, first, std::min(chunkSize, count - first));
+			}
+		}, 1);
+		endParallelRecording();
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const RenderBatchInstance& instance = batches[i];
+		setSharedVariable(ObjectVariable::WorldTransform, *instance.transform);
+		setSharedVariable(ObjectVariable::WorldRotationTransform, *instance.rotationTransform);
+		pushRenderBatch(instance.batch->material(), instance.batch->vertexStream(), instance.batch->firstIndex(), instance.batch->numIndexes());
+	}
+}
+
 uint64_t RenderPass::identifier() const
 {
 	return reinterpret_cast<uintptr_t>(this);
@@ -0,0 +1,129 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#include <et/rendering/base/renderqueue.h>
+
+namespace et
+{
+
+RenderQueue::RenderQueue()
+{
+	_entries.reserve(1024);
+	_sortedEntries.reserve(1024);
+	_items.reserve(1024);
+}
+
+void RenderQueue::clear()
+{
+	_entries.clear();
+	_sortedEntries.clear();
+	_items.clear();
+}
+
+void RenderQueue::push(const RenderBatch::Pointer& batch, const mat4& transform, const mat4& rotationTransform,
+	float normalizedDepth, uint32_t layer)
+{
+	ET_ASSERT(batch->material().valid());
+
+	SortItem item;
+	item.key = makeKey(batch->material().pointer(), normalizedDepth, layer);
+	item.index = _entries.size();
+	_items.emplace_back(item);
+
+	_entries.emplace_back();
+	RenderBatchInstance& entry = _entries.back();
+	entry.batch = batch.pointer();
+	entry.transform = &transform;
+	entry.rotationTransform = &rotationTransform;
+}
+
+uint64_t RenderQueue::makeKey(const Material* material, float normalizedDepth, uint32_t layer)
+{
+	ET_ASSERT(layer < MaxLayers);
+
+	const uint64_t depthMask = (1ull << DepthBits) - 1;
+	const uint64_t materialMask = (1ull << MaterialBits) - 1;
+
+	uint64_t materialKey = material->sortingKey();
+	uint64_t translucent = materialKey >> 63;
+	uint64_t depth = static_cast<uint64_t>(clamp(normalizedDepth, 0.0f, 1.0f) * static_cast<float>(depthMask));
+
+	uint64_t result = (static_cast<uint64_t>(layer) << 60) | (translucent << 59);
+	if (translucent)
+		result |= ((depthMask - depth) << MaterialBits) | (materialKey & materialMask);
+	else
+		result |= ((materialKey & materialMask) << DepthBits) | depth;
+
+	return result;
+}
+
+void RenderQueue::sort()
+{
+	const uint32_t radixBits = 8;
+	const uint32_t radixSize = 1 << radixBits;
+	const uint32_t radixPasses = 64 / radixBits;
+
+	size_t itemsCount = _items.size();
+	if (itemsCount < 2)
+	{
+		_sortedEntries = _entries;
+		return;
+	}
+
+	uint32_t histograms[radixPasses][radixSize] = { };
+	for (const SortItem& item : _items)
+	{
+		for (uint32_t pass = 0; pass < radixPasses; ++pass)
+			++histograms[pass][(item.key >> (pass * radixBits)) & (radixSize - 1)];
+	}
+
+	_sortBuffer.resize(itemsCount);
+	SortItem* source = _items.data();
+	SortItem* destination = _sortBuffer.data();
+
+	for (uint32_t pass = 0; pass < radixPasses; ++pass)
+	{
+		uint32_t* histogram = histograms[pass];
+		uint32_t shift = pass * radixBits;
+
+		/*
+		 * pass could be skipped if all keys have the same digit
+		 */
+		if (histogram[(source->key >> shift) & (radixSize - 1)] == itemsCount)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < radixSize; ++i)
+		{
+			uint32_t count = histogram[i];
+			histogram[i] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < itemsCount; ++i)
+		{
+			const SortItem& item = source[i];
+			destination[histogram[(item.key >> shift) & (radixSize - 1)]++] = item;
+		}
+
+		std::swap(source, destination);
+	}
+
+	if (source != _items.data())
+		_items.swap(_sortBuffer);
+
+	_sortedEntries.clear();
+	for (const SortItem& item : _items)
+		_sortedEntries.emplace_back(_entries[item.index]);
+}
+
+void RenderQueue::submit(const RenderPass::Pointer& pass) const
+{
+	pass->pushRenderBatches(_sortedEntries.data(), static_cast<uint32_t>(_sortedEntries.size()));
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/rendering/interface/renderpass.h>
+
+namespace et
+{
+/*
+ * RenderQueue collects batches of the frame, sorts them by 64-bit key and submits them to the render pass.
+ * Key layout (from the most significant bits):
+ *  - layer (4 bits)
+ *  - translucency (1 bit)
+ *  - for opaque batches: material sorting key (36 bits), depth, front to back (23 bits)
+ *  - for translucent batches: depth, back to front (23 bits), material sorting key (36 bits)
+ * Transformations are referenced, not copied, so they should stay valid until the queue is submitted.
+ * Sorted batches are submitted with RenderPass::pushRenderBatches, so large queues are recorded in parallel.
+ */
+class RenderQueue
+{
+public:
+	enum : uint32_t
+	{
+		MaxLayers = 16,
+		DepthBits = 23,
+		MaterialBits = 36,
+	};
+
+public:
+	RenderQueue();
+
+	void clear();
+
+	/*
+	 * normalizedDepth is a view space depth divided by camera's far plane, clamped to [0, 1]
+	 */
+	void push(const RenderBatch::Pointer&, const mat4& transform, const mat4& rotationTransform,
+		float normalizedDepth, uint32_t layer = 0);
+
+	void sort();
+	void submit(const RenderPass::Pointer&) const;
+
+	size_t size() const
+		{ return _entries.size(); }
+
+	/*
+	 * valid after sort() call
+	 */
+	const RenderBatchInstance& entry(size_t sortedIndex) const
+		{ return _sortedEntries[sortedIndex]; }
+
+	static uint64_t makeKey(const Material*, float normalizedDepth, uint32_t layer);
+
+private:
+	struct SortItem
+	{
+		uint64_t key = 0;
+		uint64_t index = 0;
+	};
+
+private:
+	Vector<RenderBatchInstance> _entries;
+	Vector<RenderBatchInstance> _sortedEntries;
+	Vector<SortItem> _items;
+	Vector<SortItem> _sortBuffer;
+};
+
+}
@@ -13,6 +13,7 @@
 #include <et/rendering/rendercontextparams.h>
 #include <et/rendering/renderoptions.h>
 #include <et/rendering/base/materiallibrary.h>
+#include <et/rendering/base/asynctextureloader.h>
 #include <et/rendering/interface/buffer.h>
 #include <et/rendering/interface/renderpass.h>
 #include <et/rendering/interface/pipelinestate.h>
@@ -75,9 +76,34 @@ public:
 	virtual Texture::Pointer createTexture(const TextureDescription::Pointer&) = 0;
 	virtual TextureSet::Pointer createTextureSet(const TextureSet::Description&) = 0;
 
+	/*
+	 * textures in unsupported block compressed formats are decompressed
+	 * to RGBA8 on the CPU when loaded (see bc::decompressBlocks)
+	 */
+	virtual bool textureFormatSupported(TextureFormat) const
+		{ return true; }
+
+	/*
+	 * creates textures in bulk, output contains texture (or null pointer) for each description
+	 */
+	virtual void createTextures(const Vector<TextureDescription::Pointer>&, Vector<Texture::Pointer>&);
+
 	Texture::Pointer loadTexture(const std::string& fileName, ObjectsCache& cache, 
 		TextureDescriptionUpdateMethod = nullTextureDescriptionUpdateMethod);
 
+	/*
+	 * returns immediately, texture is decoded on the job system and created
+	 * within createLoadedTextures, which is called by render context every frame
+	 */
+	TextureLoadingRequest::Pointer loadTextureAsync(const std::string& fileName, ObjectsCache& cache,
+		TextureDescriptionUpdateMethod = nullTextureDescriptionUpdateMethod);
+
+	uint32_t createLoadedTextures()
+		{ return _asyncTextureLoader.createLoadedTextures(); }
+
+	AsyncTextureLoader& asyncTextureLoader()
+		{ return _asyncTextureLoader; }
+
 	const Texture::Pointer& checkersTexture();
 	const Texture::Pointer& flatNormalTexture();
 	const Texture::Pointer& whiteTexture();
@@ -144,6 +170,7 @@ private:
 	ConstantBuffer _sharedConstantBuffer;
 	RenderBatchPool _renderBatchPool;
 	RenderOptions _options;
+	AsyncTextureLoader _asyncTextureLoader{ this };
 	Texture::Pointer _checkersTexture;
 	Texture::Pointer _whiteTexture;
 	Texture::Pointer _flatNormalTexture;
@@ -157,11 +184,15 @@ private:
 inline Texture::Pointer RenderInterface::loadTexture(const std::string& fileName, ObjectsCache& cache, 
 	TextureDescriptionUpdateMethod update)
 {
+	TextureLoadingRequest::Pointer pendingRequest = _asyncTextureLoader.pendingRequest(fileName, cache);
+	if (pendingRequest.valid())
+		return _asyncTextureLoader.finish(pendingRequest);
+
 	LoadableObject::Collection existingObjects = cache.findObjects(fileName);
 	if (existingObjects.empty())
 	{
-		TextureDescription::Pointer desc = TextureDescription::Pointer::create();
-		if (desc->load(fileName))
+		TextureDescription::Pointer desc = _asyncTextureLoader.decode(fileName);
+		if (desc.valid())
 		{
 			update(desc);
 
@@ -183,6 +214,20 @@ inline Texture::Pointer RenderInterface::loadTexture(const std::string& fileName
 	return checkersTexture();
 }
 
+inline TextureLoadingRequest::Pointer RenderInterface::loadTextureAsync(const std::string& fileName, ObjectsCache& cache,
+	TextureDescriptionUpdateMethod update)
+{
+	return _asyncTextureLoader.load(fileName, cache, update);
+}
+
+inline void RenderInterface::createTextures(const Vector<TextureDescription::Pointer>& descriptions, Vector<Texture::Pointer>& textures)
+{
+	textures.clear();
+	textures.reserve(descriptions.size());
+	for (const TextureDescription::Pointer& desc : descriptions)
+		textures.emplace_back(createTexture(desc));
+}
+
 inline const Texture::Pointer& RenderInterface::checkersTexture()
 {
 	if (_checkersTexture.invalid())
@@ -323,6 +368,7 @@ inline void RenderInterface::initInternalStructures()
 
 inline void RenderInterface::shutdownInternalStructures()
 {
+	_asyncTextureLoader.finishAll();
 	_renderBatchPool.clear();
 	_sharedMaterialLibrary.shutdown();
 	_sharedConstantBuffer.shutdown();
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <et/core/jobsystem.h>
 #include <et/camera/camera.h>
 #include <et/rendering/objects/light.h>
 #include <et/rendering/interface/compute.h>
@@ -99,6 +100,11 @@ public:
 	static const std::string kPassNameUI;
 	static const std::string kPassNameDepth;
 
+	enum : uint32_t
+	{
+		MinRecordingChunkSize = 64
+	};
+
 public:
 	RenderPass(RenderInterface*, const ConstructionInfo&);
 
@@ -140,6 +146,33 @@ public:
 
 	void executeSingleRenderBatch(const RenderBatch::Pointer& inBatch);
 
+	/*
+	 * records batches into the current subpass, preserving order.
+	 * Large lists are split into chunks, which are recorded on job system workers
+	 * into secondary command lists and then stitched into the pass.
+	 * Shared variables and textures should not be modified from other threads until the call returns
+	 */
+	void pushRenderBatches(const RenderBatchInstance* batches, uint32_t count);
+
+	/*
+	 * job system used for recording in pushRenderBatches, nullptr disables parallel recording
+	 */
+	void setRecordingJobSystem(JobSystem*);
+	JobSystem* recordingJobSystem() const
+		{ return _recordingJobSystem; }
+
+protected:
+	/*
+	 * parallel recording interface, used by pushRenderBatches:
+	 * beginParallelRecording is called on the recording thread and could reject parallel recording,
+	 * recordParallelChunk is called from the job system workers, one call per chunk,
+	 * endParallelRecording is called on the recording thread and should submit chunks in order
+	 */
+	virtual bool beginParallelRecording(const RenderBatchInstance*, uint32_t count, uint32_t chunksCount)
+		{ return false; }
+	virtual void recordParallelChunk(uint32_t chunkIndex, uint32_t first, uint32_t count) { }
+	virtual void endParallelRecording() { }
+
 protected:
 	using SharedTexturesSet = std::map<MaterialTexture, std::pair<Texture::Pointer, Sampler::Pointer>>;
 	const SharedTexturesSet& sharedTextures() const { return _sharedTextures; }
@@ -149,6 +182,7 @@ private:
 	ConstructionInfo _info;
 	SharedTexturesSet _sharedTextures;
 	VariablesHolder _sharedVariables;
+	JobSystem* _recordingJobSystem = nullptr;
 };
 
 template <class T>
@@ -156,12 +156,21 @@ inline uint32_t Texture::Description::dataOffsetForLayer(uint32_t layer, uint32_
 }
 
 inline uint32_t Texture::Description::dataSizeForMipLevel(uint32_t level) const {
-	uint32_t bpp = bitsPerPixelForTextureFormat(format) / 8;
-
-	uint32_t actualSize = static_cast<uint32_t>(sizeForMipLevel(level).square()) * bpp;
-	uint32_t minimumSize = static_cast<uint32_t>(Texture::minCompressedBlockHeight * Texture::minCompressedBlockWidth) * bpp;
-	uint32_t sz = isCompressedTextureFormat(format) ? std::max(static_cast<uint32_t>(Texture::minCompressedBlockDataSize),
-		std::max(minimumSize, actualSize)) : actualSize;
+	uint32_t bitsPerPixel = bitsPerPixelForTextureFormat(format);
+	vec2i levelSize = sizeForMipLevel(level);
+	vec2i blockSize = compressedFormatBlockSize(format);
+	uint32_t blocksCount = static_cast<uint32_t>(((levelSize.x + blockSize.x - 1) / blockSize.x) * ((levelSize.y + blockSize.y - 1) / blockSize.y));
+	uint32_t sz = blocksCount * static_cast<uint32_t>(blockSize.square()) * bitsPerPixel / 8;
+
+	/*
+	 * block compressed formats are padded to the whole blocks above,
+	 * PVRTC is addressed per pixel, but has minimal data size
+	 */
+	if (isCompressedTextureFormat(format) && (blockSize.square() == 1))
+	{
+		uint32_t minimumSize = static_cast<uint32_t>(Texture::minCompressedBlockHeight * Texture::minCompressedBlockWidth) * bitsPerPixel / 8;
+		sz = std::max(static_cast<uint32_t>(Texture::minCompressedBlockDataSize), std::max(minimumSize, sz));
+	}
 
 	return sz * layerCount;
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <et/rendering/interface/renderer.h>
+#include <et/rendering/null/null_renderpass.h>
 
 namespace et
 {
@@ -40,7 +41,7 @@ public:
 
 	void resize(const vec2i&) override { }
 
-	RenderPass::Pointer allocateRenderPass(const RenderPass::ConstructionInfo&) override { return RenderPass::Pointer(); }
+	RenderPass::Pointer allocateRenderPass(const RenderPass::ConstructionInfo& info) override { return NullRenderPass::Pointer::create(this, info); }
 	void submitRenderPass(RenderPass::Pointer) override { }
 
 	uint32_t frameIndex() const override { return 0; }
@@ -0,0 +1,146 @@
+/*
+ * This file is part of `et engine`
+ * Copyright 2009-2016 by Sergey Reznik
+ * Please, modify content only if you know what are you doing.
+ *
+ */
+
+#pragma once
+
+#include <et/rendering/interface/renderpass.h>
+
+namespace et
+{
+struct NullRenderCommand
+{
+	const MaterialInstance* material = nullptr;
+	const VertexStream* vertexStream = nullptr;
+	uint32_t first = 0;
+	uint32_t count = 0;
+	uint32_t variablesOffset = 0;
+	uint32_t variablesSize = 0;
+};
+
+/*
+ * CPU-only command list, shared variables of each command are packed into the variables storage,
+ * the same way as backends are packing object variables into constant buffer
+ */
+struct NullCommandList
+{
+	Vector<NullRenderCommand> commands;
+	Vector<uint8_t> variables;
+
+	void clear()
+	{
+		commands.clear();
+		variables.clear();
+	}
+
+	void append(const NullCommandList& list)
+	{
+		uint32_t variablesOffset = static_cast<uint32_t>(variables.size());
+		variables.insert(variables.end(), list.variables.begin(), list.variables.end());
+		for (const NullRenderCommand& command : list.commands)
+		{
+			commands.emplace_back(command);
+			commands.back().variablesOffset += variablesOffset;
+		}
+	}
+};
+
+class NullRenderPass : public RenderPass
+{
+public:
+	ET_DECLARE_POINTER(NullRenderPass);
+
+public:
+	NullRenderPass(RenderInterface* renderer, const RenderPass::ConstructionInfo& passInfo) :
+		RenderPass(renderer, passInfo) { }
+
+	void begin(const RenderPassBeginInfo&) override
+		{ _commandList.clear(); }
+
+	void pushRenderBatch(const MaterialInstance::Pointer& material, const VertexStream::Pointer& vertexStream, uint32_t first, uint32_t count) override
+		{ recordCommand(_commandList, material.pointer(), vertexStream.pointer(), first, count, nullptr, nullptr); }
+
+	void pushImageBarrier(const Texture::Pointer&, const ResourceBarrier&) override { }
+	void copyImage(const Texture::Pointer&, const Texture::Pointer&, const CopyDescriptor&) override { }
+	void copyImageToBuffer(const Texture::Pointer&, const Buffer::Pointer&, const CopyDescriptor&) override { }
+	void dispatchCompute(const Compute::Pointer&, const vec3i&) override { }
+	void endSubpass() override { }
+	void nextSubpass() override { }
+	void end() override { }
+
+	void debug() override { }
+
+	const NullCommandList& commandList() const
+		{ return _commandList; }
+
+protected:
+	bool beginParallelRecording(const RenderBatchInstance* batches, uint32_t, uint32_t chunksCount) override
+	{
+		_parallelBatches = batches;
+		if (_chunks.size() < chunksCount)
+			_chunks.resize(chunksCount);
+		return true;
+	}
+
+	void recordParallelChunk(uint32_t chunkIndex, uint32_t first, uint32_t count) override
+	{
+		NullCommandList& list = _chunks[chunkIndex];
+		list.clear();
+		for (uint32_t i = first, e = first + count; i < e; ++i)
+		{
+			const RenderBatchInstance& instance = _parallelBatches[i];
+			const RenderBatch* batch = instance.batch;
+			recordCommand(list, batch->material().pointer(), batch->vertexStream().pointer(),
+				batch->firstIndex(), batch->numIndexes(), instance.transform, instance.rotationTransform);
+		}
+	}
+
+	void endParallelRecording() override
+	{
+		for (NullCommandList& list : _chunks)
+		{
+			_commandList.append(list);
+			list.clear();
+		}
+		_parallelBatches = nullptr;
+	}
+
+private:
+	void recordCommand(NullCommandList& list, const MaterialInstance* material, const VertexStream* vertexStream,
+		uint32_t first, uint32_t count, const mat4* transform, const mat4* rotationTransform) const
+	{
+		NullRenderCommand command;
+		command.material = material;
+		command.vertexStream = vertexStream;
+		command.first = first;
+		command.count = count;
+		command.variablesOffset = static_cast<uint32_t>(list.variables.size());
+
+		for (const auto& v : sharedVariables())
+		{
+			if (!v.second.isSet())
+				continue;
+
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(v.second.data);
+			if ((transform != nullptr) && (v.first == static_cast<uint32_t>(ObjectVariable::WorldTransform)))
+				data = reinterpret_cast<const uint8_t*>(transform);
+			else if ((rotationTransform != nullptr) && (v.first == static_cast<uint32_t>(ObjectVariable::WorldRotationTransform)))
+				data = reinterpret_cast<const uint8_t*>(rotationTransform);
+
+			list.variables.insert(list.variables.end(), data, data + v.second.dataSize);
+		}
+
+		command.variablesSize = static_cast<uint32_t>(list.variables.size()) - command.variablesOffset;
+		list.commands.emplace_back(command);
+	}
+
+private:
+	NullCommandList _commandList;
+	Vector<NullCommandList> _chunks;
+	const RenderBatchInstance* _parallelBatches = nullptr;
+};
+
+}
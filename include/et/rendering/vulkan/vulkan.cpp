@@ -491,7 +491,14 @@ VkFormat textureFormatValue(TextureFormat fmt) {
 	case TextureFormat::Depth16: return VK_FORMAT_D16_UNORM;
 	case TextureFormat::Depth24: return VK_FORMAT_D24_UNORM_S8_UINT;
 	case TextureFormat::Depth32F: return VK_FORMAT_D32_SFLOAT;
+	case TextureFormat::DXT1_RGB: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case TextureFormat::DXT1_RGBA: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+	case TextureFormat::DXT3: return VK_FORMAT_BC2_UNORM_BLOCK;
 	case TextureFormat::DXT5: return VK_FORMAT_BC3_UNORM_BLOCK;
+	case TextureFormat::RGTC1: return VK_FORMAT_BC4_UNORM_BLOCK;
+	case TextureFormat::RGTC2: return VK_FORMAT_BC5_UNORM_BLOCK;
+	case TextureFormat::BC7: return VK_FORMAT_BC7_UNORM_BLOCK;
+	case TextureFormat::ETC1: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
 	case TextureFormat::R11G11B10F: return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
 	default:
 		ET_ASSERT(!"Invalid TextureFormat provided");
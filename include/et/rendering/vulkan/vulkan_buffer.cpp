@@ -141,7 +141,7 @@ uint8_t* VulkanBuffer::map(uint64_t offset, uint64_t size)
 	ET_ASSERT(offset + size <= _private->desc.alignedSize);
 
 	_private->mapped = true;
-	return _private->vulkan.allocator.map(_private->allocation);
+	return _private->vulkan.allocator.map(_private->allocation) + offset;
 }
 
 void VulkanBuffer::modifyRange(uint64_t begin, uint64_t length)
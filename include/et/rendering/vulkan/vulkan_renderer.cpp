@@ -274,6 +274,27 @@ Texture::Pointer VulkanRenderer::createTexture(const TextureDescription::Pointer
 	return VulkanTexture::Pointer::create(_private->vulkan(), desc.reference(), desc->data);
 }
 
+bool VulkanRenderer::textureFormatSupported(TextureFormat format) const {
+	switch (format)
+	{
+	case TextureFormat::PVR_2bpp_RGB:
+	case TextureFormat::PVR_2bpp_sRGB:
+	case TextureFormat::PVR_2bpp_RGBA:
+	case TextureFormat::PVR_2bpp_sRGBA:
+	case TextureFormat::PVR_4bpp_RGB:
+	case TextureFormat::PVR_4bpp_sRGB:
+	case TextureFormat::PVR_4bpp_RGBA:
+	case TextureFormat::PVR_4bpp_sRGBA:
+		return false;
+	default:
+		break;
+	}
+
+	VkFormatProperties formatProperties = {};
+	vkGetPhysicalDeviceFormatProperties(_private->physicalDevice, vulkan::textureFormatValue(format), &formatProperties);
+	return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
 TextureSet::Pointer VulkanRenderer::createTextureSet(const TextureSet::Description& desc) {
 	TextureSet::Pointer result;
 	if (desc.empty())
@@ -355,8 +376,12 @@ void VulkanRenderer::begin() {
 		_statistics = { };
 		for (VulkanRenderPass::Pointer& pass : _private->passes[frameIndex()])
 		{
-			if (pass->fillStatistics(timestampData, _statistics.passes[_statistics.activeRenderPasses]))
+			RenderPassStatistics& passStatistics = _statistics.passes[_statistics.activeRenderPasses];
+			if (pass->fillStatistics(timestampData, passStatistics))
 			{
+				_statistics.renderBatches += passStatistics.renderBatches;
+				_statistics.pipelineBinds += passStatistics.pipelineBinds;
+				_statistics.descriptorSetBinds += passStatistics.descriptorSetBinds;
 				++_statistics.activeRenderPasses;
 			}
 		}
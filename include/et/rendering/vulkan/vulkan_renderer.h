@@ -51,6 +51,7 @@ public:
 	 */
 	Texture::Pointer createTexture(const TextureDescription::Pointer&) override;
 	TextureSet::Pointer createTextureSet(const TextureSet::Description&) override;
+	bool textureFormatSupported(TextureFormat) const override;
 
 	/*
 	 * Samplers
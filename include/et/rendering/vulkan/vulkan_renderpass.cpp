@@ -25,6 +25,51 @@ uint64_t framebufferHash(uint32_t imageIndex, uint32_t mipLevel, uint32_t layer)
 		((static_cast<uint64_t>(imageIndex) & 0xFFFF) << 48);
 }
 
+/*
+ * state bound to the command buffer, used to skip redundant binds for sorted sequences of batches
+ */
+struct VulkanBoundState
+{
+	VkPipeline pipeline = nullptr;
+	VkPipelineLayout pipelineLayout = nullptr;
+	VkDescriptorSet textureSet = nullptr;
+	VkDescriptorSet imageSet = nullptr;
+	VkBuffer vertexBuffer = nullptr;
+	VkBuffer indexBuffer = nullptr;
+	uint32_t renderBatches = 0;
+	uint32_t pipelineBinds = 0;
+	uint32_t descriptorSetBinds = 0;
+};
+
+/*
+ * batch with resolved pipeline, descriptor sets and buffers,
+ * resolving is performed on the recording thread, since material and pipeline caches are not thread-safe
+ */
+struct VulkanPreparedBatch
+{
+	VulkanPipelineState* pipelineState = nullptr;
+	VkDescriptorSet textureSet = nullptr;
+	VkDescriptorSet imageSet = nullptr;
+	VkBuffer vertexBuffer = nullptr;
+	VkBuffer indexBuffer = nullptr;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	uint32_t materialVariablesOffset = 0;
+	uint32_t first = 0;
+	uint32_t count = 0;
+	const mat4* transform = nullptr;
+	const mat4* rotationTransform = nullptr;
+};
+
+/*
+ * secondary command buffer with it's own pool, so chunks could be recorded concurrently
+ */
+struct VulkanRecordingChunk
+{
+	VkCommandPool commandPool = nullptr;
+	VkCommandBuffer commandBuffer = nullptr;
+	VulkanBoundState bound;
+};
+
 class VulkanRenderPassPrivate : public VulkanNativeRenderPass
 {
 public:
@@ -48,11 +93,37 @@ public:
 	uint64_t buildBeginTime = 0;
 	uint64_t buildEndTime = 0;
 
+	VulkanBoundState bound;
+	uint32_t renderBatches = 0;
+	uint32_t pipelineBinds = 0;
+	uint32_t descriptorSetBinds = 0;
+
+	const Material* lastMaterial = nullptr;
+	const VertexStream* lastVertexStream = nullptr;
+	VulkanPipelineState::Pointer lastPipelineState;
+	VulkanPreparedBatch lastPreparedBatch;
+
+	std::array<Vector<VulkanRecordingChunk>, RendererFrameCount> recordingChunks;
+	std::array<uint32_t, RendererFrameCount> usedRecordingChunks{ };
+	uint32_t firstParallelChunk = 0;
+	uint32_t serialChunk = InvalidIndex;
+	Vector<VulkanPreparedBatch> preparedBatches;
+	Vector<VkCommandBuffer> executedCommandBuffers;
+
+	VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE;
+	bool subpassBeginPending = false;
+
 	std::atomic_bool recording{ false };
 	std::atomic_bool renderPassStarted{ false };
 
-	ConstantBufferEntry::Pointer buildObjectVariables(const VulkanProgram::Pointer& program);
 	void generateDynamicDescriptorSet(RenderPass* pass);
+
+	void beginPendingSubpass(VkSubpassContents);
+	VkCommandBuffer subpassCommandBuffer(VulkanBoundState*&);
+	uint32_t beginRecordingChunk();
+	void executeSerialChunk();
+	void accumulateStatistics(const VulkanBoundState&);
+	void recordBatch(VkCommandBuffer, VulkanBoundState&, const VulkanPreparedBatch&, const ConstantBufferDynamicEntry&);
 };
 
 VulkanRenderPass::VulkanRenderPass(VulkanRenderer* renderer, VulkanState& vulkan, const RenderPass::ConstructionInfo& passInfo)
@@ -176,6 +247,9 @@ VulkanRenderPass::~VulkanRenderPass() {
 	vkDestroyRenderPass(_private->vulkan.device, _private->renderPass, nullptr);
 	for (uint32_t i = 0; i < RendererFrameCount; ++i)
 	{
+		for (const VulkanRecordingChunk& chunk : _private->recordingChunks[i])
+			vkDestroyCommandPool(_private->vulkan.device, chunk.commandPool, nullptr);
+
 		vkFreeCommandBuffers(_private->vulkan.device, _private->vulkan.graphicsCommandPool, 1, &_private->content[i].commandBuffer);
 		vkDestroySemaphore(_private->vulkan.device, _private->content[i].semaphore, nullptr);
 	}
@@ -297,6 +371,23 @@ void VulkanRenderPass::begin(const RenderPassBeginInfo& beginInfo) {
 	_private->subframeIndex = InvalidIndex;
 	_private->renderPassStarted = false;
 	_private->recording = true;
+	_private->bound = VulkanBoundState();
+	_private->renderBatches = 0;
+	_private->pipelineBinds = 0;
+	_private->descriptorSetBinds = 0;
+	_private->lastMaterial = nullptr;
+	_private->lastVertexStream = nullptr;
+	_private->lastPipelineState.reset(nullptr);
+	_private->lastPreparedBatch = VulkanPreparedBatch();
+	_private->subpassBeginPending = false;
+	_private->serialChunk = InvalidIndex;
+
+	for (uint32_t i = 0; i < _private->usedRecordingChunks[_private->frameIndex]; ++i)
+	{
+		VkCommandPool commandPool = _private->recordingChunks[_private->frameIndex][i].commandPool;
+		VULKAN_CALL(vkResetCommandPool(_private->vulkan.device, commandPool, 0));
+	}
+	_private->usedRecordingChunks[_private->frameIndex] = 0;
 
 	setSharedVariable(ObjectVariable::DeltaTime, application().mainRunLoop().lastFrameTime());
 	setSharedVariable(ObjectVariable::ContinuousTime, application().mainRunLoop().time());
@@ -318,16 +409,14 @@ void VulkanRenderPass::nextSubpass() {
 	if (nextSubpassIndex < _private->subpassSequence.size())
 	{
 		_private->subframeIndex = (_private->subframeIndex == InvalidIndex) ? 0 : (_private->subframeIndex + 1);
-		{
-			VkCommandBuffer commandBuffer = _private->content[_private->frameIndex].commandBuffer;
-			ET_ASSERT(_private->renderPassStarted == false);
-
-			_private->renderPassStarted = true;
-			const VulkanRenderSubpass& subpass = _private->subpassSequence.at(_private->subframeIndex);
-			vkCmdBeginRenderPass(commandBuffer, &subpass.beginInfo, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdSetScissor(commandBuffer, 0, 1, &subpass.scissor);
-			vkCmdSetViewport(commandBuffer, 0, 1, &subpass.viewport);
-		}
+
+		/*
+		 * render pass instance is started with the first recorded batch,
+		 * when it is known whether subpass contents are inline or secondary command buffers
+		 */
+		ET_ASSERT(_private->renderPassStarted == false);
+		ET_ASSERT(_private->subpassBeginPending == false);
+		_private->subpassBeginPending = true;
 		_private->currentSubpassIndex = nextSubpassIndex;
 
 		vec4 viewport(
@@ -342,18 +431,32 @@ void VulkanRenderPass::nextSubpass() {
 void VulkanRenderPass::pushRenderBatch(const MaterialInstance::Pointer& inMaterial, const VertexStream::Pointer& vertexStream, uint32_t first, uint32_t count) {
 	ET_ASSERT(_private->recording);
 
-	VulkanPipelineState::Pointer pipelineState;
+	VulkanPreparedBatch batch;
+	if (!prepareRenderBatch(inMaterial, vertexStream, first, count, batch))
+		return;
+
+	VulkanBoundState* bound = nullptr;
+	VkCommandBuffer commandBuffer = _private->subpassCommandBuffer(bound);
+	ET_ASSERT(_private->renderPassStarted);
+
+	ConstantBufferDynamicEntry objectVariables = buildObjectVariables(batch.pipelineState->program());
+	_private->recordBatch(commandBuffer, *bound, batch, objectVariables);
+}
+
+bool VulkanRenderPass::prepareRenderBatch(const MaterialInstance::Pointer& inMaterial, const VertexStream::Pointer& vertexStream,
+	uint32_t first, uint32_t count, VulkanPreparedBatch& batch) {
+	const Material::Pointer& baseMaterial = inMaterial->base();
+	if ((_private->lastMaterial != baseMaterial.pointer()) || (_private->lastVertexStream != vertexStream.pointer()) || _private->lastPipelineState.invalid())
 	{
 		InstusivePointerScope<VulkanRenderPass> scope(this);
-		const Material::Pointer& baseMaterial = inMaterial->base();
-		pipelineState = _private->renderer->acquireGraphicsPipeline(VulkanRenderPass::Pointer(this), baseMaterial, vertexStream);
+		_private->lastPipelineState = _private->renderer->acquireGraphicsPipeline(VulkanRenderPass::Pointer(this), baseMaterial, vertexStream);
+		_private->lastMaterial = baseMaterial.pointer();
+		_private->lastVertexStream = vertexStream.pointer();
 	}
 
+	VulkanPipelineState* pipelineState = _private->lastPipelineState.pointer();
 	if (pipelineState->nativePipeline().pipeline == nullptr)
-		return;
-
-	bool hasVertexBuffer = vertexStream.valid() && vertexStream->vertexBuffer().valid();
-	bool hasIndexBuffer = vertexStream.valid() && vertexStream->indexBuffer().valid();
+		return false;
 
 	MaterialInstance::Pointer material = inMaterial;
 	for (const auto& sh : sharedTextures())
@@ -362,62 +465,124 @@ void VulkanRenderPass::pushRenderBatch(const MaterialInstance::Pointer& inMateri
 		material->setSampler(sh.first, sh.second.second);
 	}
 	Vector<Object::Pointer>& usedObjects = _private->usedObjects[_private->frameIndex];
-	usedObjects.reserve(_private->usedObjects[_private->frameIndex].size() + 6);
-	usedObjects.emplace_back(pipelineState);
 
 	usedObjects.emplace_back(material->constantBufferData(info().name));
 	ConstantBufferEntry* materialVariables = static_cast<ConstantBufferEntry*>(usedObjects.back().pointer());
 
-	usedObjects.emplace_back(buildObjectVariables(pipelineState->program()));
-	ConstantBufferEntry* objectVariables = static_cast<ConstantBufferEntry*>(usedObjects.back().pointer());
+	const TextureSet::Pointer& textureSet = material->textureSet(info().name);
+	const TextureSet::Pointer& imageSet = material->imageSet(info().name);
 
-	usedObjects.emplace_back(material->textureSet(info().name));
-	VulkanTextureSet* textureSet = static_cast<VulkanTextureSet*>(usedObjects.back().pointer());
+	batch.pipelineState = pipelineState;
+	batch.textureSet = static_cast<const VulkanTextureSet*>(textureSet.pointer())->nativeSet().descriptorSet;
+	batch.imageSet = static_cast<const VulkanTextureSet*>(imageSet.pointer())->nativeSet().descriptorSet;
+	batch.materialVariablesOffset = static_cast<uint32_t>(materialVariables != nullptr ? materialVariables->offset() : 0);
+	batch.first = first;
+	batch.count = count;
 
-	usedObjects.emplace_back(material->imageSet(info().name));
-	VulkanTextureSet* imageSet = static_cast<VulkanTextureSet*>(usedObjects.back().pointer());
+	if (vertexStream.valid() && vertexStream->vertexBuffer().valid())
+	{
+		const VulkanBuffer* vertexBuffer = static_cast<const VulkanBuffer*>(vertexStream->vertexBuffer().pointer());
+		batch.vertexBuffer = vertexBuffer->nativeBuffer().buffer;
+	}
 
-	VkDescriptorSet descriptorSets[DescriptorSetClass_Count] = {
-		_private->dynamicDescriptorSet,
-		textureSet->nativeSet().descriptorSet,
-		imageSet->nativeSet().descriptorSet,
-	};
+	if (vertexStream.valid() && vertexStream->indexBuffer().valid())
+	{
+		const VulkanBuffer* indexBuffer = static_cast<const VulkanBuffer*>(vertexStream->indexBuffer().pointer());
+		batch.indexBuffer = indexBuffer->nativeBuffer().buffer;
+		batch.indexType = vulkan::indexBufferFormat(vertexStream->indexArrayFormat());
+	}
 
-	uint32_t dynamicOffsets[DescriptorSetClass::DynamicDescriptorsCount] = {
-		static_cast<uint32_t>(objectVariables != nullptr ? objectVariables->offset() : 0),
-		static_cast<uint32_t>(materialVariables != nullptr ? materialVariables->offset() : 0)
-	};
+	/*
+	 * objects should be retained until frame is completed,
+	 * sorted batches are usually sharing them with the previous batch
+	 */
+	VulkanPreparedBatch& previous = _private->lastPreparedBatch;
+	if (previous.pipelineState != batch.pipelineState)
+		usedObjects.emplace_back(pipelineState);
 
-	ET_ASSERT(_private->renderPassStarted);
+	if (previous.textureSet != batch.textureSet)
+		usedObjects.emplace_back(textureSet);
 
-	VkCommandBuffer commandBuffer = _private->content[_private->frameIndex].commandBuffer;
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineState->nativePipeline().pipeline);
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineState->nativePipeline().layout, 0,
-		DescriptorSetClass_Count, descriptorSets, DescriptorSetClass::DynamicDescriptorsCount, dynamicOffsets);
+	if (previous.imageSet != batch.imageSet)
+		usedObjects.emplace_back(imageSet);
 
-	if (hasVertexBuffer)
-	{
+	if ((batch.vertexBuffer != nullptr) && (previous.vertexBuffer != batch.vertexBuffer))
 		usedObjects.emplace_back(vertexStream->vertexBuffer());
-		VulkanBuffer* vertexBuffer = static_cast<VulkanBuffer*>(usedObjects.back().pointer());
 
-		VkDeviceSize offsets[] = { 0 };
-		VkBuffer buffers[] = { vertexBuffer->nativeBuffer().buffer };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-	}
+	if ((batch.indexBuffer != nullptr) && (previous.indexBuffer != batch.indexBuffer))
+		usedObjects.emplace_back(vertexStream->indexBuffer());
 
-	if (hasIndexBuffer)
+	previous = batch;
+	return true;
+}
+
+bool VulkanRenderPass::beginParallelRecording(const RenderBatchInstance* batches, uint32_t count, uint32_t chunksCount) {
+	ET_ASSERT(_private->recording);
+
+	/*
+	 * subpass could not mix inline commands and secondary command buffers,
+	 * so batches are recorded serially if subpass was already started with inline contents
+	 */
+	_private->beginPendingSubpass(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	if (_private->subpassContents != VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+		return false;
+
+	ET_ASSERT(_private->renderPassStarted);
+	_private->executeSerialChunk();
+
+	_private->preparedBatches.resize(count);
+	for (uint32_t i = 0; i < count; ++i)
 	{
-		usedObjects.emplace_back(vertexStream->indexBuffer());
-		VulkanBuffer* indexBuffer = static_cast<VulkanBuffer*>(usedObjects.back().pointer());
+		const RenderBatchInstance& instance = batches[i];
+		VulkanPreparedBatch& prepared = _private->preparedBatches[i];
+		prepared = VulkanPreparedBatch();
+
+		/*
+		 * batches without pipeline are kept with null pipeline state to preserve chunks layout
+		 */
+		const RenderBatch* batch = instance.batch;
+		if (prepareRenderBatch(batch->material(), batch->vertexStream(), batch->firstIndex(), batch->numIndexes(), prepared))
+		{
+			prepared.transform = instance.transform;
+			prepared.rotationTransform = instance.rotationTransform;
+		}
+	}
+
+	_private->firstParallelChunk = _private->usedRecordingChunks[_private->frameIndex];
+	for (uint32_t i = 0; i < chunksCount; ++i)
+		_private->beginRecordingChunk();
+
+	return true;
+}
 
-		VkIndexType indexType = vulkan::indexBufferFormat(vertexStream->indexArrayFormat());
-		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->nativeBuffer().buffer, 0, indexType);
-		vkCmdDrawIndexed(commandBuffer, count, 1, first, 0, 0);
+void VulkanRenderPass::recordParallelChunk(uint32_t chunkIndex, uint32_t first, uint32_t count) {
+	VulkanRecordingChunk& chunk = _private->recordingChunks[_private->frameIndex][_private->firstParallelChunk + chunkIndex];
+	for (uint32_t i = first, e = first + count; i < e; ++i)
+	{
+		const VulkanPreparedBatch& batch = _private->preparedBatches[i];
+		if (batch.pipelineState != nullptr)
+		{
+			ConstantBufferDynamicEntry objectVariables = buildObjectVariables(batch.pipelineState->program(), batch.transform, batch.rotationTransform);
+			_private->recordBatch(chunk.commandBuffer, chunk.bound, batch, objectVariables);
+		}
 	}
-	else
+	VULKAN_CALL(vkEndCommandBuffer(chunk.commandBuffer));
+}
+
+void VulkanRenderPass::endParallelRecording() {
+	Vector<VulkanRecordingChunk>& chunks = _private->recordingChunks[_private->frameIndex];
+	Vector<VkCommandBuffer>& commandBuffers = _private->executedCommandBuffers;
+
+	commandBuffers.clear();
+	for (uint32_t i = _private->firstParallelChunk, e = _private->usedRecordingChunks[_private->frameIndex]; i < e; ++i)
 	{
-		vkCmdDraw(commandBuffer, count, 1, first, 0);
+		commandBuffers.emplace_back(chunks[i].commandBuffer);
+		_private->accumulateStatistics(chunks[i].bound);
 	}
+
+	VkCommandBuffer commandBuffer = _private->content[_private->frameIndex].commandBuffer;
+	vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+	_private->preparedBatches.clear();
 }
 
 void VulkanRenderPass::dispatchCompute(const Compute::Pointer& compute, const vec3i& dim) {
@@ -434,12 +599,11 @@ void VulkanRenderPass::dispatchCompute(const Compute::Pointer& compute, const ve
 	VulkanTextureSet::Pointer textureSet = material->textureSet(info().name);
 	VulkanTextureSet::Pointer imageSet = material->imageSet(info().name);
 	ConstantBufferEntry::Pointer materialVariables = material->constantBufferData(info().name);
-	ConstantBufferEntry::Pointer objectVariables = buildObjectVariables(program);
+	ConstantBufferDynamicEntry objectVariables = buildObjectVariables(program);
 
 	_private->usedObjects[_private->frameIndex].emplace_back(textureSet);
 	_private->usedObjects[_private->frameIndex].emplace_back(imageSet);
 	_private->usedObjects[_private->frameIndex].emplace_back(materialVariables);
-	_private->usedObjects[_private->frameIndex].emplace_back(objectVariables);
 
 	VkCommandBuffer commandBuffer = _private->content[_private->frameIndex].commandBuffer;
 
@@ -450,7 +614,7 @@ void VulkanRenderPass::dispatchCompute(const Compute::Pointer& compute, const ve
 	};
 
 	uint32_t dynamicOffsets[DescriptorSetClass::DynamicDescriptorsCount] = {
-		static_cast<uint32_t>(objectVariables.valid() ? objectVariables->offset() : 0),
+		objectVariables.offset,
 		static_cast<uint32_t>(materialVariables.valid() ? materialVariables->offset() : 0)
 	};
 
@@ -544,10 +708,15 @@ void VulkanRenderPass::copyImageToBuffer(const Texture::Pointer& image, const Bu
 void VulkanRenderPass::endSubpass() {
 	ET_ASSERT(_private->recording);
 
+	_private->beginPendingSubpass(VK_SUBPASS_CONTENTS_INLINE);
+	_private->executeSerialChunk();
+
 	VkCommandBuffer commandBuffer = _private->content[_private->frameIndex].commandBuffer;
 	ET_ASSERT(_private->renderPassStarted == true);
 	vkCmdEndRenderPass(commandBuffer);
 	_private->renderPassStarted = false;
+	_private->accumulateStatistics(_private->bound);
+	_private->bound = VulkanBoundState();
 }
 
 void VulkanRenderPass::end() {
@@ -565,12 +734,12 @@ void VulkanRenderPass::debug() {
 	debug::debugBreak();
 }
 
-ConstantBufferEntry::Pointer VulkanRenderPass::buildObjectVariables(const VulkanProgram::Pointer& program) {
-	ConstantBufferEntry::Pointer result;
+ConstantBufferDynamicEntry VulkanRenderPass::buildObjectVariables(const VulkanProgram::Pointer& program,
+	const mat4* transform, const mat4* rotationTransform) {
+	ConstantBufferDynamicEntry result;
 	if (program->reflection().objectVariablesBufferSize > 0)
 	{
-		result = _private->renderer->sharedConstantBuffer().allocate(
-			program->reflection().objectVariablesBufferSize, ConstantBufferDynamicAllocation);
+		result = _private->renderer->sharedConstantBuffer().allocateDynamic(program->reflection().objectVariablesBufferSize);
 
 		for (const auto& v : sharedVariables())
 		{
@@ -578,9 +747,20 @@ ConstantBufferEntry::Pointer VulkanRenderPass::buildObjectVariables(const Vulkan
 			if (var.enabled && v.second.isSet())
 			{
 				ET_ASSERT(v.second.elementCount <= var.arraySize);
-				memcpy(result->data() + var.offset, v.second.data, v.second.dataSize);
+				memcpy(result.data + var.offset, v.second.data, v.second.dataSize);
 			}
 		}
+
+		/*
+		 * transformations of batches recorded in parallel are not written to shared variables
+		 */
+		const Program::Variable& worldTransform = program->reflection().objectVariables[static_cast<uint32_t>(ObjectVariable::WorldTransform)];
+		if ((transform != nullptr) && worldTransform.enabled)
+			memcpy(result.data + worldTransform.offset, transform, sizeof(mat4));
+
+		const Program::Variable& worldRotationTransform = program->reflection().objectVariables[static_cast<uint32_t>(ObjectVariable::WorldRotationTransform)];
+		if ((rotationTransform != nullptr) && worldRotationTransform.enabled)
+			memcpy(result.data + worldRotationTransform.offset, rotationTransform, sizeof(mat4));
 	}
 	return result;
 }
@@ -601,6 +781,9 @@ bool VulkanRenderPass::fillStatistics(uint64_t* buffer, RenderPassStatistics& st
 	strncpy(stat.name, info().name.c_str(), std::min(static_cast<size_t>(MaxRenderPassName), info().name.size()));
 	stat.gpuExecution = static_cast<uint64_t>((periods * periodDuration) / 1000.0);
 	stat.cpuBuild = _private->buildEndTime - _private->buildBeginTime;
+	stat.renderBatches = _private->renderBatches;
+	stat.pipelineBinds = _private->pipelineBinds;
+	stat.descriptorSetBinds = _private->descriptorSetBinds;
 
 	return true;
 }
@@ -608,6 +791,166 @@ bool VulkanRenderPass::fillStatistics(uint64_t* buffer, RenderPassStatistics& st
 /*
  * Private implementation
  */
+void VulkanRenderPassPrivate::beginPendingSubpass(VkSubpassContents contents) {
+	if (!subpassBeginPending)
+		return;
+
+	VkCommandBuffer commandBuffer = content[frameIndex].commandBuffer;
+	const VulkanRenderSubpass& subpass = subpassSequence.at(subframeIndex);
+	vkCmdBeginRenderPass(commandBuffer, &subpass.beginInfo, contents);
+	if (contents == VK_SUBPASS_CONTENTS_INLINE)
+	{
+		vkCmdSetScissor(commandBuffer, 0, 1, &subpass.scissor);
+		vkCmdSetViewport(commandBuffer, 0, 1, &subpass.viewport);
+	}
+
+	bound = VulkanBoundState();
+	subpassContents = contents;
+	subpassBeginPending = false;
+	renderPassStarted = true;
+}
+
+VkCommandBuffer VulkanRenderPassPrivate::subpassCommandBuffer(VulkanBoundState*& state) {
+	beginPendingSubpass(VK_SUBPASS_CONTENTS_INLINE);
+
+	if (subpassContents == VK_SUBPASS_CONTENTS_INLINE)
+	{
+		state = &bound;
+		return content[frameIndex].commandBuffer;
+	}
+
+	/*
+	 * subpass contents are secondary command buffers,
+	 * so batches pushed after parallel recording are going to the serial chunk
+	 */
+	if (serialChunk == InvalidIndex)
+		serialChunk = beginRecordingChunk();
+
+	VulkanRecordingChunk& chunk = recordingChunks[frameIndex][serialChunk];
+	state = &chunk.bound;
+	return chunk.commandBuffer;
+}
+
+uint32_t VulkanRenderPassPrivate::beginRecordingChunk() {
+	Vector<VulkanRecordingChunk>& chunks = recordingChunks[frameIndex];
+	uint32_t chunkIndex = usedRecordingChunks[frameIndex]++;
+	if (chunkIndex == chunks.size())
+	{
+		chunks.emplace_back();
+		VulkanRecordingChunk& newChunk = chunks.back();
+
+		VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		poolInfo.queueFamilyIndex = vulkan.queues[VulkanQueueClass::Graphics].index;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		VULKAN_CALL(vkCreateCommandPool(vulkan.device, &poolInfo, nullptr, &newChunk.commandPool));
+
+		VkCommandBufferAllocateInfo info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		info.commandPool = newChunk.commandPool;
+		info.commandBufferCount = 1;
+		info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		VULKAN_CALL(vkAllocateCommandBuffers(vulkan.device, &info, &newChunk.commandBuffer));
+	}
+
+	const VulkanRenderSubpass& subpass = subpassSequence.at(subframeIndex);
+	VulkanRecordingChunk& chunk = chunks[chunkIndex];
+	chunk.bound = VulkanBoundState();
+
+	VkCommandBufferInheritanceInfo inheritanceInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+	inheritanceInfo.renderPass = renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = subpass.beginInfo.framebuffer;
+
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+	VULKAN_CALL(vkBeginCommandBuffer(chunk.commandBuffer, &beginInfo));
+	vkCmdSetScissor(chunk.commandBuffer, 0, 1, &subpass.scissor);
+	vkCmdSetViewport(chunk.commandBuffer, 0, 1, &subpass.viewport);
+
+	return chunkIndex;
+}
+
+void VulkanRenderPassPrivate::executeSerialChunk() {
+	if (serialChunk == InvalidIndex)
+		return;
+
+	VulkanRecordingChunk& chunk = recordingChunks[frameIndex][serialChunk];
+	VULKAN_CALL(vkEndCommandBuffer(chunk.commandBuffer));
+	vkCmdExecuteCommands(content[frameIndex].commandBuffer, 1, &chunk.commandBuffer);
+	accumulateStatistics(chunk.bound);
+	serialChunk = InvalidIndex;
+}
+
+void VulkanRenderPassPrivate::accumulateStatistics(const VulkanBoundState& state) {
+	renderBatches += state.renderBatches;
+	pipelineBinds += state.pipelineBinds;
+	descriptorSetBinds += state.descriptorSetBinds;
+}
+
+void VulkanRenderPassPrivate::recordBatch(VkCommandBuffer commandBuffer, VulkanBoundState& state,
+	const VulkanPreparedBatch& batch, const ConstantBufferDynamicEntry& objectVariables) {
+	const VulkanNativePipeline& nativePipeline = batch.pipelineState->nativePipeline();
+	if (state.pipeline != nativePipeline.pipeline)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, nativePipeline.pipeline);
+		state.pipeline = nativePipeline.pipeline;
+		++state.pipelineBinds;
+	}
+
+	VkDescriptorSet descriptorSets[DescriptorSetClass_Count] = {
+		dynamicDescriptorSet,
+		batch.textureSet,
+		batch.imageSet,
+	};
+
+	uint32_t dynamicOffsets[DescriptorSetClass::DynamicDescriptorsCount] = {
+		objectVariables.offset,
+		batch.materialVariablesOffset
+	};
+
+	/*
+	 * dynamic offsets of object and material variables are changing with every batch,
+	 * so only texture and image sets are skipped when they are already bound
+	 */
+	bool bindAllSets = (state.pipelineLayout != nativePipeline.layout) ||
+		(state.textureSet != batch.textureSet) || (state.imageSet != batch.imageSet);
+
+	uint32_t setsToBind = bindAllSets ? DescriptorSetClass_Count : 1;
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, nativePipeline.layout, 0,
+		setsToBind, descriptorSets, DescriptorSetClass::DynamicDescriptorsCount, dynamicOffsets);
+
+	if (bindAllSets)
+	{
+		state.pipelineLayout = nativePipeline.layout;
+		state.textureSet = batch.textureSet;
+		state.imageSet = batch.imageSet;
+		++state.descriptorSetBinds;
+	}
+
+	if ((batch.vertexBuffer != nullptr) && (state.vertexBuffer != batch.vertexBuffer))
+	{
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &batch.vertexBuffer, offsets);
+		state.vertexBuffer = batch.vertexBuffer;
+	}
+
+	if (batch.indexBuffer != nullptr)
+	{
+		if (state.indexBuffer != batch.indexBuffer)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, batch.indexBuffer, 0, batch.indexType);
+			state.indexBuffer = batch.indexBuffer;
+		}
+		vkCmdDrawIndexed(commandBuffer, batch.count, 1, batch.first, 0, 0);
+	}
+	else
+	{
+		vkCmdDraw(commandBuffer, batch.count, 1, batch.first, 0);
+	}
+
+	++state.renderBatches;
+}
+
 void VulkanRenderPassPrivate::generateDynamicDescriptorSet(RenderPass* pass) {
 	VkDescriptorSetLayoutBinding bindings[] = { {},{} };
 	bindings[0] = { ObjectVariablesBufferIndex, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
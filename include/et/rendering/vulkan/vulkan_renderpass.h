@@ -16,6 +16,7 @@ class VulkanState;
 class VulkanRenderer;
 class VulkanNativeRenderPass;
 class VulkanRenderPassPrivate;
+struct VulkanPreparedBatch;
 class VulkanRenderPass : public RenderPass
 {
 public:
@@ -40,11 +41,18 @@ public:
 	void debug() override;
 
 	bool fillStatistics(uint64_t* buffer, RenderPassStatistics&);
-	
+
+protected:
+	bool beginParallelRecording(const RenderBatchInstance*, uint32_t, uint32_t) override;
+	void recordParallelChunk(uint32_t, uint32_t, uint32_t) override;
+	void endParallelRecording() override;
+
 private:
-	ConstantBufferEntry::Pointer VulkanRenderPass::buildObjectVariables(const VulkanProgram::Pointer&);
+	ConstantBufferDynamicEntry buildObjectVariables(const VulkanProgram::Pointer&,
+		const mat4* transform = nullptr, const mat4* rotationTransform = nullptr);
+	bool prepareRenderBatch(const MaterialInstance::Pointer&, const VertexStream::Pointer&, uint32_t, uint32_t, VulkanPreparedBatch&);
 
 private:
-	ET_DECLARE_PIMPL(VulkanRenderPass, 384);
+	ET_DECLARE_PIMPL(VulkanRenderPass, 1024);
 };
 }
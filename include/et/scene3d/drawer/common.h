@@ -25,6 +25,12 @@ struct DrawerOptions
 	bool rebuildLookupTexture = false;
 	bool enableScreenSpaceShadows = false;
 	bool enableScreenSpaceAO = true;
+	bool parallelCulling = true;
+	/*
+	 * meshes are considered static until next setScene call,
+	 * their bounding boxes are collected once and culled with hierarchy
+	 */
+	bool staticMeshesHierarchy = false;
 };
 
 mat4 fullscreenBatchTransform(const vec2& viewport, const vec2& origin, const vec2& size);
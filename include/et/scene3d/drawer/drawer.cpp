@@ -70,15 +70,59 @@ Drawer::Drawer(const RenderInterface::Pointer& renderer) :
 }
 
 void Drawer::updateVisibleMeshes() {
-	_visibleMeshes.clear();
-	_visibleMeshes.reserve(_allMeshes.size());
-	for (Mesh::Pointer& mesh : _allMeshes)
+	const Frustum& frustum = _frameCamera->frustum();
+	JobSystem* jobSystem = options.parallelCulling ? &sharedJobSystem() : nullptr;
+	uint32_t meshesCount = static_cast<uint32_t>(_allMeshes.size());
+
+	_visibleMeshIndices.resize(meshesCount);
+	uint32_t visibleCount = 0;
+
+	if (options.staticMeshesHierarchy)
 	{
-		if (_frameCamera->frustum().containsBoundingBox(mesh->tranformedBoundingBox()))
+		if (_cullingHierarchy.objectsCount() != meshesCount)
 		{
-			_visibleMeshes.emplace_back(mesh);
+			_meshBoxes.resize(meshesCount);
+			for (uint32_t i = 0; i < meshesCount; ++i)
+				_meshBoxes.set(i, _allMeshes[i]->tranformedBoundingBox());
+			_cullingHierarchy.build(_meshBoxes);
 		}
+		visibleCount = _cullingHierarchy.cull(frustum, _visibleMeshIndices.data(), jobSystem);
 	}
+	else
+	{
+		_cullingHierarchy.clear();
+		_meshBoxes.resize(meshesCount);
+		for (uint32_t i = 0; i < meshesCount; ++i)
+			_meshBoxes.set(i, _allMeshes[i]->tranformedBoundingBox());
+		visibleCount = cullBoundingBoxes(frustum, _meshBoxes, _visibleMeshIndices.data(), jobSystem);
+	}
+
+	_visibleMeshes.clear();
+	_visibleMeshes.reserve(visibleCount);
+	for (uint32_t i = 0; i < visibleCount; ++i)
+		_visibleMeshes.emplace_back(_allMeshes[_visibleMeshIndices[i]]);
+}
+
+void Drawer::buildRenderQueue() {
+	const vec3& cameraPosition = _frameCamera->position();
+	vec3 cameraDirection = _frameCamera->direction();
+	float depthScale = 1.0f / std::max(_frameCamera->zFar(), std::numeric_limits<float>::epsilon());
+
+	_renderQueue.clear();
+	for (Mesh::Pointer& mesh : _visibleMeshes)
+	{
+		/*
+		 * camera's direction points backwards, so view space depth is negated projection
+		 */
+		const BoundingBox& box = mesh->tranformedBoundingBox();
+		float depth = -dot(box.center - cameraPosition, cameraDirection) * depthScale;
+
+		const mat4& transform = mesh->transform();
+		const mat4& rotationTransform = mesh->rotationTransform();
+		for (const RenderBatch::Pointer& rb : mesh->renderBatches())
+			_renderQueue.push(rb, transform, rotationTransform, depth);
+	}
+	_renderQueue.sort();
 }
 
 void Drawer::draw() {
@@ -102,17 +146,13 @@ void Drawer::draw() {
 	_frameCamera = _scene->renderCamera();
 	_frameCamera->setProjectionMatrix(_baseProjectionMatrix * translationMatrix(_jitter.x, _jitter.y, 0.0f));
 	updateVisibleMeshes();
+	buildRenderQueue();
 
 	_main.zPrepass->begin(RenderPassBeginInfo::singlePass());
 	{
 		_main.zPrepass->loadSharedVariablesFromCamera(_frameCamera);
 		_main.zPrepass->nextSubpass();
-		for (Mesh::Pointer& mesh : _visibleMeshes)
-		{
-			_main.zPrepass->setSharedVariable(ObjectVariable::WorldTransform, mesh->transform());
-			for (const RenderBatch::Pointer& rb : mesh->renderBatches())
-				_main.zPrepass->pushRenderBatch(rb);
-		}
+		_renderQueue.submit(_main.zPrepass);
 		_main.zPrepass->endSubpass();
 		_main.zPrepass->end();
 	}
@@ -145,13 +185,7 @@ void Drawer::draw() {
 		_main.forward->setSharedTexture(MaterialTexture::AmbientOcclusion, _main.screenSpaceAOTexture, _renderer->defaultSampler());
 		_main.forward->setSharedVariable(ObjectVariable::EnvironmentSphericalHarmonics, _cubemapProcessor->environmentSphericalHarmonics(), 9);
 		_main.forward->nextSubpass();
-		for (Mesh::Pointer& mesh : _visibleMeshes)
-		{
-			_main.forward->setSharedVariable(ObjectVariable::WorldTransform, mesh->transform());
-			_main.forward->setSharedVariable(ObjectVariable::WorldRotationTransform, mesh->rotationTransform());
-			for (const RenderBatch::Pointer& rb : mesh->renderBatches())
-				_main.forward->pushRenderBatch(rb);
-		}
+		_renderQueue.submit(_main.forward);
 		_main.forward->setSharedVariable(ObjectVariable::WorldTransform, identityMatrix);
 		_main.forward->pushRenderBatch(_lighting.environmentBatch);
 		_main.forward->endSubpass();
@@ -252,6 +286,7 @@ void Drawer::setScene(const Scene::Pointer& inScene) {
 
 	_allMeshes.clear();
 	_allMeshes.reserve(elements.size());
+	_cullingHierarchy.clear();
 	_lighting.directional.reset(nullptr);
 
 	bool updateEnvironment = false;
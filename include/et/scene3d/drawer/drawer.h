@@ -10,6 +10,8 @@
 #include <et/scene3d/drawer/debugdrawer.h>
 #include <et/scene3d/drawer/shadowmaps.h>
 #include <et/scene3d/drawer/cubemaps.h>
+#include <et/rendering/base/renderqueue.h>
+#include <et/camera/culling.h>
 
 namespace et
 {
@@ -48,6 +50,7 @@ public:
 
 private:
 	void updateVisibleMeshes();
+	void buildRenderQueue();
 	void validate(RenderInterface::Pointer&);
 
 private:
@@ -57,6 +60,10 @@ private:
 	Camera::Pointer _frameCamera;
 	Vector<Mesh::Pointer> _allMeshes;
 	Vector<Mesh::Pointer> _visibleMeshes;
+	Vector<uint32_t> _visibleMeshIndices;
+	PackedBoundingBoxes _meshBoxes;
+	CullingHierarchy _cullingHierarchy;
+	RenderQueue _renderQueue;
 
 	RenderInterface::Pointer _renderer;
 	DebugDrawer::Pointer _debugDrawer;
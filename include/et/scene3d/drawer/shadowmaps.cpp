@@ -105,17 +105,24 @@ void ShadowmapProcessor::process(RenderInterface::Pointer& renderer, DrawerOptio
 	activePass->begin(RenderPassBeginInfo::singlePass());
 	activePass->pushImageBarrier(_directionalShadowmap, ResourceBarrier(TextureState::DepthRenderTarget));
 	activePass->nextSubpass();
-	for (Mesh::Pointer& mesh : _renderables.meshes)
 	{
-		if (_light->frustum().containsBoundingBox(mesh->tranformedBoundingBox()))
+		/*
+		 * depth is not used in sorting of the shadow casters, only state changes are minimized
+		 */
+		RenderQueue& renderQueue = _renderables.renderQueue;
+		renderQueue.clear();
+		for (Mesh::Pointer& mesh : _renderables.meshes)
 		{
-			const mat4& transform = mesh->transform();
-			const mat4& rotationTransform = mesh->rotationTransform();
-			activePass->setSharedVariable(ObjectVariable::WorldTransform, transform);
-			activePass->setSharedVariable(ObjectVariable::WorldRotationTransform, rotationTransform);
-			for (const RenderBatch::Pointer& batch : mesh->renderBatches())
-				activePass->pushRenderBatch(batch);
+			if (_light->frustum().containsBoundingBox(mesh->tranformedBoundingBox()))
+			{
+				const mat4& transform = mesh->transform();
+				const mat4& rotationTransform = mesh->rotationTransform();
+				for (const RenderBatch::Pointer& batch : mesh->renderBatches())
+					renderQueue.push(batch, transform, rotationTransform, 0.0f);
+			}
 		}
+		renderQueue.sort();
+		renderQueue.submit(activePass);
 	}
 	activePass->endSubpass();
 	activePass->pushImageBarrier(_directionalShadowmap, ResourceBarrier(TextureState::ShaderResource));
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <et/scene3d/drawer/common.h>
+#include <et/rendering/base/renderqueue.h>
 
 namespace et
 {
@@ -51,6 +52,7 @@ private:
 		RenderPass::Pointer depthBasedShadowPass;
 		RenderPass::Pointer momentsBasedShadowPass;
 		Vector<Mesh::Pointer> meshes;
+		RenderQueue renderQueue;
 
 		RenderBatch::Pointer debugColorBatch;
 		RenderBatch::Pointer debugDepthBatch;
@@ -5,128 +5,97 @@
  *
  */
 
+#include <sstream>
+
 #include <et/app/application.h>
 #include <et/core/conversion.h>
 #include <et/core/filesystem.h>
+#include <et/core/jobsystem.h>
+#include <et/core/mappedfile.h>
+#include <et/core/serialization.h>
+#include <et/core/textparsing.h>
+#include <et/core/tools.h>
 #include <et/rendering/base/primitives.h>
 #include <et/rendering/base/material.h>
 #include <et/scene3d/objloader.h>
 
 namespace et {
 
-template <typename F>
-inline void splitAndWrite(const std::string& s, F func)
+/*
+ * vectors in material files are read until the end of line, missing components are set to zero
+ */
+inline void readFloats(std::istream& stream, float* values, uint32_t count)
 {
-	if (s.empty()) return;
-	
-	const char t_space = ' ';
-	const char t_tab = '\t';
-
-	const char* begin = s.data();
-	const char* pos = begin;
-	const char* end = begin + s.size();
-	while (begin < end)
-	{
-		if ((*begin == t_space) || (*begin == t_tab))
-		{
-			func(std::string(pos, begin - pos));
-			while ((*begin == t_space) || (*begin == t_tab))
-				++begin;
-			pos = begin;
-		}
-		else
-		{
-			++begin;
-		}
-	}
-	if (begin - pos > 0)
-		func(std::string(pos, begin - pos));
-}
+	std::string line;
+	std::getline(stream, line);
 
-template <typename F>
-inline void splitAndWrite(const std::string& s, char token, F func)
-{
-	if (s.empty()) return;
-	
-	const char* begin = s.data();
-	const char* pos = begin;
-	const char* end = begin + s.size();
-	while (begin < end)
-	{
-		if (*begin == token)
-		{
-			func(std::string(pos, begin - pos));
-			while (*(begin + 1) == token)
-			{
-				func(intToStr(std::numeric_limits<int32_t>::max()));
-				++begin;
-			}
-			pos = begin + 1;
-		}
-		++begin;
-	}
-	if (begin - pos > 0)
-		func(std::string(pos, begin - pos));
+	const char* position = line.data();
+	text::parseFloats(position, position + line.size(), values, count);
 }
 
 inline std::istream& operator >> (std::istream& stream, vec2& value)
 {
-	static std::string ln;
-	ln.reserve(128);
-	ln.clear();
-
-	std::getline(stream, ln);
-	trim(ln);
-
-	int comp = 0;
-	splitAndWrite(ln, [&value, &comp](const std::string& s)
-	{
-		if (comp < 2)
-			value[comp++] = strToFloat(s);
-	});
+	readFloats(stream, value.data(), 2);
 	return stream;
 }
 
 inline std::istream& operator >> (std::istream& stream, vec3& value)
 {
-	static std::string ln;
-	ln.reserve(128);
-	ln.clear();
-
-	std::getline(stream, ln);
-	trim(ln);
-
-	uint32_t comp = 0;
-	splitAndWrite(ln, [&value, &comp](const std::string& s)
-	{
-		if (comp < 3)
-		{
-			value[comp++] = strToFloat(s);
-		}
-	});
+	readFloats(stream, value.data(), 3);
 	return stream;
 }
 
 inline std::istream& operator >> (std::istream& stream, vec4& value)
 {
-	static std::string ln;
-	ln.reserve(128);
-	ln.clear();
-
-	std::getline(stream, ln);
-	trim(ln);
-
-	uint32_t comp = 0;
-	splitAndWrite(ln, [&value, &comp](const std::string& s)
-	{
-		if (comp < 4)
-			value[comp++] = strToFloat(s);
-	});
+	readFloats(stream, value.data(), 4);
 	return stream;
 }
 
 void getLine(std::ifstream& stream, std::string& line);
 
+/*
+ * Binary cache of the processed model: header, metadata (vertex declaration, material libraries, meshes),
+ * then vertex and index data aligned and stored exactly as they are uploaded to the buffers.
+ * Cache is valid if it matches load options and the source file by modification date,
+ * or by size and content hash when only the date was changed.
+ */
+namespace
+{
+enum : uint32_t
+{
+	OBJCacheSignature = ET_COMPOSE_UINT32('E', 'T', 'O', 'C'),
+	OBJCacheVersion = 1,
+	OBJCacheEndianness = 0x01020304,
+	OBJCacheDataAlignment = 64,
+};
+
+struct OBJCacheHeader
+{
+	uint32_t signature = OBJCacheSignature;
+	uint32_t version = OBJCacheVersion;
+	uint32_t endianness = OBJCacheEndianness;
+	uint32_t loadOptions = 0;
+	uint64_t sourceDate = 0;
+	uint64_t sourceSize = 0;
+	uint64_t sourceHash = 0;
+	uint32_t vertexCount = 0;
+	uint32_t vertexStride = 0;
+	uint32_t indexCount = 0;
+	uint32_t indexFormat = 0;
+	uint32_t primitiveType = 0;
+	uint32_t reserved = 0;
+	uint64_t metadataOffset = 0;
+	uint64_t metadataSize = 0;
+	uint64_t vertexDataOffset = 0;
+	uint64_t vertexDataSize = 0;
+	uint64_t indexDataOffset = 0;
+	uint64_t indexDataSize = 0;
+};
+
+bool readOBJCacheHeader(const MappedFile::Pointer&, OBJCacheHeader&);
+bool sourceMatchesOBJCacheHeader(const std::string& source, const OBJCacheHeader&);
+}
+
 /*
  * OBJLoader
  */
@@ -154,495 +123,344 @@ OBJLoader::~OBJLoader()
 		materialFile.close();
 }
 
-float naive_atof(const char *p) 
+bool OBJLoader::parse(ObjectsCache& cache, uint32_t chunksCount)
 {
-	float r = 0.0;
-	bool neg = false;
-	if (*p == '-') {
-		neg = true;
-		++p;
+	MappedFile file(inputFileName);
+	if (!file.valid())
+	{
+		log::error("Unable to map file %s", inputFileName.c_str());
+		return false;
 	}
-	while (*p >= '0' && *p <= '9') 
+
+	const char* fileBegin = reinterpret_cast<const char*>(file.data());
+	const char* fileEnd = fileBegin + file.size();
+
+	/*
+	 * several chunks per worker to balance lines of different cost (faces vs. vertices),
+	 * but not too small to keep per-chunk overhead negligible
+	 */
+	if (chunksCount == 0)
 	{
-		r = (r * 10.0f) + (*p - '0');
-		++p;
+		const uint64_t minChunkSize = 1024 * 1024;
+		uint64_t maxChunks = 4 * (static_cast<uint64_t>(sharedJobSystem().workersCount()) + 1);
+		chunksCount = static_cast<uint32_t>(clamp(file.size() / minChunkSize, uint64_t(1), maxChunks));
 	}
-	if (*p == '.') 
+
+	std::vector<OBJChunk> chunks(chunksCount);
+	const char* chunkBegin = fileBegin;
+	for (uint32_t i = 0; i < chunksCount; ++i)
 	{
-		float f = 0.0f;
-		int32_t n = 0;
-		++p;
-		while (*p >= '0' && *p <= '9') 
+		const char* chunkEnd = fileEnd;
+		if (i + 1 < chunksCount)
 		{
-			f = (f * 10.0f) + (*p - '0');
-			++p;
-			++n;
+			chunkEnd = std::max(chunkBegin, fileBegin + file.size() * (i + 1) / chunksCount);
+			chunkEnd = text::findCharacter(chunkEnd, fileEnd, ET_NEWLINE);
+			chunkEnd = (chunkEnd < fileEnd) ? chunkEnd + 1 : fileEnd;
 		}
-		r += f / std::pow(10.0f, n);
+		chunks[i].begin = chunkBegin;
+		chunks[i].end = chunkEnd;
+		chunkBegin = chunkEnd;
 	}
-	return neg ? -r : r;
-}
 
-int64_t naive_atoll(char* ptr)
-{
-	int64_t result = 0;
-	while (*ptr)
+	sharedJobSystem().parallelFor(0, chunksCount, [this, &chunks](uint32_t begin, uint32_t end)
 	{
-		result = (result * 10) + (*ptr - 48);
-		++ptr;
-	}
-	return result;
-}
+		for (uint32_t i = begin; i < end; ++i)
+			parseChunk(chunks[i]);
+	}, 1);
 
-void OBJLoader::load(ObjectsCache& cache)
-{
-	uint32_t lineNumber = 0;
+	/*
+	 * prefix sums of the chunk sizes give offsets of chunk data in the merged arrays
+	 * and bases for the relative links, copying and fixing links is done in parallel
+	 */
+	uint32_t linesCount = 0;
+	uint32_t vertexCount = static_cast<uint32_t>(_vertices.size());
+	uint32_t normalCount = static_cast<uint32_t>(_normals.size());
+	uint32_t texCoordCount = static_cast<uint32_t>(_texCoords.size());
+	for (OBJChunk& chunk : chunks)
+	{
+		chunk.lineBase = linesCount;
+		chunk.vertexBase = vertexCount;
+		chunk.normalBase = normalCount;
+		chunk.texCoordBase = texCoordCount;
+		linesCount += chunk.linesCount;
+		vertexCount += static_cast<uint32_t>(chunk.vertices.size());
+		normalCount += static_cast<uint32_t>(chunk.normals.size());
+		texCoordCount += static_cast<uint32_t>(chunk.texCoords.size());
+	}
+	_vertices.resize(vertexCount);
+	_normals.resize(normalCount);
+	_texCoords.resize(texCoordCount);
 
-	auto trimWhitespace = [](char* begin, char* end) -> char* {
-		
-		while (isWhitespaceChar(*begin))
-			++begin;
+	sharedJobSystem().parallelFor(0, chunksCount, [this, &chunks](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			OBJChunk& chunk = chunks[i];
+			std::copy(chunk.vertices.begin(), chunk.vertices.end(), _vertices.begin() + chunk.vertexBase);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), _normals.begin() + chunk.normalBase);
+			std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), _texCoords.begin() + chunk.texCoordBase);
 
-		while ((end > begin) && (isWhitespaceChar(*(end - 1)))) {
-			*(end - 1) = 0;
-			--end;
+			const uint32_t bases[OBJFace::MaxVertexSize] = { chunk.vertexBase, chunk.texCoordBase, chunk.normalBase, 0 };
+			for (OBJFace& face : chunk.faces)
+			{
+				for (uint32_t bit = 0; face.relativeLinks != 0; ++bit)
+				{
+					uint32_t mask = 1u << bit;
+					if (face.relativeLinks & mask)
+					{
+						uint32_t& link = face.vertexLinks[bit / OBJFace::MaxVertexSize][bit % OBJFace::MaxVertexSize];
+						link += bases[bit % OBJFace::MaxVertexSize];
+						face.relativeLinks &= ~mask;
+					}
+				}
+			}
 		}
+	}, 1);
 
-		return begin;
-	};
+	for (OBJChunk& chunk : chunks)
+	{
+		mergeChunk(chunk, cache);
+		chunk = OBJChunk();
+	}
 
-	auto readFloats = [](char* line, char* end, uint32_t count, float* dst) {
-		uint32_t floatsRead = 0;
-		char* begin = line;
-		while ((floatsRead < count) && (begin < end))
-		{
-			char* token = begin;
-			while (!isWhitespaceChar(*token))
-				++token;
-			
-			char tokenValue = *token;
+	return true;
+}
 
-			*token = 0;
-			dst[floatsRead] = naive_atof(begin);
-			*token = tokenValue;
+void OBJLoader::parseChunk(OBJChunk& chunk)
+{
+	bool swapYZ = (_loadOptions & Option_SwapYwithZ) == Option_SwapYwithZ;
 
-			begin = token + 1;
-			++floatsRead;
-		}
-	};
+	const char* pos = chunk.begin;
+	while (pos < chunk.end)
+	{
+		const char* lineEnd = text::findCharacter(pos, chunk.end, ET_NEWLINE);
+		const char* begin = text::skipWhitespace(pos, lineEnd);
+		const char* end = text::trimTrailingWhitespace(begin, lineEnd);
+		pos = lineEnd + 1;
+		++chunk.linesCount;
 
-	const uint32_t BufferSize = 256 * 1024;
-	char localBuffer[BufferSize + 3] = { };
+		if ((begin == end) || (*begin == '#'))
+			continue;
 
-	intptr_t readOffset = 0;
-	intptr_t charactersRead = 0;
-	do 
-	{
-		inputFile.read(localBuffer + readOffset, BufferSize - readOffset);
-		charactersRead = inputFile.gcount();
+		const char* keyEnd = text::skipToken(begin, end);
+		const char* value = text::skipWhitespace(keyEnd, end);
+		size_t keyLength = static_cast<size_t>(keyEnd - begin);
 
-		intptr_t currentBufferLength = readOffset + charactersRead;
-		if (currentBufferLength > 0)
+		auto addDirective = [&chunk, value, end](OBJDirective::Type type)
+		{
+			chunk.directives.emplace_back();
+			chunk.directives.back().type = type;
+			chunk.directives.back().faceIndex = static_cast<uint32_t>(chunk.faces.size());
+			chunk.directives.back().line = chunk.linesCount;
+			chunk.directives.back().value.assign(value, end);
+		};
+
+		if ((keyLength == 1) && (*begin == 'v'))
+		{
+			chunk.vertices.emplace_back();
+			text::parseFloats(value, end, chunk.vertices.back().data(), 3);
+			if (swapYZ)
+				std::swap(chunk.vertices.back().y, chunk.vertices.back().z);
+		}
+		else if ((keyLength == 2) && (begin[0] == 'v') && (begin[1] == 'n'))
+		{
+			chunk.normals.emplace_back();
+			text::parseFloats(value, end, chunk.normals.back().data(), 3);
+			if (swapYZ)
+				std::swap(chunk.normals.back().y, chunk.normals.back().z);
+		}
+		else if ((keyLength == 2) && (begin[0] == 'v') && (begin[1] == 't'))
 		{
-			localBuffer[readOffset + charactersRead] = 0;
-			readOffset = 0;
+			chunk.texCoords.emplace_back();
+			text::parseFloats(value, end, chunk.texCoords.back().data(), 2);
+		}
+		else if ((keyLength == 1) && (*begin == 'f'))
+		{
+			chunk.faces.emplace_back();
+			OBJFace& face = chunk.faces.back();
+
+			const uint32_t localCounts[OBJFace::MaxVertexSize] = { static_cast<uint32_t>(chunk.vertices.size()),
+				static_cast<uint32_t>(chunk.texCoords.size()), static_cast<uint32_t>(chunk.normals.size()), 0 };
 
-			char* begin = localBuffer;
-			char* end = begin;
-			while ((end - localBuffer) < currentBufferLength)
+			const char* link = value;
+			while (link < end)
 			{
-				end = begin;
-				while ((*end != 0) && (*end != '\n'))
-					++end;
+				const char* linkEnd = text::skipToken(link, end);
+				ET_ASSERT(face.vertexLinksCount < OBJFace::MaxVertexLinks);
 
-				if ((*end == '\n') || ((*end == 0) && inputFile.eof()))
+				OBJFace::VertexLink& vertexLink = face.vertexLinks[face.vertexLinksCount];
+				vertexLink.fill(0);
+
+				uint32_t component = 0;
+				while ((link < linkEnd) && (component < OBJFace::MaxVertexSize))
 				{
-					*end = 0;
+					if (*link != '/')
 					{
-						++lineNumber;
-
-						char* line_begin = begin;
-						char* local_end = end;
-						char* local_begin = trimWhitespace(line_begin, local_end);
-						if ((*local_begin == '#') || ((local_end - local_begin) == 0))
-						{
-							begin = end + 1;
-							continue;
-						}
-						
-						char* keyEnd = local_begin;
-						while (!isWhitespaceChar(*keyEnd))
-							++keyEnd;
-
-						char* key = local_begin;
-						*keyEnd = 0;
-
-						char* local_value = trimWhitespace(keyEnd + 1, local_end);
-
-						bool recognized = true;
-						switch (*key)
-						{
-						case 'm':
+						int64_t linkValue = 0;
+						text::parseInteger(link, linkEnd, linkValue);
+						if (linkValue < 0)
 						{
-							if (strcmp(key, "mtllib") == 0)
-							{
-								loadMaterials(std::string(local_value, local_end - local_value), cache);
-							}
-							else
-							{
-								recognized = false;
-							}
-							break;
+							vertexLink[component] = localCounts[component] - static_cast<uint32_t>(-linkValue);
+							face.relativeLinks |= 1u << (OBJFace::MaxVertexSize * face.vertexLinksCount + component);
 						}
-						case 'g':
-						{
-							_groups.emplace_back(local_value, _lastUsedMaterial, _sizeEstimate);
-							break;
-						}
-						case 'u':
-						{
-							if (strcmp(key, "usemtl") == 0)
-							{
-								bool addGroup = _groups.empty() ||
-									((strlen(_groups.back().material) > 0) && (strcmp(_groups.back().material, local_value) != 0));
-
-								if (addGroup)
-								{
-									char buffer[OBJGroup::MaxGroupName] = {};
-									sprintf(buffer, "group-%u-%s", static_cast<uint32_t>(_groups.size()), local_value);
-									_groups.emplace_back(buffer, local_value, _sizeEstimate);
-								}
-								else
-								{
-									size_t stringSize = std::min(static_cast<size_t>(OBJGroup::MaxMaterialName), strlen(local_value) + 1);
-									strncpy(_groups.back().material, local_value, stringSize);
-								}
-
-								memset(_lastUsedMaterial, 0, sizeof(_lastUsedMaterial));
-								strcpy(_lastUsedMaterial, local_value);
-							}
-							else
-							{
-								recognized = false;
-							}
-							break;
-						}
-						case 'v':
-						{
-							switch (*(key + 1))
-							{
-							case 0:
-							{
-								_vertices.emplace_back();
-								readFloats(local_value, local_end, 3, _vertices.back().data());
-								break;
-							}
-							case 'n':
-							{
-								_normals.emplace_back();
-								readFloats(local_value, local_end, 3, _normals.back().data());
-								break;
-							}
-							case 't':
-							{
-								_texCoords.emplace_back();
-								readFloats(local_value, local_end, 2, _texCoords.back().data());
-								break;
-							}
-							default:
-								recognized = false;
-							}
-							break;
-						}
-						case 'f':
+						else
 						{
-							if (_groups.empty())
-							{
-								char buffer[OBJGroup::MaxGroupName] = {};
-								sprintf(buffer, "group-%u", static_cast<uint32_t>(_groups.size()));
-								_groups.emplace_back(buffer, _sizeEstimate);
-							}
-
-							_groups.back().faces.emplace_back();
-							OBJFace& face = _groups.back().faces.back();
-
-							while (local_value < local_end)
-							{
-								char* valueEnd = local_value;
-								while ((valueEnd < local_end) && !isWhitespaceChar(*valueEnd))
-									++valueEnd;
-
-								char valueKey = *valueEnd;
-								*valueEnd = 0;
-
-								char* link = local_value;
-								char* linkEnd = link;
-
-								uint32_t linkIndex = 0;
-								while (link < valueEnd)
-								{
-									char endValue = *linkEnd;
-									if ((endValue == '/') || (endValue == 0))
-									{
-										*linkEnd = 0;
-
-										if (linkEnd > link)
-										{
-											int64_t linkValue = naive_atoll(link);
-											ET_ASSERT(linkValue > 0);
-											ET_ASSERT(face.vertexLinksCount < OBJFace::MaxVertexLinks);
-
-											face.vertexLinks[face.vertexLinksCount][linkIndex] = static_cast<uint32_t>(linkValue - 1);
-											*linkEnd = endValue;
-										}
-										++linkIndex;
-
-										link = linkEnd + 1;
-									}
-									++linkEnd;
-								}
-
-								++face.vertexLinksCount;
-
-								*valueEnd = valueKey;
-								local_value = valueEnd + 1;
-							}
-							break;
+							ET_ASSERT(linkValue > 0);
+							vertexLink[component] = static_cast<uint32_t>(linkValue - 1);
 						}
-						case 's':
-						case 'o':
-							break;
+					}
 
-						default:
-							recognized = false;
-							break;
-						}
+					if ((link < linkEnd) && (*link == '/'))
+						++link;
 
-						if (!recognized)
-						{
-							log::warning("Unsupported entry `%s` in OBJ file at line %u", key, lineNumber);
-						}
-					}
-					begin = end + 1;
-				}
-				else
-				{
-					readOffset = end - begin;
-					memmove(localBuffer, begin, readOffset);
+					++component;
 				}
+
+				++face.vertexLinksCount;
+				link = text::skipWhitespace(linkEnd, end);
 			}
 		}
-	} while (charactersRead > 0);
-}
-
-void OBJLoader::loadData(ObjectsCache& cache)
-{
-	std::string line;
-	uint32_t lineNumber = 0;
-	char key = 0;
-	while (inputFile.is_open() && !inputFile.eof())
-	{
-		++lineNumber;
-		inputFile >> key;
-		
-		if (inputFile.eof()) 
-			break;
-		
-		key = static_cast<char>(tolower(key));
-		
-		if (key == '#')
+		else if ((keyLength == 1) && (*begin == 'g'))
 		{
-			getLine(inputFile, line);
+			addDirective(OBJDirective::Type::Group);
 		}
-		else if (key == 'm') // mtllib
+		else if ((keyLength == 1) && (*begin == 's'))
 		{
-			std::string mtllib;
-			inputFile >> mtllib;
-			lowercase(mtllib);
-			
-			if (mtllib.compare("tllib") == 0)
-			{
-				std::string matName;
-				inputFile >> matName;
-				loadMaterials(matName, cache);
-			}
-			else
-			{
-				std::cout << "Unresolved symbol: " << key << mtllib << std::endl;
-			}
+			addDirective(OBJDirective::Type::Smoothing);
 		}
-		else if (key == 'o') // object, ignored for now
+		else if ((keyLength == 1) && (*begin == 'o'))
 		{
-			getLine(inputFile, line);
+			continue;
 		}
-		else if (key == 'g') // group
+		else if ((keyLength == 6) && (strncmp(begin, "usemtl", keyLength) == 0))
 		{
-			getLine(inputFile, line);
-			trim(line);
-			
-			if (!_groups.empty())
-			{
-				_groups.back().faces.shrink_to_fit();
-			}
-
-            _groups.emplace_back(line, _sizeEstimate);
+			addDirective(OBJDirective::Type::Material);
 		}
-		else if (key == 'u') // group's material
+		else if ((keyLength == 6) && (strncmp(begin, "mtllib", keyLength) == 0))
 		{
-			std::string usemtl;
-			inputFile >> usemtl;
-			lowercase(usemtl);
-			
-			if (usemtl.compare("semtl") == 0) 
-			{
-				std::string materialId;
-				inputFile >> materialId;
-				
-                if (_groups.empty())
-                {
-                    auto groupName = "group-" + intToStr(_lastGroupId++) + "-" + materialId;
-					_groups.emplace_back(groupName, materialId, static_cast<uint32_t>(_sizeEstimate));
-                }
-                else if ((strlen(_groups.back().material) == 0) || _groups.back().material == materialId)
-                {
-					size_t stringSize = std::min(static_cast<size_t>(OBJGroup::MaxMaterialName), materialId.size());
-					strncpy(_groups.back().material, materialId.c_str(), stringSize);
-                }
-				getLine(inputFile, line);
-			}
-			else
-			{
-				std::cout << "Unresolved symbol " << key << usemtl << ". Current group: " << _groups.back().name << std::endl;
-			}
+			addDirective(OBJDirective::Type::MaterialLibrary);
 		}
-		else if (key == 's') // smoothing group
+		else
 		{
-            if (_groups.empty())
-            {
-                _groups.emplace_back("group-" + intToStr(_lastGroupId++), _sizeEstimate);
-            }
-			getLine(inputFile, line);
-			_lastSmoothGroup = (line.compare("off") == 0) ? 0 : strToInt(line);
+			chunk.directives.emplace_back();
+			chunk.directives.back().type = OBJDirective::Type::Unsupported;
+			chunk.directives.back().faceIndex = static_cast<uint32_t>(chunk.faces.size());
+			chunk.directives.back().line = chunk.linesCount;
+			chunk.directives.back().value.assign(begin, keyEnd);
 		}
-		else if (key == 'f') // faces
-		{
-			OBJFace face;
-			std::getline(inputFile, line);
-			trim(line);
-			
-			static StringList faces;
-			faces.reserve(5);
-			faces.clear();
+	}
+}
 
-			splitAndWrite(line, ' ', [](const std::string& s) {
-				faces.emplace_back(s);
-			});
-			ET_ASSERT((faces.size() > 2) && (faces.size() < OBJFace::MaxVertexLinks));
+void OBJLoader::mergeChunk(OBJChunk& chunk, ObjectsCache& cache)
+{
+	uint32_t faceIndex = 0;
+	auto appendFaces = [this, &chunk, &faceIndex](uint32_t until)
+	{
+		if (until <= faceIndex)
+			return;
 
-			for (auto inFace : faces)
-			{
-				static Vector<int32_t> indexes;
-				indexes.reserve(3);
-				indexes.clear();
+		if (_groups.empty())
+		{
+			char buffer[OBJGroup::MaxGroupName] = {};
+			sprintf(buffer, "group-%u", static_cast<uint32_t>(_groups.size()));
+			_groups.emplace_back(buffer, _sizeEstimate);
+		}
 
-				splitAndWrite(inFace, '/', [](const std::string& s)
-					{ indexes.push_back(strToInt(s)); });
+		std::vector<OBJFace>& faces = _groups.back().faces;
+		size_t firstFace = faces.size();
+		faces.insert(faces.end(), chunk.faces.begin() + faceIndex, chunk.faces.begin() + until);
+		for (size_t i = firstFace, e = faces.size(); i < e; ++i)
+			faces[i].smoothingGroupIndex = static_cast<uint32_t>(_lastSmoothGroup);
 
-				uint32_t i = 0;
-				face.vertexLinks[face.vertexLinksCount].fill(0);
-				for (auto iValue : indexes)
-				{
-					if (iValue == std::numeric_limits<int32_t>::max())
-					{
-					}
-					else if (iValue < 0)
-					{
-						uint32_t szValue = static_cast<uint32_t>(-iValue);
-						if (i == 0)
-						{
-							ET_ASSERT(szValue <= _vertices.size());
-							face.vertexLinks[face.vertexLinksCount][i] = static_cast<uint32_t>(_vertices.size() - szValue);
-						}
-						else if (i == 1)
-						{
-							ET_ASSERT(szValue <= _texCoords.size());
-							face.vertexLinks[face.vertexLinksCount][i] = static_cast<uint32_t>(_texCoords.size() - szValue);
-						}
-						else if (i == 2)
-						{
-							ET_ASSERT(szValue <= _normals.size());
-							face.vertexLinks[face.vertexLinksCount][i] = static_cast<uint32_t>(_normals.size() - szValue);
-						}
-					}
-					else
-					{
-						face.vertexLinks[face.vertexLinksCount][i] = iValue - 1;
-					}
-					++i;
-				}
-				
-				++face.vertexLinksCount;
-			}
-			
-			if (_groups.empty())
-			{
-                _groups.emplace_back("group-" + intToStr(_lastGroupId++), _sizeEstimate);
-			}
-			
-			_groups.back().faces.push_back(face);
-		}
-		else if (key == 'v')
-		{
-			char subKey = static_cast<char>(inputFile.peek());
-			
-			if (subKey == 't')
-			{
-				vec2 vertex(0.0f);
-				inputFile >> subKey >> vertex;
-				_texCoords.push_back(vertex);
-			}
-			else if (subKey == 'n')
-			{
-				vec3 vertex(0.0f);
-				inputFile >> subKey >> vertex;
+		faceIndex = until;
+	};
 
-				if ((_loadOptions & Option_SwapYwithZ) == Option_SwapYwithZ)
-					std::swap(vertex.y, vertex.z);
+	for (const OBJDirective& directive : chunk.directives)
+	{
+		appendFaces(directive.faceIndex);
+		applyDirective(directive, chunk.lineBase, cache);
+	}
+	appendFaces(static_cast<uint32_t>(chunk.faces.size()));
+}
 
-				_normals.push_back(vertex);
-			}
-			else if (isWhitespaceChar(subKey))
-			{
-				vec3 vertex(0.0f);
-				inputFile >> vertex;
+void OBJLoader::applyDirective(const OBJDirective& directive, uint32_t lineBase, ObjectsCache& cache)
+{
+	const char* value = directive.value.c_str();
+	switch (directive.type)
+	{
+	case OBJDirective::Type::Group:
+	{
+		_groups.emplace_back(value, _lastUsedMaterial, _sizeEstimate);
+		break;
+	}
 
-				if ((_loadOptions & Option_SwapYwithZ) == Option_SwapYwithZ)
-					std::swap(vertex.y, vertex.z);
+	case OBJDirective::Type::Material:
+	{
+		bool addGroup = _groups.empty() ||
+			((strlen(_groups.back().material) > 0) && (strcmp(_groups.back().material, value) != 0));
 
-				_vertices.push_back(vertex);
-			}
-			else
-			{
-				getLine(inputFile, line);
-				log::warning("Unknown line [%u] `%s`", lineNumber, line.c_str());
-			}
+		if (addGroup)
+		{
+			char buffer[OBJGroup::MaxGroupName] = {};
+			snprintf(buffer, sizeof(buffer), "group-%u-%s", static_cast<uint32_t>(_groups.size()), value);
+			_groups.emplace_back(buffer, value, _sizeEstimate);
 		}
 		else
 		{
-			getLine(inputFile, line);
-			log::warning("Unknown line [%u] `%c%s`", lineNumber, key, line.c_str());
+			size_t stringSize = std::min(static_cast<size_t>(OBJGroup::MaxMaterialName), strlen(value) + 1);
+			strncpy(_groups.back().material, value, stringSize);
 		}
+
+		memset(_lastUsedMaterial, 0, sizeof(_lastUsedMaterial));
+		strncpy(_lastUsedMaterial, value, sizeof(_lastUsedMaterial) - 1);
+		break;
+	}
+
+	case OBJDirective::Type::Smoothing:
+	{
+		_lastSmoothGroup = (directive.value == "off") ? 0 : static_cast<int>(text::parseInteger(text::Range(directive.value)));
+		break;
+	}
+
+	case OBJDirective::Type::MaterialLibrary:
+	{
+		loadMaterials(directive.value, cache);
+		break;
+	}
+
+	default:
+		log::warning("Unsupported entry `%s` in OBJ file at line %u", value, lineBase + directive.line);
 	}
 }
 
+OBJLoader::Statistics OBJLoader::statistics() const
+{
+	Statistics result;
+	result.vertices = _vertices.size();
+	result.normals = _normals.size();
+	result.texCoords = _texCoords.size();
+	result.groups = _groups.size();
+	for (const OBJGroup& group : _groups)
+		result.faces += group.faces.size();
+	return result;
+}
+
 s3d::ElementContainer::Pointer OBJLoader::load(et::RenderInterface::Pointer ren, s3d::Storage& storage, ObjectsCache& cache)
 {
 	storage.flush();
 
+	_renderer = ren;
+
 	bool cacheLoaded = false;
 	if (fileExists(cacheFileName))
 	{
-		cacheLoaded = loadCached(cacheFileName);
+		uint64_t t1 = queryCurrentTimeInMicroSeconds();
+		cacheLoaded = loadCached(cacheFileName, cache);
+		if (cacheLoaded)
+		{
+			uint64_t loadingTime = queryCurrentTimeInMicroSeconds() - t1;
+			log::info("OBJ loaded from cache %s: %llu.%03llums", cacheFileName.c_str(), loadingTime / 1000, loadingTime % 1000);
+		}
 	}
 
 	if (cacheLoaded == false)
@@ -651,7 +469,6 @@ s3d::ElementContainer::Pointer OBJLoader::load(et::RenderInterface::Pointer ren,
 		_sizeEstimate = std::max(1024llu, fileSize / 128);
 		log::info("Loading OBJ, estimated array sizes: %llu", _sizeEstimate);
 
-		_renderer = ren;
 		_groups.reserve(128);
 		_vertices.reserve(_sizeEstimate);
 		_normals.reserve(_sizeEstimate);
@@ -662,15 +479,18 @@ s3d::ElementContainer::Pointer OBJLoader::load(et::RenderInterface::Pointer ren,
 
 		uint64_t t1 = queryCurrentTimeInMicroSeconds();
 
-		load(cache);
+		parse(cache);
 		uint64_t t2 = queryCurrentTimeInMicroSeconds();
 
 		processLoadedData();
-		// saveCache(cacheFileName);
-		// uint64_t t3 = queryCurrentTimeInMicroSeconds();
+		uint64_t t3 = queryCurrentTimeInMicroSeconds();
+
+		saveCache(cacheFileName);
 
 		uint64_t loadingTime = t2 - t1;
-		log::info("OBJ loading time: %llu.%3llums", loadingTime / 1000, loadingTime % 1000);
+		uint64_t processingTime = t3 - t2;
+		log::info("OBJ loading time: %llu.%03llums, processing time: %llu.%03llums", loadingTime / 1000, loadingTime % 1000,
+			processingTime / 1000, processingTime % 1000);
 	}
 
 	s3d::ElementContainer::Pointer result = generateVertexBuffers(storage);
@@ -692,6 +512,7 @@ void OBJLoader::loadMaterials(const std::string& fileName, ObjectsCache& cache)
 
 	application().pushSearchPath(inputFilePath);
 	_loadedMaterials.insert(filePath);
+	_materialLibraries.push_back(fileName);
 	
 	materialFile.open(filePath.c_str());
 	if (!materialFile.is_open())
@@ -1063,16 +884,9 @@ void OBJLoader::processLoadedData()
 		}
 	}
 
-	for (MaterialInstance::Pointer& mat : _materials)
-	{
-		if (mat->texture(MaterialTexture::BaseColor).invalid())
-			mat->setTexture(MaterialTexture::BaseColor, _renderer->whiteTexture());
-		if (mat->texture(MaterialTexture::Normal).invalid())
-			mat->setTexture(MaterialTexture::Normal, _renderer->flatNormalTexture());
-		if (mat->texture(MaterialTexture::Opacity).invalid())
-			mat->setTexture(MaterialTexture::Opacity, _renderer->whiteTexture());
-	}
-	uint32_t totalVertices = 3 * totalTriangles;
+	assignDefaultTextures();
+
+	uint32_t totalIndices = 3 * totalTriangles;
 	
 	bool hasNormals = _normals.size() > 0;
 	bool hasTexCoords = _texCoords.size() > 0;
@@ -1088,29 +902,67 @@ void OBJLoader::processLoadedData()
 			decl.push_back(VertexAttributeUsage::Tangent, DataType::Vec3);
 	}
 
-	IndexArrayFormat fmt = (totalVertices > 65535) ? IndexArrayFormat::Format_32bit : IndexArrayFormat::Format_16bit;
-	
-	log::info("Index array + vertex storage: %u vertices", totalVertices);
-	_indices = IndexArray::Pointer::create(fmt, totalVertices, PrimitiveType::Triangles);
-	_indices->linearize(totalVertices);
-	
-	_vertexData = VertexStorage::Pointer::create(decl, totalVertices);
+	/*
+	 * identical (position, texcoord, normal) links within a group are welded into a single vertex.
+	 * Emitted vertices are chained by position index, which serves as a hash of the link,
+	 * chains are newest first, so lookup stops at the first vertex of the previous group.
+	 * When file has no normals, vertices are welded within the same smoothing group only,
+	 * so calculated normals stay faceted outside of smoothing groups.
+	 */
+	struct WeldedVertex
+	{
+		uint32_t position = 0;
+		uint32_t texCoord = 0;
+		uint32_t normal = 0;
+		uint32_t smoothingGroup = 0;
+		uint32_t group = 0;
+	};
+	const uint32_t InvalidVertex = IndexArray::MaxIndex;
+
+	Vector<uint32_t> lastVertexForPosition(_vertices.size(), InvalidVertex);
+	Vector<uint32_t> previousVertex;
+	Vector<WeldedVertex> vertices;
+	previousVertex.reserve(totalIndices / 4);
+	vertices.reserve(totalIndices / 4);
+
+	Vector<uint32_t> indices;
+	indices.reserve(totalIndices);
+
+	Vector<vec3> centers;
+	centers.reserve(_groups.size());
+
+	auto weld = [&](const OBJFace::VertexLink& link, uint32_t smoothingGroup, uint32_t group, uint32_t groupFirstVertex) -> uint32_t
+	{
+		WeldedVertex key;
+		key.position = link[0];
+		key.texCoord = hasTexCoords ? link[1] : 0;
+		key.normal = hasNormals ? link[2] : 0;
+		key.smoothingGroup = hasNormals ? 0 : smoothingGroup;
+		key.group = group;
+
+		uint32_t& last = lastVertexForPosition[key.position];
+		if (hasNormals || (smoothingGroup > 0))
+		{
+			for (uint32_t v = last; (v != InvalidVertex) && (v >= groupFirstVertex); v = previousVertex[v])
+			{
+				const WeldedVertex& candidate = vertices[v];
+				if ((candidate.texCoord == key.texCoord) && (candidate.normal == key.normal) && (candidate.smoothingGroup == key.smoothingGroup))
+					return v;
+			}
+		}
+
+		uint32_t result = static_cast<uint32_t>(vertices.size());
+		vertices.push_back(key);
+		previousVertex.push_back(last);
+		last = result;
+		return result;
+	};
 
-	auto pos = _vertexData->accessData<DataType::Vec3>(VertexAttributeUsage::Position, 0);
-	
-	VertexDataAccessor<DataType::Vec3> nrm;
-	if (_vertexData->hasAttributeWithType(VertexAttributeUsage::Normal, DataType::Vec3))
-		nrm = _vertexData->accessData<DataType::Vec3>(VertexAttributeUsage::Normal, 0);
-	
-	VertexDataAccessor<DataType::Vec2> tex;
-	if (_vertexData->hasAttributeWithType(VertexAttributeUsage::TexCoord0, DataType::Vec2))
-		tex = _vertexData->accessData<DataType::Vec2>(VertexAttributeUsage::TexCoord0, 0);
-	
-	uint32_t index = 0;
-	
 	for (const OBJGroup& group : _groups)
 	{
-		uint32_t startIndex = index;
+		uint32_t groupIndex = static_cast<uint32_t>(centers.size());
+		uint32_t groupFirstVertex = static_cast<uint32_t>(vertices.size());
+		uint32_t startIndex = static_cast<uint32_t>(indices.size());
 		
 		vec3 center(0.0f);
 		
@@ -1133,52 +985,83 @@ void OBJLoader::processLoadedData()
 			if (vertexCount > 0.0f)
 				center /= static_cast<float>(vertexCount);
 		}
+		centers.push_back(center);
 		
 		for (const OBJFace& face : group.faces)
 		{
 			uint32_t numTriangles = face.vertexLinksCount - 2;
 			for (uint32_t i = 1; i <= numTriangles; ++i)
 			{
-				pos[index+0] = _vertices[face.vertexLinks[0][0]] - center;
-				pos[index+1] = _vertices[face.vertexLinks[i][0]] - center;
-				pos[index+2] = _vertices[face.vertexLinks[i+1][0]] - center;
-				if (hasTexCoords)
-				{
-					tex[index+0] = _texCoords[face.vertexLinks[0][1]];
-					tex[index+1] = _texCoords[face.vertexLinks[i][1]];
-					tex[index+2] = _texCoords[face.vertexLinks[i+1][1]];
-				}
-				if (hasNormals)
-				{
-					nrm[index+0] = _normals[face.vertexLinks[0][2]];
-					nrm[index+1] = _normals[face.vertexLinks[i][2]];
-					nrm[index+2] = _normals[face.vertexLinks[i+1][2]];
-				}
-				index += 3;
+				indices.push_back(weld(face.vertexLinks[0], face.smoothingGroupIndex, groupIndex, groupFirstVertex));
+				indices.push_back(weld(face.vertexLinks[i], face.smoothingGroupIndex, groupIndex, groupFirstVertex));
+				indices.push_back(weld(face.vertexLinks[i+1], face.smoothingGroupIndex, groupIndex, groupFirstVertex));
 			}
 		}
 
-		MaterialInstance::Pointer m;
-		for (const MaterialInstance::Pointer& mat : _materials)
-		{
-			if (mat->name() == group.material)
-			{
-				m = mat;
-				break;
-			}
-		}
+		uint32_t numIndexes = static_cast<uint32_t>(indices.size()) - startIndex;
+		_meshes.emplace_back(group.name, startIndex, numIndexes, findMaterial(group.material, group.name), center);
+	}
 
-		if (m.invalid())
-		{
-			log::error("Unable to find material `%s` for group `%s`", group.material, group.name);
-			Material::Pointer microfacet = _renderer->sharedMaterialLibrary().loadDefaultMaterial(DefaultMaterial::Microfacet);
-			m = microfacet->instance();
-			m->setName("missing_material");
-		}
-		
-		uint32_t startIndex_u32 = static_cast<uint32_t>(startIndex);
-		uint32_t numIndexes_u32 = static_cast<uint32_t>(index - startIndex);
-		_meshes.emplace_back(group.name, startIndex_u32, numIndexes_u32, m, center);
+	/*
+	 * triangles are reordered for post-transform cache within each mesh (so index ranges are preserved),
+	 * large meshes are split into independent chunks, which are optimized in parallel,
+	 * then vertices are renumbered in order of the first use to make vertex fetch linear
+	 */
+	const uint32_t reportedCacheSize = 16;
+	const uint32_t optimizationChunkSize = 3 * 65536;
+	float initialCacheMissRatio = primitives::averageCacheMissRatio(indices.data(), totalIndices, reportedCacheSize);
+
+	uint64_t optimizationStartTime = queryCurrentTimeInMicroSeconds();
+	Vector<std::pair<uint32_t, uint32_t>> optimizationChunks;
+	for (const OBJMeshIndexBounds& mesh : _meshes)
+	{
+		for (uint32_t offset = 0; offset < mesh.count; offset += optimizationChunkSize)
+			optimizationChunks.emplace_back(mesh.start + offset, std::min(optimizationChunkSize, mesh.count - offset));
+	}
+
+	sharedJobSystem().parallelFor(0, static_cast<uint32_t>(optimizationChunks.size()), [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+			primitives::optimizeVertexCache(indices.data() + optimizationChunks[i].first, optimizationChunks[i].second);
+	}, 1);
+
+	Vector<uint32_t> vertexOrder;
+	primitives::optimizeVertexFetch(indices.data(), totalIndices, static_cast<uint32_t>(vertices.size()), vertexOrder);
+	uint64_t optimizationTime = queryCurrentTimeInMicroSeconds() - optimizationStartTime;
+
+	float optimizedCacheMissRatio = primitives::averageCacheMissRatio(indices.data(), totalIndices, reportedCacheSize);
+	log::info("OBJ vertices welded: %u -> %u, ACMR (FIFO %u): %.3f -> %.3f, optimized in %llu.%03llums", totalIndices,
+		static_cast<uint32_t>(vertexOrder.size()), reportedCacheSize, initialCacheMissRatio, optimizedCacheMissRatio,
+		optimizationTime / 1000, optimizationTime % 1000);
+
+	uint32_t totalVertices = static_cast<uint32_t>(vertexOrder.size());
+	IndexArrayFormat fmt = (totalVertices > 65535) ? IndexArrayFormat::Format_32bit : IndexArrayFormat::Format_16bit;
+	
+	log::info("Index array + vertex storage: %u indices, %u vertices", totalIndices, totalVertices);
+	_indices = IndexArray::Pointer::create(fmt, totalIndices, PrimitiveType::Triangles);
+	for (uint32_t i = 0; i < totalIndices; ++i)
+		_indices->setIndex(indices[i], i);
+	
+	_vertexData = VertexStorage::Pointer::create(decl, totalVertices);
+
+	auto pos = _vertexData->accessData<DataType::Vec3>(VertexAttributeUsage::Position, 0);
+	
+	VertexDataAccessor<DataType::Vec3> nrm;
+	if (_vertexData->hasAttributeWithType(VertexAttributeUsage::Normal, DataType::Vec3))
+		nrm = _vertexData->accessData<DataType::Vec3>(VertexAttributeUsage::Normal, 0);
+	
+	VertexDataAccessor<DataType::Vec2> tex;
+	if (_vertexData->hasAttributeWithType(VertexAttributeUsage::TexCoord0, DataType::Vec2))
+		tex = _vertexData->accessData<DataType::Vec2>(VertexAttributeUsage::TexCoord0, 0);
+
+	for (uint32_t i = 0; i < totalVertices; ++i)
+	{
+		const WeldedVertex& vertex = vertices[vertexOrder[i]];
+		pos[i] = _vertices[vertex.position] - centers[vertex.group];
+		if (hasTexCoords)
+			tex[i] = _texCoords[vertex.texCoord];
+		if (hasNormals)
+			nrm[i] = _normals[vertex.normal];
 	}
 	
 	if (!hasNormals)
@@ -1188,6 +1071,34 @@ void OBJLoader::processLoadedData()
 		primitives::calculateTangents(_vertexData, _indices, 0, _indices->primitivesCount() & 0xffffffff);
 }
 
+void OBJLoader::assignDefaultTextures()
+{
+	for (MaterialInstance::Pointer& mat : _materials)
+	{
+		if (mat->texture(MaterialTexture::BaseColor).invalid())
+			mat->setTexture(MaterialTexture::BaseColor, _renderer->whiteTexture());
+		if (mat->texture(MaterialTexture::Normal).invalid())
+			mat->setTexture(MaterialTexture::Normal, _renderer->flatNormalTexture());
+		if (mat->texture(MaterialTexture::Opacity).invalid())
+			mat->setTexture(MaterialTexture::Opacity, _renderer->whiteTexture());
+	}
+}
+
+MaterialInstance::Pointer OBJLoader::findMaterial(const std::string& material, const std::string& group)
+{
+	for (const MaterialInstance::Pointer& mat : _materials)
+	{
+		if (mat->name() == material)
+			return mat;
+	}
+
+	log::error("Unable to find material `%s` for group `%s`", material.c_str(), group.c_str());
+	Material::Pointer microfacet = _renderer->sharedMaterialLibrary().loadDefaultMaterial(DefaultMaterial::Microfacet);
+	MaterialInstance::Pointer result = microfacet->instance();
+	result->setName("missing_material");
+	return result;
+}
+
 s3d::ElementContainer::Pointer OBJLoader::generateVertexBuffers(s3d::Storage& storage)
 {
 	s3d::ElementContainer::Pointer result = s3d::ElementContainer::Pointer::create(inputFileName, nullptr);
@@ -1225,52 +1136,205 @@ s3d::ElementContainer::Pointer OBJLoader::generateVertexBuffers(s3d::Storage& st
 	return result;
 }
 
-void OBJLoader::threadFinished()
+bool OBJLoader::loadCached(const std::string& fileName, ObjectsCache& cache)
 {
-	ET_FAIL("TODO");
+	MappedFile::Pointer file = MappedFile::Pointer::create(fileName);
+
+	OBJCacheHeader header;
+	if (!readOBJCacheHeader(file, header) || (header.loadOptions != _loadOptions))
+	{
+		log::info("OBJ cache %s is not compatible and will be rebuilt", fileName.c_str());
+		return false;
+	}
+
+	if (!sourceMatchesOBJCacheHeader(inputFileName, header))
+	{
+		log::info("OBJ cache %s is outdated and will be rebuilt", fileName.c_str());
+		return false;
+	}
+
+	struct CachedMesh
+	{
+		std::string name;
+		std::string material;
+		uint32_t start = 0;
+		uint32_t count = 0;
+		vec3 center;
+	};
+
+	std::istringstream metadata(std::string(reinterpret_cast<const char*>(file->data() + header.metadataOffset),
+		static_cast<size_t>(header.metadataSize)), std::ios::in | std::ios::binary);
+
+	VertexDeclaration decl(true);
+	decl.deserialize(metadata);
+
 	/*
-	 * TODO
-	 *
-	loaded.invoke(generateVertexBuffers(storage));
-	// */
-}
+	 * each entry takes at least 4 bytes of metadata, which limits counts read from the damaged file
+	 */
+	auto deserializeCount = [&metadata, &header]() -> uint32_t
+	{
+		uint32_t count = deserializeUInt32(metadata);
+		return (count <= header.metadataSize / 4) ? count : 0;
+	};
 
-bool OBJLoader::loadCached(const std::string& fileName)
-{
-	return false;
+	Vector<std::string> materialLibraries(deserializeCount());
+	for (std::string& library : materialLibraries)
+		library = deserializeString(metadata);
+
+	Vector<CachedMesh> meshes(deserializeCount());
+	for (CachedMesh& mesh : meshes)
+	{
+		mesh.name = deserializeString(metadata);
+		mesh.material = deserializeString(metadata);
+		mesh.start = deserializeUInt32(metadata);
+		mesh.count = deserializeUInt32(metadata);
+		mesh.center = deserializeVector<vec3>(metadata);
+	}
+
+	bool validMeshes = true;
+	for (const CachedMesh& mesh : meshes)
+		validMeshes &= (mesh.start <= header.indexCount) && (mesh.count <= header.indexCount - mesh.start);
+
+	if (metadata.fail() || !validMeshes || (decl.sizeInBytes() != header.vertexStride) ||
+		(header.vertexDataSize != static_cast<uint64_t>(header.vertexCount) * header.vertexStride) ||
+		(header.indexDataSize != static_cast<uint64_t>(header.indexCount) * header.indexFormat))
+	{
+		log::error("OBJ cache %s is corrupted and will be rebuilt", fileName.c_str());
+		return false;
+	}
+
+	for (const std::string& library : materialLibraries)
+		loadMaterials(library, cache);
+	assignDefaultTextures();
+
+	/*
+	 * payloads are stored in the final layout, so they are copied as is
+	 */
+	_vertexData = VertexStorage::Pointer::create(decl, header.vertexCount);
+	memcpy(_vertexData->data().binary(), file->data() + header.vertexDataOffset, header.vertexDataSize);
+
+	_indices = IndexArray::Pointer::create(static_cast<IndexArrayFormat>(header.indexFormat), header.indexCount,
+		static_cast<PrimitiveType>(header.primitiveType));
+	memcpy(_indices->data(), file->data() + header.indexDataOffset, header.indexDataSize);
+
+	_meshes.reserve(meshes.size());
+	for (const CachedMesh& mesh : meshes)
+		_meshes.emplace_back(mesh.name, mesh.start, mesh.count, findMaterial(mesh.material, mesh.name), mesh.center);
+
+	return true;
 }
 
 void OBJLoader::saveCache(const std::string& fileName)
 {
-	/*
 	std::string cachePath = getFilePath(fileName);
+	if (!folderExists(cachePath) && !createDirectory(cachePath, true))
+	{
+		log::error("Unable to create folder for OBJ cache %s", cachePath.c_str());
+		return;
+	}
+
+	MappedFile sourceFile(inputFileName);
+	if (!sourceFile.valid())
+		return;
+
+	std::ostringstream metadata(std::ios::out | std::ios::binary);
+
+	VertexDeclaration decl = _vertexData->declaration();
+	decl.serialize(metadata);
 
-	if (folderExists(cachePath) || createDirectory(cachePath, true))
+	serializeUInt32(metadata, static_cast<uint32_t>(_materialLibraries.size()));
+	for (const std::string& library : _materialLibraries)
+		serializeString(metadata, library);
+
+	serializeUInt32(metadata, static_cast<uint32_t>(_meshes.size()));
+	for (const OBJMeshIndexBounds& mesh : _meshes)
 	{
-		std::ofstream fOut(fileName, std::ios::binary);
-		
-		_vertexData->serialize(fOut);
-		_indices->serialize(fOut);
+		serializeString(metadata, mesh.name);
+		serializeString(metadata, mesh.material->name());
+		serializeUInt32(metadata, mesh.start);
+		serializeUInt32(metadata, mesh.count);
+		serializeVector(metadata, mesh.center);
+	}
+	std::string metadataBytes = metadata.str();
+
+	OBJCacheHeader header;
+	header.loadOptions = _loadOptions;
+	header.sourceDate = getFileDate(inputFileName);
+	header.sourceSize = sourceFile.size();
+	header.sourceHash = contentHash(sourceFile.data(), sourceFile.size());
+	header.vertexCount = _vertexData->capacity();
+	header.vertexStride = _vertexData->stride();
+	header.indexCount = _indices->capacity();
+	header.indexFormat = static_cast<uint32_t>(_indices->format());
+	header.primitiveType = static_cast<uint32_t>(_indices->primitiveType());
+	header.metadataOffset = sizeof(OBJCacheHeader);
+	header.metadataSize = metadataBytes.size();
+	header.vertexDataOffset = alignUpTo<uint64_t>(header.metadataOffset + header.metadataSize, OBJCacheDataAlignment);
+	header.vertexDataSize = _vertexData->data().size();
+	header.indexDataOffset = alignUpTo<uint64_t>(header.vertexDataOffset + header.vertexDataSize, OBJCacheDataAlignment);
+	header.indexDataSize = _indices->dataSize();
+
+	std::ofstream out(fileName, std::ios::out | std::ios::binary);
+	if (out.fail())
+	{
+		log::error("Unable to write OBJ cache %s", fileName.c_str());
+		return;
+	}
 
-		uint32_t materialsCount = static_cast<uint32_t>(_materials.size());
-		serializeUInt32(fOut, materialsCount);
-		for (const MaterialInstance::Pointer& material : _materials)
-			material->serialize(fOut);
+	char padding[OBJCacheDataAlignment] = { };
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(metadataBytes.data(), static_cast<std::streamsize>(metadataBytes.size()));
+	out.write(padding, static_cast<std::streamsize>(header.vertexDataOffset - header.metadataOffset - header.metadataSize));
+	out.write(_vertexData->data().binary(), static_cast<std::streamsize>(header.vertexDataSize));
+	out.write(padding, static_cast<std::streamsize>(header.indexDataOffset - header.vertexDataOffset - header.vertexDataSize));
+	out.write(reinterpret_cast<const char*>(_indices->data()), static_cast<std::streamsize>(header.indexDataSize));
+	out.flush();
 
-		uint32_t meshesCount = static_cast<uint32_t>(_meshes.size());
-		serializeUInt32(fOut, meshesCount);
-		for (const OBJMeshIndexBounds& mesh : _meshes)
-		{
-			serializeString(fOut, mesh.name);
-			serializeString(fOut, mesh.material->name());
-			serializeUInt32(fOut, mesh.start);
-			serializeUInt32(fOut, mesh.count);
-			serializeVector(fOut, mesh.center);
-		}
+	if (out.fail())
+	{
+		log::error("Unable to write OBJ cache %s", fileName.c_str());
+		out.close();
+		removeFile(fileName);
+	}
+}
+
+namespace
+{
+
+bool readOBJCacheHeader(const MappedFile::Pointer& file, OBJCacheHeader& header)
+{
+	if (!file->valid() || (file->size() < sizeof(OBJCacheHeader)))
+		return false;
 
-		fOut.close();
+	memcpy(&header, file->data(), sizeof(OBJCacheHeader));
+	if ((header.signature != OBJCacheSignature) || (header.version != OBJCacheVersion) || (header.endianness != OBJCacheEndianness))
+		return false;
+
+	if ((header.primitiveType >= static_cast<uint32_t>(PrimitiveType::max)) || ((header.indexFormat != static_cast<uint32_t>(IndexArrayFormat::Format_8bit)) &&
+		(header.indexFormat != static_cast<uint32_t>(IndexArrayFormat::Format_16bit)) && (header.indexFormat != static_cast<uint32_t>(IndexArrayFormat::Format_32bit))))
+	{
+		return false;
 	}
-	*/
+
+	auto rangeInFile = [&file](uint64_t offset, uint64_t size)
+	{
+		return (offset >= sizeof(OBJCacheHeader)) && (offset <= file->size()) && (size <= file->size() - offset);
+	};
+
+	return rangeInFile(header.metadataOffset, header.metadataSize) &&
+		rangeInFile(header.vertexDataOffset, header.vertexDataSize) && rangeInFile(header.indexDataOffset, header.indexDataSize);
+}
+
+bool sourceMatchesOBJCacheHeader(const std::string& source, const OBJCacheHeader& header)
+{
+	if (!fileExists(source) || (getFileDate(source) == header.sourceDate))
+		return true;
+
+	MappedFile sourceFile(source);
+	return sourceFile.valid() && (sourceFile.size() == header.sourceSize) &&
+		(contentHash(sourceFile.data(), sourceFile.size()) == header.sourceHash);
+}
+
 }
 
 /*
@@ -33,6 +33,23 @@ public:
 
 	s3d::ElementContainer::Pointer load(RenderInterface::Pointer, s3d::Storage&, ObjectsCache&) override;
 
+	/*
+	 * parses groups, faces and vertex attributes, without creating vertex buffers.
+	 * File is memory mapped and split at line boundaries into chunksCount chunks
+	 * (0 - chosen from file size and number of workers), which are parsed in parallel
+	 */
+	bool parse(ObjectsCache&, uint32_t chunksCount = 0);
+
+	struct Statistics
+	{
+		uint64_t vertices = 0;
+		uint64_t normals = 0;
+		uint64_t texCoords = 0;
+		uint64_t faces = 0;
+		uint64_t groups = 0;
+	};
+	Statistics statistics() const;
+
 	ET_DECLARE_EVENT1(loaded, s3d::ElementContainer::Pointer);
 
 private:
@@ -63,6 +80,12 @@ private:
 		VertexLinks vertexLinks;
 		uint32_t vertexLinksCount = 0;
 		uint32_t smoothingGroupIndex = 0;
+
+		/*
+		 * bit (MaxVertexSize * link + component) is set for negative (relative) links,
+		 * which are stored relative to the start of the chunk until chunks are merged
+		 */
+		uint32_t relativeLinks = 0;
 	};
 
 	struct OBJGroup
@@ -108,19 +131,58 @@ private:
 		}
 	};
 
+	/*
+	 * chunk of file parsed by a worker, directives (groups, materials, smoothing groups)
+	 * are recorded with number of faces preceding them and applied in order when chunks are merged
+	 */
+	struct OBJDirective
+	{
+		enum class Type : uint32_t
+		{
+			Group,
+			Material,
+			Smoothing,
+			MaterialLibrary,
+			Unsupported
+		};
+
+		Type type = Type::Group;
+		uint32_t faceIndex = 0;
+		uint32_t line = 0;
+		std::string value;
+	};
+
+	struct OBJChunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+		std::vector<et::vec3> vertices;
+		std::vector<et::vec3> normals;
+		std::vector<et::vec2> texCoords;
+		std::vector<OBJFace> faces;
+		std::vector<OBJDirective> directives;
+		uint32_t linesCount = 0;
+		uint32_t lineBase = 0;
+		uint32_t vertexBase = 0;
+		uint32_t normalBase = 0;
+		uint32_t texCoordBase = 0;
+	};
+
 private:
-	void loadData(ObjectsCache& cache);
-	void load(ObjectsCache& cache);
+	void parseChunk(OBJChunk&);
+	void mergeChunk(OBJChunk&, ObjectsCache&);
+	void applyDirective(const OBJDirective&, uint32_t lineBase, ObjectsCache&);
 	
-	bool loadCached(const std::string& fileName);
+	bool loadCached(const std::string& fileName, ObjectsCache&);
 	void saveCache(const std::string& fileName);
 	
 	void processLoadedData();
+	void assignDefaultTextures();
+	MaterialInstance::Pointer findMaterial(const std::string& material, const std::string& group);
 
 	s3d::ElementContainer::Pointer generateVertexBuffers(s3d::Storage&);
 
 	void loadMaterials(const std::string& fileName, ObjectsCache& cache);
-	void threadFinished();
 
 private:
 	RenderInterface::Pointer _renderer;
@@ -143,11 +205,11 @@ private:
 	std::vector<et::vec2> _texCoords;
 	std::vector<OBJGroup> _groups;
 	Set<std::string> _loadedMaterials;
+	Vector<std::string> _materialLibraries;
 	char _lastUsedMaterial[256]{ };
 
 	uint32_t _loadOptions = Option_JustLoad;
 	uint64_t _sizeEstimate = 1024;
 	int _lastSmoothGroup = 0;
-	int _lastGroupId = 0;
 };
 }
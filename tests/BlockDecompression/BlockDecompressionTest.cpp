@@ -0,0 +1,263 @@
+#include <et/app/application.h>
+#include <et/imaging/blockcompression.h>
+#include "../common/testtools.h"
+
+using namespace et;
+
+const vec2i imageSize(2048, 2048);
+
+/*
+ * straightforward per pixel decoders, used to validate vectorized and parallel ones
+ */
+namespace reference
+{
+void colorPalette(const uint8_t* block, bool forceFourColors, vec4ub* palette)
+{
+	uint32_t c[2] = { static_cast<uint32_t>(block[0] | (block[1] << 8)), static_cast<uint32_t>(block[2] | (block[3] << 8)) };
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		uint32_t r = (c[i] >> 11) & 0x1f;
+		uint32_t g = (c[i] >> 5) & 0x3f;
+		uint32_t b = c[i] & 0x1f;
+		palette[i] = vec4ub(static_cast<uint8_t>((r << 3) | (r >> 2)), static_cast<uint8_t>((g << 2) | (g >> 4)),
+			static_cast<uint8_t>((b << 3) | (b >> 2)), 255);
+	}
+
+	for (int ch = 0; ch < 3; ++ch)
+	{
+		int v0 = palette[0][ch];
+		int v1 = palette[1][ch];
+		if ((c[0] > c[1]) || forceFourColors)
+		{
+			palette[2][ch] = static_cast<uint8_t>((2 * v0 + v1) / 3);
+			palette[3][ch] = static_cast<uint8_t>((v0 + 2 * v1) / 3);
+		}
+		else
+		{
+			palette[2][ch] = static_cast<uint8_t>((v0 + v1) / 2);
+			palette[3][ch] = 0;
+		}
+	}
+	palette[2].w = 255;
+	palette[3].w = ((c[0] > c[1]) || forceFourColors) ? 255 : 0;
+}
+
+void alphaValues(const uint8_t* block, uint8_t* values)
+{
+	int a0 = block[0];
+	int a1 = block[1];
+	int palette[8] = { a0, a1 };
+	if (a0 > a1)
+	{
+		for (int i = 1; i < 7; ++i)
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; ++i)
+			palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	for (int i = 0; i < 16; ++i)
+	{
+		int bit = 16 + 3 * i;
+		int index = 0;
+		for (int b = 0; b < 3; ++b, ++bit)
+			index |= ((block[bit / 8] >> (bit % 8)) & 1) << b;
+		values[i] = static_cast<uint8_t>(palette[index]);
+	}
+}
+
+/*
+ * mode 6 only, which is produced by bc::compress
+ */
+void bc7Block(const uint8_t* block, vec4ub* output)
+{
+	const uint32_t weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	uint32_t position = 7;
+	auto read = [block, &position](uint32_t bits)
+	{
+		uint32_t result = 0;
+		for (uint32_t i = 0; i < bits; ++i, ++position)
+			result |= ((block[position / 8] >> (position % 8)) & 1u) << i;
+		return result;
+	};
+
+	uint32_t e[2][4];
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		e[0][c] = read(7);
+		e[1][c] = read(7);
+	}
+	uint32_t p0 = read(1);
+	uint32_t p1 = read(1);
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		e[0][c] = (e[0][c] << 1) | p0;
+		e[1][c] = (e[1][c] << 1) | p1;
+	}
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		uint32_t w = weights[read((i == 0) ? 3 : 4)];
+		for (uint32_t c = 0; c < 4; ++c)
+			output[i][c] = static_cast<uint8_t>(((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6);
+	}
+}
+
+void decompress(TextureFormat format, const uint8_t* source, const vec2i& size, vec4ub* destination)
+{
+	uint32_t blockSize = bc::compressedBlockSize(format);
+	for (int by = 0; by < size.y / 4; ++by)
+	{
+		for (int bx = 0; bx < size.x / 4; ++bx, source += blockSize)
+		{
+			vec4ub pixels[16];
+			uint8_t values[16];
+			uint8_t green[16];
+			vec4ub palette[4];
+			switch (format)
+			{
+			case TextureFormat::DXT1_RGB:
+			case TextureFormat::DXT1_RGBA:
+			case TextureFormat::DXT3:
+			case TextureFormat::DXT5:
+			{
+				const uint8_t* colorBlock = (format == TextureFormat::DXT1_RGB) || (format == TextureFormat::DXT1_RGBA) ? source : source + 8;
+				colorPalette(colorBlock, colorBlock != source, palette);
+				for (int i = 0; i < 16; ++i)
+					pixels[i] = palette[(colorBlock[4 + i / 4] >> (2 * (i % 4))) & 3];
+
+				if (format == TextureFormat::DXT3)
+				{
+					for (int i = 0; i < 16; ++i)
+						pixels[i].w = static_cast<uint8_t>(((source[i / 2] >> (4 * (i % 2))) & 0x0f) * 17);
+				}
+				else if (format == TextureFormat::DXT5)
+				{
+					alphaValues(source, values);
+					for (int i = 0; i < 16; ++i)
+						pixels[i].w = values[i];
+				}
+				break;
+			}
+
+			case TextureFormat::RGTC1:
+			case TextureFormat::RGTC2:
+			{
+				alphaValues(source, values);
+				if (format == TextureFormat::RGTC2)
+					alphaValues(source + 8, green);
+				for (int i = 0; i < 16; ++i)
+					pixels[i] = vec4ub(values[i], (format == TextureFormat::RGTC2) ? green[i] : 0, 0, 255);
+				break;
+			}
+
+			case TextureFormat::BC7:
+				bc7Block(source, pixels);
+				break;
+
+			default:
+				ET_FAIL("Invalid format");
+			}
+
+			for (int i = 0; i < 16; ++i)
+				destination[(4 * by + i / 4) * size.x + 4 * bx + i % 4] = pixels[i];
+		}
+	}
+}
+}
+
+double megapixelsPerSecond(uint64_t time)
+{
+	return static_cast<double>(imageSize.square()) / static_cast<double>(std::max(uint64_t(1), time));
+}
+
+void report(const char* name, uint64_t time, uint64_t referenceTime, const Vector<vec4ub>& result, const Vector<vec4ub>& expected, bool compare)
+{
+	if (!compare)
+	{
+		log::info("%s: %llu.%03llu ms (%.1f MPix/s)", name, time / 1000, time % 1000, megapixelsPerSecond(time));
+		return;
+	}
+
+	const char* status = (memcmp(result.data(), expected.data(), result.size() * sizeof(vec4ub)) == 0) ? "results match" : "RESULTS DO NOT MATCH";
+
+	log::info("%s: %llu.%03llu ms (%.1f MPix/s), reference: %llu.%03llu ms (%.1f MPix/s), speedup: %.2f, %s", name,
+		time / 1000, time % 1000, megapixelsPerSecond(time), referenceTime / 1000, referenceTime % 1000,
+		megapixelsPerSecond(referenceTime), static_cast<double>(referenceTime) / static_cast<double>(std::max(uint64_t(1), time)), status);
+}
+
+void compare(const char* name, TextureFormat format, const BinaryDataStorage& compressed, bool compareResults = true)
+{
+	Vector<vec4ub> result(static_cast<size_t>(imageSize.square()));
+	Vector<vec4ub> expected(static_cast<size_t>(imageSize.square()));
+	uint64_t time = measure([&]() { bc::decompressBlocks(format, compressed.constData(), imageSize, result.data()); });
+	uint64_t referenceTime = compareResults ?
+		measure([&]() { reference::decompress(format, compressed.constData(), imageSize, expected.data()); }) : 0;
+	report(name, time, referenceTime, result, expected, compareResults);
+}
+
+int main()
+{
+	log::addOutput(log::ConsoleOutput::Pointer::create());
+	log::info("Starting test, %d x %d image...", imageSize.x, imageSize.y);
+
+	/*
+	 * smooth gradients with noise, so encoded blocks use all palette entries
+	 */
+	uint32_t state = 0x12345678;
+	Vector<vec4ub> image(static_cast<size_t>(imageSize.square()));
+	for (int y = 0; y < imageSize.y; ++y)
+	{
+		for (int x = 0; x < imageSize.x; ++x)
+		{
+			uint32_t noise = nextRandom(state);
+			image[y * imageSize.x + x] = vec4ub(static_cast<uint8_t>(x + (noise & 0x0f)), static_cast<uint8_t>(y + ((noise >> 8) & 0x0f)),
+				static_cast<uint8_t>(x + y), static_cast<uint8_t>((x * y) >> 4));
+		}
+	}
+
+	const struct { const char* name; TextureFormat format; } encodedFormats[] =
+	{
+		{ "BC1", TextureFormat::DXT1_RGBA },
+		{ "BC3", TextureFormat::DXT5 },
+		{ "BC5", TextureFormat::RGTC2 },
+		{ "BC7 (mode 6)", TextureFormat::BC7 },
+	};
+
+	for (const auto& entry : encodedFormats)
+	{
+		BinaryDataStorage compressed(bc::compressedDataSize(entry.format, imageSize));
+		bc::compress(entry.format, image.data(), imageSize, compressed.data());
+		compare(entry.name, entry.format, compressed);
+	}
+
+	/*
+	 * formats without encoder and BC7 blocks of all modes are filled with random data
+	 */
+	const struct { const char* name; TextureFormat format; bool compare; } randomFormats[] =
+	{
+		{ "BC2", TextureFormat::DXT3, true },
+		{ "BC4", TextureFormat::RGTC1, true },
+		{ "BC7 (all modes)", TextureFormat::BC7, false },
+		{ "ETC1", TextureFormat::ETC1, false },
+		{ "PVRTC 4bpp", TextureFormat::PVR_4bpp_RGBA, false },
+		{ "PVRTC 2bpp", TextureFormat::PVR_2bpp_RGBA, false },
+	};
+
+	for (const auto& entry : randomFormats)
+	{
+		BinaryDataStorage compressed(static_cast<uint64_t>(imageSize.square()) * bitsPerPixelForTextureFormat(entry.format) / 8);
+		for (uint64_t i = 0, e = compressed.size(); i < e; ++i)
+			compressed[i] = static_cast<uint8_t>(nextRandom(state) & 0xff);
+		compare(entry.name, entry.format, compressed, entry.compare);
+	}
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
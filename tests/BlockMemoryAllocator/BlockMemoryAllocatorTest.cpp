@@ -0,0 +1,73 @@
+#include <et/app/application.h>
+
+const uint32_t iterationsPerThread = 4 * 1024 * 1024;
+const uint32_t workingSetSize = 1024;
+const uint32_t maxAllocationSize = 256;
+
+void threadFunction(et::BlockMemoryAllocator& allocator, uint32_t seed)
+{
+	std::vector<void*> workingSet(workingSetSize, nullptr);
+
+	uint32_t state = seed;
+	for (uint32_t i = 0; i < iterationsPerThread; ++i)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		void*& slot = workingSet[state % workingSetSize];
+		if (slot == nullptr)
+		{
+			slot = allocator.allocate(8 + (state >> 16) % (maxAllocationSize - 8));
+		}
+		else
+		{
+			allocator.release(slot);
+			slot = nullptr;
+		}
+	}
+
+	for (void* ptr : workingSet)
+		allocator.release(ptr);
+}
+
+uint64_t runTest(bool useThreadCaches, uint32_t threadsCount)
+{
+	et::BlockMemoryAllocator allocator(useThreadCaches);
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadsCount);
+
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+
+	for (uint32_t i = 0; i < threadsCount; ++i)
+		threads.emplace_back(threadFunction, std::ref(allocator), 0x9e3779b9 * (i + 1));
+
+	for (std::thread& t : threads)
+		t.join();
+
+	return et::queryCurrentTimeInMicroSeconds() - startTime;
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test...");
+	et::log::info("%8s | %16s | %16s | %8s", "threads", "shared lock, ms", "thread cache, ms", "speedup");
+
+	uint32_t maxThreads = static_cast<uint32_t>(std::max(size_t(1), et::threading::maxConcurrentThreads()));
+	for (uint32_t threadsCount = 1; threadsCount <= maxThreads; threadsCount *= 2)
+	{
+		uint64_t lockedTime = runTest(false, threadsCount);
+		uint64_t cachedTime = runTest(true, threadsCount);
+		
+		et::log::info("%8u | % 9llu.%03llu | % 9llu.%03llu | %8.2f", threadsCount,
+			lockedTime / 1000, lockedTime % 1000, cachedTime / 1000, cachedTime % 1000,
+			static_cast<double>(lockedTime) / static_cast<double>(std::max(uint64_t(1), cachedTime)));
+	}
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
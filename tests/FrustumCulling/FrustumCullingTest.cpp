@@ -0,0 +1,112 @@
+#include <et/app/application.h>
+#include <et/camera/camera.h>
+#include <et/camera/culling.h>
+#include "../common/testtools.h"
+
+const uint32_t boxesCount = 100 * 1000;
+const uint32_t iterationsCount = 100;
+
+float randomFloat(uint32_t& state, float minValue, float maxValue)
+{
+	return minValue + (maxValue - minValue) * static_cast<float>(nextRandom(state) % 65536) / 65535.0f;
+}
+
+template <typename F>
+uint64_t measure(F function, uint32_t& visibleCount)
+{
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	for (uint32_t i = 0; i < iterationsCount; ++i)
+		visibleCount = function();
+	return (et::queryCurrentTimeInMicroSeconds() - startTime) / iterationsCount;
+}
+
+bool sameVisibleSet(const std::vector<uint32_t>& reference, std::vector<uint32_t> indices, uint32_t visibleCount)
+{
+	indices.resize(visibleCount);
+	std::sort(indices.begin(), indices.end());
+	return indices == reference;
+}
+
+void report(const char* name, uint64_t time, uint64_t referenceTime, bool matches)
+{
+	et::log::info("%s: %llu.%03llu ms, speedup: %.2f, %s", name, time / 1000, time % 1000,
+		static_cast<double>(referenceTime) / static_cast<double>(std::max(uint64_t(1), time)),
+		matches ? "visible set matches" : "VISIBLE SET DOES NOT MATCH");
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test...");
+
+	/*
+	 * the same clip space conventions as Vulkan renderer uses
+	 */
+	et::Camera::renderingOriginTransform = -1.0f;
+	et::Camera::zeroClipRange = true;
+
+	uint32_t state = 0x12345678;
+	std::vector<et::BoundingBox> boxes(boxesCount);
+	et::PackedBoundingBoxes packedBoxes;
+	packedBoxes.resize(boxesCount);
+	for (uint32_t i = 0; i < boxesCount; ++i)
+	{
+		et::vec3 center(randomFloat(state, -500.0f, 500.0f), randomFloat(state, -500.0f, 500.0f), randomFloat(state, -500.0f, 500.0f));
+		et::vec3 halfDimension(randomFloat(state, 0.1f, 5.0f), randomFloat(state, 0.1f, 5.0f), randomFloat(state, 0.1f, 5.0f));
+		boxes[i] = et::BoundingBox(center, halfDimension);
+		packedBoxes.set(i, boxes[i]);
+	}
+
+	et::Camera::Pointer camera = et::Camera::Pointer::create();
+	camera->perspectiveProjection(QUARTER_PI, 1.0f, 1.0f, 1000.0f);
+	camera->lookAt(et::vec3(100.0f));
+	const et::Frustum& frustum = camera->frustum();
+
+	uint32_t visibleCount = 0;
+	std::vector<uint32_t> reference;
+	reference.reserve(boxesCount);
+	uint64_t scalarTime = measure([&]()
+	{
+		reference.clear();
+		for (uint32_t i = 0; i < boxesCount; ++i)
+		{
+			if (frustum.containsBoundingBox(boxes[i]))
+				reference.emplace_back(i);
+		}
+		return static_cast<uint32_t>(reference.size());
+	}, visibleCount);
+	et::log::info("%u boxes, %u visible", boxesCount, visibleCount);
+	et::log::info("containsBoundingBox: %llu.%03llu ms", scalarTime / 1000, scalarTime % 1000);
+
+	std::vector<uint32_t> visible(boxesCount);
+
+	uint64_t flatTime = measure([&]() { return et::cullBoundingBoxes(frustum, packedBoxes, visible.data()); }, visibleCount);
+	report("packed boxes", flatTime, scalarTime, sameVisibleSet(reference, visible, visibleCount));
+
+	uint64_t hierarchyBuildTime = et::queryCurrentTimeInMicroSeconds();
+	et::CullingHierarchy hierarchy;
+	hierarchy.build(packedBoxes);
+	hierarchyBuildTime = et::queryCurrentTimeInMicroSeconds() - hierarchyBuildTime;
+	et::log::info("hierarchy build: %llu.%03llu ms", hierarchyBuildTime / 1000, hierarchyBuildTime % 1000);
+
+	uint64_t hierarchyTime = measure([&]() { return hierarchy.cull(frustum, visible.data()); }, visibleCount);
+	report("hierarchy", hierarchyTime, scalarTime, sameVisibleSet(reference, visible, visibleCount));
+
+	size_t maxThreads = std::max(size_t(2), et::threading::maxConcurrentThreads());
+	for (size_t workers = 1; workers < maxThreads; workers *= 2)
+	{
+		et::JobSystem jobSystem(workers);
+		et::log::info("%llu workers + calling thread:", static_cast<uint64_t>(workers));
+
+		uint64_t parallelFlatTime = measure([&]() { return et::cullBoundingBoxes(frustum, packedBoxes, visible.data(), &jobSystem); }, visibleCount);
+		report("  packed boxes", parallelFlatTime, scalarTime, sameVisibleSet(reference, visible, visibleCount));
+
+		uint64_t parallelHierarchyTime = measure([&]() { return hierarchy.cull(frustum, visible.data(), &jobSystem); }, visibleCount);
+		report("  hierarchy", parallelHierarchyTime, scalarTime, sameVisibleSet(reference, visible, visibleCount));
+	}
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
@@ -0,0 +1,268 @@
+#include <et/app/application.h>
+#include <et/imaging/imageoperations.h>
+#include "../common/testtools.h"
+
+using namespace et;
+
+const vec2i imageSize(2048, 2048);
+const int imageComponents = 4;
+
+/*
+ * implementations which were used before sliding window, histogram and SIMD kernels
+ */
+namespace reference
+{
+int indexForCoord(const vec2i& coord, const vec2i& size)
+{
+	int xVal = coord.x < 0 ? 0 : (coord.x >= size.x ? size.x - 1 : coord.x);
+	int yVal = coord.y < 0 ? 0 : (coord.y >= size.y ? size.y - 1 : coord.y);
+	return yVal * size.x + xVal;
+}
+
+bool grayscaleSortFunction(const vec4ub& v1, const vec4ub& v2)
+{
+	int g1 = 76 * v1.x + 150 * v1.y + 29 * v1.z;
+	int g2 = 76 * v2.x + 150 * v2.y + 29 * v2.z;
+	return g1 < g2;
+}
+
+void blur(BinaryDataStorage& data, const vec2i& size, int components, vec2i direction, int radius, ImageBlurType type)
+{
+	type = ImageBlurType_Average;
+
+	BinaryDataStorage source(data);
+	for (int y = 0; y < size.y; ++y)
+	{
+		for (int x = 0; x < size.x; ++x)
+		{
+			int i0 = components * indexForCoord(vec2i(x, y), size);
+
+			vec4i sum;
+			int scale = (type == ImageBlurType_Average) ? 1 : (radius + 1);
+			int totalScale = scale;
+			for (int c = 0; c < components; ++c)
+				sum[c] = source[i0 + c] * scale;
+
+			for (int r = 1; r <= radius; ++r)
+			{
+				vec2i vNext = vec2i(x, y) + direction * r;
+				vec2i vPrev = vec2i(x, y) - direction * r;
+				int iNext = components * indexForCoord(vNext, size);
+				int iPrev = components * indexForCoord(vPrev, size);
+				scale = (type == ImageBlurType_Average) ? 1 : (radius + 1 - r);
+				totalScale += 2 * scale;
+				for (int c = 0; c < components; ++c)
+				{
+					sum[c] += source[iNext + c] * scale;
+					sum[c] += source[iPrev + c] * scale;
+				}
+
+			}
+
+			sum /= totalScale;
+			for (int c = 0; c < components; ++c)
+				data[i0 + c] = static_cast<uint8_t>(sum[c]);
+		}
+	}
+}
+
+void median(BinaryDataStorage& data, const vec2i& size, int components, int radius)
+{
+	BinaryDataStorage source(data);
+
+	std::vector<vec4ub> matrix;
+	matrix.reserve(static_cast<std::vector<vec4ub>::size_type>((1 + 2 * radius) * (1 + 2 * radius)));
+
+	for (int y = 0; y < size.y; ++y)
+	{
+		for (int x = 0; x < size.x; ++x)
+		{
+			int i0 = components * indexForCoord(vec2i(x, y), size);
+
+			matrix.clear();
+			for (int v = -radius; v <= radius; ++v)
+			{
+				for (int u = - radius; u <= radius; ++u)
+				{
+					int index = components * indexForCoord(vec2i(x + u, y + v), size);
+					vec4ub color(0);
+					for (int c = 0; c < components; ++c)
+						color[c] = source[index+c];
+					matrix.push_back(color);
+				}
+			}
+
+			std::sort(matrix.begin(), matrix.end(), grayscaleSortFunction);
+
+			vec4ub& middle = matrix.at(matrix.size() / 2);
+			for (int c = 0; c < components; ++c)
+				data[i0 + c] = middle[c];
+		}
+	}
+}
+
+void applyMatrixFilter(BinaryDataStorage& data, const vec2i& size, int components, const mat3i& m)
+{
+	BinaryDataStorage source(data);
+	matrix3<uint8_t> colorMatrix[4];
+
+	for (int y = 0; y < size.y; ++y)
+	{
+		for (int x = 0; x < size.x; ++x)
+		{
+			for (int dy = -1; dy <= 1; ++dy)
+			{
+				for (int dx = -1; dx <= 1; ++dx)
+				{
+					int index = components * indexForCoord(vec2i(x + dx, y + dy), size);
+					for (int c = 0; c < components; ++c)
+						colorMatrix[c][dy+1][dx+1] = source[index+c];
+				}
+			}
+
+			vec4i result(0);
+			int cSum = 0;
+			for (int v = 0; v < 3; ++v)
+			{
+				for (int u = 0; u < 3; ++u)
+				{
+					int value = m[v][u];
+					result.x += colorMatrix[0][v][u] * value;
+					result.y += colorMatrix[1][v][u] * value;
+					result.z += colorMatrix[2][v][u] * value;
+					result.w += colorMatrix[3][v][u] * value;
+					cSum += value;
+				}
+			}
+
+			if (cSum)
+				result /= cSum;
+
+			int i0 = components * indexForCoord(vec2i(x, y), size);
+			for (int c = 0; c < components; ++c)
+				data[i0 + c] = static_cast<uint8_t>(clamp(result[c], 0, 255));
+		}
+	}
+}
+
+void normalMapFilter(BinaryDataStorage& data, const vec2i& size, int components, const vec2& scale)
+{
+	ET_ASSERT(components > 2);
+
+	vec2 fScale = scale / 255.0f;
+	BinaryDataStorage source(data);
+	for (int y = 0; y < size.y; ++y)
+	{
+		bool halfY = y < size.y / 2;
+		for (int x = 0; x < size.x; ++x)
+		{
+			bool halfX = x < size.x / 2;
+			vec2i nextX(x + (halfX ? 1 : -1), y);
+			vec2i nextY(x, y + (halfY ? 1 : -1));
+
+			int c00 = components * indexForCoord(vec2i(x, y), size);
+			int c01 = components * indexForCoord(nextX, size);
+			int c10 = components * indexForCoord(nextY, size);
+
+			short h00 = source[c00];
+			short h01 = source[c01];
+			short h10 = source[c10];
+
+			float dx = static_cast<float>(halfX ? h01 - h00 : h00 - h01) * fScale.x;
+			float dy = static_cast<float>(halfY ? h10 - h00 : h00 - h10) * fScale.y;
+
+			vec3 du(1.0f, 0.0f, dx);
+			vec3 dv(0.0f, 1.0f, dy);
+
+			vec3 produce = normalize(cross(du, dv));
+
+			data[c00+0] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.x));
+			data[c00+1] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.y));
+			data[c00+2] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * produce.z));
+		}
+	}
+}
+}
+
+void report(const char* name, uint64_t time, uint64_t referenceTime, const BinaryDataStorage& result, const BinaryDataStorage& expected, bool compare)
+{
+	const char* status = "not compared";
+	if (compare)
+		status = (memcmp(result.data(), expected.data(), result.dataSize()) == 0) ? "results match" : "RESULTS DO NOT MATCH";
+
+	log::info("%s: %llu.%03llu ms, reference: %llu.%03llu ms, speedup: %.2f, %s", name, time / 1000, time % 1000,
+		referenceTime / 1000, referenceTime % 1000, static_cast<double>(referenceTime) / static_cast<double>(std::max(uint64_t(1), time)), status);
+}
+
+template <typename F, typename R>
+void compare(const char* name, const BinaryDataStorage& image, F function, R referenceFunction, bool compareResults = true)
+{
+	BinaryDataStorage result(image);
+	BinaryDataStorage expected(image);
+	uint64_t time = measure([&]() { function(result); });
+	uint64_t referenceTime = measure([&]() { referenceFunction(expected); });
+	report(name, time, referenceTime, result, expected, compareResults);
+}
+
+int main()
+{
+	log::addOutput(log::ConsoleOutput::Pointer::create());
+	log::info("Starting test, %d x %d x %d image...", imageSize.x, imageSize.y, imageComponents);
+
+	uint32_t state = 0x12345678;
+	BinaryDataStorage image(static_cast<uint64_t>(imageSize.x * imageSize.y * imageComponents));
+	for (uint64_t i = 0, e = image.size(); i < e; ++i)
+		image[i] = static_cast<uint8_t>(nextRandom(state) & 0xff);
+
+	BinaryDataStorage grayscale(static_cast<uint64_t>(imageSize.x * imageSize.y));
+	for (uint64_t i = 0, e = grayscale.size(); i < e; ++i)
+		grayscale[i] = image[i * imageComponents];
+
+	for (int radius : { 2, 8, 32 })
+	{
+		log::info("radius %d:", radius);
+		compare("  horizontal blur", image,
+			[radius](BinaryDataStorage& d) { ImageOperations::blur(d, imageSize, imageComponents, vec2i(1, 0), radius, ImageBlurType_Average); },
+			[radius](BinaryDataStorage& d) { reference::blur(d, imageSize, imageComponents, vec2i(1, 0), radius, ImageBlurType_Average); });
+
+		compare("  vertical blur", image,
+			[radius](BinaryDataStorage& d) { ImageOperations::blur(d, imageSize, imageComponents, vec2i(0, 1), radius, ImageBlurType_Average); },
+			[radius](BinaryDataStorage& d) { reference::blur(d, imageSize, imageComponents, vec2i(0, 1), radius, ImageBlurType_Average); });
+
+		compare("  gaussian blur", image,
+			[radius](BinaryDataStorage& d) { ImageOperations::blur(d, imageSize, imageComponents, vec2i(1, 0), radius, ImageBlurType_Gaussian); },
+			[radius](BinaryDataStorage& d) { reference::blur(d, imageSize, imageComponents, vec2i(1, 0), radius, ImageBlurType_Average); }, false);
+	}
+
+	/*
+	 * previous median sorted pixels by luminance, so results are the same for single component images only
+	 */
+	for (int radius : { 1, 3, 7 })
+	{
+		log::info("median, radius %d:", radius);
+		compare("  single component", grayscale,
+			[radius](BinaryDataStorage& d) { ImageOperations::median(d, imageSize, 1, radius); },
+			[radius](BinaryDataStorage& d) { reference::median(d, imageSize, 1, radius); });
+
+		compare("  four components", image,
+			[radius](BinaryDataStorage& d) { ImageOperations::median(d, imageSize, imageComponents, radius); },
+			[radius](BinaryDataStorage& d) { reference::median(d, imageSize, imageComponents, radius); }, false);
+	}
+
+	log::info("matrix filters:");
+	for (const mat3i* filter : { &ImageOperations::matrixFilterBlur, &ImageOperations::matrixFilterStrongBlur, &ImageOperations::matrixFilterSharpen })
+	{
+		compare("  matrix filter", image,
+			[filter](BinaryDataStorage& d) { ImageOperations::applyMatrixFilter(d, imageSize, imageComponents, *filter); },
+			[filter](BinaryDataStorage& d) { reference::applyMatrixFilter(d, imageSize, imageComponents, *filter); });
+	}
+
+	compare("normal map filter", image,
+		[](BinaryDataStorage& d) { ImageOperations::normalMapFilter(d, imageSize, imageComponents, vec2(4.0f)); },
+		[](BinaryDataStorage& d) { reference::normalMapFilter(d, imageSize, imageComponents, vec2(4.0f)); });
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
@@ -0,0 +1,120 @@
+#include <et/app/application.h>
+#include <et/core/objectscache.h>
+#include <et/core/jobsystem.h>
+#include <et/scene3d/objloader.h>
+#include "../common/testtools.h"
+
+using namespace et;
+
+/*
+ * regular grid with positions, texture coordinates and normals, split into groups with materials,
+ * every other group uses relative (negative) indices
+ */
+uint64_t writeSyntheticMesh(const std::string& fileName, uint32_t gridSize, uint32_t groupsCount)
+{
+	std::ofstream out(fileName, std::ios::binary);
+	uint32_t state = 0x12345678;
+	uint32_t rowsPerGroup = std::max(1u, gridSize / groupsCount);
+	for (uint32_t group = 0; group * rowsPerGroup < gridSize; ++group)
+	{
+		uint32_t firstRow = group * rowsPerGroup;
+		uint32_t lastRow = std::min(gridSize, firstRow + rowsPerGroup);
+		uint32_t vertexBase = group * (rowsPerGroup + 1) * (gridSize + 1);
+		bool relative = (group % 2) == 1;
+
+		char buffer[256] = { };
+		for (uint32_t y = firstRow; y <= lastRow; ++y)
+		{
+			for (uint32_t x = 0; x <= gridSize; ++x)
+			{
+				float height = static_cast<float>(nextRandom(state) % 10000) / 10000.0f;
+				float u = static_cast<float>(x) / static_cast<float>(gridSize);
+				float v = static_cast<float>(y) / static_cast<float>(gridSize);
+				int length = snprintf(buffer, sizeof(buffer), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.4f %.4f %.4f\n",
+					u * 100.0f, height, v * 100.0f, u, v, 0.0f, 1.0f, 0.0f);
+				out.write(buffer, length);
+			}
+		}
+
+		int length = snprintf(buffer, sizeof(buffer), "g group-%u\nusemtl material-%u\ns %u\n", group, group % 4, group % 2);
+		out.write(buffer, length);
+
+		uint32_t groupVertices = (lastRow - firstRow + 1) * (gridSize + 1);
+		for (uint32_t y = 0; y < lastRow - firstRow; ++y)
+		{
+			for (uint32_t x = 0; x < gridSize; ++x)
+			{
+				int64_t i[4] =
+				{
+					vertexBase + y * (gridSize + 1) + x + 1,
+					vertexBase + y * (gridSize + 1) + x + 2,
+					vertexBase + (y + 1) * (gridSize + 1) + x + 2,
+					vertexBase + (y + 1) * (gridSize + 1) + x + 1
+				};
+
+				if (relative)
+				{
+					for (int64_t& index : i)
+						index = index - static_cast<int64_t>(vertexBase + groupVertices) - 1;
+				}
+
+				length = snprintf(buffer, sizeof(buffer), "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n",
+					i[0], i[0], i[0], i[1], i[1], i[1], i[2], i[2], i[2], i[3], i[3], i[3]);
+				out.write(buffer, length);
+			}
+		}
+	}
+	return static_cast<uint64_t>(out.tellp());
+}
+
+bool operator == (const OBJLoader::Statistics& a, const OBJLoader::Statistics& b)
+{
+	return (a.vertices == b.vertices) && (a.normals == b.normals) && (a.texCoords == b.texCoords) &&
+		(a.faces == b.faces) && (a.groups == b.groups);
+}
+
+int main()
+{
+	log::addOutput(log::ConsoleOutput::Pointer::create());
+
+	uint32_t workersCount = static_cast<uint32_t>(sharedJobSystem().workersCount());
+	log::info("Starting test, %u workers...", workersCount);
+
+	ObjectsCache cache;
+	for (uint32_t gridSize : { 256, 1024, 2048 })
+	{
+		std::string fileName = "synthetic-" + intToStr(gridSize) + ".obj";
+		uint64_t fileSize = writeSyntheticMesh(fileName, gridSize, 16);
+		log::info("%u x %u grid, %llu MB:", gridSize, gridSize, fileSize / (1024 * 1024));
+
+		/*
+		 * single chunk is parsed on a single thread, it's the reference for speedup
+		 */
+		OBJLoader::Statistics referenceStatistics;
+		uint64_t referenceTime = 0;
+		for (uint32_t chunksCount = 1; chunksCount <= 4 * (workersCount + 1); chunksCount *= 2)
+		{
+			OBJLoader loader(fileName, OBJLoader::Option_JustLoad);
+			uint64_t time = measure([&]() { loader.parse(cache, chunksCount); });
+
+			if (chunksCount == 1)
+			{
+				referenceTime = time;
+				referenceStatistics = loader.statistics();
+			}
+
+			OBJLoader::Statistics statistics = loader.statistics();
+			log::info("  %2u chunks: %llu.%03llu ms (%.1f MB/s), speedup: %.2f, %llu faces, %s", chunksCount, time / 1000, time % 1000,
+				static_cast<double>(fileSize) / static_cast<double>(std::max(uint64_t(1), time)),
+				static_cast<double>(referenceTime) / static_cast<double>(std::max(uint64_t(1), time)), statistics.faces,
+				(statistics == referenceStatistics) ? "results match" : "RESULTS DO NOT MATCH");
+		}
+
+		removeFile(fileName);
+	}
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
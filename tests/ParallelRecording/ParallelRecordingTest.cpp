@@ -0,0 +1,88 @@
+#include <et/app/application.h>
+#include <et/rendering/null/null_renderpass.h>
+#include "../common/testtools.h"
+
+const uint32_t batchesCount = 20 * 1000;
+const uint32_t iterationsCount = 20;
+
+uint64_t recordPass(et::NullRenderPass::Pointer& pass, const std::vector<et::RenderBatchInstance>& batches)
+{
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	for (uint32_t i = 0; i < iterationsCount; ++i)
+	{
+		pass->begin(et::RenderPassBeginInfo::singlePass());
+		pass->nextSubpass();
+		pass->pushRenderBatches(batches.data(), static_cast<uint32_t>(batches.size()));
+		pass->endSubpass();
+		pass->end();
+	}
+	return (et::queryCurrentTimeInMicroSeconds() - startTime) / iterationsCount;
+}
+
+bool commandListsEqual(const et::NullCommandList& a, const et::NullCommandList& b)
+{
+	if ((a.commands.size() != b.commands.size()) || (a.variables != b.variables))
+		return false;
+
+	for (size_t i = 0, e = a.commands.size(); i < e; ++i)
+	{
+		const et::NullRenderCommand& ca = a.commands[i];
+		const et::NullRenderCommand& cb = b.commands[i];
+		if ((ca.first != cb.first) || (ca.count != cb.count) || (ca.variablesOffset != cb.variablesOffset) || (ca.variablesSize != cb.variablesSize))
+			return false;
+	}
+	return true;
+}
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test...");
+
+	uint32_t state = 0x12345678;
+	std::vector<et::mat4> transforms(batchesCount);
+	std::vector<et::RenderBatch::Pointer> renderBatches(batchesCount);
+	std::vector<et::RenderBatchInstance> batches(batchesCount);
+	for (uint32_t i = 0; i < batchesCount; ++i)
+	{
+		et::vec3 position(static_cast<float>(nextRandom(state) % 1000), static_cast<float>(nextRandom(state) % 1000), 0.0f);
+		transforms[i] = et::translationMatrix(position);
+		renderBatches[i] = et::RenderBatch::Pointer::create();
+		renderBatches[i]->construct(et::MaterialInstance::Pointer(), et::VertexStream::Pointer(), nextRandom(state) % 1024, 36);
+		batches[i].batch = renderBatches[i].pointer();
+		batches[i].transform = transforms.data() + i;
+		batches[i].rotationTransform = transforms.data() + i;
+	}
+
+	et::Camera::Pointer camera = et::Camera::Pointer::create();
+	camera->perspectiveProjection(QUARTER_PI, 1.0f, 1.0f, 1000.0f);
+	camera->lookAt(et::vec3(100.0f));
+
+	et::NullRenderPass::Pointer pass = et::NullRenderPass::Pointer::create(nullptr, et::RenderPass::ConstructionInfo("benchmark"));
+	pass->loadSharedVariablesFromCamera(camera);
+
+	pass->setRecordingJobSystem(nullptr);
+	uint64_t serialTime = recordPass(pass, batches);
+	et::NullCommandList reference = pass->commandList();
+	et::log::info("%u batches, %llu bytes of variables", batchesCount, static_cast<uint64_t>(reference.variables.size()));
+	et::log::info("serial: %llu.%03llu ms", serialTime / 1000, serialTime % 1000);
+
+	size_t maxThreads = std::max(size_t(2), et::threading::maxConcurrentThreads());
+	for (size_t workers = 1; workers < maxThreads; workers *= 2)
+	{
+		et::JobSystem jobSystem(workers);
+		pass->setRecordingJobSystem(&jobSystem);
+		uint64_t parallelTime = recordPass(pass, batches);
+		bool matches = commandListsEqual(reference, pass->commandList());
+		pass->setRecordingJobSystem(nullptr);
+
+		et::log::info("%llu workers + recording thread: %llu.%03llu ms, speedup: %.2f, %s", static_cast<uint64_t>(workers),
+			parallelTime / 1000, parallelTime % 1000, static_cast<double>(serialTime) / static_cast<double>(std::max(uint64_t(1), parallelTime)),
+			matches ? "commands match serial recording" : "COMMANDS DO NOT MATCH SERIAL RECORDING");
+	}
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
@@ -0,0 +1,260 @@
+#include <et/app/application.h>
+#include <et-ext/rt/kdtree.h>
+#include <et-ext/rt/bvh.h>
+#include <et-ext/rt/trianglestorage.h>
+#include "../common/testtools.h"
+
+using namespace et;
+
+float nextRandomFloat(uint32_t& state)
+{
+	return static_cast<float>(nextRandom(state) & 0xffffff) / static_cast<float>(0x1000000);
+}
+
+void reportBuild(const char* name, uint64_t time, size_t nodes, size_t maxDepth)
+{
+	time = std::max(uint64_t(1), time);
+	log::info("  %-8s build %5llu.%03llu ms, %8llu nodes, %3llu max depth", name, time / 1000, time % 1000,
+		static_cast<uint64_t>(nodes), static_cast<uint64_t>(maxDepth));
+}
+
+void reportTrace(const char* name, uint64_t time, uint64_t raysCount, uint64_t hits)
+{
+	time = std::max(uint64_t(1), time);
+	log::info("  %-8s trace %5llu.%03llu ms, %6.2f Mrays/s, %llu hits", name, time / 1000, time % 1000,
+		static_cast<double>(raysCount) / static_cast<double>(time), hits);
+}
+
+/*
+ * height field, covered with small randomly oriented triangles,
+ * gives both large coherent surfaces and cluttered regions
+ */
+void generateScene(uint32_t gridSize, rt::TriangleStorage& result)
+{
+	auto height = [](float x, float z)
+	{
+		return 0.3f * std::sin(7.0f * x) * std::cos(5.0f * z);
+	};
+
+	auto normal = [](float x, float z)
+	{
+		float dx = 2.1f * std::cos(7.0f * x) * std::cos(5.0f * z);
+		float dz = -1.5f * std::sin(7.0f * x) * std::sin(5.0f * z);
+		return vec3(-dx, 1.0f, -dz).normalized();
+	};
+
+	auto addTriangle = [&](rt::TriangleStorage& triangles, const vec3& v0, const vec3& v1, const vec3& v2)
+	{
+		vec3 positions[3] = { v0, v1, v2 };
+		vec3 normals[3] = { normal(v0.x, v0.z), normal(v1.x, v1.z), normal(v2.x, v2.z) };
+		vec2 texCoords[3] = { vec2(0.5f * v0.x + 0.5f, 0.5f * v0.z + 0.5f), vec2(0.5f * v1.x + 0.5f, 0.5f * v1.z + 0.5f),
+			vec2(0.5f * v2.x + 0.5f, 0.5f * v2.z + 0.5f) };
+		triangles.addTriangle(positions, normals, texCoords, 0);
+	};
+
+	result.reserve(5 * gridSize * gridSize / 2);
+
+	float step = 2.0f / static_cast<float>(gridSize);
+	for (uint32_t i = 0; i < gridSize; ++i)
+	{
+		for (uint32_t j = 0; j < gridSize; ++j)
+		{
+			float x0 = -1.0f + step * static_cast<float>(i);
+			float z0 = -1.0f + step * static_cast<float>(j);
+			float x1 = x0 + step;
+			float z1 = z0 + step;
+			vec3 v00(x0, height(x0, z0), z0);
+			vec3 v10(x1, height(x1, z0), z0);
+			vec3 v11(x1, height(x1, z1), z1);
+			vec3 v01(x0, height(x0, z1), z1);
+			addTriangle(result, v00, v10, v11);
+			addTriangle(result, v00, v11, v01);
+		}
+	}
+
+	uint32_t state = 0x2468ace0;
+	const float clutterSize = 0.02f;
+	for (uint32_t i = 0, e = gridSize * gridSize / 2; i < e; ++i)
+	{
+		vec3 c(2.0f * nextRandomFloat(state) - 1.0f, 1.5f * nextRandomFloat(state), 2.0f * nextRandomFloat(state) - 1.0f);
+		vec3 d1(nextRandomFloat(state), nextRandomFloat(state), nextRandomFloat(state));
+		vec3 d2(nextRandomFloat(state), nextRandomFloat(state), nextRandomFloat(state));
+		addTriangle(result, c, c + d1 * clutterSize, c + d2 * clutterSize);
+	}
+}
+
+/*
+ * compares shading attributes, reconstructed from quantized storage with the full precision ones
+ */
+void reportQuantization(const rt::TriangleStorage& full, const rt::TriangleStorage& quantized)
+{
+	float maxNormalError = 0.0f;
+	float maxTexCoordError = 0.0f;
+	for (size_t i = 0, e = full.size(); i < e; ++i)
+	{
+		rt::Triangle a = full.triangle(i);
+		rt::Triangle b = quantized.triangle(i);
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			maxNormalError = std::max(maxNormalError, (a.n[j] - b.n[j]).length());
+			maxTexCoordError = std::max(maxTexCoordError, (a.t[j] - b.t[j]).length());
+		}
+	}
+	log::info("  attributes %llu KB, quantized %llu KB, max normal error %.6f, max texcoord error %.6f",
+		static_cast<uint64_t>(full.memoryUsage() / 1024), static_cast<uint64_t>(quantized.memoryUsage() / 1024),
+		maxNormalError, maxTexCoordError);
+}
+
+/*
+ * primary - rays from the camera through the pixel grid, random - rays from random points in random directions
+ */
+Vector<rt::Ray> generatePrimaryRays(uint32_t size)
+{
+	Vector<rt::Ray> result;
+	result.reserve(size * size);
+
+	rt::float4 origin(0.0f, 2.5f, -3.0f, 1.0f);
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			float u = 2.0f * static_cast<float>(x) / static_cast<float>(size) - 1.0f;
+			float v = 2.0f * static_cast<float>(y) / static_cast<float>(size) - 1.0f;
+			rt::float4 target(1.5f * u, 0.0f, 1.5f * v, 1.0f);
+			result.emplace_back(origin, rt::normalize(target - origin));
+		}
+	}
+	return result;
+}
+
+Vector<rt::Ray> generateRandomRays(uint32_t count)
+{
+	Vector<rt::Ray> result;
+	result.reserve(count);
+
+	uint32_t state = 0x13579bdf;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		rt::float4 origin(2.0f * nextRandomFloat(state) - 1.0f, 0.75f * nextRandomFloat(state), 2.0f * nextRandomFloat(state) - 1.0f, 1.0f);
+		rt::float4 direction(2.0f * nextRandomFloat(state) - 1.0f, 2.0f * nextRandomFloat(state) - 1.0f, 2.0f * nextRandomFloat(state) - 1.0f, 0.0f);
+		result.emplace_back(origin, rt::normalize(direction));
+	}
+	return result;
+}
+
+template <class T>
+uint64_t traceRays(const T& structure, const Vector<rt::Ray>& rays, Vector<rt::TraverseResult>& results)
+{
+	results.resize(rays.size());
+	for (size_t i = 0, e = rays.size(); i < e; ++i)
+		results[i] = structure.traverse(rays[i]);
+
+	uint64_t hits = 0;
+	for (const rt::TraverseResult& result : results)
+		hits += (result.triangleIndex == rt::InvalidIndex) ? 0 : 1;
+	return hits;
+}
+
+/*
+ * consecutive rays are grouped into packets and traversed together
+ */
+uint64_t traceRayPackets(const rt::BVH& bvh, const Vector<rt::Ray>& rays, Vector<rt::TraverseResult>& results)
+{
+	results.resize(rays.size());
+	for (size_t i = 0, e = rays.size(); i < e; i += rt::PacketWidth)
+	{
+		uint32_t count = static_cast<uint32_t>(std::min(e - i, static_cast<size_t>(rt::PacketWidth)));
+		rt::RayPacket packet(rays.data() + i, count);
+		rt::PacketHits hits;
+		bvh.traverse(packet, hits);
+		for (uint32_t lane = 0; lane < count; ++lane)
+			results[i + lane] = rt::packetHitToTraverseResult(packet, hits, lane);
+	}
+
+	uint64_t hits = 0;
+	for (const rt::TraverseResult& result : results)
+		hits += (result.triangleIndex == rt::InvalidIndex) ? 0 : 1;
+	return hits;
+}
+
+/*
+ * structures could report different triangles at shared edges,
+ * so only hit distances are compared
+ */
+uint64_t countMismatches(const Vector<rt::Ray>& rays, const Vector<rt::TraverseResult>& a, const Vector<rt::TraverseResult>& b)
+{
+	uint64_t result = 0;
+	for (size_t i = 0, e = rays.size(); i < e; ++i)
+	{
+		bool hitA = (a[i].triangleIndex != rt::InvalidIndex);
+		bool hitB = (b[i].triangleIndex != rt::InvalidIndex);
+		if (hitA != hitB)
+		{
+			++result;
+		}
+		else if (hitA)
+		{
+			float distanceA = (a[i].intersectionPoint - rays[i].origin).length();
+			float distanceB = (b[i].intersectionPoint - rays[i].origin).length();
+			result += (std::abs(distanceA - distanceB) > 1.0e-3f) ? 1 : 0;
+		}
+	}
+	return result;
+}
+
+void testScene(uint32_t gridSize)
+{
+	rt::TriangleStorage triangles;
+	triangles.clear(false);
+	generateScene(gridSize, triangles);
+	log::info("Scene with %llu triangles:", static_cast<uint64_t>(triangles.size()));
+
+	rt::TriangleStorage quantizedTriangles;
+	quantizedTriangles.clear(true);
+	generateScene(gridSize, quantizedTriangles);
+	reportQuantization(triangles, quantizedTriangles);
+
+	rt::KDTree kdTree;
+	uint64_t time = measure([&]() { kdTree.build(triangles, rt::Options().maxKDTreeDepth); });
+	reportBuild("KDTree", time, kdTree.nodesStatistics().totalNodes, kdTree.nodesStatistics().maxDepth);
+
+	rt::BVH bvh;
+	time = measure([&]() { bvh.build(triangles); });
+	reportBuild("BVH", time, bvh.nodesStatistics().totalNodes, bvh.nodesStatistics().maxDepth);
+
+	const char* rayTypes[] = { "Primary", "Random" };
+	Vector<rt::Ray> rays[] = { generatePrimaryRays(512), generateRandomRays(256 * 1024) };
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		log::info(" %s rays, %llu rays:", rayTypes[i], static_cast<uint64_t>(rays[i].size()));
+
+		Vector<rt::TraverseResult> kdTreeResults;
+		uint64_t hits = 0;
+		time = measure([&]() { hits = traceRays(kdTree, rays[i], kdTreeResults); });
+		reportTrace("KDTree", time, rays[i].size(), hits);
+
+		Vector<rt::TraverseResult> bvhResults;
+		time = measure([&]() { hits = traceRays(bvh, rays[i], bvhResults); });
+		reportTrace("BVH", time, rays[i].size(), hits);
+
+		log::info("  %llu mismatches", countMismatches(rays[i], kdTreeResults, bvhResults));
+
+		Vector<rt::TraverseResult> packetResults;
+		time = measure([&]() { hits = traceRayPackets(bvh, rays[i], packetResults); });
+		reportTrace("Packets", time, rays[i].size(), hits);
+		log::info("  %llu mismatches", countMismatches(rays[i], bvhResults, packetResults));
+	}
+}
+
+int main()
+{
+	log::addOutput(log::ConsoleOutput::Pointer::create());
+
+	testScene(128);
+	testScene(640);
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
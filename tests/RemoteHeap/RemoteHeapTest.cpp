@@ -3,6 +3,117 @@
 const uint32_t heapCapacity = 32 * 1024 * 1024;
 const uint32_t heapGranularity = 128;
 const uint32_t totalAllocations = heapCapacity / heapGranularity;
+const uint32_t churnIterations = 64 * 1024;
+
+/*
+ * Previous first-fit implementation of RemoteHeap (one byte of info per granularity unit),
+ * used as a reference to compare against
+ */
+class FirstFitRemoteHeap
+{
+public:
+	enum : uint8_t
+	{
+		Empty = 0x00,
+		AllocationBegin = 0x01,
+		AllocationInterior = 0x02,
+		AllocationEnd = 0x03
+	};
+
+	FirstFitRemoteHeap(uint64_t cap, uint64_t gr) :
+		_capacity(cap), _granularity(gr), _infoSize((cap + gr - 1) / gr) { }
+
+	uint64_t requiredInfoSize() const
+		{ return _infoSize; }
+
+	void setInfoStorage(void* ptr)
+	{
+		_info = reinterpret_cast<uint8_t*>(ptr);
+		memset(_info, Empty, _infoSize);
+	}
+
+	bool allocate(uint64_t sizeToAllocate, uint64_t& offset)
+	{
+		uint64_t requiredInfoSize = et::alignUpTo(sizeToAllocate, _granularity) / _granularity;
+		if (_firstEmpty + requiredInfoSize > _infoSize)
+			return false;
+
+		uint8_t* ptr = _info + _firstEmpty;
+		uint8_t* end = _info + _infoSize;
+
+		uint64_t sz = 1;
+		uint8_t* seekBegin = ptr;
+		uint8_t* allocationBegin = ptr;
+		while (ptr < end)
+		{
+			if (*ptr)
+			{
+				allocationBegin += sz;
+				sz = 0;
+			}
+
+			if (sz == requiredInfoSize)
+			{
+				uint8_t* allocationEnd = allocationBegin + requiredInfoSize - 1;
+				offset = _granularity * static_cast<uint64_t>(allocationBegin - _info);
+
+				uint64_t usedChunks = static_cast<uint64_t>(allocationEnd - allocationBegin);
+				memset(allocationBegin, AllocationInterior, usedChunks);
+				*allocationBegin = AllocationBegin;
+				*allocationEnd = AllocationEnd;
+
+				if (allocationBegin == seekBegin)
+				{
+					_firstEmpty += usedChunks;
+					while ((allocationEnd < end) && (*allocationEnd++))
+						_firstEmpty++;
+				}
+				return true;
+			}
+
+			++ptr;
+			++sz;
+		}
+
+		return false;
+	}
+
+	bool release(uint64_t offset)
+	{
+		uint64_t index = offset / _granularity;
+		uint8_t* ptr = _info + index;
+		uint8_t state = 0;
+		do
+		{
+			state = *ptr;
+			*ptr++ = Empty;
+		} while (state != AllocationEnd);
+
+		_firstEmpty = std::min(_firstEmpty, index);
+		return true;
+	}
+
+private:
+	uint64_t _capacity = 0;
+	uint64_t _granularity = 0;
+	uint64_t _infoSize = 0;
+	uint64_t _firstEmpty = 0;
+	uint8_t* _info = nullptr;
+};
+
+template <class HP>
+void logResults(const char* name, uint64_t infoSize, const uint64_t times[3])
+{
+	uint64_t allocTime = times[1] - times[0];
+	uint64_t releaseTime = times[2] - times[1];
+	uint64_t totalTime = times[2] - times[0];
+
+	et::log::info("%24s %32s [% 12llu] : % 6llu.%03llu | % 6llu.%03llu | % 6llu.%03llu", name, 
+		typeid(HP).name(), infoSize,
+		totalTime / 1000, totalTime % 1000,
+		allocTime / 1000, allocTime % 1000,
+		releaseTime / 1000, releaseTime % 1000);
+}
 
 template <class HP>
 void runTest(uint32_t scale)
@@ -11,35 +122,110 @@ void runTest(uint32_t scale)
 	std::vector<uint8_t> infoStorage(heap.requiredInfoSize());
 	heap.setInfoStorage(infoStorage.data());
 
-	std::vector<uint32_t> allocations;
+	std::vector<uint64_t> allocations;
 	allocations.reserve(totalAllocations);
 
 	uint64_t times[3] = { et::queryCurrentTimeInMicroSeconds() };
 
 	for (uint32_t i = 0; i < totalAllocations; ++i)
 	{
-		uint32_t mem = 0;
+		uint64_t mem = 0;
 		if (heap.allocate(8 + rand() % (scale * heapGranularity - 8), mem))
 			allocations.emplace_back(mem);
 	}
 
 	times[1] = et::queryCurrentTimeInMicroSeconds();
 
-	for (uint32_t i : allocations)
+	for (uint64_t i : allocations)
 		heap.release(i);
 
 	times[2] = et::queryCurrentTimeInMicroSeconds();
 
-	uint64_t allocTime = times[1] - times[0];
-	uint64_t releaseTime = times[2] - times[1];
-	uint64_t totalTime = times[2] - times[0];
+	char name[64] = { };
+	sprintf(name, "sequential x%u", scale);
+	logResults<HP>(name, heap.requiredInfoSize(), times);
+}
 
-	et::log::info("%32s [% 12u] : % 4llu.%04llu | % 4llu.%04llu | % 4llu.%04llu", 
-		typeid(HP).name(), 
-		heap.requiredInfoSize(),
-		totalTime / 1000, totalTime % 1000,
-		allocTime / 1000, allocTime % 1000,
-		releaseTime / 1000, releaseTime % 1000);
+/*
+ * Fills heap with single-unit allocations and releases every other one,
+ * then allocates blocks which do not fit into any of holes left
+ */
+template <class HP>
+void runCheckerboardTest()
+{
+	HP heap(heapCapacity, heapGranularity);
+	std::vector<uint8_t> infoStorage(heap.requiredInfoSize());
+	heap.setInfoStorage(infoStorage.data());
+
+	std::vector<uint64_t> allocations;
+	allocations.reserve(totalAllocations);
+
+	uint64_t mem = 0;
+	for (uint32_t i = 0; i < totalAllocations / 2; ++i)
+	{
+		if (heap.allocate(heapGranularity, mem))
+			allocations.emplace_back(mem);
+	}
+
+	for (size_t i = 0; i < allocations.size(); i += 2)
+		heap.release(allocations[i]);
+
+	uint64_t times[3] = { et::queryCurrentTimeInMicroSeconds() };
+
+	std::vector<uint64_t> largeAllocations;
+	largeAllocations.reserve(totalAllocations);
+	for (uint32_t i = 0; i < totalAllocations / 64; ++i)
+	{
+		if (heap.allocate(2 * heapGranularity, mem))
+			largeAllocations.emplace_back(mem);
+	}
+
+	times[1] = et::queryCurrentTimeInMicroSeconds();
+
+	for (uint64_t i : largeAllocations)
+		heap.release(i);
+
+	times[2] = et::queryCurrentTimeInMicroSeconds();
+
+	logResults<HP>("checkerboard", heap.requiredInfoSize(), times);
+}
+
+/*
+ * Keeps heap mostly filled and randomly releases and allocates blocks of various sizes
+ */
+template <class HP>
+void runChurnTest()
+{
+	HP heap(heapCapacity, heapGranularity);
+	std::vector<uint8_t> infoStorage(heap.requiredInfoSize());
+	heap.setInfoStorage(infoStorage.data());
+
+	std::vector<uint64_t> allocations;
+	allocations.reserve(totalAllocations);
+
+	srand(1);
+	uint64_t mem = 0;
+	while (heap.allocate(heapGranularity + rand() % (16 * heapGranularity), mem))
+		allocations.emplace_back(mem);
+
+	uint64_t times[3] = { et::queryCurrentTimeInMicroSeconds() };
+
+	for (uint32_t i = 0; i < churnIterations; ++i)
+	{
+		uint64_t& slot = allocations[rand() % allocations.size()];
+		heap.release(slot);
+		if (!heap.allocate(heapGranularity + rand() % (16 * heapGranularity), slot))
+			heap.allocate(heapGranularity, slot);
+	}
+
+	times[1] = et::queryCurrentTimeInMicroSeconds();
+
+	for (uint64_t i : allocations)
+		heap.release(i);
+
+	times[2] = et::queryCurrentTimeInMicroSeconds();
+
+	logResults<HP>("random churn", heap.requiredInfoSize(), times);
 }
 
 int main()
@@ -50,9 +236,16 @@ int main()
 	uint32_t s = 1;
 	for (uint32_t i = 0; i < 5; ++i)
 	{
+		runTest<FirstFitRemoteHeap>(s);
 		runTest<et::RemoteHeap>(s);
 		s *= 2;
 	}
+
+	runCheckerboardTest<FirstFitRemoteHeap>();
+	runCheckerboardTest<et::RemoteHeap>();
+
+	runChurnTest<FirstFitRemoteHeap>();
+	runChurnTest<et::RemoteHeap>();
 	
 	system("pause");
 	return 0;
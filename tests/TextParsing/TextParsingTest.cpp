@@ -0,0 +1,263 @@
+#include <et/app/application.h>
+#include <et/core/textparsing.h>
+#include "../common/testtools.h"
+
+using namespace et;
+
+void report(const char* name, uint64_t time, uint64_t dataSize, uint64_t valuesCount, uint64_t mismatches)
+{
+	time = std::max(uint64_t(1), time);
+	log::info("  %-24s %5llu.%03llu ms, %7.1f MB/s, %6.1f M values/s, %llu mismatches", name, time / 1000, time % 1000,
+		static_cast<double>(dataSize) / static_cast<double>(time), static_cast<double>(valuesCount) / static_cast<double>(time), mismatches);
+}
+
+/*
+ * naive parser, which was used in OBJ loader: accumulates digits in float,
+ * so it loses precision on long mantissas and large exponents
+ */
+float naiveParseFloat(const char*& p, const char* end)
+{
+	float r = 0.0f;
+	bool neg = false;
+	if ((p < end) && ((*p == '-') || (*p == '+')))
+	{
+		neg = (*p == '-');
+		++p;
+	}
+	while ((p < end) && (*p >= '0') && (*p <= '9'))
+	{
+		r = (r * 10.0f) + static_cast<float>(*p - '0');
+		++p;
+	}
+	if ((p < end) && (*p == '.'))
+	{
+		float f = 0.0f;
+		int32_t n = 0;
+		++p;
+		while ((p < end) && (*p >= '0') && (*p <= '9'))
+		{
+			f = (f * 10.0f) + static_cast<float>(*p - '0');
+			++p;
+			++n;
+		}
+		r += f / std::pow(10.0f, static_cast<float>(n));
+	}
+	if ((p < end) && ((*p == 'e') || (*p == 'E')))
+	{
+		++p;
+		const char* exponentBegin = p;
+		float exponent = naiveParseFloat(p, end);
+		if (p > exponentBegin)
+			r *= std::pow(10.0f, exponent);
+	}
+	return neg ? -r : r;
+}
+
+enum class FloatStyle : uint32_t
+{
+	Fixed,
+	Shortest,
+	Scientific
+};
+
+/*
+ * fixed - typical OBJ coordinates, shortest - round-trip representation of random floats,
+ * scientific - 17 digit mantissa with exponent
+ */
+std::string generateFloats(FloatStyle style, uint32_t count, Vector<float>& expected)
+{
+	std::string result;
+	result.reserve(24 * count);
+	expected.resize(count);
+
+	char buffer[64] = { };
+	uint32_t state = 0x12345678;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (style == FloatStyle::Fixed)
+		{
+			float value = static_cast<float>(static_cast<int32_t>(nextRandom(state) % 2000000) - 1000000) / 1000.0f;
+			snprintf(buffer, sizeof(buffer), "%.6f", value);
+		}
+		else
+		{
+			uint32_t bits = nextRandom(state) & 0x7f7fffff;
+			float value = 0.0f;
+			memcpy(&value, &bits, sizeof(value));
+			snprintf(buffer, sizeof(buffer), (style == FloatStyle::Shortest) ? "%.9g" : "%.16e", value);
+		}
+		expected[i] = std::strtof(buffer, nullptr);
+		result.append(buffer);
+		result.push_back(((i + 1) % 3 == 0) ? '\n' : ' ');
+	}
+	return result;
+}
+
+bool sameFloat(float a, float b)
+{
+	return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+void testFloats(FloatStyle style, const char* styleName, uint32_t count)
+{
+	Vector<float> expected;
+	std::string input = generateFloats(style, count, expected);
+	const char* begin = input.data();
+	const char* end = begin + input.size();
+	log::info("%s floats, %u values, %llu KB:", styleName, count, static_cast<uint64_t>(input.size() / 1024));
+
+	Vector<float> values(count, 0.0f);
+	auto countMismatches = [&values, &expected, count]()
+	{
+		uint64_t result = 0;
+		for (uint32_t i = 0; i < count; ++i)
+			result += sameFloat(values[i], expected[i]) ? 0 : 1;
+		return result;
+	};
+
+	uint64_t time = measure([&]()
+	{
+		char* position = const_cast<char*>(begin);
+		for (uint32_t i = 0; i < count; ++i)
+			values[i] = std::strtof(position, &position);
+	});
+	report("strtof", time, input.size(), count, countMismatches());
+
+	time = measure([&]()
+	{
+		const char* position = begin;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			position = text::skipWhitespace(position, end);
+			values[i] = naiveParseFloat(position, end);
+		}
+	});
+	report("naive", time, input.size(), count, countMismatches());
+
+	time = measure([&]()
+	{
+		const char* position = begin;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			position = text::skipWhitespace(position, end);
+			text::parseFloat(position, end, values[i]);
+		}
+	});
+	report("text::parseFloat", time, input.size(), count, countMismatches());
+
+	time = measure([&]()
+	{
+		const char* position = begin;
+		text::Range line;
+		uint32_t index = 0;
+		while (text::nextLine(position, end, line))
+		{
+			const char* linePosition = line.begin;
+			index += text::parseFloats(linePosition, line.end, values.data() + index, std::min(3u, count - index));
+		}
+	});
+	report("text::parseFloats", time, input.size(), count, countMismatches());
+}
+
+void testIntegers(uint32_t count)
+{
+	std::string input;
+	input.reserve(12 * count);
+
+	Vector<int64_t> expected(count, 0);
+	char buffer[32] = { };
+	uint32_t state = 0x87654321;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		expected[i] = static_cast<int64_t>(nextRandom(state) % 4000000) - 2000000;
+		snprintf(buffer, sizeof(buffer), "%lld/", static_cast<long long>(expected[i]));
+		input.append(buffer);
+	}
+
+	const char* begin = input.data();
+	const char* end = begin + input.size();
+	log::info("Integers, %u values, %llu KB:", count, static_cast<uint64_t>(input.size() / 1024));
+
+	Vector<int64_t> values(count, 0);
+	auto countMismatches = [&values, &expected]()
+	{
+		uint64_t result = 0;
+		for (size_t i = 0; i < values.size(); ++i)
+			result += (values[i] == expected[i]) ? 0 : 1;
+		return result;
+	};
+
+	uint64_t time = measure([&]()
+	{
+		char* position = const_cast<char*>(begin);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			values[i] = std::strtoll(position, &position, 10);
+			++position;
+		}
+	});
+	report("strtoll", time, input.size(), count, countMismatches());
+
+	time = measure([&]()
+	{
+		const char* position = begin;
+		text::Range field;
+		for (uint32_t i = 0; text::nextField(position, end, '/', field); ++i)
+			values[i] = text::parseInteger(field);
+	});
+	report("text::parseInteger", time, input.size(), count, countMismatches());
+}
+
+void testTokenizers(uint32_t count)
+{
+	std::string input;
+	input.reserve(16 * count);
+
+	uint32_t state = 0x13572468;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t length = 1 + nextRandom(state) % 12;
+		for (uint32_t c = 0; c < length; ++c)
+			input.push_back(static_cast<char>('a' + nextRandom(state) % 26));
+		input.append(((i + 1) % 8 == 0) ? "\n" : (i % 5 == 0) ? " \t " : " ");
+	}
+
+	log::info("Tokens, %u values, %llu KB:", count, static_cast<uint64_t>(input.size() / 1024));
+
+	uint64_t tokensCount = 0;
+	uint64_t time = measure([&]()
+	{
+		StringList tokens = split(input, " \t\n");
+		for (const std::string& token : tokens)
+			tokensCount += token.empty() ? 0 : 1;
+	});
+	report("split", time, input.size(), count, (tokensCount == count) ? 0 : 1);
+
+	tokensCount = 0;
+	time = measure([&]()
+	{
+		const char* position = input.data();
+		const char* end = position + input.size();
+		text::Range token;
+		while (text::nextToken(position, end, token))
+			++tokensCount;
+	});
+	report("text::nextToken", time, input.size(), count, (tokensCount == count) ? 0 : 1);
+}
+
+int main()
+{
+	log::addOutput(log::ConsoleOutput::Pointer::create());
+
+	const uint32_t valuesCount = 4 * 1024 * 1024;
+	testFloats(FloatStyle::Fixed, "Fixed", valuesCount);
+	testFloats(FloatStyle::Shortest, "Shortest", valuesCount);
+	testFloats(FloatStyle::Scientific, "Scientific", valuesCount);
+	testIntegers(valuesCount);
+	testTokenizers(valuesCount);
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
@@ -0,0 +1,96 @@
+#include <et/app/application.h>
+#include <et/core/notifytimer.h>
+#include "../common/testtools.h"
+
+const uint32_t tasksCount = 100 * 1000;
+const uint32_t timersCount = 100 * 1000;
+const uint32_t animatedObjectsCount = 1000;
+const uint32_t maxDelayMSec = 10 * 1000;
+const uint64_t frameDurationMSec = 16;
+
+uint32_t executedTasks = 0;
+uint32_t expiredTimers = 0;
+
+class CounterTask : public et::Task
+{
+public:
+	void execute() override
+		{ ++executedTasks; }
+};
+
+class AnimatedObject : public et::TimedObject
+{
+public:
+	void start(et::TimerPool* tp)
+		{ startUpdates(tp); }
+
+	void update(float) override
+		{ ++updates; }
+
+public:
+	uint32_t updates = 0;
+};
+
+int main()
+{
+	et::log::addOutput(et::log::ConsoleOutput::Pointer::create());
+	et::log::info("Starting test...");
+
+	et::RunLoop runLoop;
+	runLoop.update(0);
+
+	et::TimerPool* timerPool = runLoop.mainTimerPool().pointer();
+	uint32_t state = 0x12345678;
+
+	uint64_t setupStart = et::queryCurrentTimeInMicroSeconds();
+	{
+		for (uint32_t i = 0; i < tasksCount; ++i)
+		{
+			float delay = static_cast<float>(nextRandom(state) % maxDelayMSec) / 1000.0f;
+			runLoop.addTask(et::etCreateObject<CounterTask>(), delay);
+		}
+	}
+	uint64_t tasksSetupTime = et::queryCurrentTimeInMicroSeconds() - setupStart;
+
+	uint32_t expectedExpirations = 0;
+	std::unique_ptr<et::NotifyTimer[]> timers(new et::NotifyTimer[timersCount]);
+	setupStart = et::queryCurrentTimeInMicroSeconds();
+	{
+		for (uint32_t i = 0; i < timersCount; ++i)
+		{
+			float period = static_cast<float>(1 + nextRandom(state) % maxDelayMSec) / 1000.0f;
+			uint32_t repeatCount = nextRandom(state) % 3;
+			timers[i].expired.connect([](et::NotifyTimer*) { ++expiredTimers; });
+			timers[i].start(timerPool, period, repeatCount);
+			expectedExpirations += repeatCount + 1;
+		}
+	}
+	uint64_t timersSetupTime = et::queryCurrentTimeInMicroSeconds() - setupStart;
+
+	std::vector<AnimatedObject> animatedObjects(animatedObjectsCount);
+	for (AnimatedObject& obj : animatedObjects)
+		obj.start(timerPool);
+
+	uint64_t frames = 0;
+	uint64_t maxFrameTime = 0;
+	uint64_t updateStart = et::queryCurrentTimeInMicroSeconds();
+	while (runLoop.hasTasks() || (expiredTimers < expectedExpirations))
+	{
+		uint64_t frameStart = et::queryCurrentTimeInMicroSeconds();
+		runLoop.update((++frames) * frameDurationMSec);
+		maxFrameTime = std::max(maxFrameTime, et::queryCurrentTimeInMicroSeconds() - frameStart);
+	}
+	uint64_t updateTime = et::queryCurrentTimeInMicroSeconds() - updateStart;
+
+	et::log::info("%u tasks added in %llu.%03llu ms", tasksCount, tasksSetupTime / 1000, tasksSetupTime % 1000);
+	et::log::info("%u timers started in %llu.%03llu ms", timersCount, timersSetupTime / 1000, timersSetupTime % 1000);
+	et::log::info("%llu frames updated in %llu.%03llu ms (%llu us per frame on average, %llu us max)", frames,
+		updateTime / 1000, updateTime % 1000, updateTime / frames, maxFrameTime);
+	et::log::info("Executed tasks: %u of %u, timer expirations: %u of %u, animated object updates: %u",
+		executedTasks, tasksCount, expiredTimers, expectedExpirations, animatedObjects.front().updates);
+
+	system("pause");
+	return 0;
+}
+
+et::IApplicationDelegate* et::Application::initApplicationDelegate() { return nullptr; };
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <et/core/tools.h>
+
+/*
+ * helpers shared by test projects
+ */
+inline uint32_t nextRandom(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/*
+ * returns execution time of the function in microseconds
+ */
+template <typename F>
+inline uint64_t measure(F function)
+{
+	uint64_t startTime = et::queryCurrentTimeInMicroSeconds();
+	function();
+	return et::queryCurrentTimeInMicroSeconds() - startTime;
+}
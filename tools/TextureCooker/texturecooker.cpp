@@ -0,0 +1,132 @@
+#include <et/core/tools.h>
+#include <et/imaging/texturecache.h>
+
+using namespace et;
+
+void printHelp()
+{
+	log::info("Using:\n"
+		"texturecooker -root <ROOT FOLDER> | -file <FILE>\n"
+		"\tOPTIONAL: -compress <none|auto|bc1|bc3|bc5|bc7>, default: auto - block compression of the cooked textures\n"
+		"\tOPTIONAL: -filter <box|kaiser>, default: kaiser - filter used to generate mip levels\n"
+		"\tOPTIONAL: -nomips, default off - don't generate mip levels\n"
+		"\tOPTIONAL: -force, default off - cook textures even if cache is up to date.");
+}
+
+bool parseCompression(const std::string& value, texturecache::CookOptions& options)
+{
+	options.automaticCompression = false;
+	options.compression = TextureFormat::Invalid;
+
+	if (value == "auto")
+		options.automaticCompression = true;
+	else if (value == "bc1")
+		options.compression = TextureFormat::DXT1_RGB;
+	else if (value == "bc3")
+		options.compression = TextureFormat::DXT5;
+	else if (value == "bc5")
+		options.compression = TextureFormat::RGTC2;
+	else if (value == "bc7")
+		options.compression = TextureFormat::BC7;
+	else if (value != "none")
+		return false;
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	log::addOutput(log::ConsoleOutput::Pointer::create());
+
+	texturecache::CookOptions options;
+	options.automaticCompression = true;
+
+	StringList fileList;
+	std::string rootFolder;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "-root") == 0) && (i + 1 < argc))
+		{
+			rootFolder = addTrailingSlash(std::string(argv[i+1]));
+			if (!folderExists(rootFolder))
+			{
+				log::error("Root folder not found: %s", rootFolder.c_str());
+				return 0;
+			}
+			++i;
+		}
+		else if ((strcmp(argv[i], "-file") == 0) && (i + 1 < argc))
+		{
+			fileList.push_back(std::string(argv[i+1]));
+			++i;
+		}
+		else if ((strcmp(argv[i], "-compress") == 0) && (i + 1 < argc))
+		{
+			if (!parseCompression(lowercase(std::string(argv[i+1])), options))
+			{
+				log::error("Unsupported compression: %s", argv[i+1]);
+				return 0;
+			}
+			++i;
+		}
+		else if ((strcmp(argv[i], "-filter") == 0) && (i + 1 < argc))
+		{
+			std::string filter = lowercase(std::string(argv[i+1]));
+			options.filter = (filter == "box") ? ImageDownsampleFilter_Box : ImageDownsampleFilter_Kaiser;
+			++i;
+		}
+		else if (strcmp(argv[i], "-nomips") == 0)
+		{
+			options.generateMips = false;
+		}
+		else if (strcmp(argv[i], "-force") == 0)
+		{
+			options.force = true;
+		}
+	}
+
+	if (!rootFolder.empty())
+	{
+		const char* masks[] = { "*.png", "*.jpg", "*.jpeg", "*.tga", "*.bmp" };
+		for (const char* mask : masks)
+			findFiles(rootFolder, mask, true, fileList);
+	}
+
+	if (fileList.empty())
+	{
+		printHelp();
+		return 0;
+	}
+
+	/*
+	 * encoders are parallel themselves, files are cooked one by one to limit memory usage
+	 */
+	uint32_t cookedCount = 0;
+	uint32_t upToDateCount = 0;
+	uint32_t failedCount = 0;
+	uint64_t startTime = queryCurrentTimeInMicroSeconds();
+	for (const std::string& file : fileList)
+	{
+		texturecache::CookResult result = texturecache::cook(file, options);
+		if (result == texturecache::CookResult::Cooked)
+		{
+			log::info("Cooked: %s", file.c_str());
+			++cookedCount;
+		}
+		else if (result == texturecache::CookResult::UpToDate)
+		{
+			++upToDateCount;
+		}
+		else
+		{
+			++failedCount;
+		}
+	}
+	uint64_t duration = queryCurrentTimeInMicroSeconds() - startTime;
+
+	log::info("%u textures cooked, %u up to date, %u failed in %llu ms", cookedCount, upToDateCount,
+		failedCount, duration / 1000);
+
+	return (failedCount > 0) ? 1 : 0;
+}